@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2018, NVIDIA Corporation.  All rights reserved.
+ * Copyright (c) 2016-2023, NVIDIA Corporation.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -28,6 +28,9 @@
 /* Number of bottom rows reserved for the CURSOR_END position */
 static const uint32_t end_rows = 2;
 
+/* Spare framebuffer rows for console scrolling, as a fraction of the height */
+#define SURFACE_SCROLL_ROWS_DIV 4
+
 static tegrabl_error_t tegrabl_display_unit_get_edid(uint32_t du_type, struct tegrabl_display_pdata *pdata)
 {
 	struct nvdisp_mode *mode = NULL;
@@ -94,15 +97,35 @@ tegrabl_error_t display_unit_set_surface(struct tegrabl_display_unit *du,
 
 	du->surf[win_idx] = surf;
 
+	/* only the visible window is cleaned, the spare rows are not scanned out */
 	dma_addr = tegrabl_dma_map_buffer(TEGRABL_MODULE_NVDISPLAY0_HEAD,
-		du->nvdisp->instance, (void *)(surf->base), surf->size,
+		du->nvdisp->instance, (void *)(surf->base + surf->origin), surf->size,
 		TEGRABL_DMA_TO_DEVICE);
+	tegrabl_surface_flush(surf);
 
+	du->surf_dma = dma_addr - surf->origin;
+	du->surf_origin = surf->origin;
 	tegrabl_nvdisp_win_set_surface(du->nvdisp, du->win_id, dma_addr);
 
 	return TEGRABL_NO_ERROR;
 }
 
+/**
+ * @brief Cleans the rows changed since the last update and moves the window
+ *        if the console has scrolled through the spare rows
+ */
+static void display_unit_update_surface(struct tegrabl_display_unit *du,
+	struct tegrabl_surface *surf)
+{
+	tegrabl_surface_flush(surf);
+
+	if (surf->origin != du->surf_origin) {
+		du->surf_origin = surf->origin;
+		tegrabl_nvdisp_win_set_surface(du->nvdisp, du->win_id,
+									   du->surf_dma + surf->origin);
+	}
+}
+
 struct tegrabl_display_unit *tegrabl_display_unit_init(
 	tegrabl_display_unit_type_t type, struct tegrabl_display_pdata *pdata)
 {
@@ -153,6 +176,7 @@ struct tegrabl_display_unit *tegrabl_display_unit_init(
 
 	surf->height = pdata->mode->v_active;
 	surf->width = pdata->mode->h_active;
+	surf->scroll_rows = surf->height / SURFACE_SCROLL_ROWS_DIV;
 	pr_debug("%s: surface height = %d, width = %d\n", __func__, surf->height, surf->width);
 
 	err = tegrabl_surface_setup(surf);
@@ -227,10 +251,7 @@ tegrabl_error_t tegrabl_display_unit_printf(struct tegrabl_display_unit *du,
 		goto fail;
 	}
 
-	err = display_unit_set_surface(du, 0, surf);
-	if (err != TEGRABL_NO_ERROR) {
-		goto fail;
-	}
+	display_unit_update_surface(du, surf);
 
 	pr_debug("%s: exit\n", __func__);
 	return err;
@@ -269,10 +290,8 @@ tegrabl_error_t tegrabl_display_unit_show_image(struct tegrabl_display_unit *du,
 		goto fail;
 	}
 
-	err = display_unit_set_surface(du, 0, surf);
-	if (err != TEGRABL_NO_ERROR) {
-		goto fail;
-	}
+	/* the image itself was cleaned by the renderer */
+	display_unit_update_surface(du, surf);
 
 	pr_debug("%s: exit\n", __func__);
 	return err;
@@ -304,7 +323,7 @@ tegrabl_error_t tegrabl_display_unit_clear(struct tegrabl_display_unit *du)
 		goto fail;
 	}
 	tegrabl_surface_clear(surf);
-	display_unit_set_surface(du, 0, surf);
+	display_unit_update_surface(du, surf);
 	tegrabl_render_text_set_position(0, 0);
 	tegrabl_render_text_set_font(FONT_DEFAULT, 2);
 
@@ -364,6 +383,11 @@ tegrabl_error_t tegrabl_display_unit_ioctl(struct tegrabl_display_unit *du,
 			err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 10);
 			break;
 		}
+		/* hand over a framebuffer that starts at base */
+		if (surf->origin != 0) {
+			tegrabl_surface_reset_origin(surf);
+			display_unit_update_surface(du, surf);
+		}
 		disp_params->size = surf->size;
 		disp_params->height = surf->height;
 		disp_params->width = surf->width;
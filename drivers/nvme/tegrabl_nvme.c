@@ -37,7 +37,8 @@ static void tegrabl_nvme_print_serial(char *array, size_t size, const char *pref
 static tegrabl_error_t nvme_smmu_protect(struct tegrabl_nvme_context *context,
 										 void *buffer,
 										 uint32_t *size,
-										 int prot)
+										 int prot,
+										 bool cached)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	unsigned long smmu_buffer = (unsigned long)buffer;
@@ -56,12 +57,21 @@ static tegrabl_error_t nvme_smmu_protect(struct tegrabl_nvme_context *context,
 			pr_debug("new size = 0x%x\n", *size);
 		}
 
-		err = tegrabl_smmu_enable_prot(
+		if (cached) {
+			err = tegrabl_smmu_map_cached(
 							context->pcie_dev->smmu_cookie,
 							smmu_buffer,
 							smmu_buffer,
 							(size_t)*size,
 							prot);
+		} else {
+			err = tegrabl_smmu_enable_prot(
+							context->pcie_dev->smmu_cookie,
+							smmu_buffer,
+							smmu_buffer,
+							(size_t)*size,
+							prot);
+		}
 		if (err != TEGRABL_NO_ERROR) {
 			pr_warn("SMMU: Failed protection @(%p, 0x%x)\n", buffer, *size);
 			*size = 0;
@@ -75,7 +85,8 @@ static tegrabl_error_t nvme_smmu_protect(struct tegrabl_nvme_context *context,
 
 static uint32_t nvme_smmu_unprotect(struct tegrabl_nvme_context *context,
 									void *buffer,
-									uint32_t size)
+									uint32_t size,
+									bool cached)
 {
 	unsigned long smmu_buffer = (unsigned long)buffer;
 	size_t rsize = 0;
@@ -94,10 +105,17 @@ static uint32_t nvme_smmu_unprotect(struct tegrabl_nvme_context *context,
 			pr_debug("new size = 0x%x\n", size);
 		}
 
-		rsize = tegrabl_smmu_disable_prot(
+		if (cached) {
+			rsize = tegrabl_smmu_unmap_cached(
+							context->pcie_dev->smmu_cookie,
+							smmu_buffer,
+							(size_t)size);
+		} else {
+			rsize = tegrabl_smmu_disable_prot(
 							context->pcie_dev->smmu_cookie,
 							smmu_buffer,
 							(size_t)size);
+		}
 		if (rsize != (size_t)size) {
 			pr_warn("SMMU: Failed unprotection @(%p, 0x%x); rsize=0x%lx\n", buffer, size, rsize);
 		}
@@ -112,7 +130,7 @@ static void nvme_free_buffer(struct tegrabl_nvme_context *context,
 {
 	pr_debug("SMMU: free @(%p, 0x%x)\n", buffer, size);
 	if (context->smmu_en && size) {
-		nvme_smmu_unprotect(context, buffer, size);
+		nvme_smmu_unprotect(context, buffer, size, false);
 	}
 
 	tegrabl_free(buffer);
@@ -157,7 +175,8 @@ static tegrabl_error_t tegrabl_construct_nvme_qpair(struct tegrabl_nvme_context
 	err = nvme_smmu_protect(context,
 							(void *)qpair->sq.entries,
 							&msize,
-							SMMU_WRITE);
+							SMMU_WRITE,
+							false);
 	qpair->sq.msize = msize;
 	if (err != TEGRABL_NO_ERROR) {
 		pr_warn("SMMU: Failed protection on SQ @%p\n", qpair->sq.entries);
@@ -190,7 +209,8 @@ static tegrabl_error_t tegrabl_construct_nvme_qpair(struct tegrabl_nvme_context
 	err = nvme_smmu_protect(context,
 							(void *)qpair->cq.entries,
 							&msize,
-							SMMU_WRITE);
+							SMMU_WRITE,
+							false);
 	qpair->cq.msize = msize;
 	if (err != TEGRABL_NO_ERROR) {
 		pr_warn("SMMU: Failed protection on CQ @%p\n", qpair->cq.entries);
@@ -241,7 +261,8 @@ static tegrabl_error_t tegrabl_create_prp1(struct tegrabl_nvme_context *context)
 	err = nvme_smmu_protect(context,
 							(void *)context->ctrl.prp_list.prp1,
 							&msize,
-							SMMU_READ | SMMU_WRITE);
+							SMMU_READ | SMMU_WRITE,
+							false);
 	context->ctrl.prp_list.prp1_msize = msize;
 	if (err != TEGRABL_NO_ERROR) {
 		pr_warn("SMMU: Failed protection on prp1. @%p\n", context->ctrl.prp_list.prp1);
@@ -281,7 +302,8 @@ static tegrabl_error_t tegrabl_create_prp_list(struct tegrabl_nvme_context *cont
 	err = nvme_smmu_protect(context,
 							(void *)context->ctrl.prp_list.prp_list,
 							&msize,
-							SMMU_READ | SMMU_WRITE);
+							SMMU_READ | SMMU_WRITE,
+							false);
 	context->ctrl.prp_list.prp_list_msize = msize;
 	if (err != TEGRABL_NO_ERROR) {
 		pr_warn("SMMU: Failed protection on prp_list @%p\n", context->ctrl.prp_list.prp_list);
@@ -932,7 +954,8 @@ tegrabl_error_t tegrabl_nvme_rw_blocks(struct tegrabl_nvme_context *context, voi
 	err = nvme_smmu_protect(context,
 							buffer,
 							&tsize,
-							SMMU_READ | SMMU_WRITE);
+							SMMU_READ | SMMU_WRITE,
+							true);
 	if (err != TEGRABL_NO_ERROR) {
 		pr_warn("SMMU: Failed protection on rw_blocks. @%p\n", buffer);
 		err = TEGRABL_NO_ERROR;
@@ -976,7 +999,7 @@ tegrabl_error_t tegrabl_nvme_rw_blocks(struct tegrabl_nvme_context *context, voi
 
 	pr_debug("SMMU: free rw_blocks @(%p, 0x%lx)\n", buffer, total_len);
 	if (context->smmu_en && tsize) {
-		nvme_smmu_unprotect(context, buffer, (uint32_t)total_len);
+		nvme_smmu_unprotect(context, buffer, (uint32_t)total_len, true);
 	}
 
 fail:
@@ -226,6 +226,7 @@ static tegrabl_error_t tegrabl_nvme_register_region(
 		goto fail;
 	}
 	user_dev->buf_align_size = TEGRABL_NVME_BUF_ALIGN_SIZE;
+	user_dev->max_xfer_blocks = (bnum_t)context->max_transfer_blk;
 
 	/* Fill bdev function pointers. */
 	user_dev->read_block = tegrabl_nvme_bdev_read_block;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2021, NVIDIA CORPORATION.  All Rights Reserved.
+ * Copyright (c) 2019-2023, NVIDIA CORPORATION.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -135,6 +135,11 @@ static void outbound_atu(struct tegrabl_pcie_dev *pdev, uint32_t i, uint32_t typ
 {
 	struct tegrabl_tegra_pcie *pdata = (struct tegrabl_tegra_pcie *)pdev->pdata;
 
+	/* the region still targets the same device, nothing to reprogram */
+	if (pdata->atu_valid && (pdata->atu_type == type) && (pdata->atu_busdev == busdev)) {
+		return;
+	}
+
 	prog_atu(pdev, i, lower_32_bits(pdata->cfg1_base), PCIE_ATU_LOWER_BASE);
 	prog_atu(pdev, i, upper_32_bits(pdata->cfg1_base), PCIE_ATU_UPPER_BASE);
 	prog_atu(pdev, i, lower_32_bits(pdata->cfg1_base + pdata->cfg1_size - 1UL), PCIE_ATU_LIMIT);
@@ -143,6 +148,10 @@ static void outbound_atu(struct tegrabl_pcie_dev *pdev, uint32_t i, uint32_t typ
 	prog_atu(pdev, i, upper_32_bits(busdev), PCIE_ATU_UPPER_TARGET);
 	prog_atu(pdev, i, type | PCIE_ATU_INCREASE_REGION_SIZE, PCIE_ATU_CR1);
 	prog_atu(pdev, i, PCIE_ATU_ENABLE, PCIE_ATU_CR2);
+
+	pdata->atu_valid = true;
+	pdata->atu_type = type;
+	pdata->atu_busdev = busdev;
 }
 
 /**
@@ -277,6 +286,8 @@ tegrabl_error_t tegrabl_pcie_soc_host_init(uint8_t ctrl_num, uint32_t flags, str
 	pr_info("tegra_pcie_info[%d].cfg1_base = 0x%08X\n", ctrl_num, tegra_pcie_info[ctrl_num].cfg1_base);
 	tegra_pcie_info[ctrl_num].cfg1_size = SZ_128K;
 	tegra_pcie_info[ctrl_num].atu_dma_base = iatu_dma_offset[ctrl_num];
+	/* the controller was just reset, the ATU has to be programmed again */
+	tegra_pcie_info[ctrl_num].atu_valid = false;
 	pr_info("tegra_pcie_info[%d].atu_dma_base = 0x%08X\n", ctrl_num, tegra_pcie_info[ctrl_num].atu_dma_base);
 
 	/** Populate PCIe bus structure */
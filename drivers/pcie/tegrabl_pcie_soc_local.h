@@ -16,6 +16,7 @@
 #define TEGRABL_PCIE_SOC_LOCAL_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <tegrabl_addressmap.h>
 #include <tegrabl_debug.h>
 
@@ -44,6 +45,12 @@ struct tegrabl_tegra_pcie {
 	uint32_t cfg1_size;
 	/** ATU & DMA base address */
 	uint32_t atu_dma_base;
+	/** Set when the config ATU region targets atu_type/atu_busdev */
+	bool atu_valid;
+	/** Translation type last programmed in the config ATU region */
+	uint32_t atu_type;
+	/** Bus:Device number last programmed in the config ATU region */
+	uint32_t atu_busdev;
 };
 
 /**
@@ -59,6 +59,10 @@ static tegrabl_error_t tegrabl_qspi_blockdev_xfer(struct tegrabl_blockdev_xfer_i
 static tegrabl_error_t tegrabl_qspi_blockdev_xfer_wait(struct tegrabl_blockdev_xfer_info *xfer,
 						time_t timeout, uint8_t *status_flag);
 static tegrabl_error_t qspi_qpi_flag_set(struct tegrabl_qspi_flash_driver_info *hqfdi, bool bset);
+#if defined(CONFIG_ENABLE_QSPI_FLASH_DIFF_WRITE)
+static tegrabl_error_t qspi_bdev_erase_dirty(tegrabl_bdev_t *dev, bnum_t block,
+	bnum_t count, bool is_secure);
+#endif
 
 #endif
 
@@ -66,6 +70,16 @@ static tegrabl_error_t qspi_quad_flag_set(
 		struct tegrabl_qspi_flash_driver_info *hqfdi, uint8_t bset);
 static tegrabl_error_t read_device_id_info(
 		struct tegrabl_qspi_flash_driver_info *hqfdi);
+static tegrabl_error_t qspi_flash_idle(
+		struct tegrabl_qspi_flash_driver_info *hqfdi, bool invalidate);
+#if defined(CONFIG_ENABLE_QSPI_FLASH_PREFETCH)
+static void qspi_flash_prefetch_wait(
+		struct tegrabl_qspi_flash_driver_info *hqfdi);
+#endif
+#if defined(CONFIG_ENABLE_QSPI_FLASH_CONT_READ)
+static tegrabl_error_t qspi_flash_cont_read_exit(
+		struct tegrabl_qspi_flash_driver_info *hqfdi);
+#endif
 
 static tegrabl_error_t qspi_bdev_ioctl(
 		struct tegrabl_bdev *dev, uint32_t ioctl, void *argp)
@@ -75,7 +89,10 @@ static tegrabl_error_t qspi_bdev_ioctl(
 
 #if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
 	if (ioctl == TEGRABL_IOCTL_DEVICE_CACHE_FLUSH) {
-		return TEGRABL_NO_ERROR;
+		if ((dev == NULL) || (dev->priv_data == NULL)) {
+			return TEGRABL_NO_ERROR;
+		}
+		return qspi_flash_idle(dev->priv_data, false);
 	}
 #endif
 	pr_debug("Unknown ioctl %"PRIu32"\n", ioctl);
@@ -175,6 +192,11 @@ tegrabl_error_t tegrabl_qspi_flash_open(uint32_t instance,
 
 	hqfdi->hqspi = hqspi;
 
+#if defined(CONFIG_ENABLE_QSPI_FLASH_CONT_READ)
+	/* an earlier boot stage may have left the flash in continuous read */
+	(void)qspi_flash_cont_read_exit(hqfdi);
+#endif
+
 	/* allocate memory for qspi handle. */
 	qspi_dev = tegrabl_calloc(1, sizeof(tegrabl_bdev_t));
 	if (qspi_dev == NULL) {
@@ -204,7 +226,11 @@ tegrabl_error_t tegrabl_qspi_flash_open(uint32_t instance,
 	qspi_dev->ioctl = qspi_bdev_ioctl;
 #if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
 	qspi_dev->write_block = qspi_bdev_write_block;
+#if defined(CONFIG_ENABLE_QSPI_FLASH_DIFF_WRITE)
+	qspi_dev->erase = qspi_bdev_erase_dirty;
+#else
 	qspi_dev->erase = qspi_bdev_erase;
+#endif
 	qspi_dev->xfer = tegrabl_qspi_blockdev_xfer;
 	qspi_dev->xfer_wait = tegrabl_qspi_blockdev_xfer_wait;
 #endif
@@ -392,6 +418,11 @@ tegrabl_error_t tegrabl_qspi_flash_reinit(uint32_t instance,
 		return TEGRABL_NO_ERROR;
 	}
 
+	err = qspi_flash_idle(qspi_flash_driver_info[instance], true);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
 	hqspi = qspi_flash_driver_info[instance]->hqspi;
 	qspi_flash_driver_info[instance]->hqspi =  NULL;
 
@@ -438,6 +469,11 @@ tegrabl_error_t qspi_read_reg(
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	struct tegrabl_qspi_transfer *transfers;
 
+	err = qspi_flash_idle(hqfdi, false);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
 	is_ext_reg_access_cmd = ((reg_access_cmd & (uint32_t) 0xFFFF00) == 0U) ?
 					false : true;
 
@@ -513,6 +549,11 @@ tegrabl_error_t qspi_write_reg(
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	struct tegrabl_qspi_transfer *transfers;
 
+	err = qspi_flash_idle(hqfdi, false);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
 	is_ext_reg_access_cmd = ((reg_access_cmd & (uint32_t) 0xFFFF00) == 0U) ?
 					false : true;
 
@@ -632,6 +673,11 @@ tegrabl_error_t qspi_write_en(
 
 	pr_trace("Doing WEN %s\n", benable ? "enable" : "disable");
 
+	err = qspi_flash_idle(hqfdi, false);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
 	transfers = hqfdi->transfers;
 	memset(transfers, 0, sizeof(struct tegrabl_qspi_transfer));
 	do {
@@ -1117,6 +1163,11 @@ static tegrabl_error_t qspi_bdev_erase(tegrabl_bdev_t *dev, bnum_t block,
 	chip_info = &hqfdi->chip_info;
 	device_info_flag = device_info_list[chip_info->device_list_index].flag;
 
+	error = qspi_flash_idle(hqfdi, true);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
 	if ((block == 0UL) && (count == chip_info->block_count) &&
 					((device_info_flag & FLAG_BULK) != 0U)) {
 		/* Erase whole device and return */
@@ -1356,17 +1407,284 @@ tegrabl_qspi_flash_write(
 	return TEGRABL_NO_ERROR;
 }
 
+#if defined(CONFIG_ENABLE_QSPI_FLASH_DIFF_WRITE)
+/**
+ * @brief Checks if programmed blocks may be programmed again to clear more
+ *        bits without an erase in between.
+ *
+ * @param hqfdi Qspi flash driver info
+ *
+ * @return true if reprogramming is allowed
+ */
+static bool qspi_flash_reprogram_allowed(
+		struct tegrabl_qspi_flash_driver_info *hqfdi)
+{
+	uint8_t manufacture_id =
+		device_info_list[hqfdi->chip_info.device_list_index].manufacture_id;
+
+	/* Spansion parts keep ECC per 16 byte unit, which is invalidated
+	 * when a unit is programmed twice */
+	return manufacture_id != MANUFACTURE_ID_SPANSION;
+}
+
+static bool qspi_flash_is_blank(const uint8_t *buf, uint32_t size)
+{
+	uint32_t i;
+
+	for (i = 0; i < size; i++) {
+		if (buf[i] != 0xFFU) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* true if new data needs only 1 -> 0 bit transitions over current data */
+static bool qspi_flash_is_programmable(const uint8_t *cur, const uint8_t *src,
+		uint32_t size)
+{
+	uint32_t i;
+
+	for (i = 0; i < size; i++) {
+		if ((src[i] & (uint8_t)~cur[i]) != 0U) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Writes blocks sector by sector, comparing with the flash contents
+ *        first. Unchanged blocks are not programmed and a sector is erased
+ *        only if some block needs a 0 -> 1 bit transition.
+ *
+ * @param dev Qspi flash block device
+ * @param buf Source buffer
+ * @param block Start block
+ * @param count Number of blocks
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error
+ */
+static tegrabl_error_t qspi_flash_diff_write(tegrabl_bdev_t *dev,
+		const uint8_t *buf, bnum_t block, bnum_t count)
+{
+	struct tegrabl_qspi_flash_driver_info *hqfdi = dev->priv_data;
+	struct tegrabl_qspi_flash_chip_info *chip_info = &hqfdi->chip_info;
+	uint32_t block_size_log2 = chip_info->block_size_log2;
+	uint32_t block_size = 1UL << block_size_log2;
+	bnum_t sector_blocks;
+	bnum_t chunk;
+	bnum_t i;
+	bnum_t run;
+	bool reprogram;
+	bool need_erase;
+	bool programmed;
+	bool *dirty = NULL;
+	uint8_t *cur = NULL;
+	const uint8_t *src;
+	uint32_t num_sectors = 0;
+	uint32_t num_skipped = 0;
+	uint32_t num_erased = 0;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	sector_blocks = 1UL << (chip_info->sector_size_log2 - block_size_log2);
+	reprogram = qspi_flash_reprogram_allowed(hqfdi);
+
+	cur = tegrabl_alloc_align(TEGRABL_HEAP_DMA, TEGRABL_QSPI_BUF_ALIGN_SIZE,
+							  sector_blocks << block_size_log2);
+	dirty = tegrabl_malloc(sector_blocks * sizeof(*dirty));
+	if ((cur == NULL) || (dirty == NULL)) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, AUX_INFO_NO_MEMORY_5);
+		goto fail;
+	}
+
+	while (count != 0U) {
+		chunk = sector_blocks - (block & (sector_blocks - 1U));
+		chunk = MIN(chunk, count);
+
+		err = tegrabl_qspi_flash_read(hqfdi, block, chunk, cur, false);
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+
+		need_erase = false;
+		for (i = 0; i < chunk; i++) {
+			src = buf + (i << block_size_log2);
+			dirty[i] = (memcmp(src, cur + (i << block_size_log2), block_size) != 0);
+			if (!dirty[i] || need_erase) {
+				continue;
+			}
+			if (qspi_flash_is_blank(cur + (i << block_size_log2), block_size)) {
+				continue;
+			}
+			if (!reprogram || !qspi_flash_is_programmable(
+					cur + (i << block_size_log2), src, block_size)) {
+				need_erase = true;
+			}
+		}
+
+		if (need_erase) {
+			err = qspi_bdev_erase(dev, block, chunk, false);
+			if (err != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+			/* erased blocks need programming only where data is not blank */
+			for (i = 0; i < chunk; i++) {
+				dirty[i] = !qspi_flash_is_blank(buf + (i << block_size_log2),
+												block_size);
+			}
+			num_erased++;
+		}
+
+		programmed = false;
+		i = 0;
+		while (i < chunk) {
+			if (!dirty[i]) {
+				i++;
+				continue;
+			}
+			run = 1;
+			while (((i + run) < chunk) && dirty[i + run]) {
+				run++;
+			}
+			err = tegrabl_qspi_flash_write(hqfdi, block + i, run,
+					(uint8_t *)buf + (i << block_size_log2));
+			if (err != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+			programmed = true;
+			i += run;
+		}
+
+		if (!need_erase && !programmed) {
+			num_skipped++;
+		}
+
+		num_sectors++;
+		block += chunk;
+		count -= chunk;
+		buf += chunk << block_size_log2;
+	}
+
+	pr_debug("QSPI: diff write of %u sectors, %u unchanged, %u erased\n",
+			 num_sectors, num_skipped, num_erased);
+
+fail:
+	if (dirty != NULL) {
+		tegrabl_free(dirty);
+	}
+	if (cur != NULL) {
+		tegrabl_free(cur);
+	}
+
+	return err;
+}
+
+/**
+ * @brief Erases blocks skipping sectors which are already blank.
+ *
+ * @param dev Qspi flash block device
+ * @param block Start block
+ * @param count Number of blocks
+ * @param is_secure secure erase
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error
+ */
+static tegrabl_error_t qspi_bdev_erase_dirty(tegrabl_bdev_t *dev, bnum_t block,
+	bnum_t count, bool is_secure)
+{
+	struct tegrabl_qspi_flash_driver_info *hqfdi;
+	struct tegrabl_qspi_flash_chip_info *chip_info;
+	uint32_t block_size_log2;
+	bnum_t sector_blocks;
+	bnum_t chunk;
+	bnum_t run_start = 0;
+	bnum_t run_count = 0;
+	uint8_t *cur = NULL;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if ((dev == NULL) || (count == 0U) || (dev->priv_data == NULL)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, AUX_INFO_INVALID_PARAMS6);
+	}
+
+	hqfdi = dev->priv_data;
+	chip_info = &hqfdi->chip_info;
+	block_size_log2 = chip_info->block_size_log2;
+
+	/* whole device goes through bulk erase */
+	if ((block == 0UL) && (count == chip_info->block_count)) {
+		return qspi_bdev_erase(dev, block, count, is_secure);
+	}
+
+	sector_blocks = 1UL << (chip_info->sector_size_log2 - block_size_log2);
+	cur = tegrabl_alloc_align(TEGRABL_HEAP_DMA, TEGRABL_QSPI_BUF_ALIGN_SIZE,
+							  sector_blocks << block_size_log2);
+	if (cur == NULL) {
+		return qspi_bdev_erase(dev, block, count, is_secure);
+	}
+
+	while (count != 0U) {
+		chunk = sector_blocks - (block & (sector_blocks - 1U));
+		chunk = MIN(chunk, count);
+
+		err = tegrabl_qspi_flash_read(hqfdi, block, chunk, cur, false);
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+
+		if (!qspi_flash_is_blank(cur, chunk << block_size_log2)) {
+			if (run_count == 0U) {
+				run_start = block;
+			}
+			run_count += chunk;
+		} else if (run_count != 0U) {
+			err = qspi_bdev_erase(dev, run_start, run_count, is_secure);
+			if (err != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+			run_count = 0;
+		} else {
+			pr_trace("QSPI: block %u-%u already blank\n", block, block + chunk - 1U);
+		}
+
+		block += chunk;
+		count -= chunk;
+	}
+
+	if (run_count != 0U) {
+		err = qspi_bdev_erase(dev, run_start, run_count, is_secure);
+	}
+
+fail:
+	tegrabl_free(cur);
+
+	return err;
+}
+#endif
+
 static tegrabl_error_t qspi_bdev_write_block(tegrabl_bdev_t *dev,
 		const void *buf, bnum_t block, bnum_t count)
 {
 	struct tegrabl_qspi_flash_driver_info *hqfdi;
+	tegrabl_error_t err;
 
 	if ((dev == NULL) || (dev->priv_data == NULL) || (buf == NULL)) {
 		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 3);
 	}
 
 	hqfdi = dev->priv_data;
+	err = qspi_flash_idle(hqfdi, true);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
+#if defined(CONFIG_ENABLE_QSPI_FLASH_DIFF_WRITE)
+	return qspi_flash_diff_write(dev, (const uint8_t *)buf, block, count);
+#else
 	return tegrabl_qspi_flash_write(hqfdi, block, count, (uint8_t *)buf);
+#endif
 }
 #endif
 
@@ -1391,6 +1709,11 @@ static tegrabl_error_t tegrabl_qspi_blockdev_xfer(struct tegrabl_blockdev_xfer_i
 	count = xfer->block_count;
 	hqfdi = dev->priv_data;
 
+#if defined(CONFIG_ENABLE_QSPI_FLASH_PREFETCH)
+	/* caller's transfer owns the controller until its xfer_wait */
+	qspi_flash_prefetch_wait(hqfdi);
+#endif
+
 	if (count != 0U) {
 		err = tegrabl_qspi_flash_read(hqfdi, block, count, (uint8_t *)buf, true);
 	}
@@ -1426,6 +1749,74 @@ static tegrabl_error_t tegrabl_qspi_blockdev_xfer_wait(struct tegrabl_blockdev_x
 }
 #endif
 
+#if defined(CONFIG_ENABLE_QSPI_FLASH_CONT_READ)
+/**
+ * @brief Checks if the flash can stay in continuous (XIP) read mode
+ *        between reads, which saves the opcode phase of every read.
+ *
+ * @param hqfdi Qspi flash driver info
+ *
+ * @return true if continuous read can be used
+ */
+static bool qspi_flash_cont_read_supported(
+		struct tegrabl_qspi_flash_driver_info *hqfdi)
+{
+	uint8_t manufacture_id;
+
+	if (hqfdi->plat_params.max_bus_width != QSPI_BUS_WIDTH_X4) {
+		return false;
+	}
+
+	manufacture_id =
+		device_info_list[hqfdi->chip_info.device_list_index].manufacture_id;
+
+	return (manufacture_id == MANUFACTURE_ID_SPANSION) ||
+		(manufacture_id == MANUFACTURE_ID_MACRONIX);
+}
+
+/**
+ * @brief Takes the flash out of continuous read mode by clocking all ones
+ *        over address and mode bits phase (mode bit reset). Harmless if
+ *        the flash is not in continuous read mode.
+ *
+ * @param hqfdi Qspi flash driver info
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error
+ */
+static tegrabl_error_t qspi_flash_cont_read_exit(
+		struct tegrabl_qspi_flash_driver_info *hqfdi)
+{
+	struct tegrabl_qspi_transfer *transfers = hqfdi->transfers;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if (hqfdi->plat_params.max_bus_width != QSPI_BUS_WIDTH_X4) {
+		hqfdi->cont_read_active = false;
+		return TEGRABL_NO_ERROR;
+	}
+
+	memset(hqfdi->address_data, 0xFF, QSPI_ADDR_LENGTH);
+	memset(transfers, 0, sizeof(struct tegrabl_qspi_transfer));
+
+	/* address length is not known before device id is read, use max */
+	transfers[0].tx_buf = hqfdi->address_data;
+	transfers[0].write_len = QSPI_ADDR_LENGTH;
+	transfers[0].mode = QSPI_FLASH_ADDR_DATA_MODE_VAL;
+	transfers[0].bus_width = QSPI_BUS_WIDTH_X4;
+	transfers[0].dummy_cycles = ZERO_CYCLES;
+	transfers[0].op_mode = SDR_MODE;
+
+	hqfdi->hqspi->is_async = false;
+	err = tegrabl_qspi_transaction(hqfdi->hqspi, &transfers[0], 1,
+								   QSPI_XFER_TIMEOUT);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("QSPI: continuous read exit failed (err:0x%x)\n", err);
+	}
+
+	hqfdi->cont_read_active = false;
+	return err;
+}
+#endif
+
 /**
  * @brief Initiate the reading of multiple pages of data into buffer.
  *
@@ -1451,11 +1842,23 @@ tegrabl_qspi_flash_read(
 	uint32_t address;
 	uint8_t *p_destination = (uint8_t *)p_dest;
 	uint8_t *cmd = hqfdi->cmd;
+	uint8_t mode_bits = QSPI_FLASH_MODE_BITS_NONE;
+	uint32_t first_xfer = 0;
 
 	if (num_of_pages == 0U) {
 		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
 	}
 
+#if defined(CONFIG_ENABLE_QSPI_FLASH_CONT_READ)
+	if (qspi_flash_cont_read_supported(hqfdi)) {
+		mode_bits = QSPI_FLASH_CONT_READ_MODE_BITS;
+		/* flash already latched the opcode, start from address phase */
+		if (hqfdi->cont_read_active) {
+			first_xfer = 1;
+		}
+	}
+#endif
+
 	transfers = hqfdi->transfers;
 	memset(transfers, 0, sizeof(struct tegrabl_qspi_transfer));
 
@@ -1492,13 +1895,12 @@ tegrabl_qspi_flash_read(
 		hqfdi->address_data[1] = (uint8_t)(address >> 16) & 0xFFU;
 		hqfdi->address_data[2] = (uint8_t)(address >> 8) & 0xFFU;
 		hqfdi->address_data[3] = (uint8_t)(address) & 0xFFU;
-		hqfdi->address_data[4] = 0; /* mode bits */
 	} else {
 		hqfdi->address_data[0] = (uint8_t)(address >> 16) & 0xFFU;
 		hqfdi->address_data[1] = (uint8_t)(address >> 8) & 0xFFU;
 		hqfdi->address_data[2] = (uint8_t)(address) & 0xFFU;
-		hqfdi->address_data[3] = 0; /* mode bits */
 	}
+	hqfdi->address_data[chip_info->address_length] = mode_bits;
 
 	/* Make sure the Dest is 4-byte aligned */
 	if (((uintptr_t)p_dest & 0x3UL) != 0UL) {
@@ -1576,15 +1978,209 @@ tegrabl_qspi_flash_read(
 		hqfdi->hqspi->is_async = false;
 	}
 
-	err = tegrabl_qspi_transaction(hqfdi->hqspi, &transfers[0], QSPI_FLASH_NUM_OF_TRANSFERS,
-											QSPI_XFER_TIMEOUT);
+	err = tegrabl_qspi_transaction(hqfdi->hqspi, &transfers[first_xfer],
+								   QSPI_FLASH_NUM_OF_TRANSFERS - first_xfer,
+								   QSPI_XFER_TIMEOUT);
 	if (err != TEGRABL_NO_ERROR) {
 		pr_error("error in qspi transactions\n");
 	}
 
+#if defined(CONFIG_ENABLE_QSPI_FLASH_CONT_READ)
+	if (mode_bits == QSPI_FLASH_CONT_READ_MODE_BITS) {
+		if (err == TEGRABL_NO_ERROR) {
+			hqfdi->cont_read_active = true;
+		} else {
+			/* state of the flash is unknown, force it back to command mode */
+			(void)qspi_flash_cont_read_exit(hqfdi);
+		}
+	}
+#endif
+
+	return err;
+}
+
+#if defined(CONFIG_ENABLE_QSPI_FLASH_PREFETCH)
+/**
+ * @brief Completes the read-ahead in flight, if any. A failed read-ahead
+ *        only drops the window, the data is read again on demand.
+ *
+ * @param hqfdi Qspi flash driver info
+ */
+static void qspi_flash_prefetch_wait(
+		struct tegrabl_qspi_flash_driver_info *hqfdi)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if (hqfdi->prefetch_state != QSPI_FLASH_PREFETCH_IN_FLIGHT) {
+		return;
+	}
+
+	/* short reads complete in PIO mode before the transaction returns */
+	if (hqfdi->hqspi->xfer_is_progress) {
+		err = tegrabl_qspi_xfer_wait(hqfdi->hqspi, QSPI_XFER_TIMEOUT, true);
+	}
+	hqfdi->hqspi->is_async = false;
+	if (err != TEGRABL_NO_ERROR) {
+		pr_warn("QSPI: read-ahead of block %u failed (err:0x%x)\n",
+				hqfdi->prefetch_block, err);
+		hqfdi->prefetch_state = QSPI_FLASH_PREFETCH_IDLE;
+		return;
+	}
+
+	hqfdi->prefetch_state = QSPI_FLASH_PREFETCH_VALID;
+}
+
+/**
+ * @brief Starts an asynchronous read of the window following a sequential
+ *        read, so the controller streams while the caller consumes data.
+ *
+ * @param hqfdi Qspi flash driver info
+ * @param block First block of the window
+ */
+static void qspi_flash_prefetch_start(
+		struct tegrabl_qspi_flash_driver_info *hqfdi, uint32_t block)
+{
+	struct tegrabl_qspi_flash_chip_info *chip_info = &hqfdi->chip_info;
+	uint32_t count;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if (block >= chip_info->block_count) {
+		return;
+	}
+
+	if (hqfdi->prefetch_buf == NULL) {
+		hqfdi->prefetch_buf = tegrabl_alloc_align(TEGRABL_HEAP_DMA,
+				TEGRABL_QSPI_BUF_ALIGN_SIZE, QSPI_FLASH_PREFETCH_SIZE);
+		if (hqfdi->prefetch_buf == NULL) {
+			pr_debug("QSPI: no memory for read-ahead, disabled\n");
+			return;
+		}
+	}
+
+	count = QSPI_FLASH_PREFETCH_SIZE >> chip_info->block_size_log2;
+	if (count > (chip_info->block_count - block)) {
+		count = chip_info->block_count - block;
+	}
+
+	err = tegrabl_qspi_flash_read(hqfdi, block, count, hqfdi->prefetch_buf, true);
+	if (err != TEGRABL_NO_ERROR) {
+		hqfdi->hqspi->is_async = false;
+		hqfdi->prefetch_state = QSPI_FLASH_PREFETCH_IDLE;
+		return;
+	}
+
+	pr_trace("QSPI: read-ahead %u blocks from %u\n", count, block);
+	hqfdi->prefetch_block = block;
+	hqfdi->prefetch_count = count;
+	hqfdi->prefetch_state = QSPI_FLASH_PREFETCH_IN_FLIGHT;
+}
+
+/**
+ * @brief Reads blocks, serving what it can from the read-ahead window and
+ *        starting the next read-ahead when the access pattern is sequential.
+ *
+ * @param hqfdi Qspi flash driver info
+ * @param block Start block
+ * @param count Number of blocks
+ * @param buf Destination buffer
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error
+ */
+static tegrabl_error_t qspi_flash_read_prefetch(
+		struct tegrabl_qspi_flash_driver_info *hqfdi, uint32_t block,
+		uint32_t count, uint8_t *buf)
+{
+	uint32_t block_size_log2 = hqfdi->chip_info.block_size_log2;
+	uint32_t window_end;
+	uint32_t hit;
+	bool is_sequential;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if (count == 0U) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+	}
+
+	is_sequential = (block == hqfdi->next_seq_block);
+	hqfdi->next_seq_block = block + count;
+
+	qspi_flash_prefetch_wait(hqfdi);
+
+	if (hqfdi->prefetch_state == QSPI_FLASH_PREFETCH_VALID) {
+		window_end = hqfdi->prefetch_block + hqfdi->prefetch_count;
+		if ((block >= hqfdi->prefetch_block) && (block < window_end)) {
+			hit = MIN(count, window_end - block);
+			memcpy(buf, hqfdi->prefetch_buf +
+				   ((block - hqfdi->prefetch_block) << block_size_log2),
+				   hit << block_size_log2);
+			if ((block + hit) == window_end) {
+				hqfdi->prefetch_state = QSPI_FLASH_PREFETCH_IDLE;
+			}
+			block += hit;
+			count -= hit;
+			buf += hit << block_size_log2;
+		}
+	}
+
+	if (count != 0U) {
+		err = tegrabl_qspi_flash_read(hqfdi, block, count, buf, false);
+		if (err != TEGRABL_NO_ERROR) {
+			return err;
+		}
+	}
+
+	if (is_sequential &&
+		(hqfdi->prefetch_state != QSPI_FLASH_PREFETCH_VALID)) {
+		qspi_flash_prefetch_start(hqfdi, hqfdi->next_seq_block);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+#endif
+
+/**
+ * @brief Brings the flash back to command mode: completes any read-ahead
+ *        in flight and exits continuous read.
+ *
+ * @param hqfdi Qspi flash driver info
+ * @param invalidate drop the read-ahead window, flash contents may change
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error
+ */
+static tegrabl_error_t qspi_flash_idle(
+		struct tegrabl_qspi_flash_driver_info *hqfdi, bool invalidate)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+#if defined(CONFIG_ENABLE_QSPI_FLASH_PREFETCH)
+	qspi_flash_prefetch_wait(hqfdi);
+	if (invalidate) {
+		hqfdi->prefetch_state = QSPI_FLASH_PREFETCH_IDLE;
+	}
+#else
+	TEGRABL_UNUSED(invalidate);
+#endif
+
+#if defined(CONFIG_ENABLE_QSPI_FLASH_CONT_READ)
+	if (hqfdi->cont_read_active) {
+		err = qspi_flash_cont_read_exit(hqfdi);
+	}
+#else
+	TEGRABL_UNUSED(hqfdi);
+#endif
+
 	return err;
 }
 
+tegrabl_error_t tegrabl_qspi_flash_quiesce(uint32_t instance)
+{
+	if ((instance >= QSPI_MAX_INSTANCE) ||
+		(qspi_flash_driver_info[instance] == NULL)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, AUX_INFO_INVALID_PARAMS);
+	}
+
+	return qspi_flash_idle(qspi_flash_driver_info[instance], true);
+}
+
 static tegrabl_error_t qspi_bdev_read_block(tegrabl_bdev_t *dev, void *buf,
 	bnum_t block, bnum_t count)
 {
@@ -1593,5 +2189,9 @@ static tegrabl_error_t qspi_bdev_read_block(tegrabl_bdev_t *dev, void *buf,
 		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
 	}
 	hqfdi = dev->priv_data;
+#if defined(CONFIG_ENABLE_QSPI_FLASH_PREFETCH)
+	return qspi_flash_read_prefetch(hqfdi, block, count, (uint8_t *)buf);
+#else
 	return tegrabl_qspi_flash_read(hqfdi, block, count, (uint8_t *)buf, false);
+#endif
 }
@@ -138,6 +138,17 @@ extern "C"
 #define FLAG_UNIFORM					0x40U
 #define FLAG_PAGE512_FIXED				0x80U
 
+/* Quad IO read mode bits, Axh keeps Spansion and Macronix in continuous
+ * read so the next read is sent without the opcode */
+#define QSPI_FLASH_CONT_READ_MODE_BITS		0xA5U
+#define QSPI_FLASH_MODE_BITS_NONE			0x00U
+
+/* Sequential read prefetch window */
+#define QSPI_FLASH_PREFETCH_SIZE			(64U * 1024U)
+#define QSPI_FLASH_PREFETCH_IDLE			0U
+#define QSPI_FLASH_PREFETCH_IN_FLIGHT		1U
+#define QSPI_FLASH_PREFETCH_VALID			2U
+
 /* QSPI Transfer timeout 5sec */
 #define QSPI_XFER_TIMEOUT 5000000U
 
@@ -161,6 +172,7 @@ extern "C"
 #define AUX_INFO_WEN_TIMEOUT 16
 #define AUX_INFO_FLAG_TIMEOUT 17 /* 0x11 */
 #define AUX_INFO_NOT_ALIGNED 18
+#define AUX_INFO_NO_MEMORY_5 19
 
 struct tegrabl_qspi_flash_chip_info {
 	uint32_t flash_size_log2;
@@ -184,6 +196,18 @@ struct tegrabl_qspi_flash_driver_info {
 	struct tegrabl_qspi_transfer *transfers;
 	uint8_t *address_data;
 	uint8_t *cmd;
+#if defined(CONFIG_ENABLE_QSPI_FLASH_CONT_READ)
+	/* flash latched continuous read mode bits, next read skips opcode */
+	bool cont_read_active;
+#endif
+#if defined(CONFIG_ENABLE_QSPI_FLASH_PREFETCH)
+	/* window read ahead asynchronously after sequential reads */
+	uint8_t *prefetch_buf;
+	uint32_t prefetch_block;
+	uint32_t prefetch_count;
+	uint32_t prefetch_state;
+	uint32_t next_seq_block;
+#endif
 };
 
 struct device_info {
@@ -20,7 +20,8 @@ MODULE_SRCS += \
 	$(LOCAL_DIR)/tegrabl_sdmmc_protocol.c \
 	$(LOCAL_DIR)/tegrabl_sdmmc_host.c \
 	$(LOCAL_DIR)/tegrabl_sdmmc_rpmb.c \
-	$(LOCAL_DIR)/tegrabl_sdmmc_protocol_rpmb.c
+	$(LOCAL_DIR)/tegrabl_sdmmc_protocol_rpmb.c \
+	$(LOCAL_DIR)/tegrabl_sdmmc_tuning.c
 
 MODULE_SRCS += \
 	$(LOCAL_DIR)/tegrabl_sd_bdev.c \
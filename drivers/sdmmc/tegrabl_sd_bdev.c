@@ -112,11 +112,84 @@ fail:
 	return error;
 }
 
+/* Time for the card supply to discharge before powering up again */
+#define TEGRABL_SD_POWER_OFF_DELAY_MS	10U
+
+static tegrabl_error_t sd_power_on(struct tegrabl_sd_platform_params *params)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	struct gpio_driver *gpio_drv;
+
+	if (params->vmmc_supply) {
+		error = tegrabl_regulator_enable(params->vmmc_supply);
+		if ((error != TEGRABL_NO_ERROR) && (TEGRABL_ERROR_REASON(error) != TEGRABL_ERR_NOT_SUPPORTED)) {
+			goto fail;
+		}
+
+		error = tegrabl_regulator_set_voltage(params->vmmc_supply, 3300000, STANDARD_VOLTS);
+		if ((error != TEGRABL_NO_ERROR) && (TEGRABL_ERROR_REASON(error) != TEGRABL_ERR_NOT_SUPPORTED)) {
+			goto fail;
+		}
+		error = TEGRABL_NO_ERROR;
+	} else if (params->en_vdd_sd_gpio) {
+		error = tegrabl_gpio_driver_get(TEGRA_GPIO_MAIN_CHIPID, &gpio_drv);
+		if (error != TEGRABL_NO_ERROR)
+			goto fail;
+
+		error = gpio_config(gpio_drv, params->en_vdd_sd_gpio, GPIO_PINMODE_OUTPUT);
+		if (error != TEGRABL_NO_ERROR)
+			goto fail;
+
+		error = gpio_write(gpio_drv, params->en_vdd_sd_gpio, GPIO_PIN_STATE_HIGH);
+		if (error != TEGRABL_NO_ERROR)
+			goto fail;
+	}
+
+	/* Card always starts with 3.3V signaling */
+	if (params->vqmmc_supply) {
+		error = tegrabl_regulator_set_voltage(params->vqmmc_supply,
+											  SD_SIGNALING_VOLTAGE_3V3, STANDARD_VOLTS);
+		if ((error != TEGRABL_NO_ERROR) && (TEGRABL_ERROR_REASON(error) != TEGRABL_ERR_NOT_SUPPORTED)) {
+			goto fail;
+		}
+		error = TEGRABL_NO_ERROR;
+	}
+
+fail:
+	return error;
+}
+
+static tegrabl_error_t sd_power_off(struct tegrabl_sd_platform_params *params)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	struct gpio_driver *gpio_drv;
+
+	if (params->vmmc_supply) {
+		error = tegrabl_regulator_disable(params->vmmc_supply);
+		if ((error != TEGRABL_NO_ERROR) && (TEGRABL_ERROR_REASON(error) != TEGRABL_ERR_NOT_SUPPORTED)) {
+			goto fail;
+		}
+		error = TEGRABL_NO_ERROR;
+	} else if (params->en_vdd_sd_gpio) {
+		error = tegrabl_gpio_driver_get(TEGRA_GPIO_MAIN_CHIPID, &gpio_drv);
+		if (error != TEGRABL_NO_ERROR)
+			goto fail;
+
+		error = gpio_write(gpio_drv, params->en_vdd_sd_gpio, GPIO_PIN_STATE_LOW);
+		if (error != TEGRABL_NO_ERROR)
+			goto fail;
+	}
+
+	tegrabl_mdelay(TEGRABL_SD_POWER_OFF_DELAY_MS);
+
+fail:
+	return error;
+}
+
 tegrabl_error_t sd_bdev_open(uint32_t instance, struct tegrabl_sd_platform_params *params)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
 	struct tegrabl_sdmmc *hsdmmc = NULL;
-	struct gpio_driver *gpio_drv;
 
 	if (instance >= MAX_SDMMC_INSTANCES) {
 		error = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 6);
@@ -146,34 +219,29 @@ tegrabl_error_t sd_bdev_open(uint32_t instance, struct tegrabl_sd_platform_param
 	hsdmmc->tap_value = 9;
 	hsdmmc->trim_value = 5;
 
+	hsdmmc->vqmmc_supply = params->vqmmc_supply;
+
+	error = sd_power_on(params);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
 	/* Call sdmmc_init to proceed with initialization. */
 	pr_trace("sdmmc init\n");
-
-	if (params->vmmc_supply) {
-		error = tegrabl_regulator_enable(params->vmmc_supply);
-		if ((error != TEGRABL_NO_ERROR) && (TEGRABL_ERROR_REASON(error) != TEGRABL_ERR_NOT_SUPPORTED)) {
+	error = sdmmc_init(hsdmmc->controller_id, hsdmmc, false);
+	if ((error != TEGRABL_NO_ERROR) && hsdmmc->disable_uhs) {
+		/* Failed 1.8V switch leaves the card unusable until power cycled */
+		pr_warn("sd card power cycle, retry without UHS-I\n");
+		error = sd_power_off(params);
+		if (error != TEGRABL_NO_ERROR) {
 			goto fail;
 		}
-
-		error = tegrabl_regulator_set_voltage(params->vmmc_supply, 3300000, STANDARD_VOLTS);
-		if ((error != TEGRABL_NO_ERROR) && (TEGRABL_ERROR_REASON(error) != TEGRABL_ERR_NOT_SUPPORTED)) {
+		error = sd_power_on(params);
+		if (error != TEGRABL_NO_ERROR) {
 			goto fail;
 		}
-	} else if (params->en_vdd_sd_gpio) {
-		error = tegrabl_gpio_driver_get(TEGRA_GPIO_MAIN_CHIPID, &gpio_drv);
-		if (error != TEGRABL_NO_ERROR)
-			goto fail;
-
-		error = gpio_config(gpio_drv, params->en_vdd_sd_gpio, GPIO_PINMODE_OUTPUT);
-		if (error != TEGRABL_NO_ERROR)
-			goto fail;
-
-		error = gpio_write(gpio_drv, params->en_vdd_sd_gpio, GPIO_PIN_STATE_HIGH);
-		if (error != TEGRABL_NO_ERROR)
-			goto fail;
+		error = sdmmc_init(hsdmmc->controller_id, hsdmmc, false);
 	}
-
-	error = sdmmc_init(hsdmmc->controller_id, hsdmmc, false);
 	if (error != TEGRABL_NO_ERROR) {
 		goto fail;
 	}
@@ -125,6 +125,16 @@ found:
 		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID_CONFIG, 0);
 	}
 
+	/* optional, needed for UHS-I 1.8V signaling */
+	data = fdt_getprop(fdt, offset, "vqmmc-supply", NULL);
+	if (data != NULL) {
+		params->vqmmc_supply = fdt32_to_cpu(*data);
+		pr_trace("vqmmc-supply 0x%x\n", params->vqmmc_supply);
+	} else {
+		params->vqmmc_supply = 0;
+		pr_debug("no vqmmc-supply, UHS-I disabled\n");
+	}
+
 fail:
 	return err;
 }
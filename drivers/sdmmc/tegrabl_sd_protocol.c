@@ -19,6 +19,168 @@
 #include <tegrabl_sd_protocol.h>
 #include <tegrabl_sdmmc_protocol.h>
 #include <tegrabl_sdmmc_host.h>
+#include <tegrabl_module.h>
+#include <tegrabl_dmamap.h>
+#include <tegrabl_timer.h>
+#include <tegrabl_utils.h>
+
+/* UHS-I fallback ladder, fastest first. SDR12 always works once at 1.8V. */
+static const struct sd_uhs_mode {
+	uint32_t access_mode;
+	uint32_t rate;
+	uint32_t clk_divider;
+	bool needs_tuning;
+	const char *name;
+} sd_uhs_modes[] = {
+	{ SD_ACCESS_MODE_SDR104, CLK_204_MHZ, 0, true, "SDR104" },
+	{ SD_ACCESS_MODE_SDR50, CLK_100_MHZ, 0, true, "SDR50" },
+	{ SD_ACCESS_MODE_SDR25, CLK_102_MHZ, 1, false, "SDR25" },
+	{ SD_ACCESS_MODE_SDR12, CLK_102_MHZ, 2, false, "SDR12" },
+};
+
+/** @brief Sends CMD11 and moves the bus to 1.8V signaling.
+ *
+ *  @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ *  @return TEGRABL_NO_ERROR if the card is at 1.8V signaling.
+ */
+static tegrabl_error_t sd_voltage_switch(struct tegrabl_sdmmc *hsdmmc)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	pr_trace("Send command 11\n");
+	err = sdmmc_send_command(SD_CMD_VOLTAGE_SWITCH, 0, RESP_TYPE_R1, 0, hsdmmc);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("Sending cmd 11 failed\n");
+		goto fail;
+	}
+
+	err = sdmmc_switch_signaling_1v8(hsdmmc);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	hsdmmc->is_uhs_signaling = true;
+
+fail:
+	return err;
+}
+
+/** @brief Sends CMD6 and reads back the 64 byte switch status.
+ *
+ *  @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ *  @param arg CMD6 argument (mode and function per group).
+ *  @param status Returns the switch status block.
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+static tegrabl_error_t sd_switch_func(struct tegrabl_sdmmc *hsdmmc,
+	uint32_t arg, uint8_t **status)
+{
+	sdmmc_device_status dev_status;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint8_t *buf = hsdmmc->ext_csd_buffer_address;
+	dma_addr_t dma_addr;
+
+	sdmmc_set_num_blocks(SD_SDHC_SWITCH_BLOCK_SIZE, 1, hsdmmc);
+
+	dma_addr = tegrabl_dma_map_buffer(TEGRABL_MODULE_SDMMC,
+									  (uint8_t)(hsdmmc->controller_id), buf,
+									  SD_SDHC_SWITCH_BLOCK_SIZE,
+									  TEGRABL_DMA_FROM_DEVICE);
+	sdmmc_setup_dma(dma_addr, hsdmmc);
+
+	err = sdmmc_send_command(SD_CMD_SWITCH_FUNC, arg, RESP_TYPE_R1, 1, hsdmmc);
+	if (err != TEGRABL_NO_ERROR) {
+		goto unmap;
+	}
+
+	hsdmmc->device_status = DEVICE_STATUS_IO_PROGRESS;
+	hsdmmc->read_start_time = tegrabl_get_timestamp_ms();
+	do {
+		dev_status = sdmmc_query_status(hsdmmc);
+	} while (dev_status == DEVICE_STATUS_IO_PROGRESS);
+
+	if (dev_status != DEVICE_STATUS_IDLE) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_BUSY, 0);
+	}
+
+unmap:
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SDMMC,
+							 (uint8_t)(hsdmmc->controller_id), buf,
+							 SD_SDHC_SWITCH_BLOCK_SIZE,
+							 TEGRABL_DMA_FROM_DEVICE);
+	*status = buf;
+	return err;
+}
+
+tegrabl_error_t sd_select_uhs_mode(struct tegrabl_sdmmc *hsdmmc)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	const struct sd_uhs_mode *mode;
+	uint32_t host_caps;
+	uint32_t card_caps;
+	uint32_t i;
+	uint8_t *status;
+
+	host_caps = sdmmc_get_uhs_caps(hsdmmc);
+
+	/* Query the group 1 functions without changing anything. */
+	err = sd_switch_func(hsdmmc, SD_SWITCH_CHECK_MODE |
+						 SD_SWITCH_KEEP_OTHER_GROUPS | SD_SWITCH_GRP1_RESULT_MASK,
+						 &status);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("sd switch function query failed\n");
+		goto fail;
+	}
+	card_caps = ((uint32_t)status[SD_SWITCH_GRP1_SUPPORT_OFFSET] << 8) |
+				status[SD_SWITCH_GRP1_SUPPORT_OFFSET + 1U];
+	pr_debug("sd uhs modes host 0x%x card 0x%x\n", host_caps, card_caps);
+
+	for (i = 0; i < ARRAY_SIZE(sd_uhs_modes); i++) {
+		mode = &sd_uhs_modes[i];
+		if ((host_caps & card_caps & (1UL << mode->access_mode)) == 0U) {
+			continue;
+		}
+
+		err = sd_switch_func(hsdmmc, SD_SWITCH_SET_MODE |
+							 SD_SWITCH_KEEP_OTHER_GROUPS | mode->access_mode,
+							 &status);
+		if (err != TEGRABL_NO_ERROR) {
+			continue;
+		}
+		if ((status[SD_SWITCH_GRP1_RESULT_OFFSET] & SD_SWITCH_GRP1_RESULT_MASK) !=
+			mode->access_mode) {
+			continue;
+		}
+
+		err = sdmmc_set_uhs_mode(hsdmmc, mode->access_mode, mode->rate,
+								 mode->clk_divider);
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+
+		if (mode->needs_tuning) {
+			err = sdmmc_execute_tuning(hsdmmc);
+			if (err != TEGRABL_NO_ERROR) {
+				pr_warn("sd %s tuning failed, trying next mode\n", mode->name);
+				continue;
+			}
+		} else {
+			sdmmc_set_tap_trim(hsdmmc);
+		}
+
+		hsdmmc->uhs_access_mode = mode->access_mode;
+		pr_info("sdmmc UHS-I %s mode\n", mode->name);
+		goto fail;
+	}
+
+	err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 3);
+	pr_error("no usable sd uhs mode\n");
+
+fail:
+	return err;
+}
 
 
 /** @brief Initializes the card by following SDMMC protocol.
@@ -32,8 +194,15 @@ tegrabl_error_t sd_identify_card(struct tegrabl_sdmmc *hsdmmc)
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	uint32_t cmd_arg;
 	uint32_t ocr_reg;
+	uint32_t uhs_caps = 0;
 	uint32_t *sdmmc_response = &(hsdmmc->response[0]);
 
+	hsdmmc->is_uhs_signaling = false;
+	hsdmmc->uhs_access_mode = SD_ACCESS_MODE_SDR12;
+	if (hsdmmc->disable_uhs == false) {
+		uhs_caps = sdmmc_get_uhs_caps(hsdmmc);
+	}
+
 	/* Check if card is present and stable. */
 	pr_trace("Check card present and stable\n");
 	if (sdmmc_is_card_present(hsdmmc))
@@ -65,6 +234,9 @@ tegrabl_error_t sd_identify_card(struct tegrabl_sdmmc *hsdmmc)
 	}
 
 	ocr_reg = SD_CARD_OCR_VALUE | CARD_CAPACITY_MASK;
+	if (uhs_caps != 0U) {
+		ocr_reg |= SD_CARD_OCR_S18R;
+	}
 	err = sdmmc_send_command(SD_ACMD_SEND_OP_COND, ocr_reg,
 				 RESP_TYPE_R3, 0, hsdmmc);
 	if (err != TEGRABL_NO_ERROR) {
@@ -83,6 +255,18 @@ tegrabl_error_t sd_identify_card(struct tegrabl_sdmmc *hsdmmc)
 		hsdmmc->is_high_capacity_card = true;
 	}
 
+	/* S18A is only valid for high capacity cards */
+	if ((uhs_caps != 0U) && (hsdmmc->is_high_capacity_card != 0U) &&
+		((ocr_reg & SD_CARD_OCR_S18A) != 0U)) {
+		err = sd_voltage_switch(hsdmmc);
+		if (err != TEGRABL_NO_ERROR) {
+			/* Card is stuck mid-switch, it needs a power cycle. */
+			pr_warn("sd voltage switch failed, disabling UHS-I\n");
+			hsdmmc->disable_uhs = true;
+			goto fail;
+		}
+	}
+
 	/* Request for all the available cids. */
 	err = sdmmc_send_command(CMD_ALL_SEND_CID, 0, RESP_TYPE_R2, 0, hsdmmc);
 	if (err != TEGRABL_NO_ERROR) {
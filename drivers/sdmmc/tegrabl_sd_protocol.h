@@ -23,6 +23,16 @@
 */
 tegrabl_error_t sd_identify_card(struct tegrabl_sdmmc *hsdmmc);
 
+/**
+* @brief Negotiates the fastest UHS-I access mode supported by both the card
+*        and the host, falling back SDR104 -> SDR50 -> SDR25 -> SDR12
+*
+* @param hsdmmc context of the sdmmc controller, card at 1.8V signaling
+*
+* @return If success returns TEGRABL_NO_ERROR, otherwise error code
+*/
+tegrabl_error_t sd_select_uhs_mode(struct tegrabl_sdmmc *hsdmmc);
+
 tegrabl_error_t sd_erase(tegrabl_bdev_t *dev, bnum_t block, bnum_t count,
 	struct tegrabl_sdmmc *hsdmmc, sdmmc_device device);
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2019, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -35,6 +35,9 @@
  */
 static struct tegrabl_sdmmc *contexts[MAX_SDMMC_INSTANCES];
 
+/* Contexts whose init was begun by sdmmc_bdev_open_start() */
+static struct tegrabl_sdmmc *pending[MAX_SDMMC_INSTANCES];
+
 tegrabl_error_t sdmmc_bdev_ioctl(tegrabl_bdev_t *dev, uint32_t ioctl,
 	void *args)
 {
@@ -44,9 +47,6 @@ tegrabl_error_t sdmmc_bdev_ioctl(tegrabl_bdev_t *dev, uint32_t ioctl,
 #if defined(CONFIG_ENABLE_SDMMC_RPMB)
 	uint32_t counter = 0;
 	sdmmc_rpmb_context_t *rpmb_context = NULL;
-#else
-	TEGRABL_UNUSED(args);
-	TEGRABL_UNUSED(dev);
 #endif
 
 	switch (ioctl) {
@@ -55,6 +55,11 @@ tegrabl_error_t sdmmc_bdev_ioctl(tegrabl_bdev_t *dev, uint32_t ioctl,
 		break;
 	case TEGRABL_IOCTL_DEVICE_CACHE_FLUSH:
 		break;
+	case TEGRABL_IOCTL_ERASE_READS_ZERO:
+		/* Both erase and trim leave the contents given by ERASED_MEM_CONT */
+		*(bool *)args =
+			(((struct tegrabl_sdmmc *)priv_data->context)->erased_mem_cont == 0U);
+		break;
 #if defined(CONFIG_ENABLE_SDMMC_RPMB)
 	case TEGRABL_IOCTL_PROTECTED_BLOCK_KEY:
 		error = sdmmc_rpmb_program_key(dev, args, (struct tegrabl_sdmmc *)priv_data->context);
@@ -404,6 +409,7 @@ tegrabl_error_t sdmmc_bdev_open(uint32_t instance, struct tegrabl_sdmmc_platform
 	pr_trace("dqs_trim_hs400 = %d\n", params->dqs_trim_hs400);
 	pr_trace("enable_strobe_hs400 = %d\n", params->enable_strobe_hs400);
 	pr_trace("is_skip_init = %d\n", params->is_skip_init);
+	pr_trace("tuning_record = %p\n", params->tuning_record);
 
 	hsdmmc = contexts[instance];
 	if (params->is_skip_init) {
@@ -411,7 +417,11 @@ tegrabl_error_t sdmmc_bdev_open(uint32_t instance, struct tegrabl_sdmmc_platform
 	}
 
 	/* Check if the handle is NULL or not. */
-	if (hsdmmc != NULL) {
+	if (pending[instance] != NULL) {
+		/* Finish the init begun by sdmmc_bdev_open_start(). */
+		hsdmmc = pending[instance];
+		pending[instance] = NULL;
+	} else if (hsdmmc != NULL) {
 		if (hsdmmc->clk_src == params->clk_src &&
 			hsdmmc->best_mode == params->best_mode &&
 			hsdmmc->tap_value == params->tap_value &&
@@ -441,11 +451,15 @@ tegrabl_error_t sdmmc_bdev_open(uint32_t instance, struct tegrabl_sdmmc_platform
 	hsdmmc->best_mode = params->best_mode;
 	hsdmmc->tap_value = params->tap_value;
 	hsdmmc->trim_value = params->trim_value;
+	hsdmmc->tuning_record = params->tuning_record;
 
 	/* Call sdmmc_init to proceed with initialization. */
 	pr_debug("sdmmc init\n");
 
 	error = sdmmc_init(hsdmmc->controller_id, hsdmmc, flag);
+	/* Record is owned by the caller and only consulted during init. */
+	hsdmmc->tuning_record = NULL;
+	hsdmmc->use_tuning_record = false;
 	if (error != TEGRABL_NO_ERROR) {
 		goto fail;
 	}
@@ -469,6 +483,74 @@ fail:
 	return error;
 }
 
+tegrabl_error_t sdmmc_bdev_open_start(uint32_t instance,
+	struct tegrabl_sdmmc_platform_params *params)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	struct tegrabl_sdmmc *hsdmmc = NULL;
+
+	if ((params == NULL) || (params->is_skip_init)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 48);
+		goto fail;
+	}
+
+	if (instance >= MAX_SDMMC_INSTANCES) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 7);
+		goto fail;
+	}
+
+	if ((contexts[instance] != NULL) || (pending[instance] != NULL)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID_STATE, 0);
+		goto fail;
+	}
+
+	hsdmmc = tegrabl_alloc(TEGRABL_HEAP_DMA, sizeof(struct tegrabl_sdmmc));
+	if (hsdmmc == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 7);
+		goto fail;
+	}
+	memset(hsdmmc, 0x0, sizeof(struct tegrabl_sdmmc));
+
+	hsdmmc->clk_src = params->clk_src;
+	hsdmmc->controller_id = instance;
+	hsdmmc->best_mode = params->best_mode;
+	hsdmmc->tap_value = params->tap_value;
+	hsdmmc->trim_value = params->trim_value;
+	hsdmmc->tuning_record = params->tuning_record;
+
+	pr_debug("sdmmc init start\n");
+	error = sdmmc_init_start(instance, hsdmmc);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	pending[instance] = hsdmmc;
+
+fail:
+	if ((error != TEGRABL_NO_ERROR) && (hsdmmc != NULL)) {
+		tegrabl_dealloc(TEGRABL_HEAP_DMA, hsdmmc);
+	}
+
+	return error;
+}
+
+tegrabl_error_t sdmmc_bdev_open_poll(uint32_t instance, bool *ready)
+{
+	if ((instance >= MAX_SDMMC_INSTANCES) || (pending[instance] == NULL)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 49);
+	}
+
+	return sdmmc_init_poll(pending[instance], ready);
+}
+
+void sdmmc_bdev_open_cancel(uint32_t instance)
+{
+	if ((instance < MAX_SDMMC_INSTANCES) && (pending[instance] != NULL)) {
+		tegrabl_dealloc(TEGRABL_HEAP_DMA, pending[instance]);
+		pending[instance] = NULL;
+	}
+}
+
 tegrabl_error_t sdmmc_bdev_close(tegrabl_bdev_t *dev)
 {
 	sdmmc_priv_data_t *priv_data;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2018, NVIDIA CORPORATION. All rights reserved.
+ * Copyright (c) 2015-2023, NVIDIA CORPORATION. All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -74,6 +74,7 @@
 #define ECSD_HS_TIMING_OFFSET					185
 #define ECSD_BUS_WIDTH							183
 #define ECSD_BOOT_CONFIG_OFFSET					179
+#define ECSD_ERASED_MEM_CONT_OFFSET				181
 #define ECSD_BOOT_PARTITION_SIZE_OFFSET			226
 #define ECSD_POWER_CLASS_4_BIT_OFFSET			0
 #define ECSD_POWER_CLASS_8_BIT_OFFSET			4
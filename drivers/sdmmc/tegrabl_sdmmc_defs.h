@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -18,6 +18,7 @@
 #include <tegrabl_timer.h>
 #include <tegrabl_blockdev.h>
 #include <tegrabl_dmamap.h>
+#include <tegrabl_sdmmc_param.h>
 
 #define MAX_SDMMC_INSTANCES 4UL
 
@@ -191,6 +192,9 @@ typedef struct tegrabl_sdmmc {
 	/* is sanitize supported or not */
 	uint8_t sanitize_support;
 
+	/* content of erased/trimmed blocks, 0 = zeros, 1 = ones */
+	uint8_t erased_mem_cont;
+
 	/* device type */
 	device_type_t device_type;
 
@@ -217,6 +221,39 @@ typedef struct tegrabl_sdmmc {
 
 	bool is_hostv4_enabled;
 
+	/* CID register as returned by CMD2 */
+	uint32_t cid[4];
+
+	/* cached tuning record supplied by platform, NULL if not used */
+	struct tegrabl_sdmmc_tuning_record *tuning_record;
+
+	/* apply the cached tuning record instead of full mode selection */
+	bool use_tuning_record;
+
+	/* pad auto-calibration timed out and drive override is in use */
+	bool auto_cal_failed;
+
+	/* SD card I/O signaling regulator phandle, 0 if not switchable */
+	uint32_t vqmmc_supply;
+
+	/* do not negotiate UHS-I, set after a failed 1.8V switch */
+	bool disable_uhs;
+
+	/* bring-up begun by sdmmc_init_start(), finished by sdmmc_init() */
+	bool init_started;
+
+	/* CMD1 sent but the card has not reported power-up done yet */
+	bool ocr_pending;
+
+	/* time the OCR poll started, in us */
+	time_t ocr_start_time;
+
+	/* SD card accepted 1.8V signaling and the switch completed */
+	bool is_uhs_signaling;
+
+	/* SD access mode (SD_ACCESS_MODE_*) selected by CMD6 */
+	uint32_t uhs_access_mode;
+
 	/* context required for non-blocking xfer */
 	void *last_io_buf;
 	tegrabl_dma_data_direction last_io_dma_dir;
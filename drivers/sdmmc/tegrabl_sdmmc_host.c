@@ -26,6 +26,10 @@
 #include <tegrabl_drf.h>
 #include <tegrabl_addressmap.h>
 #include <tegrabl_timer.h>
+#if defined(CONFIG_ENABLE_SDCARD)
+#include <tegrabl_regulator.h>
+#include <tegrabl_sd_protocol.h>
+#endif
 
 /*  Defines the macro for reading from various offsets of sdmmc base controller.
  */
@@ -37,6 +41,28 @@
 #define sdmmc_writel(hsdmmc, reg, value) \
 	NV_WRITE32(((hsdmmc)->base_addr + (uint32_t)(SDMMCAB_##reg##_0)), value);
 
+#if defined(CONFIG_ENABLE_SDCARD)
+/*  Standard SDHCI host control 2 bits, upper half of AUTO_CMD12_ERR_STATUS.
+ */
+#define SDMMC_HOST_CTRL2_1V8_SIGNALING_EN	(1U << 19)
+#define SDMMC_HOST_CTRL2_EXECUTE_TUNING		(1U << 22)
+#define SDMMC_HOST_CTRL2_SAMPLING_CLK_SEL	(1U << 23)
+
+/*  Standard SDHCI capabilities higher and interrupt status bits.
+ */
+#define SDMMC_CAP_HIGHER_SDR50			(1U << 0)
+#define SDMMC_CAP_HIGHER_SDR104			(1U << 1)
+#define SDMMC_INTR_BUFFER_READ_READY		(1U << 5)
+
+/*  Time allowed for one tuning block to arrive.
+ */
+#define SDMMC_TUNING_BLOCK_TIMEOUT_IN_US	1000U
+
+/*  All four data lines high.
+ */
+#define SDMMC_DAT_3_0_LINES_HIGH		0xFU
+#endif
+
 /** @brief Wait till the internal clock is stable.
  *
  *  @param hsdmmc Context information to determine the base
@@ -311,10 +337,12 @@ static tegrabl_error_t sdmmc_enable_hs400(struct tegrabl_sdmmc *hsdmmc)
 		goto fail;
 	}
 
-	/* read ext csd register */
-	error = sdmmc_get_ext_csd(hsdmmc);
-	if (error != TEGRABL_NO_ERROR) {
-		goto fail;
+	/* read ext csd register, the cached tuning path verifies it later */
+	if (hsdmmc->use_tuning_record == false) {
+		error = sdmmc_get_ext_csd(hsdmmc);
+		if (error != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
 	}
 	pr_debug("sdmmc HS400 mode enabled\n");
 
@@ -1272,6 +1300,11 @@ tegrabl_error_t sdmmc_select_mode_transfer(struct tegrabl_sdmmc *hsdmmc)
 
 #if defined(CONFIG_ENABLE_SDCARD)
 	if (hsdmmc->device_type == DEVICE_TYPE_SD) {
+		/* Card is at 1.8V signaling, negotiate the fastest UHS-I mode */
+		if (hsdmmc->is_uhs_signaling) {
+			error = sd_select_uhs_mode(hsdmmc);
+			goto fail;
+		}
 		/* TODO: Add High speed: 0x5A here */
 		if (hsdmmc->tran_speed == CSD_V4_3_TRAN_SPEED)
 			hsdmmc->best_mode = TEGRABL_SDMMC_MODE_SDR26;
@@ -1639,3 +1672,227 @@ fail:
 	}
 	return err;
 }
+
+#if defined(CONFIG_ENABLE_SDCARD)
+uint32_t sdmmc_get_uhs_caps(struct tegrabl_sdmmc *hsdmmc)
+{
+	uint32_t cap_reg;
+	uint32_t cap_high_reg;
+	uint32_t caps = 0;
+
+	cap_reg = sdmmc_readl(hsdmmc, CAPABILITIES);
+	cap_high_reg = sdmmc_readl(hsdmmc, CAPABILITIES_HIGHER);
+
+	/* UHS-I needs 1.8V signaling and a switchable I/O rail */
+	if ((hsdmmc->vqmmc_supply == 0U) ||
+		(NV_DRF_VAL(SDMMCAB, CAPABILITIES, VOLTAGE_SUPPORT_1_8_V, cap_reg) == 0U)) {
+		goto fail;
+	}
+
+	caps = (1UL << SD_ACCESS_MODE_SDR12) | (1UL << SD_ACCESS_MODE_SDR25);
+	if ((cap_high_reg & SDMMC_CAP_HIGHER_SDR50) != 0U) {
+		caps |= (1UL << SD_ACCESS_MODE_SDR50);
+	}
+	if ((cap_high_reg & SDMMC_CAP_HIGHER_SDR104) != 0U) {
+		caps |= (1UL << SD_ACCESS_MODE_SDR104);
+	}
+
+fail:
+	return caps;
+}
+
+tegrabl_error_t sdmmc_switch_signaling_1v8(struct tegrabl_sdmmc *hsdmmc)
+{
+	uint32_t reg;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if (hsdmmc == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 46);
+		goto fail;
+	}
+
+	/* Card holds DAT[3:0] low once it has accepted CMD11. */
+	sdmmc_card_clock_enable(hsdmmc, false);
+	reg = sdmmc_readl(hsdmmc, PRESENT_STATE);
+	if (NV_DRF_VAL(SDMMCAB, PRESENT_STATE, DAT_3_0_LINE_LEVEL, reg) != 0U) {
+		pr_warn("sd card did not drive DAT lines low for voltage switch\n");
+		error = TEGRABL_ERROR(TEGRABL_ERR_COMMAND_FAILED, 2);
+		goto fail;
+	}
+
+	error = tegrabl_regulator_set_voltage(hsdmmc->vqmmc_supply,
+										  SD_SIGNALING_VOLTAGE_1V8, STANDARD_VOLTS);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	reg = sdmmc_readl(hsdmmc, AUTO_CMD12_ERR_STATUS);
+	reg |= SDMMC_HOST_CTRL2_1V8_SIGNALING_EN;
+	sdmmc_writel(hsdmmc, AUTO_CMD12_ERR_STATUS, reg);
+
+	/* Signaling rail has to settle within 5ms. */
+	tegrabl_mdelay(5);
+
+	reg = sdmmc_readl(hsdmmc, AUTO_CMD12_ERR_STATUS);
+	if ((reg & SDMMC_HOST_CTRL2_1V8_SIGNALING_EN) == 0U) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_COMMAND_FAILED, 3);
+		goto fail;
+	}
+
+	/* Pad drive strengths differ at 1.8V, recalibrate. */
+	if (hsdmmc->auto_cal_failed == false) {
+		if (sdmmc_auto_calibrate(hsdmmc) != TEGRABL_NO_ERROR) {
+			hsdmmc->auto_cal_failed = true;
+			sdmmc_update_drv_settings(hsdmmc, hsdmmc->controller_id);
+		}
+	}
+
+	/* Card releases DAT[3:0] within 1ms of the clock restart. */
+	sdmmc_card_clock_enable(hsdmmc, true);
+	tegrabl_mdelay(1);
+
+	reg = sdmmc_readl(hsdmmc, PRESENT_STATE);
+	if (NV_DRF_VAL(SDMMCAB, PRESENT_STATE, DAT_3_0_LINE_LEVEL, reg) !=
+		SDMMC_DAT_3_0_LINES_HIGH) {
+		pr_warn("sd card did not release DAT lines after voltage switch\n");
+		error = TEGRABL_ERROR(TEGRABL_ERR_COMMAND_FAILED, 4);
+		goto fail;
+	}
+
+	pr_debug("sd card switched to 1.8V signaling\n");
+
+fail:
+	return error;
+}
+
+tegrabl_error_t sdmmc_set_uhs_mode(struct tegrabl_sdmmc *hsdmmc,
+	uint32_t access_mode, uint32_t rate, uint32_t clk_divider)
+{
+	uint32_t host_reg;
+	uint32_t srate;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if (hsdmmc == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 47);
+		goto fail;
+	}
+
+	/* reset SD clock enable */
+	sdmmc_card_clock_enable(hsdmmc, false);
+
+	error = tegrabl_car_set_clk_rate(TEGRABL_MODULE_SDMMC,
+									 (uint8_t)hsdmmc->controller_id, rate, &srate);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	tegrabl_udelay(2);
+
+	/* SD access modes share the encoding of UHS_MODE_SEL */
+	host_reg = sdmmc_readl(hsdmmc, AUTO_CMD12_ERR_STATUS);
+	host_reg = NV_FLD_SET_DRF_NUM(SDMMCAB, AUTO_CMD12_ERR_STATUS, UHS_MODE_SEL,
+								  access_mode, host_reg);
+	sdmmc_writel(hsdmmc, AUTO_CMD12_ERR_STATUS, host_reg);
+
+	sdmmc_toggle_high_speed((access_mode != SD_ACCESS_MODE_SDR12) ? 1U : 0U,
+							hsdmmc);
+
+	/* program the divider and enable SD clock */
+	error = sdmmc_set_card_clock(hsdmmc, MODE_DATA_TRANSFER, clk_divider);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	pr_trace("sd access mode %u at %u KHz / %u\n", access_mode, srate,
+			 clk_divider);
+
+fail:
+	return error;
+}
+
+tegrabl_error_t sdmmc_execute_tuning(struct tegrabl_sdmmc *hsdmmc)
+{
+	uint32_t cmd_reg;
+	uint32_t host_reg;
+	uint32_t int_enable;
+	uint32_t int_status;
+	uint32_t timeout;
+	uint32_t loop;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if (hsdmmc == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 48);
+		goto fail;
+	}
+
+	error = sdmmc_prepare_cmd_reg(&cmd_reg, 1, hsdmmc,
+								  SD_CMD_SEND_TUNING_BLOCK, RESP_TYPE_R1);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	/* Tuning blocks are consumed by the controller, not sent to memory. */
+	cmd_reg = NV_FLD_SET_DRF_NUM(SDMMCAB, CMD_XFER_MODE, DMA_EN, 0, cmd_reg);
+	sdmmc_set_num_blocks(SD_TUNING_BLOCK_SIZE, 1, hsdmmc);
+
+	int_enable = sdmmc_readl(hsdmmc, INTERRUPT_STATUS_ENABLE);
+	sdmmc_writel(hsdmmc, INTERRUPT_STATUS_ENABLE,
+				 int_enable | SDMMC_INTR_BUFFER_READ_READY);
+
+	host_reg = sdmmc_readl(hsdmmc, AUTO_CMD12_ERR_STATUS);
+	host_reg &= ~SDMMC_HOST_CTRL2_SAMPLING_CLK_SEL;
+	host_reg |= SDMMC_HOST_CTRL2_EXECUTE_TUNING;
+	sdmmc_writel(hsdmmc, AUTO_CMD12_ERR_STATUS, host_reg);
+
+	for (loop = 0; loop < SD_TUNING_MAX_LOOPS; loop++) {
+		error = sdmmc_cmd_txr_ready(hsdmmc);
+		if (error != TEGRABL_NO_ERROR) {
+			break;
+		}
+
+		int_status = sdmmc_readl(hsdmmc, INTERRUPT_STATUS);
+		sdmmc_writel(hsdmmc, INTERRUPT_STATUS, int_status);
+		sdmmc_writel(hsdmmc, ARGUMENT, 0);
+		sdmmc_writel(hsdmmc, CMD_XFER_MODE, cmd_reg);
+
+		/* A missing block only means this tap failed, keep going. */
+		timeout = SDMMC_TUNING_BLOCK_TIMEOUT_IN_US;
+		do {
+			int_status = sdmmc_readl(hsdmmc, INTERRUPT_STATUS);
+			if ((int_status & SDMMC_INTR_BUFFER_READ_READY) != 0U) {
+				break;
+			}
+			tegrabl_udelay(1);
+			timeout--;
+		} while (timeout != 0U);
+		sdmmc_writel(hsdmmc, INTERRUPT_STATUS, int_status);
+
+		host_reg = sdmmc_readl(hsdmmc, AUTO_CMD12_ERR_STATUS);
+		if ((host_reg & SDMMC_HOST_CTRL2_EXECUTE_TUNING) == 0U) {
+			break;
+		}
+	}
+
+	sdmmc_writel(hsdmmc, INTERRUPT_STATUS_ENABLE, int_enable);
+
+	host_reg = sdmmc_readl(hsdmmc, AUTO_CMD12_ERR_STATUS);
+	if ((error == TEGRABL_NO_ERROR) &&
+		((host_reg & SDMMC_HOST_CTRL2_EXECUTE_TUNING) == 0U) &&
+		((host_reg & SDMMC_HOST_CTRL2_SAMPLING_CLK_SEL) != 0U)) {
+		pr_debug("sd tuning done in %u loops\n", loop + 1U);
+		goto fail;
+	}
+
+	/* Fall back to the fixed sampling clock. */
+	host_reg &= ~(SDMMC_HOST_CTRL2_EXECUTE_TUNING |
+				  SDMMC_HOST_CTRL2_SAMPLING_CLK_SEL);
+	sdmmc_writel(hsdmmc, AUTO_CMD12_ERR_STATUS, host_reg);
+	if (error == TEGRABL_NO_ERROR) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, 10);
+	}
+	pr_warn("sd tuning failed\n");
+
+fail:
+	return error;
+}
+#endif
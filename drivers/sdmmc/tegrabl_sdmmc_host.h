@@ -281,5 +281,52 @@ void sdmmc_update_drv_settings(struct tegrabl_sdmmc *hsdmmc, uint32_t instance);
  */
 tegrabl_error_t sdmmc_dll_caliberation(struct tegrabl_sdmmc *hsdmmc);
 
+#if defined(CONFIG_ENABLE_SDCARD)
+/**
+ * @brief Query the SD access modes the host can run at 1.8V signaling
+ *
+ * @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ *
+ * @return Bitmask of (1 << SD_ACCESS_MODE_*), 0 if UHS-I is not possible
+ */
+uint32_t sdmmc_get_uhs_caps(struct tegrabl_sdmmc *hsdmmc);
+
+/**
+ * @brief Host side of the CMD11 voltage switch: gate the clock, move the
+ *        vqmmc rail and pads to 1.8V and check the card releases DAT[3:0]
+ *
+ * @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ *
+ * @return TEGRABL_NO_ERROR if success, error code in case of failure
+ */
+tegrabl_error_t sdmmc_switch_signaling_1v8(struct tegrabl_sdmmc *hsdmmc);
+
+/**
+ * @brief Program the UHS mode select and the card clock
+ *
+ * @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ * @param access_mode SD access mode (SD_ACCESS_MODE_*)
+ * @param rate Controller clock rate in KHz
+ * @param clk_divider Card clock divider
+ *
+ * @return TEGRABL_NO_ERROR if success, error code in case of failure
+ */
+tegrabl_error_t sdmmc_set_uhs_mode(struct tegrabl_sdmmc *hsdmmc,
+	uint32_t access_mode, uint32_t rate, uint32_t clk_divider);
+
+/**
+ * @brief Run CMD19 based sampling clock tuning
+ *
+ * @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ *
+ * @return TEGRABL_NO_ERROR if tuned clock is selected, error code otherwise
+ */
+tegrabl_error_t sdmmc_execute_tuning(struct tegrabl_sdmmc *hsdmmc);
+#endif
+
 
 #endif /* TEGRABL_SDMMC_HOST_H  */
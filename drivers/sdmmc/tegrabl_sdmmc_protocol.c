@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2020, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -25,6 +25,7 @@
 #include <tegrabl_addressmap.h>
 #include <tegrabl_timer.h>
 #include <tegrabl_malloc.h>
+#include <tegrabl_sdmmc_tuning.h>
 #include <inttypes.h>
 
 #if defined(CONFIG_ENABLE_SDCARD)
@@ -235,66 +236,114 @@ fail:
 	return error;
 }
 
-/** @brief Query OCR from card and fills appropriate hsdmmc.
+/** @brief Sends one SEND_OP_COND(CMD1) of the OCR poll begun by
+ *         sdmmc_ocr_start() and fills appropriate hsdmmc once the card
+ *         reports that its power-up is done.
  *
  *  @param hsdmmc Context information to determine the base
  *                 address of controller.
- *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ *  @param ready Set to true once the card is ready.
+ *  @return TEGRABL_NO_ERROR if success, error code if fails or if the card
+ *          is still busy after OCR_POLLING_TIMEOUT_IN_US.
  */
-static tegrabl_error_t sdmmc_get_operating_conditions(struct tegrabl_sdmmc *hsdmmc)
+static tegrabl_error_t sdmmc_ocr_poll(struct tegrabl_sdmmc *hsdmmc, bool *ready)
 {
 	uint32_t ocr_reg = 0;
 	uint32_t *sdmmc_resp = &hsdmmc->response[0];
 	uint32_t cmd1_arg;
-	time_t timeout = OCR_POLLING_TIMEOUT_IN_US;
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-	time_t start_time;
-	time_t elapsed_time = 0;
+	time_t elapsed_time;
 
-	if (hsdmmc == NULL) {
-		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
-		goto fail;
-	}
-
-	start_time = tegrabl_get_timestamp_us();
+	*ready = false;
 	cmd1_arg = (CARD_CAPACITY_MASK | OCR_LOW_VOLTAGE);
 
-	while (elapsed_time < timeout) {
-		/* Send SEND_OP_COND(CMD1) Command. */
-		error = sdmmc_send_command(CMD_SEND_OCR, cmd1_arg,
-					 RESP_TYPE_R3, 0, hsdmmc);
-		if (error != TEGRABL_NO_ERROR) {
-			goto fail;
-		}
+	/* Send SEND_OP_COND(CMD1) Command. */
+	error = sdmmc_send_command(CMD_SEND_OCR, cmd1_arg,
+				 RESP_TYPE_R3, 0, hsdmmc);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
 
-		/* Extract OCR from Response. */
-		ocr_reg = sdmmc_resp[0];
+	/* Extract OCR from Response. */
+	ocr_reg = sdmmc_resp[0];
 
-		/* Check for Card Ready. */
-		if ((ocr_reg & OCR_READY_MASK) != 0UL) {
-			break;
-		}
-
-		elapsed_time = tegrabl_get_timestamp_us() - start_time;
+	/* Check for Card Ready. */
+	if ((ocr_reg & OCR_READY_MASK) != 0UL) {
+		/* Query if the card is high cpacity card or not. */
+		hsdmmc->is_high_capacity_card =
+			(((ocr_reg & CARD_CAPACITY_MASK) != 0U) ? 1U : 0U);
+		hsdmmc->ocr_pending = false;
+		*ready = true;
+		goto fail;
 	}
 
-	if (elapsed_time >= timeout) {
+	elapsed_time = tegrabl_get_timestamp_us() - hsdmmc->ocr_start_time;
+	if (elapsed_time >= OCR_POLLING_TIMEOUT_IN_US) {
 		error = TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, 10);
 		goto fail;
 	}
 
-	/* Query if the card is high cpacity card or not. */
-	hsdmmc->is_high_capacity_card =
-		(((ocr_reg & CARD_CAPACITY_MASK) != 0U) ? 1U : 0U);
-
 fail:
 	if (error != TEGRABL_NO_ERROR) {
+		hsdmmc->ocr_pending = false;
 		sdmmc_print_regdump(hsdmmc);
 		pr_error("OCR failed, error = %x\n", error);
 	}
 	return error;
 }
 
+/** @brief Starts the OCR poll: the card begins its power-up init on the first
+ *         CMD1 and keeps reporting busy until it is done.
+ *
+ *  @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+static tegrabl_error_t sdmmc_ocr_start(struct tegrabl_sdmmc *hsdmmc)
+{
+	bool ready;
+
+	hsdmmc->ocr_start_time = tegrabl_get_timestamp_us();
+	hsdmmc->ocr_pending = true;
+
+	return sdmmc_ocr_poll(hsdmmc, &ready);
+}
+
+/** @brief Query OCR from card and fills appropriate hsdmmc. Continues the
+ *         poll if sdmmc_ocr_start() already began it.
+ *
+ *  @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+static tegrabl_error_t sdmmc_get_operating_conditions(struct tegrabl_sdmmc *hsdmmc)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	bool ready = false;
+
+	if (hsdmmc == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
+		goto fail;
+	}
+
+	if (hsdmmc->ocr_pending == false) {
+		error = sdmmc_ocr_start(hsdmmc);
+		if (error != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+	}
+
+	while (hsdmmc->ocr_pending == true) {
+		error = sdmmc_ocr_poll(hsdmmc, &ready);
+		if (error != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+	}
+
+fail:
+	return error;
+}
+
 #if defined(CONFIG_ENABLE_BLOCKDEV_DEVICE_INFO)
 tegrabl_error_t sdmmc_parse_cid(struct tegrabl_sdmmc *hsdmmc)
 {
@@ -886,6 +935,9 @@ tegrabl_error_t sdmmc_get_ext_csd(struct tegrabl_sdmmc *hsdmmc)
 		(buf[ECSD_SEC_FEATURE_OFFSET] &
 			ECSD_SEC_SANITIZE_MASK) >> ECSD_SEC_SANITIZE_SHIFT;
 
+	/* Store what erased blocks read back as. */
+	hsdmmc->erased_mem_cont = buf[ECSD_ERASED_MEM_CONT_OFFSET];
+
 	/* Store the high capacity erase group size. */
 	hsdmmc->erase_group_size = (uint32_t)buf[ECSD_ERASE_GRP_SIZE] << 10;
 
@@ -1032,13 +1084,14 @@ fail:
 	return error;
 }
 
-/** @brief Initializes the card by following SDMMC protocol.
+/** @brief Starts the card identification: resets the card and sends the
+ *         first CMD1, after which the card runs its power-up init.
  *
  *  @param hsdmmc Context information to determine the base
  *                 address of controller.
  *  @return TEGRABL_NO_ERROR if success, error code if fails.
  */
-static tegrabl_error_t sdmmc_identify_card(struct tegrabl_sdmmc *hsdmmc)
+static tegrabl_error_t sdmmc_identify_card_start(struct tegrabl_sdmmc *hsdmmc)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
 
@@ -1056,6 +1109,25 @@ static tegrabl_error_t sdmmc_identify_card(struct tegrabl_sdmmc *hsdmmc)
 		goto fail;
 	}
 
+	/* Let the card start its power-up init. */
+	pr_trace("Send first command 1\n");
+	error = sdmmc_ocr_start(hsdmmc);
+
+fail:
+	return error;
+}
+
+/** @brief Finishes the identification begun by sdmmc_identify_card_start():
+ *         waits for the card to be ready and moves it to transfer state.
+ *
+ *  @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+static tegrabl_error_t sdmmc_identify_card_finish(struct tegrabl_sdmmc *hsdmmc)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
 	/* Get the operating conditions. */
 	pr_trace("Send command 1\n");
 	error = sdmmc_get_operating_conditions(hsdmmc);
@@ -1070,6 +1142,15 @@ static tegrabl_error_t sdmmc_identify_card(struct tegrabl_sdmmc *hsdmmc)
 	if (error != TEGRABL_NO_ERROR) {
 		goto fail;
 	}
+	memcpy(hsdmmc->cid, hsdmmc->response, sizeof(hsdmmc->cid));
+
+	/* Cached tuning is only usable on the card it was taken from. */
+	if (hsdmmc->use_tuning_record == true) {
+		error = sdmmc_tuning_record_check_cid(hsdmmc);
+		if (error != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+	}
 
 	/* Assign the relative card address. */
 	pr_trace("Send command 3\n");
@@ -1153,6 +1234,24 @@ fail:
 	return error;
 }
 
+/** @brief Initializes the card by following SDMMC protocol.
+ *
+ *  @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+static tegrabl_error_t sdmmc_identify_card(struct tegrabl_sdmmc *hsdmmc)
+{
+	tegrabl_error_t error;
+
+	error = sdmmc_identify_card_start(hsdmmc);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	return sdmmc_identify_card_finish(hsdmmc);
+}
+
 /** @brief Read/write from the input block till the count of blocks.
  *
  *  @param block Start sector for read/write.
@@ -1419,11 +1518,19 @@ tegrabl_error_t sdmmc_init_controller(struct tegrabl_sdmmc *hsdmmc, uint32_t ins
 
 	sdmmc_set_tap_trim(hsdmmc);
 
-	/* Enable Auto-Calibration */
-	pr_trace("Perform auto-calibration\n");
-	error = sdmmc_auto_calibrate(hsdmmc);
-	if (error != TEGRABL_NO_ERROR) {
+	/* Enable Auto-Calibration, unless it is known to time out on this board. */
+	if ((hsdmmc->use_tuning_record == true) &&
+		(hsdmmc->tuning_record->auto_cal_failed != 0U)) {
+		pr_trace("Skip auto-calibration, use drive override\n");
+		hsdmmc->auto_cal_failed = true;
 		sdmmc_update_drv_settings(hsdmmc, instance);
+	} else {
+		pr_trace("Perform auto-calibration\n");
+		error = sdmmc_auto_calibrate(hsdmmc);
+		hsdmmc->auto_cal_failed = (error != TEGRABL_NO_ERROR);
+		if (error != TEGRABL_NO_ERROR) {
+			sdmmc_update_drv_settings(hsdmmc, instance);
+		}
 	}
 
 	/* Enable the clock oscillator with DIV64 divider. */
@@ -1497,6 +1604,152 @@ fail:
 	return error;
 }
 
+/** @brief Brings up the controller and starts the card identification. For
+ *         eMMC this returns while the card is still running its power-up
+ *         init; sdmmc_full_init_finish() completes the bring-up.
+ *
+ *  @param instance Instance of the controller to be initialized.
+ *  @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+static tegrabl_error_t sdmmc_full_init_start(uint32_t instance,
+	struct tegrabl_sdmmc *hsdmmc)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	/* Enable clocks for input sdmmc instance. */
+	pr_trace("Enabling clock\n");
+	error = sdmmc_clock_init(hsdmmc->controller_id, CLK_102_MHZ,
+								hsdmmc->clk_src);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	/* Initiliaze controller. */
+	pr_trace("Initialize controller\n");
+	error = sdmmc_init_controller(hsdmmc, instance);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	/* Identify card. */
+	pr_trace("Identify card\n");
+
+#if defined(CONFIG_ENABLE_SDCARD)
+	if (hsdmmc->device_type == DEVICE_TYPE_SD)
+		error = sd_identify_card(hsdmmc);
+	else
+#endif
+		error = sdmmc_identify_card_start(hsdmmc);
+
+fail:
+	return error;
+}
+
+/** @brief Completes the bring-up begun by sdmmc_full_init_start() and
+ *         selects the transfer mode.
+ *
+ *  @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+static tegrabl_error_t sdmmc_full_init_finish(struct tegrabl_sdmmc *hsdmmc)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if (hsdmmc->device_type != DEVICE_TYPE_SD) {
+		error = sdmmc_identify_card_finish(hsdmmc);
+		if (error != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+	}
+
+	/* Setup card for data transfer. */
+	pr_trace("Set card for data transfer\n");
+	error = sdmmc_select_mode_transfer(hsdmmc);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	/* Setup the default region of operation as user partition. */
+	pr_trace("Set default region as user partition\n");
+	if (hsdmmc->device_type != DEVICE_TYPE_SD) {
+		error = sdmmc_set_default_region(hsdmmc);
+		if (error != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+	}
+
+fail:
+	return error;
+}
+
+/** @brief Brings up the controller and card from reset and selects the
+ *         transfer mode.
+ *
+ *  @param instance Instance of the controller to be initialized.
+ *  @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+static tegrabl_error_t sdmmc_full_init(uint32_t instance,
+	struct tegrabl_sdmmc *hsdmmc)
+{
+	tegrabl_error_t error;
+
+	error = sdmmc_full_init_start(instance, hsdmmc);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	return sdmmc_full_init_finish(hsdmmc);
+}
+
+tegrabl_error_t sdmmc_init_start(uint32_t instance, struct tegrabl_sdmmc *hsdmmc)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if ((hsdmmc == NULL) || (hsdmmc->initialized == true) ||
+		(hsdmmc->init_started == true)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 23);
+		goto fail;
+	}
+
+	/* Store the default init parameters. */
+	pr_trace("Set default hsdmmc\n");
+	sdmmc_set_default_hsdmmc(hsdmmc, instance);
+
+	/* Use the cached tuning outcome if the platform supplied a good one. */
+	hsdmmc->use_tuning_record = sdmmc_tuning_record_is_valid(hsdmmc);
+
+	error = sdmmc_full_init_start(instance, hsdmmc);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	hsdmmc->init_started = true;
+
+fail:
+	if (error != TEGRABL_NO_ERROR) {
+		pr_debug("sdmmc init start failed, error = %x\n", error);
+	}
+	return error;
+}
+
+tegrabl_error_t sdmmc_init_poll(struct tegrabl_sdmmc *hsdmmc, bool *ready)
+{
+	if ((hsdmmc == NULL) || (ready == NULL) ||
+		(hsdmmc->init_started == false)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 24);
+	}
+
+	if (hsdmmc->ocr_pending == false) {
+		*ready = true;
+		return TEGRABL_NO_ERROR;
+	}
+
+	return sdmmc_ocr_poll(hsdmmc, ready);
+}
+
 /** @brief  Initializes the card and the controller and select appropriate mode
  *          for card transfer like DDR or SDR.
  *
@@ -1521,14 +1774,17 @@ tegrabl_error_t sdmmc_init(uint32_t instance, struct tegrabl_sdmmc *hsdmmc, uint
 		return TEGRABL_NO_ERROR;
 	}
 
-	/* Store the default init parameters. */
-	pr_trace("Set default hsdmmc\n");
-	sdmmc_set_default_hsdmmc(hsdmmc, instance);
+	/* Store the default init parameters, sdmmc_init_start() already did. */
+	if (hsdmmc->init_started == false) {
+		pr_trace("Set default hsdmmc\n");
+		sdmmc_set_default_hsdmmc(hsdmmc, instance);
+	}
 
 	/* TODO: Handle the case if sdmmc is initialized with different
 	 * mode than what hsdmmc is configured.
 	 */
-	if (((flag == SKIP_INIT) || (flag == SKIP_INIT_UPDATE_CONFIG)) &&
+	if ((hsdmmc->init_started == false) &&
+			((flag == SKIP_INIT) || (flag == SKIP_INIT_UPDATE_CONFIG)) &&
 			(sdmmc_check_is_trans_mode(hsdmmc) == TEGRABL_NO_ERROR)) {
 		sdmmc_get_hostv4_status(hsdmmc);
 #if !defined(CONFIG_ENABLE_SDMMC_64_BIT_SUPPORT)
@@ -1564,48 +1820,34 @@ tegrabl_error_t sdmmc_init(uint32_t instance, struct tegrabl_sdmmc *hsdmmc, uint
 		return TEGRABL_NO_ERROR;
 	}
 
-	/* Enable clocks for input sdmmc instance. */
-	pr_trace("Enabling clock\n");
-	error = sdmmc_clock_init(hsdmmc->controller_id, CLK_102_MHZ,
-								hsdmmc->clk_src);
-	if (error != TEGRABL_NO_ERROR) {
-		goto fail;
+	if (hsdmmc->init_started == true) {
+		/* Resume the bring-up begun by sdmmc_init_start(). */
+		hsdmmc->init_started = false;
+		error = sdmmc_full_init_finish(hsdmmc);
+	} else {
+		/* Use the cached tuning outcome if the platform supplied a good one. */
+		hsdmmc->use_tuning_record = sdmmc_tuning_record_is_valid(hsdmmc);
+
+		error = sdmmc_full_init(instance, hsdmmc);
 	}
-	/* Initiliaze controller. */
-	pr_trace("Initialize controller\n");
-	error = sdmmc_init_controller(hsdmmc, instance);
-	if (error != TEGRABL_NO_ERROR) {
-		goto fail;
+	if (hsdmmc->use_tuning_record == true) {
+		if (error == TEGRABL_NO_ERROR) {
+			error = sdmmc_tuning_record_verify(hsdmmc);
+		}
+		if (error != TEGRABL_NO_ERROR) {
+			/* Drop the record and retune from scratch. */
+			pr_warn("sdmmc cached tuning rejected (%x), retuning\n", error);
+			sdmmc_tuning_record_invalidate(hsdmmc);
+			sdmmc_set_default_hsdmmc(hsdmmc, instance);
+			error = sdmmc_full_init(instance, hsdmmc);
+		}
 	}
-
-	/* Identify card. */
-	pr_trace("Identify card\n");
-
-#if defined(CONFIG_ENABLE_SDCARD)
-	if (hsdmmc->device_type == DEVICE_TYPE_SD)
-		error = sd_identify_card(hsdmmc);
-	else
-#endif
-		error = sdmmc_identify_card(hsdmmc);
-
 	if (error != TEGRABL_NO_ERROR) {
 		goto fail;
 	}
 
-	/* Setup card for data transfer. */
-	pr_trace("Set card for data transfer\n");
-	error = sdmmc_select_mode_transfer(hsdmmc);
-	if (error != TEGRABL_NO_ERROR) {
-		goto fail;
-	}
-	/* Setup the default region of operation as user partition. */
-	pr_trace("Set default region as user partition\n");
-	if (hsdmmc->device_type != DEVICE_TYPE_SD) {
-		error = sdmmc_set_default_region(hsdmmc);
-		if (error != TEGRABL_NO_ERROR) {
-			goto fail;
-		}
-	}
+	sdmmc_tuning_record_update(hsdmmc);
+
 	/* Mark as device is initialized. */
 	hsdmmc->initialized = true;
 
@@ -1809,6 +2051,11 @@ tegrabl_error_t sdmmc_enable_high_speed(struct tegrabl_sdmmc *hsdmmc)
 		if (error != TEGRABL_NO_ERROR) {
 			goto fail;
 		}
+		/* The cached tuning path validates the final mode once instead. */
+		if (hsdmmc->use_tuning_record == true) {
+			return TEGRABL_NO_ERROR;
+		}
+
 		/* Validate high speed mode bit from card here. */
 		error = sdmmc_get_ext_csd(hsdmmc);
 		if (error != TEGRABL_NO_ERROR) {
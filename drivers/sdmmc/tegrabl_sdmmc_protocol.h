@@ -37,6 +37,11 @@
  */
 #define CLK_102_MHZ 102000U
 
+/*  Define SD UHS-I SDR50 and SDR104 source clocks
+ */
+#define CLK_100_MHZ 100000U
+#define CLK_204_MHZ 204000U
+
 /* Different modes for  card clock init */
 	/* 400 KHz supplied to card. */
 #define MODE_INIT 0U
@@ -150,6 +155,27 @@ typedef uint32_t sdmmc_resp_type;
 #define SD_CSD_CSIZE_MULT_MASK		0x7U
 #define SD_BUS_WIDTH_1BIT		0U
 #define SD_BUS_WIDTH_4BIT		2U
+#define SD_CARD_OCR_S18R		0x01000000U
+#define SD_CARD_OCR_S18A		0x01000000U
+#define SD_SIGNALING_VOLTAGE_1V8	1800000U
+#define SD_SIGNALING_VOLTAGE_3V3	3300000U
+
+/* CMD6 switch function arguments and status layout (group 1, access mode) */
+#define SD_SWITCH_CHECK_MODE		0x00000000U
+#define SD_SWITCH_SET_MODE		0x80000000U
+#define SD_SWITCH_KEEP_OTHER_GROUPS	0x00FFFFF0U
+#define SD_SWITCH_GRP1_SUPPORT_OFFSET	12U
+#define SD_SWITCH_GRP1_RESULT_OFFSET	16U
+#define SD_SWITCH_GRP1_RESULT_MASK	0xFU
+#define SD_ACCESS_MODE_SDR12		0U
+#define SD_ACCESS_MODE_SDR25		1U
+#define SD_ACCESS_MODE_SDR50		2U
+#define SD_ACCESS_MODE_SDR104		3U
+#define SD_ACCESS_MODE_DDR50		4U
+
+/* CMD19 tuning block and retry limit */
+#define SD_TUNING_BLOCK_SIZE		64U
+#define SD_TUNING_MAX_LOOPS		40U
 
 #define TIMING_INTERFACE_HIGH_SPEED	1U
 #define TIMING_INTERFACE_HS200		2U
@@ -157,8 +183,11 @@ typedef uint32_t sdmmc_resp_type;
 
 /* Defines various Application specific Sd Commands as per spec */
 #define SD_ACMD_SET_BUS_WIDTH		6U
+#define SD_CMD_SWITCH_FUNC		6U
 #define SD_CMD_SEND_IF_COND		8U
+#define SD_CMD_VOLTAGE_SWITCH		11U
 #define SD_ACMD_SD_STATUS		13U
+#define SD_CMD_SEND_TUNING_BLOCK	19U
 #define SD_ACMD_SEND_NUM_WR_BLOCKS	22U
 #define SD_ACMD_SET_WR_BLK_ERASE_COUNT	23U
 #define SD_CMD_ERASE_BLK_START		32U
@@ -201,6 +230,30 @@ tegrabl_error_t sdmmc_clock_init(uint32_t instance, uint32_t rate,
  */
 tegrabl_error_t sdmmc_init(uint32_t instance, struct tegrabl_sdmmc *hsdmmc, uint8_t flag);
 
+/** @brief  Starts a full init of the controller and card: enables the
+ *          controller, resets the card and sends the first CMD1. The card
+ *          then runs its power-up init while the caller does other work.
+ *          sdmmc_init() completes the init.
+ *
+ *  @param instance Instance of the controller to be initialized.
+ *  @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ *
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+tegrabl_error_t sdmmc_init_start(uint32_t instance, struct tegrabl_sdmmc *hsdmmc);
+
+/** @brief  Sends one more CMD1 of an init begun by sdmmc_init_start().
+ *
+ *  @param hsdmmc Context information to determine the base
+ *                 address of controller.
+ *  @param ready Set to true once the card has finished its power-up init.
+ *
+ *  @return TEGRABL_NO_ERROR if success, error code if the card failed or
+ *          timed out.
+ */
+tegrabl_error_t sdmmc_init_poll(struct tegrabl_sdmmc *hsdmmc, bool *ready);
+
 /** @brief Read/write from the input block till the count of blocks.
  *
  *  @param dev Bio device from which read/write is done.
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited
+ */
+
+#define MODULE TEGRABL_ERR_SDMMC
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <tegrabl_error.h>
+#include <tegrabl_debug.h>
+#include <tegrabl_utils.h>
+#include <tegrabl_sdmmc_defs.h>
+#include <tegrabl_sdmmc_protocol.h>
+#include <tegrabl_sdmmc_tuning.h>
+
+#define SDMMC_HS_TIMING_MASK	0xFU
+
+static uint32_t sdmmc_tuning_record_crc(struct tegrabl_sdmmc_tuning_record *record)
+{
+	return tegrabl_utils_crc32(0, record,
+			sizeof(*record) - sizeof(record->crc32));
+}
+
+bool sdmmc_tuning_record_is_valid(struct tegrabl_sdmmc *hsdmmc)
+{
+	struct tegrabl_sdmmc_tuning_record *record = hsdmmc->tuning_record;
+
+	if (record == NULL) {
+		return false;
+	}
+
+	if ((record->magic != TEGRABL_SDMMC_TUNING_RECORD_MAGIC) ||
+		(record->version != TEGRABL_SDMMC_TUNING_RECORD_VERSION)) {
+		pr_debug("sdmmc tuning record not present\n");
+		return false;
+	}
+
+	if (record->crc32 != sdmmc_tuning_record_crc(record)) {
+		pr_warn("sdmmc tuning record crc mismatch\n");
+		return false;
+	}
+
+	/* Platform configuration changed since the record was taken. */
+	if ((record->clk_src != hsdmmc->clk_src) ||
+		(record->best_mode != hsdmmc->best_mode) ||
+		(record->tap_value != hsdmmc->tap_value) ||
+		(record->trim_value != hsdmmc->trim_value)) {
+		pr_debug("sdmmc tuning record is stale\n");
+		return false;
+	}
+
+	return true;
+}
+
+tegrabl_error_t sdmmc_tuning_record_check_cid(struct tegrabl_sdmmc *hsdmmc)
+{
+	struct tegrabl_sdmmc_tuning_record *record = hsdmmc->tuning_record;
+
+	if (memcmp(record->cid, hsdmmc->cid, sizeof(record->cid)) != 0) {
+		pr_info("sdmmc card changed, tuning record ignored\n");
+		return TEGRABL_ERROR(TEGRABL_ERR_MISMATCH, 0);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t sdmmc_tuning_record_verify(struct tegrabl_sdmmc *hsdmmc)
+{
+	struct tegrabl_sdmmc_tuning_record *record = hsdmmc->tuning_record;
+	uint8_t *buf = hsdmmc->ext_csd_buffer_address;
+	uint32_t bus_width;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	/* The ext csd read is the quick read: it exercises the data lines at
+	 * the final bus speed and reports what the card has latched.
+	 */
+	error = sdmmc_get_ext_csd(hsdmmc);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	bus_width = hsdmmc->data_width | ((hsdmmc->enhanced_strobe ? 1UL : 0UL) << 7);
+
+	if (((buf[ECSD_HS_TIMING_OFFSET] & SDMMC_HS_TIMING_MASK) !=
+			(record->hs_timing & SDMMC_HS_TIMING_MASK)) ||
+		(buf[ECSD_BUS_WIDTH] != bus_width)) {
+		pr_debug("hs_timing %u bus_width %u, expected %u %u\n",
+				 buf[ECSD_HS_TIMING_OFFSET], buf[ECSD_BUS_WIDTH],
+				 record->hs_timing, bus_width);
+		error = TEGRABL_ERROR(TEGRABL_ERR_VERIFY_FAILED, 0);
+	}
+
+fail:
+	return error;
+}
+
+void sdmmc_tuning_record_update(struct tegrabl_sdmmc *hsdmmc)
+{
+	struct tegrabl_sdmmc_tuning_record *record = hsdmmc->tuning_record;
+
+	if (record == NULL) {
+		return;
+	}
+
+	memset(record, 0, sizeof(*record));
+	record->magic = TEGRABL_SDMMC_TUNING_RECORD_MAGIC;
+	record->version = TEGRABL_SDMMC_TUNING_RECORD_VERSION;
+	memcpy(record->cid, hsdmmc->cid, sizeof(record->cid));
+	record->clk_src = hsdmmc->clk_src;
+	record->best_mode = hsdmmc->best_mode;
+	record->data_width = hsdmmc->data_width;
+	record->tap_value = hsdmmc->tap_value;
+	record->trim_value = hsdmmc->trim_value;
+	record->hs_timing = hsdmmc->ext_csd_buffer_address[ECSD_HS_TIMING_OFFSET];
+	record->enhanced_strobe = hsdmmc->enhanced_strobe ? 1U : 0U;
+	record->auto_cal_failed = hsdmmc->auto_cal_failed ? 1U : 0U;
+	record->crc32 = sdmmc_tuning_record_crc(record);
+}
+
+void sdmmc_tuning_record_invalidate(struct tegrabl_sdmmc *hsdmmc)
+{
+	if (hsdmmc->tuning_record != NULL) {
+		hsdmmc->tuning_record->magic = 0;
+	}
+	hsdmmc->use_tuning_record = false;
+}
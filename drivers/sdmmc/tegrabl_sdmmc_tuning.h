@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited
+ */
+
+#ifndef TEGRABL_SDMMC_TUNING_H
+#define TEGRABL_SDMMC_TUNING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <tegrabl_error.h>
+#include <tegrabl_sdmmc_defs.h>
+
+/** @brief Checks the cached tuning record supplied by the platform against
+ *         the requested configuration. The CID is checked separately once the
+ *         card has been identified.
+ *
+ *  @param hsdmmc Context information of the controller.
+ *
+ *  @return true if the record is intact and matches the requested
+ *          clock source, mode, tap and trim values.
+ */
+bool sdmmc_tuning_record_is_valid(struct tegrabl_sdmmc *hsdmmc);
+
+/** @brief Compares the CID read by CMD2 with the one in the tuning record.
+ *
+ *  @param hsdmmc Context information of the controller.
+ *
+ *  @return TEGRABL_NO_ERROR if the card matches, error code otherwise.
+ */
+tegrabl_error_t sdmmc_tuning_record_check_cid(struct tegrabl_sdmmc *hsdmmc);
+
+/** @brief Verifies the mode applied from the tuning record with a single
+ *         ext csd read at the final bus speed.
+ *
+ *  @param hsdmmc Context information of the controller.
+ *
+ *  @return TEGRABL_NO_ERROR if the card reports the expected timing and
+ *          bus width, error code otherwise.
+ */
+tegrabl_error_t sdmmc_tuning_record_verify(struct tegrabl_sdmmc *hsdmmc);
+
+/** @brief Fills the tuning record with the outcome of the current init.
+ *
+ *  @param hsdmmc Context information of the controller.
+ */
+void sdmmc_tuning_record_update(struct tegrabl_sdmmc *hsdmmc);
+
+/** @brief Marks the tuning record as unusable.
+ *
+ *  @param hsdmmc Context information of the controller.
+ */
+void sdmmc_tuning_record_invalidate(struct tegrabl_sdmmc *hsdmmc);
+
+#endif /* TEGRABL_SDMMC_TUNING_H */
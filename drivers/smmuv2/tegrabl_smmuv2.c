@@ -14,6 +14,7 @@
 #include <tegrabl_ar_macro.h>
 #include <inttypes.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 #include <tegrabl_debug.h>
@@ -65,6 +66,13 @@
 
 #define PAGE_INDEX_SIZE (LEVEL2_PAGE_SHIFT - LEVEL3_PAGE_SHIFT)
 
+/* first level which can hold a leaf entry, 1G blocks with a 4K granule */
+#define BLOCK_START_LEVEL 1
+
+/* leaf invalidations collected before falling back to the whole context */
+#define TLB_BATCH_MAX 16U
+
+#define PTE_TYPE_MASK		3
 #define PTE_TYPE_BLOCK		1
 #define PTE_TYPE_TABLE		3
 #define PTE_TYPE_PAGE		3
@@ -100,11 +108,29 @@ static struct {
 	{ LEVEL3_PAGE_SIZE, LEVEL3_PAGE_SHIFT },
 };
 
+struct tlb_batch {
+	unsigned long iova[TLB_BATCH_MAX];
+	uint32_t nr;
+	bool all;
+};
+
 static inline uint64_t table_index(unsigned long iova, int level)
 {
 	return (iova >> tt_level[level].shift) & ((1 << PAGE_INDEX_SIZE) - 1);
 }
 
+static inline bool pte_is_table(uint64_t pte, int level)
+{
+	return (level < MAX_PAGE_TABLE_LEVEL - 1) &&
+		((pte & PTE_TYPE_MASK) == PTE_TYPE_TABLE);
+}
+
+/* bytes from iova to the end of the entry covering it at the given level */
+static inline uint64_t level_remain(unsigned long iova, int level)
+{
+	return tt_level[level].size - (iova & (tt_level[level].size - 1));
+}
+
 static void *tegrabl_smmu_alloc_pages(size_t size)
 {
 	void *pages = tegrabl_alloc_align(TEGRABL_HEAP_DMA, PAGE_SIZE, size);
@@ -139,15 +165,16 @@ static void tlb_inv_and_sync(void)
 	} while ((reg & tlbgstatus.GSACTIVE) != 0U);
 }
 
-static void cb_tlb_inv_and_sync(unsigned long iova, uint32_t cb)
+static void cb_tlb_inv(unsigned long iova, uint32_t cb)
 {
-	uint32_t reg;
-
-	wmb();
-
 	iova >>= 12;
 	iova |= (uint64_t)cb << 48;
 	cb_write64(cb, cb_offs.S1_TLBIVAL, iova);
+}
+
+static void cb_tlb_sync(uint32_t cb)
+{
+	uint32_t reg;
 
 	cb_write(cb, cb_offs.TLBSYNC, 0);
 	do {
@@ -155,18 +182,49 @@ static void cb_tlb_inv_and_sync(unsigned long iova, uint32_t cb)
 	} while ((reg & tlbgstatus.GSACTIVE) != 0U);
 }
 
-static void tlb_inv_sync_context(uint32_t cb)
+static void cb_tlb_inv_and_sync(unsigned long iova, uint32_t cb)
 {
-	uint32_t reg;
+	wmb();
+
+	cb_tlb_inv(iova, cb);
+	cb_tlb_sync(cb);
+}
 
+static void tlb_inv_sync_context(uint32_t cb)
+{
 	wmb();
 
 	cb_write(cb, cb_offs.S1_TLBIASID, cb);
+	cb_tlb_sync(cb);
+}
 
-	cb_write(cb, cb_offs.TLBSYNC, 0);
-	do {
-		reg = cb_read(cb, cb_offs.TLBSTATUS);
-	} while ((reg & tlbgstatus.GSACTIVE) != 0U);
+static void tlb_batch_add(struct tlb_batch *batch, unsigned long iova)
+{
+	if (batch->nr < TLB_BATCH_MAX)
+		batch->iova[batch->nr++] = iova;
+	else
+		batch->all = true;
+}
+
+/*
+ * Invalidates all the leaf entries cleared since the batch was started with a
+ * single sync, or the whole context if there were too many to track.
+ */
+static void tlb_batch_flush(struct tlb_batch *batch, uint32_t cb)
+{
+	uint32_t i;
+
+	if (batch->all) {
+		tlb_inv_sync_context(cb);
+	} else if (batch->nr != 0U) {
+		wmb();
+		for (i = 0; i < batch->nr; i++)
+			cb_tlb_inv(batch->iova[i], cb);
+		cb_tlb_sync(cb);
+	}
+
+	batch->nr = 0;
+	batch->all = false;
 }
 
 static uint32_t allocate_smr(void)
@@ -392,6 +450,7 @@ tegrabl_error_t tegrabl_smmu_add_device(const void *fdt, int32_t node_offset,
 		err = TEGRABL_ERR_NO_MEMORY;
 		goto free_cb;
 	}
+	memset(priv, 0, sizeof(*priv));
 	priv->sid = sid;
 	priv->cb = cb;
 
@@ -403,6 +462,7 @@ tegrabl_error_t tegrabl_smmu_add_device(const void *fdt, int32_t node_offset,
 
 	program_s2cr(sid, cb);
 
+	smmu.devs[cb] = priv;
 	*data = priv;
 
 	return err;
@@ -427,7 +487,7 @@ static void free_page_table(int lvl, uint64_t *tt_pte)
 	while (tt_pte != end) {
 		uint64_t pte = *tt_pte++;
 
-		if (!pte)
+		if (!pte_is_table(pte, lvl))
 			continue;
 
 		free_page_table(lvl + 1, (uint64_t *)(pte & PTE_ADDR_MASK));
@@ -442,8 +502,12 @@ void tegrabl_smmu_remove_device(void *data)
 	uint32_t sid = priv->sid;
 	uint32_t cb = priv->cb;
 
+	pr_debug("SMMU: cb %u mapping cache %"PRIu64" hits, %"PRIu64" misses\n",
+			 cb, priv->cache_hits, priv->cache_misses);
+
 	free_smr(sid);
 
+	smmu.devs[cb] = NULL;
 	tlb_inv_sync_context(priv->cb);
 	free_page_table(PAGE_TABLE_START_LEVEL, priv->table_base);
 	tegrabl_free(priv);
@@ -524,21 +588,26 @@ static void install_table_pte(uint64_t *table, uint64_t *tt_pte)
 	tegrabl_arch_clean_dcache_range((uintptr_t)tt_pte, sizeof(*tt_pte));
 }
 
-static void install_block_pte(uint64_t paddr, int prot, int lvl, uint64_t *pte)
+static uint64_t leaf_pte(uint64_t paddr, int prot, int lvl)
 {
-	*pte |= PTE_FLAGS;
+	uint64_t pte = PTE_FLAGS;
 
 	if (!(prot & SMMU_WRITE) && (prot & SMMU_READ))
-		*pte |= PTE_AP_RDONLY;
+		pte |= PTE_AP_RDONLY;
 
-	*pte |= (MAIR_ATTR_IDX_CACHE << PTE_ATTRINDX_SHIFT);
+	pte |= (MAIR_ATTR_IDX_CACHE << PTE_ATTRINDX_SHIFT);
 
 	if (lvl == MAX_PAGE_TABLE_LEVEL - 1)
-		*pte |= PTE_TYPE_PAGE;
+		pte |= PTE_TYPE_PAGE;
 	else
-		*pte |= PTE_TYPE_BLOCK;
+		pte |= PTE_TYPE_BLOCK;
 
-	*pte |= paddr;
+	return pte | paddr;
+}
+
+static void install_block_pte(uint64_t paddr, int prot, int lvl, uint64_t *pte)
+{
+	*pte |= leaf_pte(paddr, prot, lvl);
 
 	tegrabl_arch_clean_dcache_range((uintptr_t)pte, sizeof(*pte));
 }
@@ -550,31 +619,138 @@ static void clear_pte(uint64_t *pte)
 	tegrabl_arch_clean_dcache_range((uintptr_t)pte, sizeof(*pte));
 }
 
-tegrabl_error_t tegrabl_smmu_enable_prot(void *data, unsigned long iova,
-				uint64_t paddr, size_t size, int prot)
+/* true if no leaf entry is reachable from the table */
+static bool table_is_empty(int lvl, const uint64_t *table)
 {
-	tegrabl_error_t err = TEGRABL_NO_ERROR;
-	unsigned long orig_iova = iova;
-	struct priv_data *priv = data;
-	size_t orig_size = size;
+	uint32_t i;
 
-	if (!(prot & (SMMU_READ | SMMU_WRITE)))
-		return TEGRABL_ERR_NO_ACCESS;
+	for (i = 0; i < (1U << PAGE_INDEX_SIZE); i++) {
+		if (!table[i])
+			continue;
+		if (!pte_is_table(table[i], lvl) ||
+		    !table_is_empty(lvl + 1, (uint64_t *)(table[i] & PTE_ADDR_MASK)))
+			return false;
+	}
 
-	if (!size || !IS_ALIGNED(size, PAGE_SIZE))
-		return TEGRABL_ERR_INVALID;
+	return true;
+}
+
+/*
+ * Replaces the block entry at tt_pte by a table of next level entries mapping
+ * the same range with the same attributes.
+ */
+static tegrabl_error_t split_block_pte(uint64_t *tt_pte, int lvl,
+				       unsigned long iova, uint32_t cb)
+{
+	uint64_t attrs = *tt_pte & ~(PTE_ADDR_MASK | PTE_TYPE_MASK);
+	uint64_t paddr = *tt_pte & PTE_ADDR_MASK;
+	uint64_t type = PTE_TYPE_BLOCK;
+	uint64_t *table;
+	uint32_t i;
+
+	if (lvl + 1 == MAX_PAGE_TABLE_LEVEL - 1)
+		type = PTE_TYPE_PAGE;
+
+	table = tegrabl_smmu_alloc_pages(TABLE_SIZE);
+	if (!table)
+		return TEGRABL_ERR_NO_MEMORY;
 
+	for (i = 0; i < (1U << PAGE_INDEX_SIZE); i++)
+		table[i] = attrs | type | (paddr + i * tt_level[lvl + 1].size);
+
+	tegrabl_arch_clean_dcache_range((uintptr_t)table, TABLE_SIZE);
+
+	/* break before make, the walker must not see both translations */
+	clear_pte(tt_pte);
+	cb_tlb_inv_and_sync(iova, cb);
+	install_table_pte(table, tt_pte);
+
+	return TEGRABL_NO_ERROR;
+}
+
+/*
+ * Returns true if a leaf entry in [iova, iova + size) maps another address or
+ * with other permissions than the mapping about to be added
+ */
+static bool smmu_map_conflicts(struct priv_data *priv, unsigned long iova,
+			       uint64_t paddr, size_t size, int prot)
+{
 	while (size) {
 		uint64_t *table = (uint64_t *)priv->table_base;
+		uint64_t step = PAGE_SIZE;
+		int lvl;
+
+		for (lvl = 0; lvl < MAX_PAGE_TABLE_LEVEL; lvl++) {
+			uint64_t pte = table[table_index(iova, lvl)];
+			uint64_t offset = iova & (tt_level[lvl].size - 1);
+
+			step = level_remain(iova, lvl);
+			if (!pte)
+				break;
+
+			if (pte_is_table(pte, lvl)) {
+				table = (uint64_t *)(pte & PTE_ADDR_MASK);
+				continue;
+			}
+
+			if (pte != leaf_pte(paddr - offset, prot, lvl)) {
+				pr_error("SMMU: iova %lx already mapped as %"PRIx64"\n",
+					 iova, pte);
+				return true;
+			}
+			break;
+		}
+
+		step = MIN(step, size);
+		iova += step;
+		paddr += step;
+		size -= step;
+	}
+
+	return false;
+}
+
+/*
+ * Maps [iova, iova + size) with the largest entries the alignment of iova and
+ * paddr allows. Parts already covered by a leaf entry are left as they are,
+ * smmu_map_conflicts() has checked that they match.
+ */
+static tegrabl_error_t smmu_map(struct priv_data *priv, unsigned long iova,
+				uint64_t paddr, size_t size, int prot)
+{
+	while (size) {
+		uint64_t *table = (uint64_t *)priv->table_base;
+		uint64_t step = PAGE_SIZE;
 		int lvl;
 
 		for (lvl = 0; lvl < MAX_PAGE_TABLE_LEVEL; lvl++) {
 			uint64_t tbl_idx = table_index(iova, lvl);
 			uint64_t *tt_pte = table + tbl_idx;
+			uint64_t blk_size = tt_level[lvl].size;
 			uint64_t *tt_next;
+			bool fits;
+
+			if (*tt_pte && !pte_is_table(*tt_pte, lvl)) {
+				step = level_remain(iova, lvl);
+				break;
+			}
 
-			if (tt_level[lvl].size == PAGE_SIZE) {
+			fits = (lvl >= BLOCK_START_LEVEL) &&
+				IS_ALIGNED((iova | paddr), blk_size) && (size >= blk_size);
+
+			/* tables emptied by earlier unmaps are given back for a block */
+			if (fits && *tt_pte) {
+				tt_next = (uint64_t *)(*tt_pte & PTE_ADDR_MASK);
+				if (table_is_empty(lvl + 1, tt_next)) {
+					clear_pte(tt_pte);
+					cb_tlb_inv_and_sync(iova, priv->cb);
+					free_page_table(lvl + 1, tt_next);
+				}
+			}
+
+			if (fits && !*tt_pte) {
 				install_block_pte(paddr, prot, lvl, tt_pte);
+				step = blk_size;
 				break;
 			}
 
@@ -584,44 +760,41 @@ tegrabl_error_t tegrabl_smmu_enable_prot(void *data, unsigned long iova,
 			}
 
 			tt_next = tegrabl_smmu_alloc_pages(TABLE_SIZE);
-			if (!tt_next) {
-				err = TEGRABL_ERR_NO_MEMORY;
-				break;
-			}
+			if (!tt_next)
+				return TEGRABL_ERR_NO_MEMORY;
 
 			install_table_pte(tt_next, tt_pte);
 
 			table = tt_next;
 		}
 
-		if (err != TEGRABL_NO_ERROR)
-			break;
-
-		iova += PAGE_SIZE;
-		paddr += PAGE_SIZE;
-		size -= PAGE_SIZE;
-	}
-
-	wmb();
-
-	if (size) {
-		tegrabl_smmu_disable_prot(priv, orig_iova, orig_size);
-		return TEGRABL_ERR_INVALID;
+		step = MIN(step, size);
+		iova += step;
+		paddr += step;
+		size -= step;
 	}
 
 	return TEGRABL_NO_ERROR;
 }
 
-size_t tegrabl_smmu_disable_prot(void *data, unsigned long iova, size_t size)
+/*
+ * Unmaps [iova, iova + size), splitting the blocks which are only partly
+ * covered. All the cleared entries are invalidated with a single sync at the
+ * end. With strict set a hole in the range is an error and 0 is returned,
+ * otherwise holes are skipped.
+ */
+static size_t smmu_unmap(struct priv_data *priv, unsigned long iova,
+			 size_t size, bool strict)
 {
-	struct priv_data *priv = data;
+	struct tlb_batch batch;
 	size_t unmapped = 0UL;
 
-	if (!size || !IS_ALIGNED(size, PAGE_SIZE))
-		return 0;
+	batch.nr = 0;
+	batch.all = false;
 
 	while (unmapped < size) {
 		uint64_t *table = (uint64_t *)priv->table_base;
+		uint64_t step = PAGE_SIZE;
 		int lvl;
 
 		for (lvl = 0; lvl < MAX_PAGE_TABLE_LEVEL; lvl++) {
@@ -629,26 +802,215 @@ size_t tegrabl_smmu_disable_prot(void *data, unsigned long iova, size_t size)
 			uint64_t *tt_pte = table + tbl_idx;
 
 			if (*tt_pte == 0U) {
-				pr_error("No PTE mappings found for iova %lx\n", iova);
-				return 0;
+				if (strict) {
+					pr_error("No PTE mappings found for iova %lx\n", iova);
+					unmapped = 0;
+					goto done;
+				}
+				step = level_remain(iova, lvl);
+				break;
 			}
 
-			if (tt_level[lvl].size == PAGE_SIZE) {
-				clear_pte(tt_pte);
-				cb_tlb_inv_and_sync(iova, priv->cb);
-				break;
+			if (!pte_is_table(*tt_pte, lvl) &&
+			    ((level_remain(iova, lvl) != tt_level[lvl].size) ||
+			     (size - unmapped < tt_level[lvl].size))) {
+				if (split_block_pte(tt_pte, lvl, iova, priv->cb) !=
+						TEGRABL_NO_ERROR) {
+					pr_error("Failed to split block at iova %lx\n", iova);
+					goto done;
+				}
+			}
+
+			if (pte_is_table(*tt_pte, lvl)) {
+				table = (uint64_t *)(*tt_pte & PTE_ADDR_MASK);
+				continue;
 			}
 
-			table = (uint64_t *)(*tt_pte & PTE_ADDR_MASK);
+			clear_pte(tt_pte);
+			tlb_batch_add(&batch, iova);
+			step = tt_level[lvl].size;
+			break;
 		}
 
-		iova += PAGE_SIZE;
-		unmapped += PAGE_SIZE;
+		iova += step;
+		unmapped += step;
+	}
+
+done:
+	tlb_batch_flush(&batch, priv->cb);
+
+	return MIN(unmapped, size);
+}
+
+static bool cache_overlaps(const struct smmu_map_cache_entry *entry,
+			   unsigned long iova, size_t size)
+{
+	return (entry->size != 0U) && (iova < entry->iova + entry->size) &&
+		(entry->iova < iova + size);
+}
+
+static bool cache_contains(const struct smmu_map_cache_entry *entry,
+			   unsigned long iova, size_t size)
+{
+	return (entry->size != 0U) && (iova >= entry->iova) &&
+		(iova + size <= entry->iova + entry->size);
+}
+
+/*
+ * drops every cached mapping overlapping [iova, iova + size) as its page
+ * tables are about to change; idle ones are unmapped in full, busy ones are
+ * only forgotten and get unmapped through disable_prot once their holder
+ * calls tegrabl_smmu_unmap_cached()
+ */
+static void cache_evict_overlaps(struct priv_data *priv, unsigned long iova,
+				 size_t size)
+{
+	struct smmu_map_cache_entry *entry;
+	uint32_t i;
+
+	for (i = 0; i < SMMU_MAP_CACHE_SIZE; i++) {
+		entry = &priv->cache[i];
+		if (!cache_overlaps(entry, iova, size))
+			continue;
+		if (entry->refs == 0U)
+			(void)smmu_unmap(priv, entry->iova, entry->size, false);
+		entry->size = 0;
+		entry->refs = 0;
+	}
+}
+
+tegrabl_error_t tegrabl_smmu_enable_prot(void *data, unsigned long iova,
+				uint64_t paddr, size_t size, int prot)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	struct priv_data *priv = data;
+
+	if (!(prot & (SMMU_READ | SMMU_WRITE)))
+		return TEGRABL_ERR_NO_ACCESS;
+
+	if (!size || !IS_ALIGNED(size, PAGE_SIZE) ||
+	    !IS_ALIGNED((iova | paddr), PAGE_SIZE))
+		return TEGRABL_ERR_INVALID;
+
+	cache_evict_overlaps(priv, iova, size);
+
+	if (smmu_map_conflicts(priv, iova, paddr, size, prot))
+		return TEGRABL_ERR_ALREADY_EXISTS;
+
+	err = smmu_map(priv, iova, paddr, size, prot);
+
+	wmb();
+
+	if (err != TEGRABL_NO_ERROR) {
+		(void)smmu_unmap(priv, iova, size, false);
+		return TEGRABL_ERR_INVALID;
 	}
 
+	return TEGRABL_NO_ERROR;
+}
+
+size_t tegrabl_smmu_disable_prot(void *data, unsigned long iova, size_t size)
+{
+	struct priv_data *priv = data;
+	size_t unmapped;
+
+	if (!size || !IS_ALIGNED(size, PAGE_SIZE))
+		return 0;
+
+	unmapped = smmu_unmap(priv, iova, size, true);
+
+	cache_evict_overlaps(priv, iova, size);
+
 	return unmapped;
 }
 
+tegrabl_error_t tegrabl_smmu_map_cached(void *data, unsigned long iova,
+				uint64_t paddr, size_t size, int prot)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	struct priv_data *priv = data;
+	struct smmu_map_cache_entry *entry;
+	struct smmu_map_cache_entry *slot = NULL;
+	uint32_t i;
+
+	priv->cache_tick++;
+
+	for (i = 0; i < SMMU_MAP_CACHE_SIZE; i++) {
+		entry = &priv->cache[i];
+		if (cache_contains(entry, iova, size) &&
+		    ((paddr - iova) == (entry->paddr - entry->iova)) &&
+		    ((entry->prot & prot) == prot)) {
+			entry->refs++;
+			entry->last_use = priv->cache_tick;
+			priv->cache_hits++;
+			return TEGRABL_NO_ERROR;
+		}
+	}
+	priv->cache_misses++;
+
+	err = tegrabl_smmu_enable_prot(data, iova, paddr, size, prot);
+	if (err != TEGRABL_NO_ERROR)
+		return err;
+
+	/* take a free slot, else the least recently used idle one */
+	for (i = 0; i < SMMU_MAP_CACHE_SIZE; i++) {
+		entry = &priv->cache[i];
+		if (entry->size == 0U) {
+			slot = entry;
+			break;
+		}
+		if ((entry->refs == 0U) &&
+		    ((slot == NULL) || (entry->last_use < slot->last_use)))
+			slot = entry;
+	}
+
+	/* all the slots are in use, the mapping is simply not cached */
+	if (slot == NULL)
+		return TEGRABL_NO_ERROR;
+
+	if (slot->size != 0U)
+		(void)smmu_unmap(priv, slot->iova, slot->size, false);
+
+	slot->iova = iova;
+	slot->paddr = paddr;
+	slot->size = size;
+	slot->prot = prot;
+	slot->refs = 1;
+	slot->last_use = priv->cache_tick;
+
+	return TEGRABL_NO_ERROR;
+}
+
+size_t tegrabl_smmu_unmap_cached(void *data, unsigned long iova, size_t size)
+{
+	struct priv_data *priv = data;
+	struct smmu_map_cache_entry *entry;
+	uint32_t i;
+
+	for (i = 0; i < SMMU_MAP_CACHE_SIZE; i++) {
+		entry = &priv->cache[i];
+		if ((entry->refs != 0U) && cache_contains(entry, iova, size)) {
+			entry->refs--;
+			return size;
+		}
+	}
+
+	return tegrabl_smmu_disable_prot(data, iova, size);
+}
+
+void tegrabl_smmu_flush_cached(void)
+{
+	uint32_t cb;
+
+	if (!smmu.devs)
+		return;
+
+	for (cb = 0; cb < smmu.nr_cb; cb++) {
+		if (smmu.devs[cb])
+			cache_evict_overlaps(smmu.devs[cb], 0, ~0UL);
+	}
+}
+
 tegrabl_error_t tegrabl_smmu_init(void)
 {
 	uint64_t hw_pgsize;
@@ -663,11 +1025,18 @@ tegrabl_error_t tegrabl_smmu_init(void)
 	smmu.cbs = tegrabl_calloc(smmu.nr_cb, sizeof(*smmu.cbs));
 	if (!smmu.cbs)
 		return TEGRABL_ERR_NO_MEMORY;
+	smmu.devs = tegrabl_calloc(smmu.nr_cb, sizeof(*smmu.devs));
+	if (!smmu.devs) {
+		tegrabl_free(smmu.cbs);
+		return TEGRABL_ERR_NO_MEMORY;
+	}
 
 	reg = smmu_read32(grs0_offs.IDR0);
 	smmu.nr_smr = BIT_RSH(reg, idr0.NUMSMRG);
 	smmu.smr = tegrabl_calloc(smmu.nr_smr, sizeof(*smmu.smr));
-	if (!smmu.cbs) {
+	if (!smmu.smr) {
+		tegrabl_free(smmu.devs);
+		smmu.devs = NULL;
 		tegrabl_free(smmu.cbs);
 		return TEGRABL_ERR_NO_MEMORY;
 	}
@@ -681,5 +1050,7 @@ void tegrabl_smmu_deinit(void)
 	smmu_write32(grs0_offs.CR0, cr0.CLIENTPD);
 
 	tegrabl_free(smmu.smr);
+	tegrabl_free(smmu.devs);
+	smmu.devs = NULL;
 	tegrabl_free(smmu.cbs);
 }
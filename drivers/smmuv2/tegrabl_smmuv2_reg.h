@@ -28,16 +28,34 @@ struct SMMU {
 	uint32_t nr_pages;
 	uint32_t nr_cb;
 	uint32_t *cbs;
+	/* device using each context bank, NULL if free */
+	struct priv_data **devs;
 	void *table_base;
 	uint32_t nr_smr;
 	uint32_t *smr;
 	uint32_t in_addr_size;
 } smmu;
 
+/* number of I/O mappings kept alive per device after their last user */
+#define SMMU_MAP_CACHE_SIZE 8U
+
+struct smmu_map_cache_entry {
+	unsigned long iova;
+	uint64_t paddr;
+	size_t size;		/* 0 if the slot is free */
+	int prot;
+	uint32_t refs;
+	uint64_t last_use;
+};
+
 struct priv_data {
 	uint32_t cb;
 	uint32_t sid;
 	void *table_base;
+	struct smmu_map_cache_entry cache[SMMU_MAP_CACHE_SIZE];
+	uint64_t cache_tick;
+	uint64_t cache_hits;
+	uint64_t cache_misses;
 };
 
 struct GRS0_offset {
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2020, NVIDIA Corporation.  All rights reserved.
+ * Copyright (c) 2016-2023, NVIDIA Corporation.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property
  * and proprietary rights in and to this software and related documentation
@@ -3088,6 +3088,43 @@ tegrabl_error_t tegrabl_ufs_get_manufacture_id(uint16_t *manufacture_id)
 	return err;
 }
 
+/**
+ * @brief Checks if blocks erased by tegrabl_ufs_erase() read back as zeros.
+ * Partial erase is an UNMAP, which only a thin provisioned LUN with TPRZ set
+ * is required to follow with zeros.
+ *
+ * @param lun_id LUN to be erased
+ * @param is_zero true if erased blocks read back as zeros (output)
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error
+ */
+tegrabl_error_t tegrabl_ufs_erase_reads_zero(uint8_t lun_id, bool *is_zero)
+{
+	uint8_t boot_lun_type;
+	uint8_t lun_type;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	*is_zero = false;
+
+	/* tegrabl_ufs_erase() refuses partial erase on a fully provisioned
+	 * boot LUN, whatever the LUN being erased */
+	error = tegrabl_ufs_get_provisioning_type(pufs_context->boot_lun,
+											  &boot_lun_type);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	error = tegrabl_ufs_get_provisioning_type(lun_id, &lun_type);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	*is_zero = (boot_lun_type != UFS_PROVISIONING_FULL) &&
+			   (lun_type == UFS_PROVISIONING_THIN_TPRZ);
+
+	return TEGRABL_NO_ERROR;
+}
+
 tegrabl_error_t
 tegrabl_ufs_get_provisioning_type(uint32_t lun, uint8_t *provision_type)
 {
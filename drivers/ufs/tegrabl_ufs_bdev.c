@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2018, NVIDIA Corporation.  All rights reserved.
+ * Copyright (c) 2015-2023, NVIDIA Corporation.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property
  * and proprietary rights in and to this software and related documentation
@@ -45,10 +45,6 @@ static tegrabl_error_t tegrabl_ufs_bdev_ioctl(
 	struct tegrabl_ufs_context *context = NULL;
 #if defined(CONFIG_ENABLE_UFS_RPMB)
 	uint32_t counter = 0;
-#else
-	TEGRABL_UNUSED(dev);
-	TEGRABL_UNUSED(ioctl);
-	TEGRABL_UNUSED(argp);
 #endif
 	if (dev == NULL) {
 		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
@@ -78,6 +74,14 @@ static tegrabl_error_t tegrabl_ufs_bdev_ioctl(
 	case TEGRABL_IOCTL_BLOCK_DEV_SUSPEND:
 		error = tegrabl_ufs_hibernate_enter();
 		break;
+	case TEGRABL_IOCTL_ERASE_READS_ZERO:
+		if (tegrabl_blockdev_get_storage_type(dev) == TEGRABL_STORAGE_UFS_RPMB) {
+			error = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 1);
+			break;
+		}
+		error = tegrabl_ufs_erase_reads_zero(
+					((struct ufs_priv_data *)dev->priv_data)->lun_id, argp);
+		break;
 	default:
 		pr_debug("Unknown ioctl %"PRIu32"\n", ioctl);
 		error = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2018, NVIDIA Corporation.  All rights reserved.
+ * Copyright (c) 2016-2023, NVIDIA Corporation.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property
  * and proprietary rights in and to this software and related documentation
@@ -363,6 +363,10 @@ struct dme_cmd {
 #define UFS_UNIT_DESC_QLOGICAL_BLOCK_COUNT	0xBU
 #define UFS_UNIT_DESC_ERASE_BLOCK_SIZE		0x13U
 #define UFS_UNIT_DESC_PROVISIONING_TYPE		0x17U
+
+/* bProvisioningType values */
+#define UFS_PROVISIONING_FULL			0x0U
+#define UFS_PROVISIONING_THIN_TPRZ		0x3U
 #define UFS_UNIT_DESC_QPHY_MEM_RSRC_COUNT	0x18U
 
 /* Well known logical unit id in LUN field of UPIU */
@@ -677,6 +681,7 @@ tegrabl_error_t tegrabl_ufs_get_provisioning_type(uint32_t lun,
 	uint8_t *provision_type);
 tegrabl_error_t tegrabl_ufs_erase(struct tegrabl_bdev *dev, uint8_t lun_id, uint32_t start_block,
 					uint32_t blocks);
+tegrabl_error_t tegrabl_ufs_erase_reads_zero(uint8_t lun_id, bool *is_zero);
 uint8_t tegrabl_ufs_is_rpmb_lun_supported(void);
 tegrabl_error_t tegrabl_ufs_get_lun_capacity(uint8_t lun_id, uint32_t *block_size_log2,
 						uint32_t *block_count);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -20,6 +20,7 @@
 #include <tegrabl_addressmap.h>
 #include <tegrabl_malloc.h>
 #include <tegrabl_io.h>
+#include <tegrabl_utils.h>
 
 #include <tegrabl_usbf.h>
 #include <tegrabl_transport_usbf.h>
@@ -36,7 +37,7 @@
 #define FASTBOOT_USB_VID_PROP_NAME "nvidia,fastboot-usb-vid"
 #endif
 
-#define MAX_TFR_LENGTH	 (64U * 1024U)
+#define MAX_TFR_LENGTH	 TEGRABL_USBF_MAX_QUEUED_LENGTH
 #define MAX_TCM_BUFFER_SUPPORTED 1024U
 
 #define MAX_SERIALNO_LEN 32
@@ -461,14 +462,84 @@ static bool is_buffer_from_tcm(const void *buf)
 		return false;
 }
 
+static uint32_t transport_usbf_timeout_us(time_t timeout)
+{
+	if (timeout >= (0xFFFFFFFFULL / 1000ULL)) {
+		return 0xFFFFFFFFUL;
+	}
+	return (uint32_t)timeout * 1000U;
+}
+
+/* Abort the requests left queued after a failure, so that they do not show up
+ * as completions of a later transfer. Stops once the queue is empty.
+ */
+static void transport_usbf_drain(bool is_in)
+{
+	tegrabl_error_t retval = TEGRABL_NO_ERROR;
+
+	while (retval == TEGRABL_NO_ERROR) {
+		if (is_in) {
+			retval = tegrabl_usbf_transmit_abort();
+		} else {
+			retval = tegrabl_usbf_receive_abort();
+		}
+	}
+}
+
+/* Split the buffer in MAX_TFR_LENGTH requests and keep up to
+ * TEGRABL_USBF_QUEUE_DEPTH of them queued on the endpoint, so that the host
+ * is not NAKed while a completed request is reaped.
+ */
+static tegrabl_error_t transport_usbf_queued_xfer(bool is_in, uint8_t *buf,
+												  uint32_t length,
+												  uint32_t *transferred)
+{
+	tegrabl_error_t retval = TEGRABL_NO_ERROR;
+	uint32_t queued = 0;
+	uint32_t count = 0;
+	uint32_t tfr_length;
+	uint32_t bytes = 0;
+
+	while ((queued < length) || (count != 0U)) {
+		while ((queued < length) && (count < TEGRABL_USBF_QUEUE_DEPTH)) {
+			tfr_length = MIN(length - queued, MAX_TFR_LENGTH);
+			if (is_in) {
+				retval = tegrabl_usbf_transmit_queue(buf + queued, tfr_length);
+			} else {
+				retval = tegrabl_usbf_receive_queue(buf + queued, tfr_length);
+			}
+			if (retval != TEGRABL_NO_ERROR) {
+				pr_critical("ERROR: Add to request queue failed\n");
+				goto fail;
+			}
+			queued += tfr_length;
+			count++;
+		}
+
+		if (is_in) {
+			retval = tegrabl_usbf_transmit_dequeue(NULL, &bytes, 0xFFFFFFFFUL);
+		} else {
+			retval = tegrabl_usbf_receive_dequeue(NULL, &bytes, 0xFFFFFFFFUL);
+		}
+		count--;
+		if (retval != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+		*transferred += bytes;
+	}
+	return TEGRABL_NO_ERROR;
+
+fail:
+	transport_usbf_drain(is_in);
+	return retval;
+}
+
 tegrabl_error_t tegrabl_transport_usbf_send(const void *buffer,
 											uint32_t length,
 											uint32_t *bytes_transmitted,
 											time_t timeout)
 {
 	tegrabl_error_t retval = TEGRABL_NO_ERROR;
-	uint32_t tfr_length;
-	uint32_t bytes_sent = 0;
 	uint8_t *buf = (uint8_t *)buffer;
 
 	TEGRABL_UNUSED(timeout);
@@ -488,22 +559,9 @@ tegrabl_error_t tegrabl_transport_usbf_send(const void *buffer,
 		}
 	}
 
-	while (length != 0U) {
-		if (length > MAX_TFR_LENGTH)
-			tfr_length = MAX_TFR_LENGTH;
-		else
-			tfr_length = length;
-
-		retval = tegrabl_usbf_transmit((uint8_t *)buf, tfr_length, &bytes_sent);
-		if (retval != TEGRABL_NO_ERROR) {
-			pr_critical(
-							   "ERROR: Add to request queue failed\n");
-			goto fail;
-		}
-
-		length = length - tfr_length;
-		buf = buf + tfr_length;
-		*bytes_transmitted += bytes_sent;
+	retval = transport_usbf_queued_xfer(true, buf, length, bytes_transmitted);
+	if (retval != TEGRABL_NO_ERROR) {
+		goto fail;
 	}
 	return TEGRABL_NO_ERROR;
 
@@ -517,8 +575,6 @@ tegrabl_error_t tegrabl_transport_usbf_receive(void *buf, uint32_t length,
 											   time_t timeout)
 {
 	tegrabl_error_t retval = TEGRABL_NO_ERROR;
-	uint32_t tfr_length;
-	uint32_t bytes_received = 0;
 	void *dataptr = buf;
 	bool is_tcm_buffer = is_buffer_from_tcm(buf);
 
@@ -536,34 +592,157 @@ tegrabl_error_t tegrabl_transport_usbf_receive(void *buf, uint32_t length,
 		}
 	}
 
-	while (length != 0U) {
-		if (length > MAX_TFR_LENGTH)
-			tfr_length = MAX_TFR_LENGTH;
-		else
-			tfr_length = length;
+	retval = transport_usbf_queued_xfer(false, (uint8_t *)dataptr, length,
+										received);
+	if (retval != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	if (is_tcm_buffer) {
+		memcpy(buf, dataptr, length);
+	}
+
+	return TEGRABL_NO_ERROR;
 
-		retval = tegrabl_usbf_receive((uint8_t *)dataptr, tfr_length,
-					 &bytes_received);
+fail:
+	pr_critical("ERROR: USB RECEIVE FAILED\n");
+	return retval;
+}
+
+tegrabl_error_t tegrabl_transport_usbf_send_submit(const void *buffer,
+												   uint32_t length)
+{
+	if ((buffer == NULL) || is_buffer_from_tcm(buffer) ||
+		(length > MAX_TFR_LENGTH)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 2);
+	}
+
+	return tegrabl_usbf_transmit_queue((uint8_t *)buffer, length);
+}
+
+tegrabl_error_t tegrabl_transport_usbf_send_complete(const void **buffer,
+													 uint32_t *bytes_transmitted,
+													 time_t timeout)
+{
+	tegrabl_error_t retval;
+	uint8_t *buf = NULL;
+
+	retval = tegrabl_usbf_transmit_dequeue(&buf, bytes_transmitted,
+										   transport_usbf_timeout_us(timeout));
+	if (buffer != NULL) {
+		*buffer = buf;
+	}
+	return retval;
+}
+
+tegrabl_error_t tegrabl_transport_usbf_receive_submit(void *buf,
+													  uint32_t length)
+{
+	if ((buf == NULL) || is_buffer_from_tcm(buf) ||
+		(length > MAX_TFR_LENGTH)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 3);
+	}
+
+	return tegrabl_usbf_receive_queue((uint8_t *)buf, length);
+}
+
+tegrabl_error_t tegrabl_transport_usbf_receive_complete(void **buf,
+														uint32_t *received,
+														time_t timeout)
+{
+	tegrabl_error_t retval;
+	uint8_t *dataptr = NULL;
+
+	retval = tegrabl_usbf_receive_dequeue(&dataptr, received,
+										  transport_usbf_timeout_us(timeout));
+	if (buf != NULL) {
+		*buf = dataptr;
+	}
+	return retval;
+}
+
+#if defined(CONFIG_ENABLE_USBF_LOOPBACK)
+tegrabl_error_t tegrabl_transport_usbf_loopback(uint32_t length)
+{
+	tegrabl_error_t retval = TEGRABL_NO_ERROR;
+	uint8_t *pool;
+	uint8_t *buf = NULL;
+	uint32_t queued = 0;
+	uint32_t count = 0;
+	uint32_t received = 0;
+	uint32_t tfr_length;
+	uint32_t bytes = 0;
+	uint32_t sent = 0;
+	uint32_t i;
+	time_t start;
+	time_t elapsed;
+
+	pool = tegrabl_alloc(TEGRABL_HEAP_DMA,
+						 TEGRABL_USBF_QUEUE_DEPTH * MAX_TFR_LENGTH);
+	if (pool == NULL) {
+		pr_error("Failed to allocate memory for usbf loopback\n");
+		return TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 1);
+	}
+
+	pr_info("usbf loopback: echoing %u bytes\n", length);
+	start = tegrabl_get_timestamp_us();
+
+	for (i = 0; (i < TEGRABL_USBF_QUEUE_DEPTH) && (queued < length); i++) {
+		tfr_length = MIN(length - queued, MAX_TFR_LENGTH);
+		retval = tegrabl_usbf_receive_queue(pool + (i * MAX_TFR_LENGTH),
+											tfr_length);
 		if (retval != TEGRABL_NO_ERROR) {
 			goto fail;
 		}
+		queued += tfr_length;
+		count++;
+	}
 
-		if (is_tcm_buffer) {
-			memcpy(buf, dataptr, tfr_length);
+	while (count != 0U) {
+		retval = tegrabl_usbf_receive_dequeue(&buf, &bytes, 0xFFFFFFFFUL);
+		count--;
+		if (retval != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+		received += bytes;
+
+		/* The other buffers keep the OUT endpoint primed meanwhile */
+		if (bytes != 0U) {
+			retval = tegrabl_usbf_transmit(buf, bytes, &sent);
+			if (retval != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
 		}
 
-		*received += bytes_received;
-		length = length - tfr_length;
-
-		dataptr = (uint8_t *)dataptr + tfr_length;
+		if (queued < length) {
+			tfr_length = MIN(length - queued, MAX_TFR_LENGTH);
+			retval = tegrabl_usbf_receive_queue(buf, tfr_length);
+			if (retval != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+			queued += tfr_length;
+			count++;
+		}
 	}
 
-	return TEGRABL_NO_ERROR;
+	elapsed = tegrabl_get_timestamp_us() - start;
+	if (elapsed == 0U) {
+		elapsed = 1U;
+	}
+	pr_info("usbf loopback: %u bytes in %u us, %u KB/s per direction\n",
+			received, (uint32_t)elapsed,
+			(uint32_t)(((uint64_t)received * 1000000ULL) / 1024ULL / elapsed));
 
 fail:
-	pr_critical("ERROR: USB RECEIVE FAILED\n");
+	transport_usbf_drain(false);
+	transport_usbf_drain(true);
+	tegrabl_free(pool);
+	if (retval != TEGRABL_NO_ERROR) {
+		pr_critical("ERROR: USB LOOPBACK FAILED\n");
+	}
 	return retval;
 }
+#endif
 
 #if defined(CONFIG_ENABLE_USBF_SNO)
 static tegrabl_error_t update_usbf_serial_no(void)
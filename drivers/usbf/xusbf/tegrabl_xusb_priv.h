@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015 - 2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015 - 2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -12,6 +12,9 @@
 #define __TEGRABL_XUSB_PRIV_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <tegrabl_error.h>
+#include <tegrabl_usbf.h>
 
 /* Desc macros */
 #define USB_DEV_DESCRIPTOR_SIZE 18
@@ -153,6 +156,29 @@ typedef uint32_t device_state_t;
 #define CONFIGURED 7U
 #define SUSPENDED 8U
 
+/**
+ * @brief Bulk transfer queued on a transfer ring. Each request is a TD of
+ * one normal TRB.
+ */
+struct xusb_bulk_req {
+	uint8_t *buffer;
+	uint32_t bytes;
+	uint32_t actual; /* Bytes transferred, valid once done is set */
+	dma_addr_t trb_dma; /* Address the controller reports in the event */
+	tegrabl_error_t err;
+	bool done;
+};
+
+/**
+ * @brief Requests of a bulk endpoint in submission order
+ */
+struct xusb_bulk_queue {
+	struct xusb_bulk_req req[TEGRABL_USBF_QUEUE_DEPTH];
+	uint32_t head; /* Oldest request not yet returned to the caller */
+	uint32_t count; /* Requests not yet returned to the caller */
+	uint32_t pending; /* Requests without a transfer event yet */
+};
+
 /**
  * @brief USB function interface structure
  */
@@ -169,6 +195,11 @@ struct xusb_device_context {
 	uintptr_t bulkin_epenqueue_ptr;
 	uintptr_t bulkin_epdequeue_ptr;
 	uint32_t bulkin_pcs; /* Producer Cycle State */
+	/* DMA addr of the bulk transfer rings, to match transfer events */
+	dma_addr_t dma_bulkout_ring_start;
+	dma_addr_t dma_bulkin_ring_start;
+	struct xusb_bulk_queue bulkout_queue;
+	struct xusb_bulk_queue bulkin_queue;
 	/* As Consumer (of Event TRBs) */
 	uintptr_t event_enqueue_ptr;
 	uintptr_t event_dequeue_ptr;
@@ -178,8 +209,6 @@ struct xusb_device_context {
 	device_state_t device_state;
 	uint32_t initialized;
 	uint32_t enumerated;
-	uint32_t bytes_txfred;
-	uint32_t tx_count;
 	uint32_t cntrl_seq_num;
 	uint32_t setup_pkt_index;
 	uint32_t config_num;
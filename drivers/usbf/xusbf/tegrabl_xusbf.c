@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2019, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -622,6 +622,11 @@ static tegrabl_error_t tegrabl_init_epcontext(uint8_t ep_index)
 						(void *)&p_txringep1out[0], sizeof(struct data_trb),
 						TEGRABL_DMA_TO_DEVICE);
 
+			/* Requests queued on the old ring are dropped */
+			p_xusb_dev_context->dma_bulkout_ring_start = dma_buf;
+			memset(&p_xusb_dev_context->bulkout_queue, 0,
+				   sizeof(struct xusb_bulk_queue));
+
 			ep_info->trd_dequeueptr_lo = (U64_TO_U32_LO(dma_buf) >> 4);
 			ep_info->trd_dequeueptr_hi = U64_TO_U32_HI(dma_buf);
 
@@ -666,6 +671,11 @@ static tegrabl_error_t tegrabl_init_epcontext(uint8_t ep_index)
 				 (void *)&p_txringep1in[0], sizeof(struct data_trb),
 				 TEGRABL_DMA_TO_DEVICE);
 
+			/* Requests queued on the old ring are dropped */
+			p_xusb_dev_context->dma_bulkin_ring_start = dma_buf;
+			memset(&p_xusb_dev_context->bulkin_queue, 0,
+				   sizeof(struct xusb_bulk_queue));
+
 			ep_info->trd_dequeueptr_lo = (U64_TO_U32_LO(dma_buf) >> 4);
 			ep_info->trd_dequeueptr_hi = U64_TO_U32_HI(dma_buf);
 
@@ -1599,6 +1609,74 @@ static tegrabl_error_t tegrabl_handle_port_status(void)
 	return e;
 }
 
+static struct xusb_bulk_queue *tegrabl_bulk_queue(uint8_t ep_index)
+{
+	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
+
+	if (ep_index == EP1_IN) {
+		return &p_xusb_dev_context->bulkin_queue;
+	}
+	return &p_xusb_dev_context->bulkout_queue;
+}
+
+/* Complete the oldest request still waiting for its transfer event. Each
+ * request is a single TRB with IOC and ISP set, so the controller posts
+ * exactly one event per request and in queue order.
+ */
+static tegrabl_error_t tegrabl_handle_bulk_event(
+		struct transfer_event_trb *p_tx_eventrb)
+{
+	struct xusb_bulk_queue *queue;
+	struct xusb_bulk_req *req;
+	dma_addr_t trb_dma;
+	uint32_t index;
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
+
+	queue = tegrabl_bulk_queue((uint8_t)p_tx_eventrb->emp_id);
+	if (queue->pending == 0U) {
+		pr_error("xusbf: event on ep %u without request\n",
+				 p_tx_eventrb->emp_id);
+		e = TEGRABL_ERROR(TEGRABL_ERR_INVALID_STATE, AUX_INFO_BULK_EVENT);
+		return e;
+	}
+
+	index = (queue->head + queue->count - queue->pending) %
+				TEGRABL_USBF_QUEUE_DEPTH;
+	req = &queue->req[index];
+
+	trb_dma = U64_FROM_U32(p_tx_eventrb->trb_pointer_lo,
+						   p_tx_eventrb->trb_pointer_hi);
+	if (trb_dma != req->trb_dma) {
+		pr_error("xusbf: ep %u event for trb 0x%08x, expected 0x%08x\n",
+				 p_tx_eventrb->emp_id, U64_TO_U32_LO(trb_dma),
+				 U64_TO_U32_LO(req->trb_dma));
+		e = TEGRABL_ERROR(TEGRABL_ERR_MISMATCH, AUX_INFO_BULK_EVENT);
+		return e;
+	}
+
+	/* TRB Tx Len is 0 or the remaining bytes for a short packet. */
+	req->actual = req->bytes - p_tx_eventrb->trb_tx_len;
+	if ((p_tx_eventrb->comp_code == SUCCESS_ERR_CODE) ||
+		(p_tx_eventrb->comp_code == SHORT_PKT_ERR_CODE)) {
+		/* Short packet is not an error for OUT as the host decides the
+		 * size of a transfer, for IN we should not have remaining bytes.
+		 */
+		if ((p_tx_eventrb->emp_id == EP1_IN) &&
+			(p_tx_eventrb->trb_tx_len != 0U)) {
+			req->err = TEGRABL_ERROR(TEGRABL_ERR_TOO_LARGE,
+									 AUX_INFO_BULK_EVENT);
+		}
+	} else {
+		pr_error("xusbf: ep %u comp_code 0x%x\n", p_tx_eventrb->emp_id,
+				 p_tx_eventrb->comp_code);
+		req->err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, AUX_INFO_BULK_EVENT);
+	}
+	req->done = true;
+	queue->pending--;
+
+	return e;
+}
+
 static tegrabl_error_t tegrabl_handle_txfer_event(
 		struct transfer_event_trb *p_tx_eventrb)
 {
@@ -1649,6 +1727,12 @@ static tegrabl_error_t tegrabl_handle_txfer_event(
 		p_xusb_dev_context->bulkin_epdequeue_ptr = (uintptr_t)p_next_trb;
 	}
 
+	/* Bulk events complete the queued requests. */
+	if ((p_tx_eventrb->emp_id == EP1_OUT) ||
+		(p_tx_eventrb->emp_id == EP1_IN)) {
+		return tegrabl_handle_bulk_event(p_tx_eventrb);
+	}
+
 	/* Check for errors. */
 	if ((p_tx_eventrb->comp_code == SUCCESS_ERR_CODE) ||
 		(p_tx_eventrb->comp_code == SHORT_PKT_ERR_CODE)) {
@@ -1676,25 +1760,6 @@ static tegrabl_error_t tegrabl_handle_txfer_event(
 				/* No Action Required */
 			}
 		}
-		if (p_tx_eventrb->emp_id == EP1_IN) {
-			/* TRB Tx Len will be 0 or remaining bytes. */
-			p_xusb_dev_context->bytes_txfred -= p_tx_eventrb->trb_tx_len;
-			p_xusb_dev_context->tx_count--;
-			/* For IN, we should not have remaining bytes. Flag error */
-			if (p_tx_eventrb->trb_tx_len != 0U) {
-				e = TEGRABL_ERROR(TEGRABL_ERR_TOO_LARGE, AUX_INFO_HANDLE_TXFER_EVENT_1);
-				TEGRABL_SET_CRITICAL_STRING(e, "remain bytes", "0");
-				return e;
-			}
-		}
-		if (p_tx_eventrb->emp_id == EP1_OUT) {
-			/* TRB Tx Len will be 0 or remaining bytes for short packet. */
-			p_xusb_dev_context->bytes_txfred -= p_tx_eventrb->trb_tx_len;
-			p_xusb_dev_context->tx_count--;
-			/* Short packet is not necessary an error
-			* because we prime for 4K bytes. */
-		}
-		/* This should be zero except in the case of a short packet. */
 	} else if (p_tx_eventrb->comp_code == CTRL_DIR_ERR_CODE) {
 		e = TEGRABL_ERROR(TEGRABL_ERR_INVALID, AUX_INFO_HANDLE_TXFER_EVENT_1);
 		TEGRABL_SET_CRITICAL_STRING(e, "comp_code:0x%08x", CTRL_DIR_ERR_CODE);
@@ -1865,7 +1930,7 @@ static tegrabl_error_t tegrabl_create_normal_trb(
 	p_normal_trb->trb_tx_len = bytes;
 
 	/* Number of packets remaining.
-	 * BL will always queue only 1 TRB at a time.
+	 * Every TD is a single TRB, so there is nothing left after it.
 	 */
 	p_normal_trb->tdsize = 0;
 	if (dir == DIR_IN) {
@@ -2047,174 +2112,388 @@ tegrabl_error_t tegrabl_usbf_enumerate(uint8_t *buffer)
 	return TEGRABL_NO_ERROR;
 }
 
-tegrabl_error_t tegrabl_usbf_receive(uint8_t *buffer, uint32_t bytes,
-		uint32_t *bytes_received)
+/* Queue a TD of one normal TRB on a bulk endpoint. The doorbell is rung for
+ * every TD; the controller keeps processing the ring, so the endpoint stays
+ * primed as long as requests are queued.
+ */
+static tegrabl_error_t tegrabl_bulk_queue_req(uint8_t ep_index,
+		uint8_t *buffer, uint32_t bytes)
 {
-	tegrabl_error_t e = TEGRABL_NO_ERROR;
-	uint32_t direction;
 	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
+	struct xusb_bulk_queue *queue = tegrabl_bulk_queue(ep_index);
+	struct xusb_bulk_req *req;
+	uintptr_t trb;
+	uint32_t direction;
 	dma_addr_t dma_buf;
+	dma_addr_t ring_dma;
+	uintptr_t ring_start;
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
 
-	if ((buffer == NULL) || (bytes_received == NULL)) {
-		e = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, AUX_INFO_USBF_RECEIVE);
+	if ((buffer == NULL) || (bytes > TEGRABL_USBF_MAX_QUEUED_LENGTH)) {
+		e = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, AUX_INFO_BULK_QUEUE);
 		return e;
 	}
 
-	p_xusb_dev_context->bytes_txfred = bytes;
-	p_xusb_dev_context->tx_count = 0;
-	direction = DIR_OUT;
+	if (queue->count == TEGRABL_USBF_QUEUE_DEPTH) {
+		e = TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, AUX_INFO_BULK_QUEUE);
+		return e;
+	}
 
-	dma_buf = tegrabl_dma_map_buffer(TEGRABL_MODULE_XUSBF, 0,
-				(void *)buffer, bytes, TEGRABL_DMA_FROM_DEVICE);
+	if (ep_index == EP1_IN) {
+		direction = DIR_IN;
+		trb = p_xusb_dev_context->bulkin_epenqueue_ptr;
+		ring_start = (uintptr_t)&p_txringep1in[0];
+		ring_dma = p_xusb_dev_context->dma_bulkin_ring_start;
+		dma_buf = tegrabl_dma_map_buffer(TEGRABL_MODULE_XUSBF, 0,
+					(void *)buffer, bytes, TEGRABL_DMA_TO_DEVICE);
+	} else {
+		direction = DIR_OUT;
+		trb = p_xusb_dev_context->bulkout_epenqueue_ptr;
+		ring_start = (uintptr_t)&p_txringep1out[0];
+		ring_dma = p_xusb_dev_context->dma_bulkout_ring_start;
+		dma_buf = tegrabl_dma_map_buffer(TEGRABL_MODULE_XUSBF, 0,
+					(void *)buffer, bytes, TEGRABL_DMA_FROM_DEVICE);
+	}
+
+	req = &queue->req[(queue->head + queue->count) % TEGRABL_USBF_QUEUE_DEPTH];
+	memset(req, 0, sizeof(struct xusb_bulk_req));
+	req->buffer = buffer;
+	req->bytes = bytes;
+	req->trb_dma = ring_dma + (trb - ring_start);
+
+	/* Account the request before the doorbell, its event can be posted
+	 * before the next poll.
+	 */
+	queue->count++;
+	queue->pending++;
 
-	/* Handle difference in sysram view between host and device. */
 	e = tegrabl_issue_normal_trb(dma_buf, bytes, direction);
 	if (e != TEGRABL_NO_ERROR) {
+		queue->count--;
+		queue->pending--;
+	}
+
+	return e;
+}
+
+static tegrabl_error_t tegrabl_bulk_dequeue_req(uint8_t ep_index,
+		uint8_t **buffer, uint32_t *bytes, uint32_t timeout_us)
+{
+	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
+	struct xusb_bulk_queue *queue = tegrabl_bulk_queue(ep_index);
+	struct xusb_bulk_req *req;
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
+
+	if (bytes == NULL) {
+		e = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, AUX_INFO_BULK_DEQUEUE);
 		return e;
 	}
-	p_xusb_dev_context->tx_count++;
-	while (p_xusb_dev_context->tx_count > 0U) {
-		e = tegrabl_poll_for_event(0xFFFFFFFFUL);
+
+	if (queue->count == 0U) {
+		e = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, AUX_INFO_BULK_DEQUEUE);
+		return e;
+	}
+
+	req = &queue->req[queue->head];
+	while (req->done == false) {
+		e = tegrabl_poll_for_event(timeout_us);
 		if (e != TEGRABL_NO_ERROR) {
-			break;
+			return e;
 		}
+		/* The rings are re-initialized on set configuration, which drops
+		 * the queued requests. They have to be queued again.
+		 */
+		if (queue->count == 0U) {
+			e = TEGRABL_ERROR(TEGRABL_ERR_INVALID_STATE, AUX_INFO_BULK_DEQUEUE);
+			return e;
+		}
+		/* If we get a reset or set config 0, we need to indicate to higher
+		 * level software so that transfer can be scheduled again.
+		 * Being suspended is ok. We should get un-suspended when host
+		 * initiates a transfer.
+		 * Removing cable will also create a suspend condition.
+		 * Ideally this should be a disconnect condition but as we set
+		 * vbus override, this is not the case. In this case, we will
+		 * just wait here to be reconnected at which point we should
+		 * receive a reset.
+		 */
+		if ((p_xusb_dev_context->device_state != CONFIGURED) &&
+			(p_xusb_dev_context->device_state != SUSPENDED)) {
+			e = TEGRABL_ERROR(TEGRABL_ERR_INVALID_STATE, AUX_INFO_BULK_DEQUEUE);
+			return e;
+		}
+	}
+
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_XUSBF, 0, (void *)req->buffer,
+			req->bytes, (ep_index == EP1_IN) ? TEGRABL_DMA_TO_DEVICE :
+			TEGRABL_DMA_FROM_DEVICE);
+
+	if (buffer != NULL) {
+		*buffer = req->buffer;
 	}
-	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_XUSBF, 0,
-				(void *)buffer, bytes, TEGRABL_DMA_FROM_DEVICE);
+	*bytes = req->actual;
+	e = req->err;
 
-	*bytes_received = p_xusb_dev_context->bytes_txfred;
+	queue->head = (queue->head + 1U) % TEGRABL_USBF_QUEUE_DEPTH;
+	queue->count--;
 
 	return e;
 }
 
-tegrabl_error_t tegrabl_usbf_transmit(uint8_t *buffer, uint32_t bytes,
-		uint32_t *bytes_transmitted)
+/* Pause or resume a bulk endpoint and wait for the controller to report
+ * the state change.
+ */
+static tegrabl_error_t tegrabl_pause_ep(uint8_t ep_index, bool pause)
 {
+	uint32_t reg_data;
+	uint32_t mask = 1UL << ep_index;
 	tegrabl_error_t e = TEGRABL_NO_ERROR;
-	uint32_t direction;
-	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
-	dma_addr_t dma_buf;
 
-	if ((buffer == NULL) || (bytes_transmitted == NULL)) {
-		e = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, AUX_INFO_USBF_TRANSMIT);
-		return e;
+	reg_data = NV_READ32(XUSB_BASE + XUSB_DEV_XHCI_EP_PAUSE_0);
+	if (pause) {
+		reg_data |= mask;
+	} else {
+		reg_data &= ~mask;
 	}
+	NV_WRITE32(XUSB_BASE + XUSB_DEV_XHCI_EP_PAUSE_0, reg_data);
 
-	p_xusb_dev_context->bytes_txfred = bytes;
-	p_xusb_dev_context->tx_count = 0;
-	direction = DIR_IN;
+	e = tegrabl_poll_field(XUSB_BASE + XUSB_DEV_XHCI_EP_STCHG_0, mask, mask,
+						   1000);
+	NV_WRITE32(XUSB_BASE + XUSB_DEV_XHCI_EP_STCHG_0, mask);
+	if (e != TEGRABL_NO_ERROR) {
+		e = TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, AUX_INFO_PAUSE_EP);
+	}
 
-	dma_buf = tegrabl_dma_map_buffer(TEGRABL_MODULE_XUSBF, 0,
-					(void *)buffer, bytes, TEGRABL_DMA_TO_DEVICE);
+	return e;
+}
 
-	/* Handle difference in sysram view between host and device. */
-	e = tegrabl_issue_normal_trb(dma_buf, bytes, direction);
+/* Point the endpoint context past the TRB of an aborted request and have the
+ * controller reload it. The endpoint must be paused.
+ */
+static tegrabl_error_t tegrabl_skip_trb(uint8_t ep_index,
+		struct xusb_bulk_req *req)
+{
+	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
+	struct ep_context *ep_info = &p_ep_context[ep_index];
+	struct data_trb *ring;
+	struct data_trb *p_trb;
+	struct data_trb *p_next_trb;
+	dma_addr_t ring_dma;
+	dma_addr_t next_dma;
+	uint32_t mask = 1UL << ep_index;
+	uint32_t dcs;
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
+
+	if (ep_index == EP1_IN) {
+		ring = p_txringep1in;
+		ring_dma = p_xusb_dev_context->dma_bulkin_ring_start;
+	} else {
+		ring = p_txringep1out;
+		ring_dma = p_xusb_dev_context->dma_bulkout_ring_start;
+	}
+
+	/* The TRB after the aborted one; the cycle state flips on the link */
+	p_trb = &ring[(req->trb_dma - ring_dma) / sizeof(struct data_trb)];
+	dcs = p_trb->c;
+	p_next_trb = p_trb + 1;
+	if (p_next_trb->trb_type == LINK_TRB) {
+		p_next_trb = &ring[0];
+		dcs ^= 1U;
+	}
+	next_dma = ring_dma + ((uintptr_t)p_next_trb - (uintptr_t)&ring[0]);
+
+	/* The controller saved its state in the context when it paused */
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_XUSBF, 0, (void *)ep_info,
+							 sizeof(struct ep_context), TEGRABL_DMA_FROM_DEVICE);
+	ep_info->trd_dequeueptr_lo = (U64_TO_U32_LO(next_dma) >> 4);
+	ep_info->trd_dequeueptr_hi = U64_TO_U32_HI(next_dma);
+	ep_info->dcs = dcs;
+	/* Drop what was done of the aborted TD */
+	ep_info->ptd = 0;
+	ep_info->data_offset = 0;
+	(void)tegrabl_dma_map_buffer(TEGRABL_MODULE_XUSBF, 0, (void *)ep_info,
+								 sizeof(struct ep_context), TEGRABL_DMA_TO_DEVICE);
+
+	NV_WRITE32(XUSB_BASE + XUSB_DEV_XHCI_EP_RELOAD_0,
+			   NV_DRF_NUM(XUSB_DEV_XHCI, EP_RELOAD, DCI, mask));
+	e = tegrabl_poll_field(XUSB_BASE + XUSB_DEV_XHCI_EP_RELOAD_0, mask, 0,
+						   1000);
 	if (e != TEGRABL_NO_ERROR) {
-		goto fail;
+		e = TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, AUX_INFO_BULK_ABORT);
 	}
-	p_xusb_dev_context->tx_count++;
 
-	while (p_xusb_dev_context->tx_count > 0U) {
-		e = tegrabl_poll_for_event(0xFFFFFFFFUL);
+	return e;
+}
+
+/* Give up on the oldest request and remove it from the queue whether or not
+ * it completed. If it is still on the ring, the endpoint is paused and its
+ * dequeue pointer moved past the TRB before the buffer is unmapped, so the
+ * controller no longer touches it.
+ */
+static tegrabl_error_t tegrabl_bulk_abort_req(uint8_t ep_index)
+{
+	struct xusb_bulk_queue *queue = tegrabl_bulk_queue(ep_index);
+	struct xusb_bulk_req *req;
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
+
+	if (queue->count == 0U) {
+		e = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, AUX_INFO_BULK_ABORT);
+		return e;
+	}
+
+	req = &queue->req[queue->head];
+	if (req->done == false) {
+		e = tegrabl_pause_ep(ep_index, true);
 		if (e != TEGRABL_NO_ERROR) {
-			break;
+			return e;
+		}
+
+		/* Reap the events posted before the endpoint stopped, the request
+		 * may have completed meanwhile.
+		 */
+		while ((req->done == false) &&
+			   (tegrabl_poll_for_event(1) == TEGRABL_NO_ERROR)) {
+			/* The rings were re-initialized, nothing is left to abort */
+			if (queue->count == 0U) {
+				return e;
+			}
+		}
+
+		if (req->done == false) {
+			e = tegrabl_skip_trb(ep_index, req);
+			if (e != TEGRABL_NO_ERROR) {
+				return e;
+			}
+			queue->pending--;
+		}
+
+		e = tegrabl_pause_ep(ep_index, false);
+		if (e != TEGRABL_NO_ERROR) {
+			return e;
 		}
 	}
 
-	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_XUSBF, 0,
-					(void *)buffer, bytes, TEGRABL_DMA_TO_DEVICE);
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_XUSBF, 0, (void *)req->buffer,
+			req->bytes, (ep_index == EP1_IN) ? TEGRABL_DMA_TO_DEVICE :
+			TEGRABL_DMA_FROM_DEVICE);
 
-	*bytes_transmitted = p_xusb_dev_context->bytes_txfred;
+	queue->head = (queue->head + 1U) % TEGRABL_USBF_QUEUE_DEPTH;
+	queue->count--;
 
-fail:
 	return e;
 }
 
-tegrabl_error_t tegrabl_usbf_receive_start(uint8_t *buffer, uint32_t bytes)
+tegrabl_error_t tegrabl_usbf_receive_queue(uint8_t *buffer, uint32_t bytes)
+{
+	return tegrabl_bulk_queue_req(EP1_OUT, buffer, bytes);
+}
+
+tegrabl_error_t tegrabl_usbf_receive_dequeue(uint8_t **buffer,
+		uint32_t *bytes_received, uint32_t timeout_us)
+{
+	return tegrabl_bulk_dequeue_req(EP1_OUT, buffer, bytes_received,
+									timeout_us);
+}
+
+tegrabl_error_t tegrabl_usbf_receive_abort(void)
+{
+	return tegrabl_bulk_abort_req(EP1_OUT);
+}
+
+tegrabl_error_t tegrabl_usbf_transmit_queue(uint8_t *buffer, uint32_t bytes)
+{
+	return tegrabl_bulk_queue_req(EP1_IN, buffer, bytes);
+}
+
+tegrabl_error_t tegrabl_usbf_transmit_dequeue(uint8_t **buffer,
+		uint32_t *bytes_transmitted, uint32_t timeout_us)
+{
+	return tegrabl_bulk_dequeue_req(EP1_IN, buffer, bytes_transmitted,
+									timeout_us);
+}
+
+tegrabl_error_t tegrabl_usbf_transmit_abort(void)
+{
+	return tegrabl_bulk_abort_req(EP1_IN);
+}
+
+tegrabl_error_t tegrabl_usbf_receive(uint8_t *buffer, uint32_t bytes,
+		uint32_t *bytes_received)
 {
 	tegrabl_error_t e = TEGRABL_NO_ERROR;
-	uint32_t direction;
-	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
-	dma_addr_t dma_buf;
 
-	if (buffer == NULL) {
-		e = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, AUX_INFO_USBF_RECEIVE_START);
+	if ((buffer == NULL) || (bytes_received == NULL)) {
+		e = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, AUX_INFO_USBF_RECEIVE);
 		return e;
 	}
 
-	p_xusb_dev_context->bytes_txfred = bytes;
-	p_xusb_dev_context->tx_count = 0;
-	direction = DIR_OUT;
+	e = tegrabl_usbf_receive_start(buffer, bytes);
+	if (e != TEGRABL_NO_ERROR) {
+		return e;
+	}
 
-	dma_buf = tegrabl_dma_map_buffer(TEGRABL_MODULE_XUSBF, 0,
-					(void *)buffer, bytes, TEGRABL_DMA_TO_DEVICE);
+	return tegrabl_usbf_receive_complete(bytes_received, 0xFFFFFFFFUL);
+}
 
-	/* Handle difference in sysram view between host and device. */
-	e = tegrabl_issue_normal_trb(dma_buf, bytes, direction);
+tegrabl_error_t tegrabl_usbf_transmit(uint8_t *buffer, uint32_t bytes,
+		uint32_t *bytes_transmitted)
+{
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
+
+	if ((buffer == NULL) || (bytes_transmitted == NULL)) {
+		e = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, AUX_INFO_USBF_TRANSMIT);
+		return e;
+	}
+
+	e = tegrabl_usbf_transmit_start(buffer, bytes);
 	if (e != TEGRABL_NO_ERROR) {
 		return e;
 	}
-	p_xusb_dev_context->tx_count++;
 
-	return e;
+	return tegrabl_usbf_transmit_complete(bytes_transmitted, 0xFFFFFFFFUL);
+}
+
+tegrabl_error_t tegrabl_usbf_receive_start(uint8_t *buffer, uint32_t bytes)
+{
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
+
+	if (buffer == NULL) {
+		e = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, AUX_INFO_USBF_RECEIVE_START);
+		return e;
+	}
+
+	return tegrabl_bulk_queue_req(EP1_OUT, buffer, bytes);
 }
 
 tegrabl_error_t tegrabl_usbf_receive_complete(uint32_t *bytes_received,
 		uint32_t timeout_us)
 {
 	tegrabl_error_t e = TEGRABL_NO_ERROR;
-	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
-	dma_addr_t dma_buf;
-
-	TEGRABL_UNUSED(dma_buf);
 
 	if (bytes_received == NULL) {
 		e = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, AUX_INFO_USBF_RECEIVE_COMPLETE);
 		return e;
 	}
 
-	while (p_xusb_dev_context->tx_count > 0U) {
-		e = tegrabl_poll_for_event(timeout_us);
-		if (e != TEGRABL_NO_ERROR) {
-			break;
-		}
-	}
-	*bytes_received = p_xusb_dev_context->bytes_txfred;
-
-	return e;
+	return tegrabl_bulk_dequeue_req(EP1_OUT, NULL, bytes_received, timeout_us);
 }
 
 tegrabl_error_t tegrabl_usbf_transmit_start(uint8_t *buffer, uint32_t bytes)
 {
 	tegrabl_error_t e = TEGRABL_NO_ERROR;
-	uint32_t direction;
-	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
-	dma_addr_t dma_buf;
 
 	if (buffer == NULL) {
 		e = TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, AUX_INFO_USBF_TRANSMIT_START_1);
 		return e;
 	}
 
-	p_xusb_dev_context->bytes_txfred = bytes;
-	p_xusb_dev_context->tx_count = 0;
-	direction = DIR_IN;
-
-	dma_buf = tegrabl_dma_map_buffer(TEGRABL_MODULE_XUSBF, 0,
-					(void *)buffer, bytes, TEGRABL_DMA_TO_DEVICE);
-
-	/* Handle difference in sysram view between host and device. */
-	tegrabl_issue_normal_trb(dma_buf, bytes, direction);
-	p_xusb_dev_context->tx_count++;
-
-	return e;
+	return tegrabl_bulk_queue_req(EP1_IN, buffer, bytes);
 }
 
 tegrabl_error_t tegrabl_usbf_transmit_complete(uint32_t *p_bytes_transferred,
 											   uint32_t timeout)
 {
 	tegrabl_error_t e = TEGRABL_NO_ERROR;
-	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
 
 	(void)timeout;
 
@@ -2223,36 +2502,8 @@ tegrabl_error_t tegrabl_usbf_transmit_complete(uint32_t *p_bytes_transferred,
 		return e;
 	}
 
-	while ((p_xusb_dev_context->tx_count) > 0UL) {
-		e = tegrabl_poll_for_event(0xFFFFFFFFUL);
-		if (e != TEGRABL_NO_ERROR) {
-			break;
-		}
-		/* If we get a reset or set config 0, we need to indicate to higher
-		 * level software so that transfer can be scheduled again.
-		 */
-		if (p_xusb_dev_context->device_state != CONFIGURED) {
-			/* Being suspended is ok. We should get un-suspended when host
-			 * initiates a transfer.
-			 * Removing cable will also create a suspend condition.
-			 * Ideally this should be a disconnect condition but as we set
-			 * vbus override, this is not the case. In this case, we will
-			 * just wait here to be reconnected at which
-			 * point we should receive a reset.
-			 */
-			if (p_xusb_dev_context->device_state != SUSPENDED) {
-				/* This could be a reset or addressed pending state.
-				 * Return same error. In any case, we need to go back into
-				 * enumerate loop and re-schedule the transfer
-				 */
-				/*TODO: Need to define error value */
-				break;
-			}
-		}
-	}
-	*p_bytes_transferred = p_xusb_dev_context->bytes_txfred;
-
-	return e;
+	return tegrabl_bulk_dequeue_req(EP1_IN, NULL, p_bytes_transferred,
+									0xFFFFFFFFUL);
 }
 
 static tegrabl_error_t tegrabl_usbf_setup_static_params_pad(void)
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2019-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -35,6 +35,11 @@
 #define AUX_INFO_USBF_TRANSMIT_START_2			0x14U
 #define AUX_INFO_USBF_REGULATOR_INIT_1			0x15U
 #define AUX_INFO_USBF_REGULATOR_INIT_2			0x16U
+#define AUX_INFO_BULK_QUEUE				0x17U
+#define AUX_INFO_BULK_DEQUEUE				0x18U
+#define AUX_INFO_BULK_EVENT				0x19U
+#define AUX_INFO_BULK_ABORT				0x1aU
+#define AUX_INFO_PAUSE_EP				0x1bU
 
 #endif
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2021, NVIDIA Corporation.  All rights reserved.
+ * Copyright (c) 2015-2023, NVIDIA Corporation.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property
  * and proprietary rights in and to this software and related documentation
@@ -68,6 +68,14 @@
 
 #define NV_ID_AFR0_NVCACHE_OPS_MASK			(0xf << 12)
 
+#define ID_AA64ISAR0_SHA1_SHIFT		8
+#define ID_AA64ISAR0_SHA2_SHIFT		12
+#define ID_AA64ISAR0_FIELD_MASK		0xfULL
+
+#define CPACR_EL1_FPEN_SHIFT		20
+#define CPACR_EL1_FPEN_MASK			0x3ULL
+#define CPACR_EL1_FPEN_NO_TRAP		0x3ULL
+
 #if !defined(_ASSEMBLY_)
 
 static inline void tegrabl_dsb(void)
@@ -118,6 +126,20 @@ static inline uint64_t tegrabl_read_id_afr0(void)
 	return reg;
 }
 
+static inline uint64_t tegrabl_read_id_aa64isar0(void)
+{
+	uint64_t reg;
+	asm volatile ("mrs %0, id_aa64isar0_el1" : "=r"(reg) : : "memory", "cc");
+	return reg;
+}
+
+static inline uint64_t tegrabl_read_cpacr_el1(void)
+{
+	uint64_t reg;
+	asm volatile ("mrs %0, cpacr_el1" : "=r"(reg) : : "memory", "cc");
+	return reg;
+}
+
 static inline void tegrabl_enable_serror(void)
 {
 	asm volatile ("msr daifclr, #4" : : : "memory", "cc");
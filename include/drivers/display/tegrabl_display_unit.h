@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2017, NVIDIA Corporation.  All rights reserved.
+ * Copyright (c) 2016-2023, NVIDIA Corporation.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -13,6 +13,7 @@
 
 #include <stdint.h>
 #include <tegrabl_error.h>
+#include <tegrabl_dmamap.h>
 #include <tegrabl_surface.h>
 #include <tegrabl_render_text.h>
 #include <tegrabl_render_image.h>
@@ -81,6 +82,8 @@ struct tegrabl_display_unit {
 	uint32_t rotation_angle;
 	bool is_init_done;
 	struct tegrabl_nvdisp *nvdisp;
+	dma_addr_t surf_dma;	/* bus address of the surface base */
+	uint32_t surf_origin;	/* origin the window was last programmed with */
 };
 
 /**
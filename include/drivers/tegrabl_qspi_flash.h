@@ -54,6 +54,16 @@ tegrabl_error_t tegrabl_qspi_flash_open(uint32_t instance,
 tegrabl_error_t tegrabl_qspi_flash_reinit(uint32_t instance,
 					struct tegrabl_qspi_flash_platform_params *params);
 
+/**
+ * @brief Completes any read-ahead in flight and takes the flash out of
+ *        continuous read mode, call before handing the flash to the OS
+ *
+ * @instance to know the qspi instance
+ *
+ * @retval TEGRABL_NO_ERROR flash is idle and accepts regular commands.
+ */
+tegrabl_error_t tegrabl_qspi_flash_quiesce(uint32_t instance);
+
 #if defined(__cplusplus)
 }
 #endif
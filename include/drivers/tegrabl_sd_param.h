@@ -22,6 +22,7 @@ struct gpio_info {
 
 struct tegrabl_sd_platform_params {
 	uint32_t vmmc_supply;
+	uint32_t vqmmc_supply;
 	struct gpio_info cd_gpio;
 	uint32_t en_vdd_sd_gpio;
 	uint32_t sd_instance;
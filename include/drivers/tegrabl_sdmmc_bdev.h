@@ -34,6 +34,36 @@
  */
 tegrabl_error_t sdmmc_bdev_open(uint32_t instance, struct tegrabl_sdmmc_platform_params *params);
 
+/** @brief Starts the init of the eMMC on the given instance: enables the
+ *         controller, resets the card and sends the first CMD1. The card
+ *         runs its power-up init while the caller brings up other devices.
+ *         sdmmc_bdev_open() with the same params completes the init.
+ *
+ *  @param instance instance of the sdmmc controller.
+ *  @param params Parameters to initialize sdmmc, skip init is not allowed.
+ *
+ *  @return TEGRABL_NO_ERROR if successful, specific error if fails
+ */
+tegrabl_error_t sdmmc_bdev_open_start(uint32_t instance,
+	struct tegrabl_sdmmc_platform_params *params);
+
+/** @brief Polls the card of an init begun by sdmmc_bdev_open_start().
+ *
+ *  @param instance instance of the sdmmc controller.
+ *  @param ready Set to true once the card has finished its power-up init.
+ *
+ *  @return TEGRABL_NO_ERROR if successful, specific error if the card failed
+ *          or timed out.
+ */
+tegrabl_error_t sdmmc_bdev_open_poll(uint32_t instance, bool *ready);
+
+/** @brief Drops an init begun by sdmmc_bdev_open_start(). A later
+ *         sdmmc_bdev_open() then does a full init.
+ *
+ *  @param instance instance of the sdmmc controller.
+ */
+void sdmmc_bdev_open_cancel(uint32_t instance);
+
 /** @brief send CMD0, Partial CMD1
  *   This is to avoid the waiting time in QB for emmc device to warm up/reset
  *
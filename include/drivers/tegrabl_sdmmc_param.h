@@ -11,6 +11,44 @@
 #ifndef INCLUDED_TEGRABL_SDMMC_PARAM_H
 #define INCLUDED_TEGRABL_SDMMC_PARAM_H
 
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TEGRABL_SDMMC_TUNING_RECORD_MAGIC	0x4E555453U /* "STUN" */
+#define TEGRABL_SDMMC_TUNING_RECORD_VERSION	1U
+
+/**
+* @brief Outcome of sdmmc bus-width/mode selection, keyed by card CID
+*
+* magic			TEGRABL_SDMMC_TUNING_RECORD_MAGIC
+* version		TEGRABL_SDMMC_TUNING_RECORD_VERSION
+* cid			CID register of the card the record was taken from
+* clk_src		Clock source used while tuning
+* best_mode		Validated transfer mode (TEGRABL_SDMMC_MODE_*)
+* data_width	Negotiated data width (DATA_WIDTH_*)
+* tap_value		Tap value programmed in vendor clock control
+* trim_value	Trim value programmed in vendor clock control
+* hs_timing		HS_TIMING value read back from ext csd in the final mode
+* enhanced_strobe	Enhanced strobe enabled for HS400
+* auto_cal_failed	Pad auto-calibration timed out, drive override was used
+* crc32			crc32 over all the preceding fields
+*/
+struct tegrabl_sdmmc_tuning_record {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t cid[4];
+	uint32_t clk_src;
+	uint32_t best_mode;
+	uint32_t data_width;
+	uint32_t tap_value;
+	uint32_t trim_value;
+	uint8_t hs_timing;
+	uint8_t enhanced_strobe;
+	uint8_t auto_cal_failed;
+	uint8_t reserved;
+	uint32_t crc32;
+};
+
 /**
 * @brief structure for sdmmc platform parameters
 *
@@ -35,6 +73,10 @@
 * is_skip_init	Boolean flag to determine whether to do full init or skip init
 *				true = skip init
 *				flase = full init
+* tuning_record	Optional cached tuning result from a previous boot. When valid and
+*				keyed to the attached card it is applied directly; on return it
+*				holds the result of this init so the caller can persist it.
+*				NULL = always run the full mode selection
 */
 struct tegrabl_sdmmc_platform_params {
 	uint32_t clk_src;
@@ -47,6 +89,7 @@ struct tegrabl_sdmmc_platform_params {
 	bool dqs_trim_hs400;
 	bool enable_strobe_hs400;
 	bool is_skip_init;
+	struct tegrabl_sdmmc_tuning_record *tuning_record;
 };
 
 #endif /* INCLUDED_TEGRABL_SDMMC_PARAM_H */
@@ -21,6 +21,25 @@ tegrabl_error_t tegrabl_smmu_enable_prot(void *data, unsigned long iova,
 
 size_t tegrabl_smmu_disable_prot(void *data, unsigned long iova, size_t size);
 
+/*
+ * Same as enable_prot, but the mapping is kept after its release so that
+ * mapping the same buffer again costs no page table update. The least
+ * recently used idle mappings are unmapped when the cache is full.
+ */
+tegrabl_error_t tegrabl_smmu_map_cached(void *data, unsigned long iova,
+				uint64_t paddr, size_t size, int prot);
+
+/* releases a mapping of tegrabl_smmu_map_cached() */
+size_t tegrabl_smmu_unmap_cached(void *data, unsigned long iova, size_t size);
+
+/*
+ * Unmaps the mappings the cache keeps after their release, on every device,
+ * so that none of those buffers stays reachable by DMA. Called before an
+ * image read through the SMMU is authenticated and before the kernel is
+ * started.
+ */
+void tegrabl_smmu_flush_cached(void);
+
 tegrabl_error_t tegrabl_smmu_init(void);
 
 void tegrabl_smmu_deinit(void);
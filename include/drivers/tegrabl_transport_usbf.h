@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2017, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -68,6 +68,73 @@ tegrabl_error_t tegrabl_transport_usbf_send(const void *buffer, uint32_t length,
 tegrabl_error_t tegrabl_transport_usbf_receive(void *buf, uint32_t length,
 		uint32_t *received, time_t timeout);
 
+/**
+ * @brief Queues a send request and returns immediately. Several requests can
+ * be queued so that the bulk IN endpoint is not idle between them.
+ *
+ * @param buffer A pointer to the data bytes to send, not in TCM. It must stay
+ * valid until returned by tegrabl_transport_usbf_send_complete().
+ * @param length The number of bytes to send, at most 64KB.
+ *
+ * @return NO_ERROR if the request is queued.
+ */
+tegrabl_error_t tegrabl_transport_usbf_send_submit(const void *buffer,
+												   uint32_t length);
+
+/**
+ * @brief Waits for the oldest queued send request to complete.
+ *
+ * @param buffer Returns the buffer of the request, may be null.
+ * @param bytes_transmitted Actual bytes sent.
+ * @param timeout timeout value in msec to wait for an event.
+ *
+ * @return status of the request.
+ */
+tegrabl_error_t tegrabl_transport_usbf_send_complete(const void **buffer,
+													 uint32_t *bytes_transmitted,
+													 time_t timeout);
+
+/**
+ * @brief Queues a receive request and returns immediately. Keeping several
+ * requests queued keeps the bulk OUT endpoint primed, so the host does not
+ * see NAKs while a received buffer is processed.
+ *
+ * @param buf A pointer to receive the data bytes, not in TCM. It must stay
+ * valid until returned by tegrabl_transport_usbf_receive_complete().
+ * @param length The maximum number of bytes to receive, at most 64KB.
+ *
+ * @return NO_ERROR if the request is queued.
+ */
+tegrabl_error_t tegrabl_transport_usbf_receive_submit(void *buf,
+													  uint32_t length);
+
+/**
+ * @brief Waits for the oldest queued receive request to complete.
+ *
+ * @param buf Returns the buffer of the request, may be null.
+ * @param received Actual bytes received.
+ * @param timeout timeout value in msec to wait for an event.
+ *
+ * @return status of the request.
+ */
+tegrabl_error_t tegrabl_transport_usbf_receive_complete(void **buf,
+														uint32_t *received,
+														time_t timeout);
+
+#if defined(CONFIG_ENABLE_USBF_LOOPBACK)
+/**
+ * @brief Echoes the data received from the host back to it and prints the
+ * sustained throughput. The host sends length bytes in transfers of 64KB
+ * and reads each of them back. Entered with "fastboot oem usb-loopback
+ * <bytes>" when the fastboot library is built in.
+ *
+ * @param length Total number of bytes the host sends.
+ *
+ * @return NO_ERROR if all data was echoed.
+ */
+tegrabl_error_t tegrabl_transport_usbf_loopback(uint32_t length);
+#endif
+
 /**
  * Closes USB Device.
  *
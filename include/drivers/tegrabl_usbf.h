@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015 - 2017, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015 - 2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -15,6 +15,15 @@
 #include <stddef.h>
 #include <tegrabl_error.h>
 
+/**
+ * Maximum number of transfers which can be queued on a bulk endpoint
+ */
+#define TEGRABL_USBF_QUEUE_DEPTH 8U
+
+/**
+ * Maximum length of a single queued transfer
+ */
+#define TEGRABL_USBF_MAX_QUEUED_LENGTH (64U * 1024U)
 
 /**
  * Defines USB string descriptor Index
@@ -197,6 +206,87 @@ tegrabl_error_t tegrabl_usbf_receive_start(uint8_t *buffer, uint32_t bytes);
 tegrabl_error_t tegrabl_usbf_receive_complete(uint32_t *bytes_received,
 		uint32_t timeout_us);
 
+/**
+ * @brief Queue a receive request on the bulk OUT endpoint and return
+ * immediately. Up to TEGRABL_USBF_QUEUE_DEPTH requests can be outstanding,
+ * so that the endpoint stays primed while earlier requests are processed.
+ *
+ * @param buffer buffer to receive the data, must stay valid until the request
+ * is returned by tegrabl_usbf_receive_dequeue().
+ *
+ * @param bytes Number of bytes to be received, at most
+ * TEGRABL_USBF_MAX_QUEUED_LENGTH.
+ *
+ * @return returns TEGRABL_NO_ERROR if success, TEGRABL_ERR_OVERFLOW if the
+ * queue is full.
+ */
+tegrabl_error_t tegrabl_usbf_receive_queue(uint8_t *buffer, uint32_t bytes);
+
+/**
+ * @brief Wait for the oldest queued receive request to complete and remove
+ * it from the queue.
+ *
+ * @param buffer Returns the buffer of the request, can be NULL.
+ *
+ * @param bytes_received Returns the number of bytes actually received.
+ *
+ * @param timeout_us Maximum time to wait for an event in usec.
+ *
+ * @return returns the status of the request, TEGRABL_ERR_NOT_FOUND if no
+ * request is queued.
+ */
+tegrabl_error_t tegrabl_usbf_receive_dequeue(uint8_t **buffer,
+		uint32_t *bytes_received, uint32_t timeout_us);
+
+/**
+ * @brief Remove the oldest queued receive request without waiting for it,
+ * e.g. after tegrabl_usbf_receive_dequeue() failed. If the request is still
+ * on the ring, the endpoint is paused and made to skip it. The buffer is no
+ * longer mapped for the controller once this returns.
+ *
+ * @return returns TEGRABL_NO_ERROR if success, TEGRABL_ERR_NOT_FOUND if no
+ * request is queued.
+ */
+tegrabl_error_t tegrabl_usbf_receive_abort(void);
+
+/**
+ * @brief Queue a transmit request on the bulk IN endpoint and return
+ * immediately. Same rules as tegrabl_usbf_receive_queue().
+ *
+ * @param buffer buffer pointer contains the data to be transfered.
+ *
+ * @param bytes Number of bytes to be transfered.
+ *
+ * @return returns TEGRABL_NO_ERROR if success, TEGRABL_ERR_OVERFLOW if the
+ * queue is full.
+ */
+tegrabl_error_t tegrabl_usbf_transmit_queue(uint8_t *buffer, uint32_t bytes);
+
+/**
+ * @brief Wait for the oldest queued transmit request to complete and remove
+ * it from the queue.
+ *
+ * @param buffer Returns the buffer of the request, can be NULL.
+ *
+ * @param bytes_transmitted Returns the number of bytes actually transmitted.
+ *
+ * @param timeout_us Maximum time to wait for an event in usec.
+ *
+ * @return returns the status of the request, TEGRABL_ERR_NOT_FOUND if no
+ * request is queued.
+ */
+tegrabl_error_t tegrabl_usbf_transmit_dequeue(uint8_t **buffer,
+		uint32_t *bytes_transmitted, uint32_t timeout_us);
+
+/**
+ * @brief Remove the oldest queued transmit request without waiting for it.
+ * Same rules as tegrabl_usbf_receive_abort().
+ *
+ * @return returns TEGRABL_NO_ERROR if success, TEGRABL_ERR_NOT_FOUND if no
+ * request is queued.
+ */
+tegrabl_error_t tegrabl_usbf_transmit_abort(void);
+
 /**
  * @brief stop the already initialized controller.
  *
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017, NVIDIA CORPORATION.  All Rights Reserved.
+ * Copyright (c) 2017-2023, NVIDIA CORPORATION.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -51,4 +51,17 @@ extern size_t clib_dma_memset_threshold;
  */
 extern void *clib_dma_memset_priv;
 
+#if defined(__aarch64__) && defined(CONFIG_ENABLE_CLIB_ARMV8_ASM)
+/**
+ * @brief Load/store implementations in memcpy_armv8.S and memset_armv8.S.
+ * The copies require non-overlapping buffers.
+ *
+ * Off by default: the routines use unaligned accesses, so a build enabling
+ * CONFIG_ENABLE_CLIB_ARMV8_ASM must not call memcpy/memset before the MMU is
+ * on or on Device memory. Otherwise the C word loops in string.c are used.
+ */
+void clib_cpu_memcpy(void *dest, const void *src, size_t n);
+void clib_cpu_memset(void *s, int c, size_t n);
+#endif
+
 #endif /* INCLUDED_CLIB_DMA_H */
@@ -56,6 +56,12 @@ struct dirent {
     char name[FS_MAX_FILE_LEN];
 };
 
+/* one destination of a scatter read */
+struct fs_iovec {
+    void *base;
+    size_t len;
+};
+
 struct fs_mount {
     struct list_node node;
     char *path;
@@ -85,6 +91,8 @@ status_t fs_create_file(const char *path, filehandle **handle, uint64_t len) __N
 status_t fs_open_file(const char *path, filehandle **handle) __NONNULL();
 status_t fs_remove_file(const char *path) __NONNULL();
 ssize_t fs_read_file(filehandle *handle, void *buf, off_t offset, size_t len) __NONNULL();
+/* read consecutive file bytes from offset into each iov in turn, stops short at end of file */
+ssize_t fs_read_file_iov(filehandle *handle, const struct fs_iovec *iov, uint32_t iovcnt, off_t offset) __NONNULL();
 ssize_t fs_write_file(filehandle *handle, const void *buf, off_t offset, size_t len) __NONNULL();
 status_t fs_close_file(filehandle *handle) __NONNULL();
 status_t fs_stat_file(filehandle *handle, struct file_stat *) __NONNULL((1));
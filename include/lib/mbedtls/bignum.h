@@ -127,6 +127,7 @@
   #if (!defined(MBEDTLS_HAVE_INT32) &&			   \
 		defined(__GNUC__) && (							\
 		defined(__amd64__) || defined(__x86_64__)	 || \
+		defined(__aarch64__)						 || \
 		defined(__ppc64__) || defined(__powerpc64__) || \
 		defined(__ia64__)  || defined(__alpha__)	 || \
 		(defined(__sparc__) && defined(__arch64__))  || \
@@ -134,14 +135,18 @@
 	 #define MBEDTLS_HAVE_INT64
 	 typedef  int64_t mbedtls_mpi_sint;
 	 typedef uint64_t mbedtls_mpi_uint;
+	 #if !defined(MBEDTLS_NO_UDBL_DIVISION)
 	 typedef unsigned int mbedtls_t_udbl __attribute__((mode(TI)));
 	 #define MBEDTLS_HAVE_UDBL
+	 #endif
   #else
 	 #define MBEDTLS_HAVE_INT32
 	 typedef  int32_t mbedtls_mpi_sint;
 	 typedef uint32_t mbedtls_mpi_uint;
+	 #if !defined(MBEDTLS_NO_UDBL_DIVISION)
 	 typedef uint64_t mbedtls_t_udbl;
 	 #define MBEDTLS_HAVE_UDBL
+	 #endif
   #endif /* !MBEDTLS_HAVE_INT32 && __GNUC__ && 64-bit platform */
 #endif /* !MBEDTLS_HAVE_INT32 && _MSC_VER && _M_AMD64 */
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015, NVIDIA Corporation.	All Rights Reserved.
+ * Copyright (c) 2015-2023, NVIDIA Corporation.	All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -21,4 +21,40 @@
  */
 #define MBEDTLS_BIGNUM_C
 
+/**
+ * \def MBEDTLS_HAVE_ASM
+ *
+ * The compiler has support for asm().
+ *
+ * Enables the assembly multiply-accumulate loops of bn_mul.h, including the
+ * AArch64 one.
+ *
+ * Comment to use the portable C implementation.
+ */
+#define MBEDTLS_HAVE_ASM
+
+/**
+ * \def MBEDTLS_NO_UDBL_DIVISION
+ *
+ * The platform lacks support for double-width integer division.
+ *
+ * With 64-bit limbs the quotient estimate of mbedtls_mpi_div_mpi() would
+ * divide a 128-bit value, which needs __udivti3 from libgcc. Use the
+ * limb-sized long division instead so that bignum.c does not depend on it.
+ *
+ * The limbs can be forced to 32 bits on AArch64 by defining
+ * MBEDTLS_HAVE_INT32.
+ */
+#define MBEDTLS_NO_UDBL_DIVISION
+
+/**
+ * \def MBEDTLS_SELF_TEST
+ *
+ * Enable mbedtls_mpi_self_test(), the mbedtls known-answer tests for
+ * multiplication, division, modular exponentiation, inverse and gcd.
+ */
+#if defined(CONFIG_ENABLE_CRYPTO_SELF_TEST)
+#define MBEDTLS_SELF_TEST
+#endif
+
 #endif /* MBEDTLS_CONFIG_H */
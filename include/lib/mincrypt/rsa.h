@@ -59,6 +59,14 @@ int rsa_verify(const struct rsa_public_key *key,
 				const uint8_t *hash,
 				 const int hash_len);
 
+#if defined(CONFIG_ENABLE_CRYPTO_SELF_TEST)
+#include <tegrabl_error.h>
+
+/* Known-answer test of rsa_verify() for e = 3 and e = 65537, which also
+ * reports the time of one 2048-bit e = 65537 verification.*/
+tegrabl_error_t mincrypt_rsa_test(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -51,6 +51,19 @@ const uint8_t *sha_hash(const void *data, int len, uint8_t *digest);
 
 #define SHA_DIGEST_SIZE 20
 
+#if defined(CONFIG_ENABLE_CRYPTO_SELF_TEST)
+#include <tegrabl_error.h>
+
+/* Known-answer tests of SHA-1 and SHA-256, run through the C transforms and,
+ * where the CPU allows it, the ARMv8 Cryptography Extension ones.*/
+tegrabl_error_t mincrypt_sha_test(void);
+
+/* Forces the C (0) or ARMv8 Cryptography Extension (1) transform, or goes
+ * back to the automatic choice (-1). Returns 0 if the transform is not
+ * usable on this CPU.*/
+int sha_test_select(int armv8);
+#endif
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus*/
@@ -51,6 +51,11 @@ const uint8_t *sha256_hash(const void *data, int len, uint8_t *digest);
 
 #define SHA256_DIGEST_SIZE 32
 
+#if defined(CONFIG_ENABLE_CRYPTO_SELF_TEST)
+/* Same as sha_test_select() for SHA-256.*/
+int sha256_test_select(int armv8);
+#endif
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus*/
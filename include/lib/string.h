@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2019, NVIDIA CORPORATION.  All Rights Reserved.
+ * Copyright (c) 2015-2023, NVIDIA CORPORATION.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -87,6 +87,54 @@ struct tegrabl_clib_dma {
  */
 void tegrabl_clib_dma_register(struct tegrabl_clib_dma *dma_info);
 
+/**
+ * @brief Size classes memcpy/memset pick their implementation for:
+ * below 4KB, below 64KB, below 1MB and 1MB or more.
+ */
+#define TEGRABL_CLIB_SIZE_CLASSES 4U
+
+/**
+ * @brief Implementations memcpy/memset can dispatch to
+ */
+/* load/store loops */
+#define TEGRABL_CLIB_PATH_CPU 0U
+/* registered DMA callbacks */
+#define TEGRABL_CLIB_PATH_DMA 1U
+#define TEGRABL_CLIB_PATH_MAX 2U
+
+/**
+ * @brief Usage counter of one implementation for one size class
+ *
+ * @calls number of calls
+ * @bytes number of bytes moved or set
+ */
+struct tegrabl_clib_usage {
+	uint64_t calls;
+	uint64_t bytes;
+};
+
+/**
+ * @brief Selected implementations and usage counters of memcpy/memset
+ *
+ * @memcpy_path implementation memcpy uses for each size class
+ * @memset_path implementation memset uses for each size class
+ * @memcpy usage counters of memcpy
+ * @memset usage counters of memset
+ */
+struct tegrabl_clib_stats {
+	uint8_t memcpy_path[TEGRABL_CLIB_SIZE_CLASSES];
+	uint8_t memset_path[TEGRABL_CLIB_SIZE_CLASSES];
+	struct tegrabl_clib_usage memcpy[TEGRABL_CLIB_SIZE_CLASSES][TEGRABL_CLIB_PATH_MAX];
+	struct tegrabl_clib_usage memset[TEGRABL_CLIB_SIZE_CLASSES][TEGRABL_CLIB_PATH_MAX];
+};
+
+/**
+ * @brief Returns the selected implementations and usage counters
+ *
+ * @return pointer to the statistics
+ */
+const struct tegrabl_clib_stats *tegrabl_clib_get_stats(void);
+
 /* Copy N bytes of SRC to DEST.  */
 extern void *memcpy(void *dest, const void *src, size_t n);
 
@@ -159,6 +207,8 @@ int tegrabl_clib_test_memcpy(size_t maxsize, bool alloc, void *testbuf);
 
 int tegrabl_clib_test_memset(size_t maxsize, bool alloc, void *testbuf);
 
+int tegrabl_clib_test_memmove(size_t maxsize, bool alloc, void *testbuf);
+
 
 #endif // INCLUDED_STRING_H
 
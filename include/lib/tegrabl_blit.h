@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+#ifndef TEGRABL_BLIT_H
+#define TEGRABL_BLIT_H
+
+#include <stdint.h>
+#include <tegrabl_error.h>
+#include <tegrabl_surface.h>
+
+/**
+ * @brief Pixel formats accepted as blit source. The values are the number of
+ * bytes per pixel, matching the BMP bit depths that are supported.
+ */
+/* macro tegrabl blit format */
+typedef uint32_t tegrabl_blit_format_t;
+#define TEGRABL_BLIT_FORMAT_X1B5G5R5 2
+#define TEGRABL_BLIT_FORMAT_R8G8B8 3
+#define TEGRABL_BLIT_FORMAT_R8G8B8X8 4
+
+/**
+ * @brief Source image of a blit
+ */
+struct tegrabl_blit_src {
+	const uint8_t *pixels;		/* first pixel of the top row */
+	int32_t stride;				/* bytes from one row to the next, negative
+								   for images stored bottom-up */
+	uint32_t width;
+	uint32_t height;
+	tegrabl_blit_format_t format;
+};
+
+/**
+ * @brief Converts an image to the surface pixel format, rotates it clockwise by
+ *        the given angle and writes it directly into the surface with its
+ *        top-left corner at (x, y). The written area is cleaned from the data
+ *        cache once, after all pixels are in place.
+ *
+ * @param surf surface to draw into
+ * @param x X coordinate of the top-left pixel of the rotated image
+ * @param y Y coordinate of the top-left pixel of the rotated image
+ * @param src source image
+ * @param angle rotation angle, one of 0/90/180/270
+ *
+ * @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+tegrabl_error_t tegrabl_blit_image(struct tegrabl_surface *surf, uint32_t x,
+	uint32_t y, const struct tegrabl_blit_src *src, uint32_t angle);
+
+/**
+ * @brief Same as tegrabl_blit_image() but without any cache maintenance, for
+ *        images that are drawn in several strips as they are decoded. Call
+ *        tegrabl_blit_flush() on the whole image after the last strip.
+ *
+ * @param surf surface to draw into
+ * @param x X coordinate of the top-left pixel of the rotated strip
+ * @param y Y coordinate of the top-left pixel of the rotated strip
+ * @param src source strip
+ * @param angle rotation angle, one of 0/90/180/270
+ *
+ * @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+tegrabl_error_t tegrabl_blit_strip(struct tegrabl_surface *surf, uint32_t x,
+	uint32_t y, const struct tegrabl_blit_src *src, uint32_t angle);
+
+/**
+ * @brief Writes back the cache lines covering a rectangle of the surface
+ *
+ * @param surf surface that was drawn into
+ * @param x X coordinate of the top-left pixel of the rectangle
+ * @param y Y coordinate of the top-left pixel of the rectangle
+ * @param width width of the rectangle
+ * @param height height of the rectangle
+ */
+void tegrabl_blit_flush(struct tegrabl_surface *surf, uint32_t x, uint32_t y,
+	uint32_t width, uint32_t height);
+
+/**
+ * @brief Self test: blits random 16/24/32bpp bottom-up images at every angle
+ *        into progressive and interlaced surfaces and compares them pixel for
+ *        pixel with a per-pixel reference conversion.
+ *
+ * @return TEGRABL_NO_ERROR if the test passed else error code.
+ */
+tegrabl_error_t tegrabl_blit_test(void);
+
+#endif
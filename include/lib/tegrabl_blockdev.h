@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2020, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -34,7 +34,8 @@ typedef uint64_t off_t;
 #define TEGRABL_IOCTL_GET_RPMB_WRITE_COUNTER   6U
 #define TEGRABL_IOCTL_BLOCK_DEV_SUSPEND	       7U
 #define TEGRABL_IOCTL_SEND_STATUS		       8U
-#define TEGRABL_IOCTL_INVALID                  9U
+#define TEGRABL_IOCTL_ERASE_READS_ZERO         9U
+#define TEGRABL_IOCTL_INVALID                  10U
 
 #define TEGRABL_BLOCKDEV_WRITE			1U
 #define TEGRABL_BLOCKDEV_READ			2U
@@ -65,6 +66,19 @@ struct tegrabl_blockdev_xfer_info {
 	uint8_t xfer_status;
 };
 
+/**
+* @brief Read or write request of a batch given to tegrabl_blockdev_submit()
+*/
+struct tegrabl_blockdev_req {
+	uint8_t xfer_type; /* read, write */
+	void *buf;
+	bnum_t start_block;
+	bnum_t block_count;
+	tegrabl_error_t error; /* result, set when the batch completes */
+};
+
+struct tegrabl_blockdev_queue;
+
 #define TEGRABL_BLOCK_DEVICE_ID(storage_type, instance) \
 	((storage_type) << 16 | (instance))
 
@@ -82,10 +96,26 @@ struct tegrabl_blockdev_xfer_info {
 #define TEGRABL_STORAGE_UFS_USER	8UL
 #define TEGRABL_STORAGE_UFS_RPMB	9UL
 #define TEGRABL_STORAGE_NVME		10UL
-#define TEGRABL_STORAGE_MAX		11UL
+#define TEGRABL_STORAGE_EMU		11UL
+#define TEGRABL_STORAGE_MAX		12UL
 #define TEGRABL_STORAGE_INVALID		TEGRABL_STORAGE_MAX
 typedef uint32_t tegrabl_storage_type_t;
 
+/**
+* @brief Bounce buffer of a block device, used by the generic read/write path
+*        for the parts of an I/O which are not block or buffer aligned. It is
+*        allocated on first use and kept until the device is removed.
+*/
+struct tegrabl_bdev_bounce {
+	uint8_t *buf;
+	bnum_t block_count;
+	bool in_use;
+	/* uses served by the buffer */
+	uint64_t hits;
+	/* uses which had to allocate, including the buffer itself */
+	uint64_t misses;
+};
+
 /**
 * @brief block device structure. It holds information about storage interface
 *        block properties, kpi information and function pointers to read, write
@@ -101,6 +131,8 @@ typedef struct tegrabl_bdev {
 	bnum_t block_count;
 	bool published;
 	uint32_t buf_align_size;
+	/* largest transfer the driver takes in one call, 0 if not limited */
+	bnum_t max_xfer_blocks;
 
 #if defined(CONFIG_ENABLE_BLOCKDEV_KPI)
 	time_t last_read_start_time;
@@ -113,6 +145,10 @@ typedef struct tegrabl_bdev {
 	uint64_t total_write_size;
 #endif
 
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+	struct tegrabl_bdev_bounce bounce;
+#endif
+
 	void *priv_data;
 
 	tegrabl_error_t (*read)(struct tegrabl_bdev *dev, void *buf, off_t offset,
@@ -297,6 +333,54 @@ tegrabl_error_t tegrabl_blockdev_xfer(struct tegrabl_blockdev_xfer_info *xfer);
 tegrabl_error_t tegrabl_blockdev_xfer_wait(struct tegrabl_blockdev_xfer_info *xfer, time_t timeout,
 		uint8_t *status_flag);
 
+/**
+ * @brief Starts a batch of read/write requests
+ *
+ * Requests with consecutive blocks and buffers are merged, the batch is
+ * issued in block order unless requests overlap, and the commands are split at
+ * dev->max_xfer_blocks. Commands go through the driver's non-blocking xfer
+ * hooks where the driver has them and accepts the buffer, and through the
+ * blocking read/write path otherwise.
+ *
+ * @param dev Block device handle.
+ * @param reqs Requests, have to stay valid until the batch completes.
+ * @param num Number of requests.
+ * @param queue Handle of the batch for tegrabl_blockdev_queue_wait().
+ *
+ * @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+tegrabl_error_t tegrabl_blockdev_queue_submit(tegrabl_bdev_t *dev,
+	struct tegrabl_blockdev_req *reqs, uint32_t num,
+	struct tegrabl_blockdev_queue **queue);
+
+/**
+ * @brief Makes progress on a batch and waits for it as per given timeout.
+ * The handle is released once the status is XFER_COMPLETE or XFER_FAILURE;
+ * the error of each request is set by then.
+ *
+ * @param queue Handle returned by tegrabl_blockdev_queue_submit().
+ * @param timeout Time to wait for the batch in us.
+ * @param status_flag XFER_IN_PROGRESS, XFER_COMPLETE or XFER_FAILURE.
+ *
+ * @return TEGRABL_NO_ERROR if success, error of the failed request otherwise.
+ */
+tegrabl_error_t tegrabl_blockdev_queue_wait(struct tegrabl_blockdev_queue *queue,
+	time_t timeout, uint8_t *status_flag);
+
+/**
+ * @brief Runs a batch of read/write requests to completion, see
+ * tegrabl_blockdev_queue_submit()
+ *
+ * @param dev Block device handle.
+ * @param reqs Requests.
+ * @param num Number of requests.
+ *
+ * @return TEGRABL_NO_ERROR if success, error of the first failed request
+ * otherwise.
+ */
+tegrabl_error_t tegrabl_blockdev_submit(tegrabl_bdev_t *dev,
+	struct tegrabl_blockdev_req *reqs, uint32_t num);
+
 /** @brief Executes given ioctl
  *
  *  @param dev Block device handle.
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+#ifndef TEGRABL_BLOCKDEV_EMU_H
+#define TEGRABL_BLOCKDEV_EMU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <tegrabl_error.h>
+#include <tegrabl_blockdev.h>
+
+/* maximum number of non-blocking transfers a device can have in flight */
+#define TEGRABL_BLOCKDEV_EMU_MAX_QUEUE_DEPTH	32U
+
+/* maximum number of armed faults per device */
+#define TEGRABL_BLOCKDEV_EMU_MAX_FAULTS		8U
+
+/* command types, used as index into the stats and as fault mask */
+#define TEGRABL_BLOCKDEV_EMU_CMD_READ		0U
+#define TEGRABL_BLOCKDEV_EMU_CMD_WRITE		1U
+#define TEGRABL_BLOCKDEV_EMU_CMD_ERASE		2U
+#define TEGRABL_BLOCKDEV_EMU_CMD_MAX		3U
+
+#define TEGRABL_BLOCKDEV_EMU_FAULT_READ		(1U << TEGRABL_BLOCKDEV_EMU_CMD_READ)
+#define TEGRABL_BLOCKDEV_EMU_FAULT_WRITE	(1U << TEGRABL_BLOCKDEV_EMU_CMD_WRITE)
+#define TEGRABL_BLOCKDEV_EMU_FAULT_ERASE	(1U << TEGRABL_BLOCKDEV_EMU_CMD_ERASE)
+
+/**
+ * @brief Geometry and timing of an emulated block device
+ *
+ * The media serves one command at a time. Each command costs cmd_latency_us
+ * plus its size divided by the read or write bandwidth, and commands queued
+ * behind a busy media start when the previous one finishes.
+ */
+struct tegrabl_blockdev_emu_config {
+	/* backing store of block_count blocks, allocated (zeroed) if NULL */
+	void *backing;
+	uint32_t block_size_log2;
+	bnum_t block_count;
+	/* required alignment of the caller buffers, power of two */
+	uint32_t buf_align_size;
+	/* blocks per command, larger requests are split; 0 for no limit */
+	bnum_t max_xfer_blocks;
+	/* non-blocking transfers accepted before xfer returns busy */
+	uint32_t queue_depth;
+	uint32_t cmd_latency_us;
+	uint32_t erase_latency_us;
+	/* media bandwidth in MB/s, 0 for infinitely fast */
+	uint32_t read_mbps;
+	uint32_t write_mbps;
+	/*
+	 * run on a private clock which only moves when the device waits, so
+	 * that results do not depend on the speed of the host
+	 */
+	bool virtual_time;
+};
+
+/**
+ * @brief Fault armed on an emulated block device
+ *
+ * A command of a type in cmd_mask that touches [start_block,
+ * start_block + block_count) is a match. The first skip matches are served
+ * normally, the next count matches complete with the given error (all of
+ * them if count is 0). Failed writes and erases leave the media untouched.
+ */
+struct tegrabl_blockdev_emu_fault {
+	uint32_t cmd_mask;
+	bnum_t start_block;
+	bnum_t block_count;
+	uint32_t skip;
+	uint32_t count;
+	tegrabl_error_t error;
+};
+
+struct tegrabl_blockdev_emu_stats {
+	uint64_t cmds[TEGRABL_BLOCKDEV_EMU_CMD_MAX];
+	uint64_t blocks[TEGRABL_BLOCKDEV_EMU_CMD_MAX];
+	/* time the media spent serving commands */
+	uint64_t busy_us;
+	/* time callers spent blocked on the device */
+	uint64_t wait_us;
+	uint32_t max_queued;
+	uint32_t faults;
+};
+
+/**
+ * @brief Creates a RAM backed block device with the given model and registers
+ * it as TEGRABL_STORAGE_EMU/instance
+ *
+ * @param instance Instance of the device
+ * @param config Geometry and timing of the device
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error
+ */
+tegrabl_error_t tegrabl_blockdev_emu_open(uint32_t instance,
+	const struct tegrabl_blockdev_emu_config *config);
+
+/**
+ * @brief Arms a fault on an emulated block device
+ *
+ * @param dev Handle of the emulated device
+ * @param fault Fault description, copied
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error
+ */
+tegrabl_error_t tegrabl_blockdev_emu_inject_fault(tegrabl_bdev_t *dev,
+	const struct tegrabl_blockdev_emu_fault *fault);
+
+/**
+ * @brief Disarms all the faults of an emulated block device
+ *
+ * @param dev Handle of the emulated device
+ */
+void tegrabl_blockdev_emu_clear_faults(tegrabl_bdev_t *dev);
+
+/**
+ * @brief Returns the counters of an emulated block device and resets them
+ *
+ * @param dev Handle of the emulated device
+ * @param stats Filled with the counters since the last call
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error
+ */
+tegrabl_error_t tegrabl_blockdev_emu_get_stats(tegrabl_bdev_t *dev,
+	struct tegrabl_blockdev_emu_stats *stats);
+
+/**
+ * @brief Returns the current time of the device clock in us, which is the
+ * virtual clock for devices with virtual_time set
+ *
+ * @param dev Handle of the emulated device
+ */
+time_t tegrabl_blockdev_emu_now(tegrabl_bdev_t *dev);
+
+/**
+ * @brief Self test of the emulated device: blocking transfers and their cost,
+ * non-blocking transfers through tegrabl_blockdev_xfer()/xfer_wait() up to
+ * the queue depth, and an injected write fault. Registers and frees its own
+ * device as TEGRABL_STORAGE_EMU/0xff.
+ *
+ * @return TEGRABL_NO_ERROR if all the checks pass else appropriate error
+ */
+tegrabl_error_t tegrabl_blockdev_emu_test(void);
+
+#endif
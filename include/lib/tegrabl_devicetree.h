@@ -508,4 +508,108 @@ tegrabl_error_t tegrabl_get_alias_id(char *prefix, char *alias_name,
  */
 tegrabl_error_t tegrabl_dt_create_space(void *fdt, uint32_t inc_size, uint32_t max_size);
 
+/**
+ * @brief Drop the cached node/phandle index of a device tree. Needed only
+ * when a new device tree is placed in a buffer that was indexed before;
+ * edits through libfdt are detected on the next lookup.
+ *
+ * @param fdt pointer to fdt handle, NULL drops all indexes.
+ */
+void tegrabl_dt_index_invalidate(const void *fdt);
+
+/**
+ * @brief Indexed equivalent of fdt_path_offset(). The first lookup in a
+ * device tree builds a path/phandle index in a single pass, later lookups
+ * are hash table hits verified against the tree.
+ *
+ * @param fdt pointer to fdt handle.
+ * @param path full path of the node or alias name.
+ *
+ * @return offset of the node in case of success else libfdt error code.
+ */
+int tegrabl_dt_path_offset(const void *fdt, const char *path);
+
+/**
+ * @brief Indexed equivalent of fdt_node_offset_by_phandle().
+ *
+ * @param fdt pointer to fdt handle.
+ * @param phandle phandle of the node.
+ *
+ * @return offset of the node in case of success else libfdt error code.
+ */
+int tegrabl_dt_node_offset_by_phandle(const void *fdt, uint32_t phandle);
+
+/**
+ * @brief Equivalent of fdt_subnode_offset() which also finds nodes added by
+ * an open staged fixup.
+ *
+ * @param fdt pointer to fdt handle.
+ * @param parent offset of the parent node.
+ * @param name name of the subnode.
+ *
+ * @return offset of the node in case of success else libfdt error code.
+ */
+int tegrabl_dt_subnode_offset(const void *fdt, int parent, const char *name);
+
+/**
+ * @brief Equivalents of the libfdt functions of the same name which keep
+ * the node/phandle index of @fdt up to date instead of forcing a rebuild.
+ *
+ * @return 0 (or node offset for add_subnode) in case of success else
+ * libfdt error code.
+ */
+int tegrabl_dt_add_subnode(void *fdt, int parent, const char *name);
+int tegrabl_dt_setprop(void *fdt, int node, const char *name,
+					   const void *val, int len);
+int tegrabl_dt_setprop_cell(void *fdt, int node, const char *name,
+							uint32_t val);
+int tegrabl_dt_setprop_string(void *fdt, int node, const char *name,
+							  const char *str);
+int tegrabl_dt_appendprop(void *fdt, int node, const char *name,
+						  const void *val, int len);
+int tegrabl_dt_delprop(void *fdt, int node, const char *name);
+
+/**
+ * @brief Start collecting the edits made to @fdt through the tegrabl_dt_*
+ * wrappers instead of applying each of them right away. Nodes added while
+ * staging get handles that are only valid for the wrappers, and reads
+ * through libfdt see the tree as it was before staging began.
+ *
+ * @param fdt pointer to fdt handle.
+ *
+ * @return TEGRABL_NO_ERROR in case of success, else edits go to @fdt
+ * directly.
+ */
+tegrabl_error_t tegrabl_dt_stage_begin(void *fdt);
+
+/**
+ * @brief Apply all edits collected since tegrabl_dt_stage_begin() in a
+ * single rebuild of the structure block. The result matches the one of
+ * making the same edits one at a time through libfdt.
+ *
+ * @param fdt pointer to fdt handle.
+ *
+ * @return TEGRABL_NO_ERROR in case of success else error code. Staging is
+ * over in both cases.
+ */
+tegrabl_error_t tegrabl_dt_stage_commit(void *fdt);
+
+/**
+ * @brief Drop all edits collected since tegrabl_dt_stage_begin() without
+ * applying any of them, leaving @fdt as it was when staging began.
+ *
+ * @param fdt pointer to fdt handle.
+ */
+void tegrabl_dt_stage_discard(void *fdt);
+
+/**
+ * @brief Self test of staged fixups: checks that a list of edits made
+ * through the staging wrappers yields the same DTB bytes as the same edits
+ * made one at a time through libfdt, and that discarded edits leave the
+ * DTB untouched. Available with CONFIG_ENABLE_DT_STAGED_FIXUP.
+ *
+ * @return TEGRABL_NO_ERROR if the test passed else error code.
+ */
+tegrabl_error_t tegrabl_dt_stage_test(void);
+
 #endif /* __TEGRABL_DEVICETREE_H__ */
@@ -12,6 +12,7 @@
 #define TEGRABL_FILE_MANAGER_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <tegrabl_error.h>
 #include <tegrabl_blockdev.h>
 
@@ -70,6 +71,61 @@ tegrabl_error_t tegrabl_fm_read(struct tegrabl_fm_handle *handle,
 								uint32_t *size,
 								bool *is_file_loaded_from_fs);
 
+/**
+ * @brief One destination of a scatter read
+ */
+struct tegrabl_fm_sg_entry {
+	void *load_address;
+	uint32_t size;
+};
+
+/**
+ * @brief Read part of a file from the filesystem if available, otherwise the same
+ * range of the partition.
+ *
+ * @param handle pointer to file manager handle
+ * @param file_path file name along with the path
+ * @param partition_name partition to read from in case if file read fails from filesystem.
+ * @param offset byte offset in the file/partition to start reading from
+ * @param load_address address into which the data needs to be loaded.
+ * @param size in: number of bytes to read, out: number of bytes read (short at end of file)
+ * @param is_file_loaded_from_fs specify whether data is loaded from filesystem or partition.
+ *
+ * @return TEGRABL_NO_ERROR if success, specific error if fails.
+ */
+tegrabl_error_t tegrabl_fm_read_range(struct tegrabl_fm_handle *handle,
+									  char *file_path,
+									  char *partition_name,
+									  uint64_t offset,
+									  void *load_address,
+									  uint32_t *size,
+									  bool *is_file_loaded_from_fs);
+
+/**
+ * @brief Read consecutive bytes of a file, starting at offset, into a list of
+ * buffers, falling back to the partition like tegrabl_fm_read_range(). The file
+ * is looked up once for the whole list.
+ *
+ * @param handle pointer to file manager handle
+ * @param file_path file name along with the path
+ * @param partition_name partition to read from in case if file read fails from filesystem.
+ * @param offset byte offset in the file/partition to start reading from
+ * @param sg buffers filled in order
+ * @param sg_count number of entries in sg
+ * @param bytes_read total number of bytes read (short at end of file)
+ * @param is_file_loaded_from_fs specify whether data is loaded from filesystem or partition.
+ *
+ * @return TEGRABL_NO_ERROR if success, specific error if fails.
+ */
+tegrabl_error_t tegrabl_fm_read_sg(struct tegrabl_fm_handle *handle,
+								   char *file_path,
+								   char *partition_name,
+								   uint64_t offset,
+								   const struct tegrabl_fm_sg_entry *sg,
+								   uint32_t sg_count,
+								   uint64_t *bytes_read,
+								   bool *is_file_loaded_from_fs);
+
 /**
  * @brief get file manager handle
  *
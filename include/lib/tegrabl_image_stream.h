@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+#ifndef TEGRABL_IMAGE_STREAM_H
+#define TEGRABL_IMAGE_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <tegrabl_error.h>
+
+/**
+ * @brief Sequential reader over an image that is either stored as is or
+ * wrapped in an LZ4 frame. Compressed images are decoded one LZ4 block at a
+ * time, so only the largest block of the frame (plus the 64KB window of
+ * linked blocks) is ever held in memory.
+ *
+ * @in next unread byte of the input
+ * @in_end end of the input
+ * @out next unread decoded byte
+ * @out_avail number of decoded bytes at out
+ * @buf LZ4 block buffer, NULL if the image is not compressed
+ * @buf_size size of buf
+ * @buf_pos end of the decoded data in buf
+ * @block_max largest block size allowed by the frame
+ * @length decoded size if known, 0 otherwise
+ * @block_csum blocks are followed by a checksum
+ * @linked blocks may refer to data of the previous blocks
+ * @done no more input to decode
+ */
+struct tegrabl_image_stream {
+	const uint8_t *in;
+	const uint8_t *in_end;
+	const uint8_t *out;
+	uint32_t out_avail;
+	uint8_t *buf;
+	uint32_t buf_size;
+	uint32_t buf_pos;
+	uint32_t block_max;
+	uint32_t length;
+	bool block_csum;
+	bool linked;
+	bool done;
+};
+
+/**
+ * @brief Checks whether an image is wrapped in an LZ4 frame
+ *
+ * @param data start of the image
+ * @param length size of the image
+ *
+ * @return true if the image is compressed
+ */
+bool tegrabl_image_stream_is_compressed(const uint8_t *data, uint32_t length);
+
+/**
+ * @brief Prepares a stream to read an image. The image must stay in memory
+ *        until the stream is closed.
+ *
+ * @param s stream to initialize
+ * @param data start of the image, plain or LZ4 frame
+ * @param length size of the image in bytes
+ *
+ * @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+tegrabl_error_t tegrabl_image_stream_open(struct tegrabl_image_stream *s,
+	const uint8_t *data, uint32_t length);
+
+/**
+ * @brief Returns the decoded bytes that can be accessed in place, decoding the
+ *        next block if all previous bytes have been consumed. The returned
+ *        pointer is valid until the next call on the stream.
+ *
+ * @param s stream
+ * @param ptr address of the next decoded byte, to be filled
+ * @param avail number of contiguous bytes at ptr, 0 at the end of the image
+ *
+ * @return TEGRABL_NO_ERROR if success, error code if the data is corrupted.
+ */
+tegrabl_error_t tegrabl_image_stream_map(struct tegrabl_image_stream *s,
+	const uint8_t **ptr, uint32_t *avail);
+
+/**
+ * @brief Marks bytes returned by tegrabl_image_stream_map() as consumed
+ *
+ * @param s stream
+ * @param n number of bytes, not more than the available ones
+ */
+void tegrabl_image_stream_consume(struct tegrabl_image_stream *s, uint32_t n);
+
+/**
+ * @brief Copies the next bytes of the image
+ *
+ * @param s stream
+ * @param dst destination buffer, NULL to skip the bytes
+ * @param n number of bytes
+ *
+ * @return TEGRABL_NO_ERROR if success, error code if the image ends before.
+ */
+tegrabl_error_t tegrabl_image_stream_read(struct tegrabl_image_stream *s,
+	void *dst, uint32_t n);
+
+/**
+ * @brief Releases the buffers of a stream
+ *
+ * @param s stream
+ */
+void tegrabl_image_stream_close(struct tegrabl_image_stream *s);
+
+#endif
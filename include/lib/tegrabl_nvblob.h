@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2014-2017, NVIDIA Corporation.  All Rights Reserved.
+ * Copyright (c) 2014-2023, NVIDIA Corporation.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -65,6 +65,10 @@ typedef uint32_t tegrabl_bmp_resolution_t;
 #define BMPRES_NUM 6
 #define BMPRES_FORCE32 0x7FFFFFFF
 
+/*
+ * BMP entries hold a BMP file (uncompressed, RLE8 or RLE4), either stored as is
+ * or wrapped in an LZ4 frame. bmp_size is the size stored in the blob.
+ */
 struct tegrabl_bmp_entry {
 	tegrabl_image_type_t bmp_type;
 	uint32_t bmp_offset;
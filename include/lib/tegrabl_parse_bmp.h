@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2014-2017, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2014-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -17,7 +17,7 @@
  * @brief bmp image descriptor
  *
  * @img_type type of the bmp image
- * @bmp image buffer
+ * @bmp image buffer, a BMP file that may be wrapped in an LZ4 frame
  * @image_size size of bmp image
  * @panel_resolution resolution of the panel for which best bmp is searched
  * @is_panel_portrait bool value denoting if panel is portrait
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2017, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -25,7 +25,8 @@ typedef uint32_t tegrabl_image_format_t;
 /** @brief Rendors the bmp image in the given surface.
  *
  *  @param surf address of the surface to which bmp image has to be rendered.
- *  @param buf address of bmp image data.
+ *  @param buf address of bmp image data, which may be wrapped in an LZ4 frame;
+ *         compressed images are decoded straight into the surface.
  *  @param size size of the buffer, which holds bmp image data.
  *
  *  @return TEGRABL_NO_ERROR if success, error code if fails.
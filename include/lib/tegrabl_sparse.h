@@ -122,6 +122,22 @@ struct tegrabl_unsparse_state {
 	 * appropriate error.
 	 */
 	tegrabl_error_t (*seeker)(uint64_t size, void *aux_info);
+
+	/**
+	 * @brief Optional handle of function which fills the next size bytes
+	 * with a 32-bit pattern without a data buffer, e.g. by erase/discard for
+	 * zero fill. It advances the location like writer does.
+	 *
+	 * @param fill_value Pattern to be filled
+	 * @param size Bytes to fill from current location.
+	 * @param aux_info Auxiliary information passed.
+	 *
+	 * @return should return TEGRABL_NO_ERROR if successful,
+	 * TEGRABL_ERR_NOT_SUPPORTED (location unchanged) to let the pattern be
+	 * written through writer, else appropriate error.
+	 */
+	tegrabl_error_t (*filler)(uint32_t fill_value, uint64_t size,
+			void *aux_info);
 };
 
 struct tegrabl_sparse_state {
@@ -169,6 +185,20 @@ tegrabl_error_t tegrabl_sparse_init_unsparse_state(
 			void *aux_info),
 		tegrabl_error_t (*seeker)(uint64_t size, void *aux_info));
 
+/**
+ * @brief Registers function which fills ranges for chunks of type fill
+ * instead of writing the pattern.
+ *
+ * @param unsparse_state State information maintained by unsparse machine.
+ * @param filler Handle of function which fills a range at destination.
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error code.
+ */
+tegrabl_error_t tegrabl_sparse_set_unsparse_filler(
+		struct tegrabl_unsparse_state *unsparse_state,
+		tegrabl_error_t (*filler)(uint32_t fill_value, uint64_t size,
+			void *aux_info));
+
 /**
  * @brief Unsparses the current buffer based on state.
  *
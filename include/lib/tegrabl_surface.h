@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2017, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -57,6 +57,11 @@ struct tegrabl_surface {
 	tegrabl_scan_format_t scan_format;
 	tegrabl_surface_layout_t layout;
 	uint32_t second_field_offset;
+	uint32_t scroll_rows;	/* spare rows allocated for ring scrolling */
+	uint32_t backing_size;	/* size of the buffer, with the spare rows */
+	uint32_t origin;		/* byte offset of the visible area from base */
+	uint32_t dirty_start;	/* bytes from base written since the last flush */
+	uint32_t dirty_end;
 };
 
 /**
@@ -93,9 +98,47 @@ tegrabl_error_t tegrabl_surface_write(struct tegrabl_surface *surf, uint32_t x,
 tegrabl_error_t tegrabl_surface_read(struct tegrabl_surface *surf, uint32_t x,
 	uint32_t y, uint32_t width, uint32_t height, void *dest_pixels);
 
+/**
+ *  @brief Scrolls the visible contents of a surface by dx columns or dy rows.
+ *         Positive values move the contents right/down, negative values
+ *         left/up; the exposed pixels are cleared. Only one of dx and dy may
+ *         be non-zero.
+ *
+ *         On progressive surfaces with scroll_rows set, vertical scrolling
+ *         only moves the origin of the visible area through the spare rows.
+ *         The contents are copied back when the origin runs off either end,
+ *         so a full-screen copy happens once every scroll_rows rows. The
+ *         scan-out address must be updated from origin afterwards.
+ *
+ *  @param surf A pointer to structure describing the surface.
+ *  @param dx Number of columns to move the contents by.
+ *  @param dy Number of rows to move the contents by.
+ *
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+tegrabl_error_t tegrabl_surface_scroll(struct tegrabl_surface *surf,
+	int32_t dx, int32_t dy);
+
+/**
+ *  @brief Moves the visible area of a surface back to the start of its buffer
+ *         and resets the origin, e.g. before handing the framebuffer over.
+ *
+ *  @param surf A pointer to structure describing the surface.
+ */
+void tegrabl_surface_reset_origin(struct tegrabl_surface *surf);
+
+/**
+ *  @brief Writes back the cache lines of the rows that were written or
+ *         scrolled since the last flush, so that only the changed part of the
+ *         frame buffer is cleaned after each update.
+ *
+ *  @param surf A pointer to structure describing the surface.
+ */
+void tegrabl_surface_flush(struct tegrabl_surface *surf);
+
 /**
  *  @brief Sets up give surface. Calculates pitch, alignment and also allocates
- *         memory for the frame buffer.
+ *         memory for the frame buffer, including scroll_rows spare rows.
  *
  *  @param surf A pointer to structure describing the surface.
  *
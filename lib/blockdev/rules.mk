@@ -1,5 +1,5 @@
 #
-# Copyright (c) 2015-2017, NVIDIA CORPORATION.  All rights reserved.
+# Copyright (c) 2015-2023, NVIDIA CORPORATION.  All rights reserved.
 #
 # NVIDIA CORPORATION and its licensors retain all intellectual property
 # and proprietary rights in and to this software, related documentation
@@ -16,11 +16,18 @@ GLOBAL_INCLUDES += \
 	$(LOCAL_DIR)
 
 MODULE_SRCS += \
-	$(LOCAL_DIR)/tegrabl_blockdev.c
+	$(LOCAL_DIR)/tegrabl_blockdev.c \
+	$(LOCAL_DIR)/tegrabl_blockdev_queue.c
 
 ifeq ($(CONFIG_ENABLE_BLOCKDEV_KPI), yes)
 MODULE_SRCS += \
 	$(LOCAL_DIR)/tegrabl_blockdev_profiling.c
 endif
 
+ifeq ($(CONFIG_ENABLE_BLOCKDEV_EMU), yes)
+MODULE_SRCS += \
+	$(LOCAL_DIR)/tegrabl_blockdev_emu.c \
+	$(LOCAL_DIR)/tegrabl_blockdev_emu_test.c
+endif
+
 include make/module.mk
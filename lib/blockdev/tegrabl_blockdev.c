@@ -22,7 +22,7 @@
  */
 
 /*
- * Copyright (c) 2015-2021, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -59,126 +59,156 @@ static inline bool tegrabl_blockdev_buffer_aligned(tegrabl_bdev_t *dev, const vo
 	return MOD_POW2((uintptr_t)buf, dev->buf_align_size) == 0UL;
 }
 
+/* alignment of the bounce buffers, they have to satisfy the device as well */
+static inline size_t tegrabl_blockdev_bounce_align(tegrabl_bdev_t *dev)
+{
+	return MAX(TEGRABL_BLOCKDEV_MEM_ALIGN_SIZE, dev->buf_align_size);
+}
+
 #if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
 
+/* upper bound of the bounce buffer each device keeps */
+#define TEGRABL_BLOCKDEV_BOUNCE_MAX_SIZE	(64UL * 1024UL)
+
+static bnum_t tegrabl_blockdev_bounce_blocks(tegrabl_bdev_t *dev)
+{
+	bnum_t count = (bnum_t)MAX(1UL, TEGRABL_BLOCKDEV_BOUNCE_MAX_SIZE >> dev->block_size_log2);
+
+	if (dev->max_xfer_blocks != 0U) {
+		count = MIN(count, dev->max_xfer_blocks);
+	}
+	return count;
+}
+
+/**
+ * @brief Returns a bounce buffer for up to *count blocks and updates *count to
+ * what it holds. That is the device's own buffer unless it is in use already,
+ * in which case a buffer is taken from the heap.
+ */
+static uint8_t *tegrabl_blockdev_bounce_get(tegrabl_bdev_t *dev, bnum_t *count)
+{
+	struct tegrabl_bdev_bounce *bounce = &dev->bounce;
+	uint8_t *buf;
+
+	if (!bounce->in_use) {
+		if (bounce->buf == NULL) {
+			bounce->block_count = tegrabl_blockdev_bounce_blocks(dev);
+			bounce->buf = tegrabl_alloc_align(TEGRABL_HEAP_DMA, tegrabl_blockdev_bounce_align(dev),
+											  (size_t)bounce->block_count << dev->block_size_log2);
+			bounce->misses++;
+		} else {
+			bounce->hits++;
+		}
+		if (bounce->buf != NULL) {
+			bounce->in_use = true;
+			*count = MIN(*count, bounce->block_count);
+			return bounce->buf;
+		}
+	}
+
+	bounce->misses++;
+	*count = MIN(*count, tegrabl_blockdev_bounce_blocks(dev));
+	buf = tegrabl_alloc_align(TEGRABL_HEAP_DMA, tegrabl_blockdev_bounce_align(dev),
+							  (size_t)*count << dev->block_size_log2);
+	return buf;
+}
+
+static void tegrabl_blockdev_bounce_put(tegrabl_bdev_t *dev, uint8_t *buf)
+{
+	if (buf == NULL) {
+		return;
+	}
+	if (buf == dev->bounce.buf) {
+		dev->bounce.in_use = false;
+	} else {
+		tegrabl_dealloc(TEGRABL_HEAP_DMA, buf);
+	}
+}
+
+/**
+ * @brief Returns the number of blocks of the next piece of an I/O which has to
+ * go through the bounce buffer: the head block alone if the caller buffer is
+ * aligned for the blocks following it, else everything up to the end.
+ */
+static bnum_t tegrabl_blockdev_bounce_span(tegrabl_bdev_t *dev, const uint8_t *buf,
+	size_t block_offset, off_t len)
+{
+	off_t span = DIV_CEIL_LOG2(block_offset + len, dev->block_size_log2);
+
+	if ((block_offset != 0U) && (span > 1U) &&
+		tegrabl_blockdev_buffer_aligned(dev, buf + TEGRABL_BLOCKDEV_BLOCK_SIZE(dev) - block_offset)) {
+		span = 1;
+	}
+	return (bnum_t)span;
+}
+
 static tegrabl_error_t tegrabl_blockdev_default_read(tegrabl_bdev_t *dev,
 	void *buffer, off_t offset, off_t len)
 {
 	uint8_t *buf = (uint8_t *)buffer;
-	size_t bytes_read = 0;
+	uint8_t *bounce = NULL;
+	bnum_t bounce_count = 0;
 	bnum_t block;
+	bnum_t count;
+	size_t block_offset;
+	size_t bytes;
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-	void *temp_buf = NULL;
-	void *partial_block_buf = NULL;
 
 	if ((dev == NULL) || (buffer == NULL)) {
 		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
 		goto fail;
 	}
 
-	if (MOD_LOG2(offset, dev->block_size_log2) ||
-		MOD_LOG2(len, dev->block_size_log2)) {
-		partial_block_buf = tegrabl_alloc_align(TEGRABL_HEAP_DMA, TEGRABL_BLOCKDEV_MEM_ALIGN_SIZE,
-												TEGRABL_BLOCKDEV_BLOCK_SIZE(dev));
-		if (partial_block_buf == NULL) {
-			error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
-			goto fail;
-		}
-	}
-
 	/* find the starting block */
 	block = DIV_FLOOR_LOG2(offset, dev->block_size_log2);
+	block_offset = MOD_LOG2(offset, dev->block_size_log2);
 
 	pr_trace("buf %p, offset %" PRIu64", block %u, len %"PRIu64"\n",
 			 buf, offset, block, len);
 
-	/* handle partial first block */
-	if (MOD_LOG2(offset, dev->block_size_log2) != 0ULL) {
-		/* read in the block */
-		error = tegrabl_blockdev_read_block(dev, partial_block_buf, block, 1);
-		if (error != TEGRABL_NO_ERROR) {
-			goto fail;
-		}
-
-		/* copy what we need */
-		size_t block_offset = MOD_LOG2(offset, dev->block_size_log2);
-		size_t tocopy = MIN(TEGRABL_BLOCKDEV_BLOCK_SIZE(dev) -
-							block_offset, len);
-		memcpy(buf, (uint8_t *)partial_block_buf + block_offset, tocopy);
-
-		/* increment our buffers */
-		buf += tocopy;
-		len -= tocopy;
-		bytes_read += tocopy;
-		block++;
-	}
-
-	pr_trace("buf %p, block %u, len %"PRIu64"\n", buf, block, len);
-
-	/* handle middle blocks */
-	if (len >= (1U << dev->block_size_log2)) {
-		/* do the middle reads */
-		size_t block_count = DIV_FLOOR_LOG2(len, dev->block_size_log2);
-		size_t bytes = block_count << dev->block_size_log2;
-		if (bytes > len) {
-			error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
-			goto fail;
-		}
-
-		if (!tegrabl_blockdev_buffer_aligned(dev, buf)) {
-			temp_buf = tegrabl_alloc_align(TEGRABL_HEAP_DMA, TEGRABL_BLOCKDEV_MEM_ALIGN_SIZE,
-										   block_count * TEGRABL_BLOCKDEV_BLOCK_SIZE(dev));
-			if (temp_buf == NULL) {
-				error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 1);
-				goto fail;
-			}
-			error = tegrabl_blockdev_read_block(dev, temp_buf, block, block_count);
+	while (len > 0ULL) {
+		if ((block_offset == 0U) && (len >= TEGRABL_BLOCKDEV_BLOCK_SIZE(dev)) &&
+			tegrabl_blockdev_buffer_aligned(dev, buf)) {
+			/* whole blocks straight into the caller's buffer */
+			count = (bnum_t)DIV_FLOOR_LOG2(len, dev->block_size_log2);
+			error = tegrabl_blockdev_read_block(dev, buf, block, count);
 			if (error != TEGRABL_NO_ERROR) {
 				TEGRABL_SET_HIGHEST_MODULE(error);
 				goto fail;
 			}
-			memcpy(buf, temp_buf, bytes);
+			bytes = (size_t)count << dev->block_size_log2;
 		} else {
-			error = tegrabl_blockdev_read_block(dev, buf, block, block_count);
+			count = tegrabl_blockdev_bounce_span(dev, buf, block_offset, len);
+			if (bounce == NULL) {
+				bounce_count = count;
+				bounce = tegrabl_blockdev_bounce_get(dev, &bounce_count);
+				if (bounce == NULL) {
+					error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+					goto fail;
+				}
+			}
+			count = MIN(count, bounce_count);
+
+			error = tegrabl_blockdev_read_block(dev, bounce, block, count);
 			if (error != TEGRABL_NO_ERROR) {
 				TEGRABL_SET_HIGHEST_MODULE(error);
 				goto fail;
 			}
+			bytes = MIN(((size_t)count << dev->block_size_log2) - block_offset, len);
+			memcpy(buf, bounce + block_offset, bytes);
 		}
 
-		/* increment our buffers */
+		pr_trace("buf %p, block %u, count %u\n", buf, block, count);
+
 		buf += bytes;
 		len -= bytes;
-		bytes_read += bytes;
-		block += block_count;
-	}
-
-	pr_trace("buf %p, block %u, len %"PRIu64"\n", buf, block, len);
-
-	/* handle partial last block */
-	if (len > 0ULL) {
-		if (partial_block_buf == NULL) {
-			error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
-			goto fail;
-		}
-		/* read the block */
-		error = tegrabl_blockdev_read_block(dev, partial_block_buf, block, 1);
-		if (error != TEGRABL_NO_ERROR) {
-			TEGRABL_SET_HIGHEST_MODULE(error);
-			goto fail;
-		}
-
-		/* copy the partial block from our temp_buf buffer */
-		memcpy(buf, partial_block_buf, len);
-		bytes_read += len;
+		block += count;
+		block_offset = 0;
 	}
 
 fail:
-	if (partial_block_buf != NULL) {
-		tegrabl_dealloc(TEGRABL_HEAP_DMA, partial_block_buf);
-	}
-	if (temp_buf != NULL) {
-		tegrabl_dealloc(TEGRABL_HEAP_DMA, temp_buf);
+	if (dev != NULL) {
+		tegrabl_blockdev_bounce_put(dev, bounce);
 	}
 	return error;
 }
@@ -187,133 +217,89 @@ static tegrabl_error_t tegrabl_blockdev_default_write(tegrabl_bdev_t *dev,
 	const void *buffer, off_t offset, off_t len)
 {
 	const uint8_t *buf = (const uint8_t *)buffer;
-	size_t bytes_written = 0;
+	uint8_t *bounce = NULL;
+	bnum_t bounce_count = 0;
 	bnum_t block;
+	bnum_t count;
+	size_t block_offset;
+	size_t bytes;
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-	void *temp_buf = NULL;
-	void *partial_block_buf = NULL;
 
 	if ((dev == NULL) || (buffer == NULL)) {
 		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 2);
 		goto fail;
 	}
 
-	if ((MOD_LOG2(offset, dev->block_size_log2) != 0U) ||
-		(MOD_LOG2(len, dev->block_size_log2) != 0U)) {
-		partial_block_buf = tegrabl_alloc_align(TEGRABL_HEAP_DMA, TEGRABL_BLOCKDEV_MEM_ALIGN_SIZE,
-												TEGRABL_BLOCKDEV_BLOCK_SIZE(dev));
-		if (partial_block_buf == NULL) {
-			error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
-			goto fail;
-		}
-	}
-
 	/* find the starting block */
 	block = DIV_FLOOR_LOG2(offset, dev->block_size_log2);
+	block_offset = MOD_LOG2(offset, dev->block_size_log2);
 
 	pr_trace("buf %p, offset %" PRIu64", block %u, len %"PRIu64"\n",
 			 buf, offset, block, len);
 
-	/* handle partial first block */
-	if (MOD_LOG2(offset, dev->block_size_log2) != 0U) {
-		/* read in the block */
-		error = tegrabl_blockdev_read_block(dev, partial_block_buf, block, 1);
-		if (error != TEGRABL_NO_ERROR) {
-			TEGRABL_SET_HIGHEST_MODULE(error);
-			goto fail;
-		}
-
-		/* copy what we need */
-		size_t block_offset = MOD_LOG2(offset, dev->block_size_log2);
-		size_t tocopy = MIN(TEGRABL_BLOCKDEV_BLOCK_SIZE(dev) -
-							block_offset, len);
-		memcpy((uint8_t *)partial_block_buf + block_offset, buf, tocopy);
-
-		/* write it back out */
-		error = tegrabl_blockdev_write_block(dev, partial_block_buf, block, 1);
-		if (error != TEGRABL_NO_ERROR) {
-			TEGRABL_SET_HIGHEST_MODULE(error);
-			goto fail;
-		}
-
-		/* increment our buffers */
-		buf += tocopy;
-		len -= tocopy;
-		bytes_written += tocopy;
-		block++;
-	}
-
-	pr_trace("buf %p, block %u, len %"PRIu64"\n", buf, block, len);
-
-	/* handle middle blocks */
-	if (len >= (1U << dev->block_size_log2)) {
-		/* do the middle writes */
-		size_t block_count = DIV_FLOOR_LOG2(len, dev->block_size_log2);
-		size_t bytes = block_count << dev->block_size_log2;
-		if (bytes > len) {
-			error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 3);
-			goto fail;
-		}
-		if (!tegrabl_blockdev_buffer_aligned(dev, buf)) {
-			temp_buf = tegrabl_alloc_align(TEGRABL_HEAP_DMA, TEGRABL_BLOCKDEV_MEM_ALIGN_SIZE,
-										   block_count * TEGRABL_BLOCKDEV_BLOCK_SIZE(dev));
-			if (temp_buf == NULL) {
-				error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 2);
+	while (len > 0ULL) {
+		if ((block_offset == 0U) && (len >= TEGRABL_BLOCKDEV_BLOCK_SIZE(dev)) &&
+			tegrabl_blockdev_buffer_aligned(dev, buf)) {
+			/* whole blocks straight from the caller's buffer */
+			count = (bnum_t)DIV_FLOOR_LOG2(len, dev->block_size_log2);
+			error = tegrabl_blockdev_write_block(dev, buf, block, count);
+			if (error != TEGRABL_NO_ERROR) {
+				TEGRABL_SET_HIGHEST_MODULE(error);
 				goto fail;
 			}
-			memcpy(temp_buf, buf, bytes);
-			error = tegrabl_blockdev_write_block(dev, temp_buf, block, block_count);
+			bytes = (size_t)count << dev->block_size_log2;
 		} else {
-			error = tegrabl_blockdev_write_block(dev, buf, block, block_count);
-		}
+			count = tegrabl_blockdev_bounce_span(dev, buf, block_offset, len);
+			if (bounce == NULL) {
+				bounce_count = count;
+				bounce = tegrabl_blockdev_bounce_get(dev, &bounce_count);
+				if (bounce == NULL) {
+					error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 2);
+					goto fail;
+				}
+			}
+			count = MIN(count, bounce_count);
+			bytes = MIN(((size_t)count << dev->block_size_log2) - block_offset, len);
+
+			/* read in the partially written first and last blocks */
+			if (block_offset != 0U) {
+				error = tegrabl_blockdev_read_block(dev, bounce, block, 1);
+				if (error != TEGRABL_NO_ERROR) {
+					TEGRABL_SET_HIGHEST_MODULE(error);
+					goto fail;
+				}
+			}
+			if (((block_offset + bytes) < ((size_t)count << dev->block_size_log2)) &&
+				((count > 1U) || (block_offset == 0U))) {
+				error = tegrabl_blockdev_read_block(dev,
+					bounce + ((size_t)(count - 1U) << dev->block_size_log2),
+					block + count - 1U, 1);
+				if (error != TEGRABL_NO_ERROR) {
+					TEGRABL_SET_HIGHEST_MODULE(error);
+					goto fail;
+				}
+			}
 
-		if (error != TEGRABL_NO_ERROR) {
-			TEGRABL_SET_HIGHEST_MODULE(error);
-			goto fail;
+			memcpy(bounce + block_offset, buf, bytes);
+			error = tegrabl_blockdev_write_block(dev, bounce, block, count);
+			if (error != TEGRABL_NO_ERROR) {
+				TEGRABL_SET_HIGHEST_MODULE(error);
+				goto fail;
+			}
 		}
 
-		/* increment our buffers */
+		pr_trace("buf %p, block %u, count %u\n", buf, block, count);
+
 		buf += bytes;
 		len -= bytes;
-		bytes_written += bytes;
-		block += block_count;
-	}
-
-	pr_trace("buf %p, block %u, len %"PRIu64"\n", buf, block, len);
-
-	/* handle partial last block */
-	if (len > 0ULL) {
-		if (partial_block_buf == NULL) {
-			error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
-			goto fail;
-		}
-		/* read the block */
-		error = tegrabl_blockdev_read_block(dev, partial_block_buf, block, 1);
-		if (error != TEGRABL_NO_ERROR) {
-			TEGRABL_SET_HIGHEST_MODULE(error);
-			goto fail;
-		}
-		/* copy the partial block from our temp_buf buffer */
-		memcpy(partial_block_buf, buf, len);
-
-		/* write it back out */
-		error = tegrabl_blockdev_write_block(dev, partial_block_buf, block, 1);
-		if (error != TEGRABL_NO_ERROR) {
-			TEGRABL_SET_HIGHEST_MODULE(error);
-			goto fail;
-		}
-
-		bytes_written += len;
+		block += count;
+		block_offset = 0;
 	}
 
 fail:
-	if (temp_buf != NULL) {
-		tegrabl_dealloc(TEGRABL_HEAP_DMA, temp_buf);
-	}
-	if (partial_block_buf != NULL) {
-		tegrabl_dealloc(TEGRABL_HEAP_DMA, partial_block_buf);
+	if (dev != NULL) {
+		tegrabl_blockdev_bounce_put(dev, bounce);
 	}
-	/* return error or bytes written */
 	return error;
 }
 
@@ -380,6 +366,11 @@ static tegrabl_error_t bdev_dec_ref(tegrabl_bdev_t *dev)
 		if (dev->close != NULL)
 			dev->close(dev);
 
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+		if (dev->bounce.buf != NULL) {
+			tegrabl_dealloc(TEGRABL_HEAP_DMA, dev->bounce.buf);
+		}
+#endif
 		tegrabl_free(dev);
 	}
 fail:
@@ -764,6 +755,8 @@ tegrabl_error_t tegrabl_blockdev_ioctl(tegrabl_bdev_t *dev, uint32_t ioctl,
 	if (ioctl == TEGRABL_IOCTL_BLOCK_SIZE) {
 		bsize = (size_t *)args;
 		*bsize = TEGRABL_BLOCKDEV_BLOCK_SIZE(dev);
+	} else if (dev->ioctl == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 3);
 	} else {
 		error = dev->ioctl(dev, ioctl, args);
 		if (error != TEGRABL_NO_ERROR) {
@@ -795,6 +788,10 @@ tegrabl_error_t tegrabl_blockdev_initialize_bdev(tegrabl_bdev_t *dev,
 	dev->block_count = block_count;
 	dev->size = (off_t)block_count << block_size_log2;
 	dev->ref = 0;
+	dev->max_xfer_blocks = 0;
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+	memset(&dev->bounce, 0, sizeof(dev->bounce));
+#endif
 
 #if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
 	/* set up the default hooks, the sub driver should override the block
@@ -867,6 +864,10 @@ void tegrabl_blockdev_dump_devices(void)
 	list_for_every_entry(&bdevs->list, entry, tegrabl_bdev_t, node) {
 		pr_debug("\t%d, size %"PRIu64", bsize %lu, ref %d\n", entry->device_id,
 				 entry->size, TEGRABL_BLOCKDEV_BLOCK_SIZE(entry), entry->ref);
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+		pr_debug("\t\tbounce %u blocks, %"PRIu64" hits, %"PRIu64" misses\n",
+				 entry->bounce.block_count, entry->bounce.hits, entry->bounce.misses);
+#endif
 	}
 }
 
@@ -884,6 +885,7 @@ const char *tegrabl_blockdev_get_name(tegrabl_storage_type_t type)
 		[TEGRABL_STORAGE_UFS_USER] = "UFS_USER",
 		[TEGRABL_STORAGE_UFS_RPMB] = "UFS_RPMB",
 		[TEGRABL_STORAGE_NVME] = "NVME",
+		[TEGRABL_STORAGE_EMU] = "EMU",
 	};
 
 	TEGRABL_COMPILE_ASSERT(ARRAY_SIZE(storage_name) == TEGRABL_STORAGE_MAX, "missing storage-type in array");
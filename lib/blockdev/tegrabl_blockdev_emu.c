@@ -0,0 +1,557 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+#define MODULE TEGRABL_ERR_BLOCK_DEV
+
+#include "build_config.h"
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <tegrabl_blockdev.h>
+#include <tegrabl_blockdev_emu.h>
+#include <tegrabl_malloc.h>
+#include <tegrabl_debug.h>
+#include <tegrabl_utils.h>
+#include <tegrabl_error.h>
+#include <tegrabl_compiler.h>
+#include <tegrabl_timer.h>
+
+/**
+ * @brief Non-blocking transfer accepted by the device. The data is moved when
+ * the modelled completion time has passed, so a caller looking at the buffer
+ * too early sees stale contents just like with a real controller.
+ */
+struct emu_slot {
+	struct tegrabl_blockdev_xfer_info *xfer;
+	time_t done;
+	tegrabl_error_t error;
+	bool complete;
+};
+
+struct emu_context {
+	struct tegrabl_blockdev_emu_config config;
+	uint8_t *backing;
+	bool own_backing;
+	/* current time for virtual_time devices */
+	time_t vclock;
+	/* time the media finishes the last accepted command */
+	time_t busy_until;
+	/* in submission order, which is also completion order */
+	struct emu_slot queue[TEGRABL_BLOCKDEV_EMU_MAX_QUEUE_DEPTH];
+	uint32_t queued;
+	struct tegrabl_blockdev_emu_fault faults[TEGRABL_BLOCKDEV_EMU_MAX_FAULTS];
+	struct tegrabl_blockdev_emu_stats stats;
+};
+
+static inline time_t emu_now(struct emu_context *ctx)
+{
+	return ctx->config.virtual_time ? ctx->vclock : tegrabl_get_timestamp_us();
+}
+
+static void emu_wait_until(struct emu_context *ctx, time_t t)
+{
+	time_t now = emu_now(ctx);
+
+	if (t <= now) {
+		return;
+	}
+
+	ctx->stats.wait_us += t - now;
+	if (ctx->config.virtual_time) {
+		ctx->vclock = t;
+	} else {
+		while (tegrabl_get_timestamp_us() < t) {
+			;
+		}
+	}
+}
+
+/**
+ * @brief Accounts a command on the media and returns its completion time
+ */
+static time_t emu_schedule(struct emu_context *ctx, uint32_t cmd, bnum_t count)
+{
+	const struct tegrabl_blockdev_emu_config *cfg = &ctx->config;
+	uint64_t bytes = (uint64_t)count << cfg->block_size_log2;
+	uint64_t chunks = 1;
+	uint64_t cost;
+	uint32_t mbps = 0;
+	time_t start;
+
+	if ((cfg->max_xfer_blocks != 0U) && (count != 0U)) {
+		chunks = DIV_CEIL(count, cfg->max_xfer_blocks);
+	}
+
+	if (cmd == TEGRABL_BLOCKDEV_EMU_CMD_ERASE) {
+		cost = chunks * cfg->erase_latency_us;
+	} else {
+		cost = chunks * cfg->cmd_latency_us;
+		mbps = (cmd == TEGRABL_BLOCKDEV_EMU_CMD_READ) ? cfg->read_mbps :
+				cfg->write_mbps;
+	}
+
+	/* a MB/s is a byte per us */
+	if (mbps != 0U) {
+		cost += DIV_CEIL(bytes, mbps);
+	}
+
+	start = MAX(emu_now(ctx), ctx->busy_until);
+	ctx->busy_until = start + cost;
+
+	ctx->stats.cmds[cmd] += chunks;
+	ctx->stats.blocks[cmd] += count;
+	ctx->stats.busy_us += cost;
+
+	return ctx->busy_until;
+}
+
+/**
+ * @brief Returns the error of the first armed fault matching the command
+ */
+static tegrabl_error_t emu_check_faults(struct emu_context *ctx, uint32_t cmd,
+	bnum_t block, bnum_t count)
+{
+	struct tegrabl_blockdev_emu_fault *fault;
+	uint32_t i;
+
+	for (i = 0; i < TEGRABL_BLOCKDEV_EMU_MAX_FAULTS; i++) {
+		fault = &ctx->faults[i];
+		if (((fault->cmd_mask & (1U << cmd)) == 0U) ||
+			((uint64_t)block >= ((uint64_t)fault->start_block + fault->block_count)) ||
+			((uint64_t)block + count <= fault->start_block)) {
+			continue;
+		}
+
+		if (fault->skip != 0U) {
+			fault->skip--;
+			continue;
+		}
+
+		if (fault->count != 0U) {
+			fault->count--;
+			if (fault->count == 0U) {
+				/* spent, disarm */
+				fault->cmd_mask = 0;
+			}
+		}
+
+		ctx->stats.faults++;
+		pr_debug("emu: fault 0x%08x on cmd %u, block %u, count %u\n",
+				 fault->error, cmd, block, count);
+		return fault->error;
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+static void emu_move_data(struct emu_context *ctx, uint32_t cmd, void *buf,
+	bnum_t block, bnum_t count)
+{
+	uint8_t *media = ctx->backing + ((size_t)block << ctx->config.block_size_log2);
+	size_t bytes = (size_t)count << ctx->config.block_size_log2;
+
+	if (cmd == TEGRABL_BLOCKDEV_EMU_CMD_READ) {
+		memcpy(buf, media, bytes);
+	} else if (cmd == TEGRABL_BLOCKDEV_EMU_CMD_WRITE) {
+		memcpy(media, buf, bytes);
+	} else {
+		memset(media, 0, bytes);
+	}
+}
+
+static inline uint32_t emu_xfer_cmd(struct tegrabl_blockdev_xfer_info *xfer)
+{
+	return (xfer->xfer_type == TEGRABL_BLOCKDEV_WRITE) ?
+		TEGRABL_BLOCKDEV_EMU_CMD_WRITE : TEGRABL_BLOCKDEV_EMU_CMD_READ;
+}
+
+/**
+ * @brief Moves the data of all the queued transfers which have completed
+ */
+static void emu_retire(struct emu_context *ctx)
+{
+	struct emu_slot *slot;
+	time_t now = emu_now(ctx);
+	uint32_t i;
+
+	for (i = 0; i < ctx->queued; i++) {
+		slot = &ctx->queue[i];
+		if (slot->done > now) {
+			break;
+		}
+		if (slot->complete) {
+			continue;
+		}
+		if (slot->error == TEGRABL_NO_ERROR) {
+			emu_move_data(ctx, emu_xfer_cmd(slot->xfer), slot->xfer->buf,
+						  slot->xfer->start_block, slot->xfer->block_count);
+		}
+		slot->complete = true;
+	}
+}
+
+static tegrabl_error_t emu_validate(tegrabl_bdev_t *dev, uint32_t cmd,
+	const void *buf, bnum_t block, bnum_t count)
+{
+	struct emu_context *ctx = dev->priv_data;
+
+	if (ctx == NULL) {
+		return TEGRABL_ERROR(TEGRABL_ERR_NOT_INITIALIZED, 0);
+	}
+
+	if ((uint64_t)block + count > dev->block_count) {
+		pr_error("emu: [%u, +%u] beyond %u blocks\n", block, count,
+				 dev->block_count);
+		return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 1);
+	}
+
+	if (cmd != TEGRABL_BLOCKDEV_EMU_CMD_ERASE) {
+		if (buf == NULL) {
+			return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 30);
+		}
+		if (MOD_POW2((uintptr_t)buf, ctx->config.buf_align_size) != 0UL) {
+			pr_error("emu: buffer %p not aligned to %u\n", buf,
+					 ctx->config.buf_align_size);
+			return TEGRABL_ERROR(TEGRABL_ERR_NOT_ALIGNED, 0);
+		}
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+/**
+ * @brief Runs a blocking command, queued behind whatever the media is busy with
+ */
+static tegrabl_error_t emu_io(tegrabl_bdev_t *dev, uint32_t cmd, void *buf,
+	bnum_t block, bnum_t count)
+{
+	struct emu_context *ctx = dev->priv_data;
+	tegrabl_error_t error;
+	time_t done;
+
+	error = emu_validate(dev, cmd, buf, block, count);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	error = emu_check_faults(ctx, cmd, block, count);
+	done = emu_schedule(ctx, cmd, count);
+	emu_wait_until(ctx, done);
+
+	/* everything accepted before this command is done by now */
+	emu_retire(ctx);
+
+	if (error == TEGRABL_NO_ERROR) {
+		emu_move_data(ctx, cmd, buf, block, count);
+	}
+
+fail:
+	return error;
+}
+
+static tegrabl_error_t emu_bdev_read_block(tegrabl_bdev_t *dev, void *buf,
+	bnum_t block, bnum_t count)
+{
+	return emu_io(dev, TEGRABL_BLOCKDEV_EMU_CMD_READ, buf, block, count);
+}
+
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+static tegrabl_error_t emu_bdev_write_block(tegrabl_bdev_t *dev,
+	const void *buf, bnum_t block, bnum_t count)
+{
+	return emu_io(dev, TEGRABL_BLOCKDEV_EMU_CMD_WRITE, (void *)buf, block, count);
+}
+
+static tegrabl_error_t emu_bdev_erase(tegrabl_bdev_t *dev, bnum_t block,
+	bnum_t count, bool is_secure)
+{
+	TEGRABL_UNUSED(is_secure);
+
+	return emu_io(dev, TEGRABL_BLOCKDEV_EMU_CMD_ERASE, NULL, block, count);
+}
+
+static tegrabl_error_t emu_bdev_xfer(struct tegrabl_blockdev_xfer_info *xfer)
+{
+	tegrabl_bdev_t *dev = xfer->dev;
+	struct emu_context *ctx = dev->priv_data;
+	uint32_t cmd = emu_xfer_cmd(xfer);
+	struct emu_slot *slot;
+	tegrabl_error_t error;
+
+	if (!xfer->is_non_blocking) {
+		error = emu_io(dev, cmd, xfer->buf, xfer->start_block,
+					   xfer->block_count);
+		xfer->xfer_status = (error == TEGRABL_NO_ERROR) ?
+			TEGRABL_BLOCKDEV_XFER_COMPLETE : TEGRABL_BLOCKDEV_XFER_FAILURE;
+		goto fail;
+	}
+
+	error = emu_validate(dev, cmd, xfer->buf, xfer->start_block,
+						 xfer->block_count);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	if (ctx->queued >= ctx->config.queue_depth) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_BUSY, 0);
+		goto fail;
+	}
+
+	slot = &ctx->queue[ctx->queued++];
+	slot->xfer = xfer;
+	slot->error = emu_check_faults(ctx, cmd, xfer->start_block,
+								   xfer->block_count);
+	slot->done = emu_schedule(ctx, cmd, xfer->block_count);
+	slot->complete = false;
+
+	ctx->stats.max_queued = MAX(ctx->stats.max_queued, ctx->queued);
+	xfer->xfer_status = TEGRABL_BLOCKDEV_XFER_IN_PROGRESS;
+
+fail:
+	return error;
+}
+
+static tegrabl_error_t emu_bdev_xfer_wait(
+	struct tegrabl_blockdev_xfer_info *xfer, time_t timeout,
+	uint8_t *status_flag)
+{
+	struct emu_context *ctx = xfer->dev->priv_data;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	struct emu_slot *slot = NULL;
+	time_t now;
+	uint32_t i;
+
+	for (i = 0; i < ctx->queued; i++) {
+		if (ctx->queue[i].xfer == xfer) {
+			slot = &ctx->queue[i];
+			break;
+		}
+	}
+
+	if (slot == NULL) {
+		/* blocking transfers are finished by the time xfer returns */
+		if (xfer->xfer_status != TEGRABL_BLOCKDEV_XFER_COMPLETE) {
+			error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 31);
+		}
+		*status_flag = xfer->xfer_status;
+		goto fail;
+	}
+
+	/*
+	 * a poll still costs a microsecond on the virtual clock, else callers
+	 * polling with a zero timeout would never see the transfer finish
+	 */
+	if (ctx->config.virtual_time && (timeout == 0U)) {
+		timeout = 1;
+	}
+	now = emu_now(ctx);
+	emu_wait_until(ctx, ((slot->done - MIN(slot->done, now)) > timeout) ?
+				   (now + timeout) : slot->done);
+	emu_retire(ctx);
+
+	if (!slot->complete) {
+		*status_flag = TEGRABL_BLOCKDEV_XFER_IN_PROGRESS;
+		goto fail;
+	}
+
+	error = slot->error;
+	xfer->xfer_status = (error == TEGRABL_NO_ERROR) ?
+		TEGRABL_BLOCKDEV_XFER_COMPLETE : TEGRABL_BLOCKDEV_XFER_FAILURE;
+	*status_flag = xfer->xfer_status;
+
+	ctx->queued--;
+	memmove(slot, slot + 1, (size_t)(ctx->queue + ctx->queued - slot) * sizeof(*slot));
+
+fail:
+	return error;
+}
+#endif
+
+static tegrabl_error_t emu_bdev_ioctl(tegrabl_bdev_t *dev, uint32_t ioctl,
+	void *args)
+{
+	struct emu_context *ctx = dev->priv_data;
+
+	TEGRABL_UNUSED(args);
+
+	if (ioctl == TEGRABL_IOCTL_DEVICE_CACHE_FLUSH) {
+		emu_wait_until(ctx, ctx->busy_until);
+		emu_retire(ctx);
+		return TEGRABL_NO_ERROR;
+	}
+
+	return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+}
+
+static tegrabl_error_t emu_bdev_close(tegrabl_bdev_t *dev)
+{
+	struct emu_context *ctx = dev->priv_data;
+
+	if (ctx != NULL) {
+		if (ctx->own_backing) {
+			tegrabl_free(ctx->backing);
+		}
+		tegrabl_free(ctx);
+		dev->priv_data = NULL;
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t tegrabl_blockdev_emu_open(uint32_t instance,
+	const struct tegrabl_blockdev_emu_config *config)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	struct emu_context *ctx = NULL;
+	tegrabl_bdev_t *dev = NULL;
+	size_t size;
+
+	if ((config == NULL) || (config->block_count == 0U) ||
+		(config->queue_depth > TEGRABL_BLOCKDEV_EMU_MAX_QUEUE_DEPTH) ||
+		((config->buf_align_size & (config->buf_align_size - 1U)) != 0U)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 32);
+		goto fail;
+	}
+
+	size = (size_t)config->block_count << config->block_size_log2;
+	if ((size >> config->block_size_log2) != config->block_count) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_TOO_LARGE, 0);
+		goto fail;
+	}
+
+	ctx = tegrabl_calloc(1, sizeof(*ctx));
+	dev = tegrabl_calloc(1, sizeof(*dev));
+	if ((ctx == NULL) || (dev == NULL)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 2);
+		goto fail;
+	}
+
+	ctx->config = *config;
+	if (ctx->config.buf_align_size == 0U) {
+		ctx->config.buf_align_size = 1;
+	}
+	if (ctx->config.queue_depth == 0U) {
+		ctx->config.queue_depth = 1;
+	}
+
+	ctx->backing = config->backing;
+	if (ctx->backing == NULL) {
+		ctx->backing = tegrabl_calloc(1, size);
+		if (ctx->backing == NULL) {
+			pr_error("emu: no memory for %"PRIu64" byte backing store\n", (uint64_t)size);
+			error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 3);
+			goto fail;
+		}
+		ctx->own_backing = true;
+	}
+
+	error = tegrabl_blockdev_initialize_bdev(dev,
+		TEGRABL_BLOCK_DEVICE_ID(TEGRABL_STORAGE_EMU, instance),
+		config->block_size_log2, config->block_count);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	dev->buf_align_size = ctx->config.buf_align_size;
+	dev->max_xfer_blocks = config->max_xfer_blocks;
+	dev->read_block = emu_bdev_read_block;
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+	dev->write_block = emu_bdev_write_block;
+	dev->erase = emu_bdev_erase;
+	dev->xfer = emu_bdev_xfer;
+	dev->xfer_wait = emu_bdev_xfer_wait;
+#endif
+	dev->ioctl = emu_bdev_ioctl;
+	dev->close = emu_bdev_close;
+	dev->priv_data = ctx;
+
+	error = tegrabl_blockdev_register_device(dev);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	pr_info("emu: instance %u, %u blocks of %lu bytes, qd %u, %u us/cmd, "
+			"r %u w %u MB/s%s\n", instance, config->block_count,
+			TEGRABL_BLOCKDEV_BLOCK_SIZE(dev), config->queue_depth,
+			config->cmd_latency_us, config->read_mbps, config->write_mbps,
+			config->virtual_time ? ", virtual time" : "");
+
+fail:
+	if (error != TEGRABL_NO_ERROR) {
+		pr_error("%s: error = 0x%08x\n", __func__, error);
+		if ((ctx != NULL) && ctx->own_backing) {
+			tegrabl_free(ctx->backing);
+		}
+		tegrabl_free(ctx);
+		tegrabl_free(dev);
+	}
+	return error;
+}
+
+static struct emu_context *emu_get_context(tegrabl_bdev_t *dev)
+{
+	if ((dev == NULL) ||
+		(tegrabl_blockdev_get_storage_type(dev) != TEGRABL_STORAGE_EMU)) {
+		return NULL;
+	}
+	return dev->priv_data;
+}
+
+tegrabl_error_t tegrabl_blockdev_emu_inject_fault(tegrabl_bdev_t *dev,
+	const struct tegrabl_blockdev_emu_fault *fault)
+{
+	struct emu_context *ctx = emu_get_context(dev);
+	uint32_t i;
+
+	if ((ctx == NULL) || (fault == NULL) || (fault->cmd_mask == 0U)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 33);
+	}
+
+	for (i = 0; i < TEGRABL_BLOCKDEV_EMU_MAX_FAULTS; i++) {
+		if (ctx->faults[i].cmd_mask == 0U) {
+			ctx->faults[i] = *fault;
+			return TEGRABL_NO_ERROR;
+		}
+	}
+
+	return TEGRABL_ERROR(TEGRABL_ERR_NO_RESOURCE, 0);
+}
+
+void tegrabl_blockdev_emu_clear_faults(tegrabl_bdev_t *dev)
+{
+	struct emu_context *ctx = emu_get_context(dev);
+
+	if (ctx != NULL) {
+		memset(ctx->faults, 0, sizeof(ctx->faults));
+	}
+}
+
+tegrabl_error_t tegrabl_blockdev_emu_get_stats(tegrabl_bdev_t *dev,
+	struct tegrabl_blockdev_emu_stats *stats)
+{
+	struct emu_context *ctx = emu_get_context(dev);
+
+	if ((ctx == NULL) || (stats == NULL)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 34);
+	}
+
+	*stats = ctx->stats;
+	memset(&ctx->stats, 0, sizeof(ctx->stats));
+	ctx->stats.max_queued = ctx->queued;
+
+	return TEGRABL_NO_ERROR;
+}
+
+time_t tegrabl_blockdev_emu_now(tegrabl_bdev_t *dev)
+{
+	struct emu_context *ctx = emu_get_context(dev);
+
+	return (ctx != NULL) ? emu_now(ctx) : tegrabl_get_timestamp_us();
+}
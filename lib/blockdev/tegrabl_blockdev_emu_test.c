@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+#define MODULE TEGRABL_ERR_BLOCK_DEV
+
+#include "build_config.h"
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <tegrabl_blockdev.h>
+#include <tegrabl_blockdev_emu.h>
+#include <tegrabl_malloc.h>
+#include <tegrabl_debug.h>
+#include <tegrabl_utils.h>
+#include <tegrabl_error.h>
+
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+
+#define EMU_TEST_INSTANCE 0xffU
+#define EMU_TEST_ALIGN 64U
+#define EMU_TEST_BLOCK_SIZE_LOG2 9U
+#define EMU_TEST_BLOCKS 64U
+#define EMU_TEST_SIZE (EMU_TEST_BLOCKS << EMU_TEST_BLOCK_SIZE_LOG2)
+#define EMU_TEST_QUEUE_DEPTH 4U
+/* blocks of each non-blocking read */
+#define EMU_TEST_XFER_BLOCKS 16U
+#define EMU_TEST_XFER_SIZE (EMU_TEST_XFER_BLOCKS << EMU_TEST_BLOCK_SIZE_LOG2)
+#define EMU_TEST_STALE 0xa5U
+#define EMU_TEST_NO_TIMEOUT ((time_t)-1)
+
+/*
+ * Every figure below follows from this model: 100 us per command of up to 32
+ * blocks plus the size at 256 MB/s for reads and 128 MB/s for writes.
+ */
+static const struct tegrabl_blockdev_emu_config emu_test_config = {
+	.backing = NULL,
+	.block_size_log2 = EMU_TEST_BLOCK_SIZE_LOG2,
+	.block_count = 256,
+	.buf_align_size = EMU_TEST_ALIGN,
+	.max_xfer_blocks = 32,
+	.queue_depth = EMU_TEST_QUEUE_DEPTH,
+	.cmd_latency_us = 100,
+	.erase_latency_us = 1000,
+	.read_mbps = 256,
+	.write_mbps = 128,
+	.virtual_time = true,
+};
+
+/* 64 block write: 2 commands and 32KB at 128 MB/s */
+#define EMU_TEST_WRITE_US (200U + 256U)
+/* 64 block read: 2 commands and 32KB at 256 MB/s */
+#define EMU_TEST_READ_US (200U + 128U)
+/* 16 block read: 1 command and 8KB at 256 MB/s */
+#define EMU_TEST_XFER_US (100U + 32U)
+#define EMU_TEST_POLL_US 10U
+
+static void emu_test_init_xfer(struct tegrabl_blockdev_xfer_info *xfer,
+	tegrabl_bdev_t *dev, uint8_t type, void *buf, bnum_t block, bnum_t count)
+{
+	memset(xfer, 0, sizeof(*xfer));
+	xfer->dev = dev;
+	xfer->xfer_type = type;
+	xfer->buf = buf;
+	xfer->start_block = block;
+	xfer->block_count = count;
+	xfer->is_non_blocking = true;
+}
+
+/* Blocking read and write through the default paths, with their cost */
+static tegrabl_error_t emu_test_blocking(tegrabl_bdev_t *dev,
+	const uint8_t *pattern, uint8_t *buf)
+{
+	tegrabl_error_t err;
+	time_t t;
+
+	t = tegrabl_blockdev_emu_now(dev);
+	err = tegrabl_blockdev_write_block(dev, pattern, 0, EMU_TEST_BLOCKS);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+	if ((tegrabl_blockdev_emu_now(dev) - t) != EMU_TEST_WRITE_US) {
+		pr_error("emu test: write took %"PRIu64" us\n",
+				 (uint64_t)(tegrabl_blockdev_emu_now(dev) - t));
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 40);
+	}
+
+	t = tegrabl_blockdev_emu_now(dev);
+	memset(buf, 0, EMU_TEST_SIZE);
+	err = tegrabl_blockdev_read_block(dev, buf, 0, EMU_TEST_BLOCKS);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+	if ((tegrabl_blockdev_emu_now(dev) - t) != EMU_TEST_READ_US) {
+		pr_error("emu test: read took %"PRIu64" us\n",
+				 (uint64_t)(tegrabl_blockdev_emu_now(dev) - t));
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 41);
+	}
+	if (memcmp(buf, pattern, EMU_TEST_SIZE) != 0) {
+		pr_error("emu test: blocking read differs\n");
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 42);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+/*
+ * Fills the queue with non-blocking reads and checks that the data shows up
+ * only once xfer_wait reports completion, in submission order.
+ */
+static tegrabl_error_t emu_test_nonblocking(tegrabl_bdev_t *dev,
+	const uint8_t *pattern, uint8_t *buf)
+{
+	struct tegrabl_blockdev_xfer_info xfer[EMU_TEST_QUEUE_DEPTH + 1U];
+	struct tegrabl_blockdev_xfer_info *x;
+	tegrabl_error_t err;
+	uint8_t status;
+	uint32_t polls;
+	uint32_t i;
+
+	memset(buf, EMU_TEST_STALE, EMU_TEST_SIZE);
+	for (i = 0; i <= EMU_TEST_QUEUE_DEPTH; i++) {
+		emu_test_init_xfer(&xfer[i], dev, TEGRABL_BLOCKDEV_READ,
+						   buf + (i * EMU_TEST_XFER_SIZE) % EMU_TEST_SIZE,
+						   i * EMU_TEST_XFER_BLOCKS, EMU_TEST_XFER_BLOCKS);
+	}
+
+	for (i = 0; i < EMU_TEST_QUEUE_DEPTH; i++) {
+		err = tegrabl_blockdev_xfer(&xfer[i]);
+		if (err != TEGRABL_NO_ERROR) {
+			return err;
+		}
+	}
+	/* the device must refuse more than its queue depth */
+	if (tegrabl_blockdev_xfer(&xfer[EMU_TEST_QUEUE_DEPTH]) == TEGRABL_NO_ERROR) {
+		pr_error("emu test: transfer beyond the queue depth accepted\n");
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 43);
+	}
+	if ((buf[0] != EMU_TEST_STALE) || (buf[EMU_TEST_XFER_SIZE] != EMU_TEST_STALE)) {
+		pr_error("emu test: data arrived before xfer_wait\n");
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 44);
+	}
+
+	/* waiting for the second one retires the first one on the way */
+	x = &xfer[1];
+	polls = 0;
+	do {
+		err = tegrabl_blockdev_xfer_wait(x, EMU_TEST_POLL_US, &status);
+		if (err != TEGRABL_NO_ERROR) {
+			return err;
+		}
+		polls++;
+	} while (status == TEGRABL_BLOCKDEV_XFER_IN_PROGRESS);
+	if ((status != TEGRABL_BLOCKDEV_XFER_COMPLETE) ||
+		(polls != DIV_CEIL(2U * EMU_TEST_XFER_US, EMU_TEST_POLL_US))) {
+		pr_error("emu test: status %u after %u polls\n", status, polls);
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 45);
+	}
+	if ((memcmp(buf, pattern, 2U * EMU_TEST_XFER_SIZE) != 0) ||
+		(buf[2U * EMU_TEST_XFER_SIZE] != EMU_TEST_STALE)) {
+		pr_error("emu test: data after the second read is wrong\n");
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 46);
+	}
+
+	/* an unbounded timeout runs to completion in one call */
+	for (i = 0; i < EMU_TEST_QUEUE_DEPTH; i++) {
+		if (i == 1U) {
+			continue;
+		}
+		err = tegrabl_blockdev_xfer_wait(&xfer[i], EMU_TEST_NO_TIMEOUT,
+										 &status);
+		if (err != TEGRABL_NO_ERROR) {
+			return err;
+		}
+		if (status != TEGRABL_BLOCKDEV_XFER_COMPLETE) {
+			pr_error("emu test: read %u not complete\n", i);
+			return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 47);
+		}
+	}
+	if (memcmp(buf, pattern, EMU_TEST_SIZE) != 0) {
+		pr_error("emu test: non-blocking reads differ\n");
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 48);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+/* A failed non-blocking write reports the fault and leaves the media alone */
+static tegrabl_error_t emu_test_fault(tegrabl_bdev_t *dev,
+	const uint8_t *pattern, uint8_t *buf)
+{
+	struct tegrabl_blockdev_emu_fault fault;
+	struct tegrabl_blockdev_xfer_info xfer;
+	tegrabl_error_t err;
+	uint8_t status;
+
+	memset(&fault, 0, sizeof(fault));
+	fault.cmd_mask = TEGRABL_BLOCKDEV_EMU_FAULT_WRITE;
+	fault.start_block = 0;
+	fault.block_count = 1;
+	fault.count = 1;
+	fault.error = TEGRABL_ERROR(TEGRABL_ERR_WRITE_FAILED, 0);
+	err = tegrabl_blockdev_emu_inject_fault(dev, &fault);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
+	memset(buf, EMU_TEST_STALE, EMU_TEST_XFER_SIZE);
+	emu_test_init_xfer(&xfer, dev, TEGRABL_BLOCKDEV_WRITE, buf, 0,
+					   EMU_TEST_XFER_BLOCKS);
+	err = tegrabl_blockdev_xfer(&xfer);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+	err = tegrabl_blockdev_xfer_wait(&xfer, EMU_TEST_NO_TIMEOUT, &status);
+	if ((err == TEGRABL_NO_ERROR) ||
+		(status != TEGRABL_BLOCKDEV_XFER_FAILURE)) {
+		pr_error("emu test: faulted write reported status %u\n", status);
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 49);
+	}
+
+	err = tegrabl_blockdev_read_block(dev, buf, 0, EMU_TEST_XFER_BLOCKS);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+	if (memcmp(buf, pattern, EMU_TEST_XFER_SIZE) != 0) {
+		pr_error("emu test: faulted write changed the media\n");
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 50);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t tegrabl_blockdev_emu_test(void)
+{
+	struct tegrabl_blockdev_emu_stats stats;
+	tegrabl_bdev_t *dev = NULL;
+	uint8_t *pattern = NULL;
+	uint8_t *buf = NULL;
+	tegrabl_error_t err;
+	uint32_t i;
+
+	pattern = tegrabl_memalign(EMU_TEST_ALIGN, EMU_TEST_SIZE);
+	buf = tegrabl_memalign(EMU_TEST_ALIGN, EMU_TEST_SIZE);
+	if ((pattern == NULL) || (buf == NULL)) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 10);
+		goto fail;
+	}
+	for (i = 0; i < EMU_TEST_SIZE; i++) {
+		pattern[i] = (uint8_t)((i * 7U) + (i >> EMU_TEST_BLOCK_SIZE_LOG2));
+	}
+
+	err = tegrabl_blockdev_emu_open(EMU_TEST_INSTANCE, &emu_test_config);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	dev = tegrabl_blockdev_open(TEGRABL_STORAGE_EMU, EMU_TEST_INSTANCE);
+	if (dev == NULL) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_OPEN_FAILED, 0);
+		goto fail;
+	}
+
+	err = emu_test_blocking(dev, pattern, buf);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	err = emu_test_nonblocking(dev, pattern, buf);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	err = emu_test_fault(dev, pattern, buf);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	err = tegrabl_blockdev_emu_get_stats(dev, &stats);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	if ((stats.max_queued != EMU_TEST_QUEUE_DEPTH) || (stats.faults != 1U)) {
+		pr_error("emu test: max queued %u, faults %u\n", stats.max_queued,
+				 stats.faults);
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 51);
+		goto fail;
+	}
+
+	pr_info("emu test: passed\n");
+
+fail:
+	if (dev != NULL) {
+		tegrabl_blockdev_close(dev);
+		/* drop the reference of the registration too, freeing the device */
+		tegrabl_blockdev_close(dev);
+	}
+	if (pattern != NULL) {
+		tegrabl_free(pattern);
+	}
+	if (buf != NULL) {
+		tegrabl_free(buf);
+	}
+
+	return err;
+}
+
+#endif /* !CONFIG_ENABLE_BLOCKDEV_BASIC */
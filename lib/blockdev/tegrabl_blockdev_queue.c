@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+#define MODULE TEGRABL_ERR_BLOCK_DEV
+
+#include "build_config.h"
+#include <stdint.h>
+#include <string.h>
+#include <tegrabl_blockdev.h>
+#include <tegrabl_malloc.h>
+#include <tegrabl_debug.h>
+#include <tegrabl_utils.h>
+#include <tegrabl_error.h>
+#include <tegrabl_timer.h>
+
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+
+/**
+ * @brief Run of merged requests, order[first] to order[first + num_reqs - 1]
+ */
+struct blockdev_cmd {
+	uint8_t xfer_type;
+	uint8_t *buf;
+	bnum_t start_block;
+	bnum_t block_count;
+	uint32_t first;
+	uint32_t num_reqs;
+};
+
+struct tegrabl_blockdev_queue {
+	tegrabl_bdev_t *dev;
+	struct tegrabl_blockdev_req *reqs;
+	/* request indices in issue order */
+	uint32_t *order;
+	struct blockdev_cmd *cmds;
+	uint32_t num_cmds;
+	uint32_t next_cmd;
+	/* blocks of the current command done so far */
+	bnum_t cmd_done;
+	/* blocks of the native transfer in flight, 0 if none */
+	bnum_t in_flight;
+	/* xfer types the driver refused to run non-blocking */
+	uint32_t sync_types;
+	struct tegrabl_blockdev_xfer_info xfer;
+};
+
+static void queue_set_error(struct tegrabl_blockdev_queue *queue,
+	const struct blockdev_cmd *cmd, tegrabl_error_t error)
+{
+	uint32_t i;
+
+	for (i = cmd->first; i < (cmd->first + cmd->num_reqs); i++) {
+		queue->reqs[queue->order[i]].error = error;
+	}
+}
+
+/**
+ * @brief Orders the requests by start block, keeping the submission order if
+ * any two of them overlap. Batches are short and usually already sorted, for
+ * which insertion sort is linear.
+ */
+static void queue_order(struct tegrabl_blockdev_queue *queue, uint32_t num)
+{
+	const struct tegrabl_blockdev_req *reqs = queue->reqs;
+	uint32_t *order = queue->order;
+	uint64_t end = 0;
+	uint32_t i;
+	uint32_t j;
+	uint32_t idx;
+
+	for (i = 0; i < num; i++) {
+		idx = i;
+		for (j = i; (j > 0U) &&
+			 (reqs[order[j - 1U]].start_block > reqs[idx].start_block); j--) {
+			order[j] = order[j - 1U];
+		}
+		order[j] = idx;
+	}
+
+	for (i = 0; i < num; i++) {
+		if (reqs[order[i]].start_block < end) {
+			pr_debug("%s: overlapping requests, keeping submission order\n",
+					 __func__);
+			for (j = 0; j < num; j++) {
+				order[j] = j;
+			}
+			break;
+		}
+		end = MAX(end, (uint64_t)reqs[order[i]].start_block +
+				  reqs[order[i]].block_count);
+	}
+}
+
+static void queue_merge(struct tegrabl_blockdev_queue *queue, uint32_t num)
+{
+	const struct tegrabl_blockdev_req *req;
+	struct blockdev_cmd *cmd = NULL;
+	uint32_t log2 = queue->dev->block_size_log2;
+	uint32_t i;
+
+	queue->num_cmds = 0;
+	for (i = 0; i < num; i++) {
+		req = &queue->reqs[queue->order[i]];
+		if ((cmd != NULL) && (cmd->xfer_type == req->xfer_type) &&
+			(((uint64_t)cmd->start_block + cmd->block_count) == req->start_block) &&
+			((cmd->buf + ((size_t)cmd->block_count << log2)) == req->buf) &&
+			(((uint64_t)cmd->block_count + req->block_count) <= UINT32_MAX)) {
+			cmd->block_count += req->block_count;
+			cmd->num_reqs++;
+			continue;
+		}
+
+		cmd = &queue->cmds[queue->num_cmds++];
+		cmd->xfer_type = req->xfer_type;
+		cmd->buf = req->buf;
+		cmd->start_block = req->start_block;
+		cmd->block_count = req->block_count;
+		cmd->first = i;
+		cmd->num_reqs = 1;
+	}
+}
+
+/**
+ * @brief Accounts count blocks of the current command as done
+ */
+static void queue_advance(struct tegrabl_blockdev_queue *queue, bnum_t count)
+{
+	struct blockdev_cmd *cmd = &queue->cmds[queue->next_cmd];
+
+	queue->cmd_done += count;
+	if (queue->cmd_done == cmd->block_count) {
+		queue_set_error(queue, cmd, TEGRABL_NO_ERROR);
+		queue->next_cmd++;
+		queue->cmd_done = 0;
+	}
+}
+
+/**
+ * @brief Starts the next piece of the current command on the driver's
+ * non-blocking path, or runs it to completion on the blocking one
+ */
+static tegrabl_error_t queue_dispatch(struct tegrabl_blockdev_queue *queue)
+{
+	tegrabl_bdev_t *dev = queue->dev;
+	struct blockdev_cmd *cmd = &queue->cmds[queue->next_cmd];
+	struct tegrabl_blockdev_xfer_info *xfer = &queue->xfer;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	bnum_t count = cmd->block_count - queue->cmd_done;
+	uint8_t *buf = cmd->buf + ((size_t)queue->cmd_done << dev->block_size_log2);
+	off_t offset;
+
+	if (dev->max_xfer_blocks != 0U) {
+		count = MIN(count, dev->max_xfer_blocks);
+	}
+
+	if ((dev->xfer != NULL) && (dev->xfer_wait != NULL) &&
+		((queue->sync_types & (1UL << cmd->xfer_type)) == 0UL) &&
+		(MOD_POW2((uintptr_t)buf, dev->buf_align_size) == 0UL)) {
+		memset(xfer, 0, sizeof(*xfer));
+		xfer->dev = dev;
+		xfer->xfer_type = cmd->xfer_type;
+		xfer->buf = buf;
+		xfer->start_block = cmd->start_block + queue->cmd_done;
+		xfer->block_count = count;
+		xfer->is_non_blocking = true;
+
+		error = dev->xfer(xfer);
+		if (error == TEGRABL_NO_ERROR) {
+			queue->in_flight = count;
+			goto fail;
+		}
+
+		/* e.g. drivers doing only reads non-blocking */
+		pr_debug("%s: xfer type %u refused (0x%08x), using blocking path\n",
+				 __func__, cmd->xfer_type, error);
+		queue->sync_types |= 1UL << cmd->xfer_type;
+	}
+
+	offset = (off_t)(cmd->start_block + queue->cmd_done) << dev->block_size_log2;
+	if (cmd->xfer_type == TEGRABL_BLOCKDEV_WRITE) {
+		error = tegrabl_blockdev_write(dev, buf, offset,
+									   (off_t)count << dev->block_size_log2);
+	} else {
+		error = tegrabl_blockdev_read(dev, buf, offset,
+									  (off_t)count << dev->block_size_log2);
+	}
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	queue_advance(queue, count);
+
+fail:
+	return error;
+}
+
+tegrabl_error_t tegrabl_blockdev_queue_submit(tegrabl_bdev_t *dev,
+	struct tegrabl_blockdev_req *reqs, uint32_t num,
+	struct tegrabl_blockdev_queue **queue)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	struct tegrabl_blockdev_queue *q = NULL;
+	const struct tegrabl_blockdev_req *req;
+	uint32_t i;
+
+	if ((dev == NULL) || (reqs == NULL) || (num == 0U) || (queue == NULL) ||
+		(dev->ref == 0U)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 35);
+		goto fail;
+	}
+
+	for (i = 0; i < num; i++) {
+		req = &reqs[i];
+		if ((req->buf == NULL) || (req->block_count == 0U) ||
+			((req->xfer_type != TEGRABL_BLOCKDEV_READ) &&
+			 (req->xfer_type != TEGRABL_BLOCKDEV_WRITE))) {
+			error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 36);
+			goto fail;
+		}
+		if (((uint64_t)req->start_block + req->block_count) > dev->block_count) {
+			error = TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 2);
+			goto fail;
+		}
+	}
+
+	q = tegrabl_calloc(1, sizeof(*q) + (num * sizeof(*q->order)) +
+					   (num * sizeof(*q->cmds)));
+	if (q == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 4);
+		goto fail;
+	}
+
+	q->dev = dev;
+	q->reqs = reqs;
+	q->cmds = (struct blockdev_cmd *)(q + 1);
+	q->order = (uint32_t *)(q->cmds + num);
+
+	for (i = 0; i < num; i++) {
+		reqs[i].error = TEGRABL_ERROR(TEGRABL_ERR_NOT_STARTED, 0);
+	}
+
+	queue_order(q, num);
+	queue_merge(q, num);
+
+	pr_trace("%u requests, %u commands\n", num, q->num_cmds);
+
+	/* get the device busy before the caller goes off doing other work */
+	if (dev->xfer != NULL) {
+		error = queue_dispatch(q);
+		if (error != TEGRABL_NO_ERROR) {
+			queue_set_error(q, &q->cmds[q->next_cmd], error);
+			goto fail;
+		}
+	}
+
+	*queue = q;
+
+fail:
+	if (error != TEGRABL_NO_ERROR) {
+		pr_error("Blockdev queue submit: exit error = %x\n", error);
+		tegrabl_free(q);
+	}
+	return error;
+}
+
+tegrabl_error_t tegrabl_blockdev_queue_wait(struct tegrabl_blockdev_queue *queue,
+	time_t timeout, uint8_t *status_flag)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	time_t start_time;
+	time_t elapsed = 0;
+	uint8_t status;
+
+	if ((queue == NULL) || (status_flag == NULL)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 37);
+	}
+
+	*status_flag = TEGRABL_BLOCKDEV_XFER_IN_PROGRESS;
+	start_time = tegrabl_get_timestamp_us();
+
+	/* every call dispatches at least once, so polling makes progress */
+	while (true) {
+		if (queue->in_flight != 0U) {
+			status = TEGRABL_BLOCKDEV_XFER_IN_PROGRESS;
+			error = queue->dev->xfer_wait(&queue->xfer,
+										  timeout - MIN(elapsed, timeout), &status);
+			if (error != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+			if (status == TEGRABL_BLOCKDEV_XFER_IN_PROGRESS) {
+				return TEGRABL_NO_ERROR;
+			}
+			queue_advance(queue, queue->in_flight);
+			queue->in_flight = 0;
+		} else if (elapsed > timeout) {
+			return TEGRABL_NO_ERROR;
+		}
+
+		if (queue->next_cmd == queue->num_cmds) {
+			break;
+		}
+
+		error = queue_dispatch(queue);
+		if (error != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+		elapsed = tegrabl_get_timestamp_us() - start_time;
+	}
+
+	*status_flag = TEGRABL_BLOCKDEV_XFER_COMPLETE;
+
+fail:
+	if (error != TEGRABL_NO_ERROR) {
+		pr_error("Blockdev queue: command %u of %u failed, error = %x\n",
+				 queue->next_cmd, queue->num_cmds, error);
+		TEGRABL_SET_HIGHEST_MODULE(error);
+		queue_set_error(queue, &queue->cmds[queue->next_cmd], error);
+		*status_flag = TEGRABL_BLOCKDEV_XFER_FAILURE;
+	}
+	tegrabl_free(queue);
+	return error;
+}
+
+tegrabl_error_t tegrabl_blockdev_submit(tegrabl_bdev_t *dev,
+	struct tegrabl_blockdev_req *reqs, uint32_t num)
+{
+	struct tegrabl_blockdev_queue *queue = NULL;
+	tegrabl_error_t error;
+	uint8_t status;
+
+	error = tegrabl_blockdev_queue_submit(dev, reqs, num, &queue);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	do {
+		error = tegrabl_blockdev_queue_wait(queue, UINT64_MAX, &status);
+	} while (status == TEGRABL_BLOCKDEV_XFER_IN_PROGRESS);
+
+fail:
+	return error;
+}
+
+#endif
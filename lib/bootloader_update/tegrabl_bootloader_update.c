@@ -224,42 +224,156 @@ static tegrabl_error_t is_always_ab_partition(const char *part_name,
 }
 
 
+#if defined(CONFIG_ENABLE_QSPI) && defined(CONFIG_ENABLE_QSPI_FLASH_DIFF_WRITE)
+/**
+ * @brief Erases the part of a partition past the new image. QSPI flash
+ * writes compare with the flash contents and erase only the sectors which
+ * need it, so the partition is not erased upfront.
+ *
+ * @param part Handle of the partition
+ * @param size Size of the new image
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error
+ */
+static tegrabl_error_t erase_partition_tail(struct tegrabl_partition *part,
+											uint32_t size)
+{
+	tegrabl_bdev_t *bdev = part->block_device;
+	uint32_t start_block = 0;
+	bnum_t num_blocks;
+	bnum_t used_blocks;
+	tegrabl_error_t status = TEGRABL_NO_ERROR;
+
+	status = tegrabl_partition_start_in_block(part, &start_block);
+	if (status != TEGRABL_NO_ERROR) {
+		goto end;
+	}
+
+	num_blocks = (bnum_t)(tegrabl_partition_size(part) >>
+						  TEGRABL_BLOCKDEV_BLOCK_SIZE_LOG2(bdev));
+	used_blocks = (bnum_t)DIV_CEIL_LOG2(size,
+										TEGRABL_BLOCKDEV_BLOCK_SIZE_LOG2(bdev));
+	if (used_blocks >= num_blocks) {
+		goto end;
+	}
+
+	status = tegrabl_blockdev_erase(bdev, start_block + used_blocks,
+									num_blocks - used_blocks, false);
+end:
+	return status;
+}
+
+/**
+ * @brief Writes an image to a partition, padding its last block with 0xFF.
+ * The partition is not erased upfront, so without the padding the bytes past
+ * the image in that block would keep their old contents.
+ *
+ * @param part Handle of the partition
+ * @param data Image to be written
+ * @param size Size of the image
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error
+ */
+static tegrabl_error_t write_partition_padded(struct tegrabl_partition *part,
+											  uint8_t *data, uint32_t size)
+{
+	uint32_t block_size = TEGRABL_BLOCKDEV_BLOCK_SIZE(part->block_device);
+	uint32_t aligned_size = size & ~(block_size - 1U);
+	uint8_t *last_block = NULL;
+	tegrabl_error_t status = TEGRABL_NO_ERROR;
+
+	if (aligned_size != 0U) {
+		status = tegrabl_partition_write(part, data, aligned_size);
+		if (status != TEGRABL_NO_ERROR) {
+			goto end;
+		}
+	}
+
+	if (aligned_size == size) {
+		goto end;
+	}
+
+	last_block = tegrabl_malloc(block_size);
+	if (last_block == NULL) {
+		status = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 1);
+		goto end;
+	}
+
+	memset(last_block, 0xFF, block_size);
+	memcpy(last_block, data + aligned_size, size - aligned_size);
+	status = tegrabl_partition_write(part, last_block, block_size);
+	tegrabl_free(last_block);
+
+end:
+	return status;
+}
+#endif
+
 static tegrabl_error_t write_partition(const char *part_name, uint8_t *data,
 									   uint32_t size)
 {
 	struct tegrabl_partition part;
 	tegrabl_error_t status = TEGRABL_NO_ERROR;
+	bool is_bct;
 
 	pr_info("Updating partition: %s...\n", part_name);
 	status = tegrabl_partition_open(part_name, &part);
 	if (status != TEGRABL_NO_ERROR) {
 		goto end;
 	}
+
+	is_bct = !strncmp(part_name, BR_BCT_PARTITION_NAME,
+					  strlen(BR_BCT_PARTITION_NAME)) &&
+			 (callbacks.update_bct != NULL);
+
 #if defined(CONFIG_ENABLE_QSPI)
 	uint32_t storage_type;
+	bool is_diff_write = false;
 
 	storage_type = tegrabl_blockdev_get_storage_type(part.block_device);
 	if (storage_type == TEGRABL_STORAGE_QSPI_FLASH) {
-		status = tegrabl_partition_erase(&part, false);
-		if (status != TEGRABL_NO_ERROR) {
-			TEGRABL_SET_HIGHEST_MODULE(status);
-			goto end;
+#if defined(CONFIG_ENABLE_QSPI_FLASH_DIFF_WRITE)
+		/* BCT copies are laid out by update_bct, start from a blank partition */
+		is_diff_write = !is_bct;
+#endif
+		if (!is_diff_write) {
+			status = tegrabl_partition_erase(&part, false);
+			if (status != TEGRABL_NO_ERROR) {
+				TEGRABL_SET_HIGHEST_MODULE(status);
+				goto end;
+			}
 		}
 	}
 #endif
 
-	if (!strncmp(part_name, BR_BCT_PARTITION_NAME,
-				 strlen(BR_BCT_PARTITION_NAME)) &&
-		callbacks.update_bct != NULL) {
+	if (is_bct) {
 		pr_info("updating bCT\n");
 		status = callbacks.update_bct((uintptr_t)data, size);
 		goto end;
 	}
 
+#if defined(CONFIG_ENABLE_QSPI) && defined(CONFIG_ENABLE_QSPI_FLASH_DIFF_WRITE)
+	if (is_diff_write) {
+		status = write_partition_padded(&part, data, size);
+	} else {
+		status = tegrabl_partition_write(&part, data, size);
+	}
+#else
 	status = tegrabl_partition_write(&part, data, size);
+#endif
 	if (status != TEGRABL_NO_ERROR) {
 		goto end;
 	}
+
+#if defined(CONFIG_ENABLE_QSPI) && defined(CONFIG_ENABLE_QSPI_FLASH_DIFF_WRITE)
+	if (is_diff_write) {
+		status = erase_partition_tail(&part, size);
+		if (status != TEGRABL_NO_ERROR) {
+			TEGRABL_SET_HIGHEST_MODULE(status);
+			goto end;
+		}
+	}
+#endif
 	tegrabl_partition_close(&part);
 end:
 	return status;
@@ -391,7 +505,8 @@ static tegrabl_error_t update_partition(tegrabl_blob_handle bh,
 			goto end;
 		}
 
-#if defined(CONFIG_ENABLE_QSPI)
+	/* with diff write, write_partition() erases only what the image needs */
+#if defined(CONFIG_ENABLE_QSPI) && !defined(CONFIG_ENABLE_QSPI_FLASH_DIFF_WRITE)
 	uint32_t storage_type;
 	struct tegrabl_partition part;
 	status = tegrabl_partition_open(entry->partname, &part);
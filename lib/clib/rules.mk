@@ -1,5 +1,5 @@
 #
-# Copyright (c) 2015-2016, NVIDIA Corporation.  All Rights Reserved.
+# Copyright (c) 2015-2023, NVIDIA Corporation.  All Rights Reserved.
 #
 # NVIDIA Corporation and its licensors retain all intellectual property and
 # proprietary rights in and to this software and related documentation.  Any
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2022, NVIDIA Corporation.  All rights reserved.
+ * Copyright (c) 2015-2023, NVIDIA Corporation.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -50,6 +50,42 @@ clib_dma_memset_t clib_dma_memset_callback = NULL;
 size_t clib_dma_memset_threshold = 0;
 void *clib_dma_memset_priv = 0;
 
+static struct tegrabl_clib_stats clib_stats;
+
+/* smallest size of each class */
+static const size_t clib_class_start[TEGRABL_CLIB_SIZE_CLASSES] = {
+	0, 4096, 64 * 1024, 1024 * 1024,
+};
+
+static uint32_t clib_size_class(size_t n)
+{
+	uint32_t cls = TEGRABL_CLIB_SIZE_CLASSES - 1U;
+
+	while (n < clib_class_start[cls]) {
+		cls--;
+	}
+	return cls;
+}
+
+/**
+ * @brief Selects DMA for the size classes that reach the registered
+ * threshold, memcpy/memset keep checking the threshold on each call.
+ */
+static void clib_dma_default_paths(uint8_t *path, bool registered,
+								   size_t threshold)
+{
+	uint32_t cls;
+
+	for (cls = 0; cls < TEGRABL_CLIB_SIZE_CLASSES; cls++) {
+		if (registered && ((cls == (TEGRABL_CLIB_SIZE_CLASSES - 1U)) ||
+						   (clib_class_start[cls + 1U] > threshold))) {
+			path[cls] = TEGRABL_CLIB_PATH_DMA;
+		} else {
+			path[cls] = TEGRABL_CLIB_PATH_CPU;
+		}
+	}
+}
+
 void tegrabl_clib_dma_register(struct tegrabl_clib_dma *dma_info)
 {
 	if (dma_info != NULL) {
@@ -59,15 +95,59 @@ void tegrabl_clib_dma_register(struct tegrabl_clib_dma *dma_info)
 		clib_dma_memset_callback = dma_info->memset_callback;
 		clib_dma_memset_threshold = dma_info->memset_threshold;
 		clib_dma_memset_priv = dma_info->memset_priv;
+
+		clib_dma_default_paths(clib_stats.memcpy_path,
+							   clib_dma_memcpy_callback != NULL,
+							   clib_dma_memcpy_threshold);
+		clib_dma_default_paths(clib_stats.memset_path,
+							   clib_dma_memset_callback != NULL,
+							   clib_dma_memset_threshold);
 	}
 }
 
+const struct tegrabl_clib_stats *tegrabl_clib_get_stats(void)
+{
+	return &clib_stats;
+}
+
 #if !defined(__ARM_ARCH_7R__)
-void *memset(void *s, int c, size_t n)
+
+/* forward copy, also used when dest is below an overlapping src */
+static void clib_word_memcpy(char *d, const char *s, size_t n)
 {
-	char *xs = (char *)s;
-	size_t len = (-(word)s) & lmask;
-	int not_done = 1;
+	size_t len;
+
+	if (((uintptr_t)d | (uintptr_t)s) & lmask) {
+		/* src and/or dest do not align on word boundary */
+		if ((((uintptr_t)d ^ (uintptr_t)s) & lmask) || (n < lsize))
+			len = n; /* copy the rest of the buffer with the byte mover */
+		else /* move ptrs up to word boundary */
+			len = lsize - ((uintptr_t)d & lmask);
+
+		n -= len;
+		for (; len > 0; len--)
+			*d++ = *s++;
+	}
+
+	for (len = (n / lsize); len > 0; len--) {
+		*(word *)d = *(word *)s;
+		d += lsize;
+		s += lsize;
+	}
+
+	for (len = (n & lmask); len > 0; len--)
+		*d++ = *s++;
+}
+
+#if defined(__aarch64__) && defined(CONFIG_ENABLE_CLIB_ARMV8_ASM)
+#define clib_cpu_copy(d, s, n) clib_cpu_memcpy((d), (s), (n))
+#define clib_cpu_fill(s, c, n) clib_cpu_memset((s), (c), (n))
+#else
+#define clib_cpu_copy(d, s, n) clib_word_memcpy((d), (s), (n))
+
+static void clib_cpu_fill(char *xs, int c, size_t n)
+{
+	size_t len = (-(word)xs) & lmask;
 	word cc = c & 0xff;
 
 	if (n > len) {
@@ -83,22 +163,10 @@ void *memset(void *s, int c, size_t n)
 			*xs++ = c;
 		}
 
-		len = (n / lsize);
-
-		if (clib_dma_memset_callback &&
-			((len * lsize) >= clib_dma_memset_threshold)) {
-			not_done = clib_dma_memset_callback(clib_dma_memset_priv, xs,
-												c, len * lsize);
-		}
-
-		if (not_done) {
-			/* write to aligned memory word-wise */
-			while (len--) {
-				*((word *)xs) = cc;
-				xs += lsize;
-			}
-		} else {
-			xs += (len * lsize);
+		/* write to aligned memory word-wise */
+		for (len = (n / lsize); len > 0; len--) {
+			*((word *)xs) = cc;
+			xs += lsize;
 		}
 
 		n &= lmask;
@@ -108,6 +176,100 @@ void *memset(void *s, int c, size_t n)
 	for (; n > 0; n--) {
 		*xs++ = c;
 	}
+}
+#endif
+
+/**
+ * @brief Hands the word aligned part of a copy to the DMA callback and copies
+ * the unaligned head and tail with the CPU.
+ *
+ * @return true if the buffer was copied, false to fall back to the CPU.
+ */
+static bool clib_dma_copy(char *d, const char *s, size_t n)
+{
+	size_t head = (-(uintptr_t)d) & 0x3U;
+	size_t body;
+
+	if ((clib_dma_memcpy_callback == NULL) ||
+		(n < clib_dma_memcpy_threshold) || (n < head) ||
+		((((uintptr_t)d ^ (uintptr_t)s) & 0x3U) != 0U)) {
+		return false;
+	}
+
+	body = (n - head) & ~(size_t)0x3U;
+	if (clib_dma_memcpy_callback(clib_dma_memcpy_priv, d + head, s + head,
+								 body) != 0) {
+		return false;
+	}
+
+	clib_cpu_copy(d, s, head);
+	clib_cpu_copy(d + head + body, s + head + body, n - head - body);
+
+	return true;
+}
+
+/**
+ * @brief DMA counterpart of clib_dma_copy() for memset
+ */
+static bool clib_dma_fill(char *s, int c, size_t n)
+{
+	size_t head = (-(uintptr_t)s) & 0x3U;
+	size_t body;
+
+	if ((clib_dma_memset_callback == NULL) ||
+		(n < clib_dma_memset_threshold) || (n < head)) {
+		return false;
+	}
+
+	body = (n - head) & ~(size_t)0x3U;
+	if (clib_dma_memset_callback(clib_dma_memset_priv, s + head,
+								 (uint32_t)c, body) != 0) {
+		return false;
+	}
+
+	clib_cpu_fill(s, c, head);
+	clib_cpu_fill(s + head + body, c, n - head - body);
+
+	return true;
+}
+
+/**
+ * @brief Copies n bytes between non-overlapping buffers with the given
+ * implementation, falling back to the CPU if the DMA callback refuses.
+ *
+ * @return implementation that did the copy
+ */
+static uint32_t clib_memcpy_via(uint32_t path, void *dest, const void *src,
+								size_t n)
+{
+	if ((path != TEGRABL_CLIB_PATH_DMA) || !clib_dma_copy(dest, src, n)) {
+		path = TEGRABL_CLIB_PATH_CPU;
+		clib_cpu_copy(dest, src, n);
+	}
+	return path;
+}
+
+/**
+ * @brief memset counterpart of clib_memcpy_via()
+ */
+static uint32_t clib_memset_via(uint32_t path, void *s, int c, size_t n)
+{
+	if ((path != TEGRABL_CLIB_PATH_DMA) || !clib_dma_fill(s, c, n)) {
+		path = TEGRABL_CLIB_PATH_CPU;
+		clib_cpu_fill(s, c, n);
+	}
+	return path;
+}
+
+void *memset(void *s, int c, size_t n)
+{
+	uint32_t cls = clib_size_class(n);
+	uint32_t path;
+
+	path = clib_memset_via(clib_stats.memset_path[cls], s, c, n);
+
+	clib_stats.memset[cls][path].calls++;
+	clib_stats.memset[cls][path].bytes += n;
 
 	return s;
 }
@@ -116,8 +278,8 @@ void *memcpy(void *dest, const void *src, size_t n)
 {
 	char *d = (char *)dest;
 	const char *s = (const char *)src;
-	size_t len;
-	int not_done = 1;
+	uint32_t cls;
+	uint32_t path;
 
 	if (n == 0 || dest == src) {
 		return dest;
@@ -127,38 +289,17 @@ void *memcpy(void *dest, const void *src, size_t n)
 		return NULL;
 	}
 
-	if (((uintptr_t)d | (uintptr_t)s) & lmask) {
-		/* src and/or dest do not align on word boundary */
-		if ((((uintptr_t)d ^ (uintptr_t)s) & lmask) || (n < lsize))
-			len = n; /* copy the rest of the buffer with the byte mover */
-		else /* move ptrs up to word boundary */
-			len = lsize - ((uintptr_t)d & lmask);
-
-		n -= len;
-		for (; len > 0; len--)
-			*d++ = *s++;
-	}
-
-	len = (n / lsize);
-
-	if (clib_dma_memcpy_callback &&
-		((len * lsize) >= clib_dma_memcpy_threshold))
-		not_done = clib_dma_memcpy_callback(clib_dma_memcpy_priv, d,
-											s, len * lsize);
-
-	if (not_done) {
-		while (len--) {
-			*(word *)d = *(word *)s;
-			d += lsize;
-			s += lsize;
-		}
+	/* memmove relies on forward copies when dest is below src */
+	cls = clib_size_class(n);
+	if ((d < s) && ((size_t)(s - d) < n)) {
+		clib_word_memcpy(d, s, n);
+		path = TEGRABL_CLIB_PATH_CPU;
 	} else {
-		d += (len * lsize);
-		s += (len * lsize);
+		path = clib_memcpy_via(clib_stats.memcpy_path[cls], d, s, n);
 	}
 
-	for (len = (n & lmask); len > 0; len--)
-		*d++ = *s++;
+	clib_stats.memcpy[cls][path].calls++;
+	clib_stats.memcpy[cls][path].bytes += n;
 
 	return dest;
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2017, NVIDIA Corporation.  All rights reserved.
+ * Copyright (c) 2015-2023, NVIDIA Corporation.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -189,12 +189,16 @@ int tegrabl_clib_test_memcpy(size_t maxsize, bool alloc, void *testbuf)
 	return result;
 }
 
+/* fill values, 0 separately as it is the memory clear case */
+static const uint8_t clib_test_memset_ch[] = { 0x5a, 0x00, 0x80 };
+
 int tegrabl_clib_test_memset(size_t maxsize, bool alloc, void *testbuf)
 {
 	uint8_t *buf;
 	size_t len;
-	const uint8_t testch = 0x5a;
+	uint8_t testch;
 	size_t offset;
+	size_t i;
 	int result = 0;
 	size_t offset_limit = (maxsize < 64U) ? maxsize : 64U;
 
@@ -202,29 +206,96 @@ int tegrabl_clib_test_memset(size_t maxsize, bool alloc, void *testbuf)
 
 	tegrabl_printf("%s: (buf: %p, maxsize: 0x%lx)\n", __func__, buf,
 				   (long int)maxsize);
-	for (offset = 0; offset < offset_limit; offset++) {
-		for (len = 0; len <= (maxsize - offset); len++) {
-			/* Initialize the memory with known pattern */
-			_clib_test_bytewise_init(buf, 0xff, 0, maxsize);
-
-			/* call memset */
-			memset(buf + offset, (int32_t)testch, len);
-
-			/* verify entire buffer */
-			if ((_clib_test_bytewise_verify(buf, 0xff,
-					0, offset) != 0) ||
-				(_clib_test_bytewise_verify(buf + offset,
-					testch, 0, len) != 0) ||
-				 (_clib_test_bytewise_verify(buf + offset +
-					len, 0xff, 0, maxsize -
-						offset - len) != 0)) {
-				tegrabl_printf("FAILED: memset(%p, 0x%02x, 0x%lx)\n",
-							   buf + offset, testch, (long int)len);
+	for (i = 0; (i < sizeof(clib_test_memset_ch)) && (result == 0); i++) {
+		testch = clib_test_memset_ch[i];
+		for (offset = 0; offset < offset_limit; offset++) {
+			for (len = 0; len <= (maxsize - offset); len++) {
+				/* Initialize the memory with known pattern */
+				_clib_test_bytewise_init(buf, 0xff, 0, maxsize);
+
+				/* call memset */
+				memset(buf + offset, (int32_t)testch, len);
+
+				/* verify entire buffer */
+				if ((_clib_test_bytewise_verify(buf, 0xff,
+						0, offset) != 0) ||
+					(_clib_test_bytewise_verify(buf + offset,
+						testch, 0, len) != 0) ||
+					 (_clib_test_bytewise_verify(buf + offset +
+						len, 0xff, 0, maxsize -
+							offset - len) != 0)) {
+					tegrabl_printf("FAILED: memset(%p, 0x%02x, 0x%lx)\n",
+								   buf + offset, testch, (long int)len);
+					result = -1;
+					break;
+				}
+			}
+			if (result != 0) {
+				break;
+			}
+			tegrabl_printf("dest=%p, ch=0x%02x : DONE\n", buf + offset,
+						   testch);
+		}
+	}
+
+	if (result == 0) {
+		(void)tegrabl_printf("%s: PASSED\n", __func__);
+	}
+
+	return result;
+}
+
+int tegrabl_clib_test_memmove(size_t maxsize, bool alloc, void *testbuf)
+{
+	uint8_t *buf, *src, *dst;
+	size_t len;
+	size_t gap;
+	size_t gap_limit = (maxsize < 64U) ? maxsize : 64U;
+	int result = 0;
+
+	buf = (alloc) ? tegrabl_malloc(maxsize) : testbuf;
+
+	tegrabl_printf("%s: (buf: %p, maxsize: 0x%lx)\n", __func__, buf,
+				   (long int)maxsize);
+
+	/* dest above and below src, overlapping by all but gap bytes */
+	for (gap = 1; gap < gap_limit; gap++) {
+		for (len = 0; len <= (maxsize - gap); len++) {
+			src = buf;
+			dst = buf + gap;
+
+			_clib_test_bytewise_init(buf, 0xaa, 1, maxsize);
+			memmove(dst, src, len);
+			if ((_clib_test_bytewise_verify(buf, 0xaa, 1, gap) != 0) ||
+				(_clib_test_bytewise_verify(dst, 0xaa, 1, len) != 0) ||
+				(_clib_test_bytewise_verify(dst + len,
+						0xaaU + (uint8_t)(gap + len), 1,
+						maxsize - gap - len) != 0)) {
+				tegrabl_printf("FAILED: memmove(%p, %p, 0x%lx)\n",
+							   dst, src, (long int)len);
 				result = -1;
 				break;
 			}
+
+			src = buf + gap;
+			dst = buf;
+
+			_clib_test_bytewise_init(buf, 0xaa, 1, maxsize);
+			memmove(dst, src, len);
+			if ((_clib_test_bytewise_verify(dst, 0xaaU + (uint8_t)gap, 1,
+											len) != 0) ||
+				(_clib_test_bytewise_verify(dst + len,
+						0xaaU + (uint8_t)len, 1, maxsize - len) != 0)) {
+				tegrabl_printf("FAILED: memmove(%p, %p, 0x%lx)\n",
+							   dst, src, (long int)len);
+				result = -1;
+				break;
+			}
+		}
+		if (result != 0) {
+			break;
 		}
-		tegrabl_printf("dest=%p : DONE\n", buf + offset);
+		tegrabl_printf("gap=0x%lx : DONE\n", (long int)gap);
 	}
 
 	if (result == 0) {
@@ -18,7 +18,10 @@ GLOBAL_INCLUDES += \
 	$(LOCAL_DIR)/../../include/lib
 
 MODULE_SRCS += \
-	$(LOCAL_DIR)/tegrabl_devicetree.c
+	$(LOCAL_DIR)/tegrabl_devicetree.c \
+	$(LOCAL_DIR)/tegrabl_devicetree_index.c \
+	$(LOCAL_DIR)/tegrabl_devicetree_stage.c \
+	$(LOCAL_DIR)/tegrabl_devicetree_stage_test.c
 
 include make/module.mk
 
@@ -159,6 +159,7 @@ tegrabl_error_t tegrabl_dt_set_fdt_handle(tegrabl_dt_type_t type,
 		return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
 	}
 
+	tegrabl_dt_index_invalidate(fdt);
 	fdt_handle_table[type] = fdt;
 	return TEGRABL_NO_ERROR;
 }
@@ -454,7 +455,7 @@ tegrabl_error_t tegrabl_dt_get_node_with_path(const void *fdt, const char *path,
 		return TEGRABL_ERR_INVALID;
 	}
 
-	node_offset = fdt_path_offset(fdt, path);
+	node_offset = tegrabl_dt_path_offset(fdt, path);
 	if (node_offset < 0) {
 		pr_error("Error %d when finding node with path %s\n", node_offset,
 					path);
@@ -553,10 +554,10 @@ int tegrabl_add_subnode_if_absent(void *fdt, int parentnode, char *nodename)
 
 	TEGRABL_ASSERT(fdt);
 
-	node = fdt_subnode_offset(fdt, parentnode, nodename);
+	node = tegrabl_dt_subnode_offset(fdt, parentnode, nodename);
 	if (node < 0) {
 		pr_warn("\"%s\" doesn't exist, creating\n", nodename);
-		node = fdt_add_subnode(fdt, parentnode, nodename);
+		node = tegrabl_dt_add_subnode(fdt, parentnode, nodename);
 		if (node < 0) {
 			pr_error("Creating node \"%s\" failed\n", nodename);
 		}
@@ -0,0 +1,774 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited
+ */
+
+#define MODULE TEGRABL_ERR_DEVICETREE
+
+#include <tegrabl_devicetree.h>
+#include <tegrabl_devicetree_local.h>
+#include <tegrabl_error.h>
+#include <tegrabl_compiler.h>
+#include <tegrabl_debug.h>
+#include <tegrabl_malloc.h>
+#include <libfdt.h>
+#include <string.h>
+
+#if defined(CONFIG_ENABLE_DT_INDEX)
+
+/* Number of device trees indexed at the same time (e.g. kernel and overlay) */
+#define DT_INDEX_SLOTS 2U
+
+/* Deepest node path that can be hashed while building the index */
+#define DT_INDEX_MAX_DEPTH 32
+
+/* Free entries reserved for nodes added after the index is built */
+#define DT_INDEX_HEADROOM 64U
+
+#define DT_INDEX_EMPTY (-1)
+
+#define DT_INDEX_FNV_BASIS 0xcbf29ce484222325ULL
+#define DT_INDEX_FNV_PRIME 0x100000001b3ULL
+
+struct dt_index_path {
+	uint64_t hash;
+	int32_t offset;
+};
+
+struct dt_index_phandle {
+	uint32_t phandle;
+	int32_t offset;
+};
+
+struct dt_index_node {
+	int32_t offset;
+	int32_t parent;
+	uint64_t hash;
+};
+
+/*
+ * Open addressed hash tables mapping full node paths and phandles to
+ * structure block offsets, and offsets back to the node's path hash and
+ * parent. The reverse table lets a hit be checked against every component
+ * of the path. All tables have the same power of two capacity and are kept
+ * at most half full.
+ */
+struct dt_index {
+	const void *fdt;
+	uint32_t struct_size;
+	uint32_t capacity;
+	uint32_t nodes;
+	uint32_t phandles;
+	uint32_t offsets;
+	uint32_t last_use;
+	struct dt_index_path *paths;
+	struct dt_index_phandle *phandle_table;
+	struct dt_index_node *node_table;
+	/* Spare reverse table, rehashed into when node offsets move */
+	struct dt_index_node *node_spare;
+};
+
+static struct dt_index dt_indexes[DT_INDEX_SLOTS];
+static uint32_t dt_index_clock;
+
+static uint64_t dt_index_hash_component(uint64_t hash, const char *name,
+										int len)
+{
+	int i;
+
+	hash = (hash ^ (uint8_t)'/') * DT_INDEX_FNV_PRIME;
+	for (i = 0; i < len; i++) {
+		hash = (hash ^ (uint8_t)name[i]) * DT_INDEX_FNV_PRIME;
+	}
+
+	return hash;
+}
+
+static uint32_t dt_index_slot(uint64_t key, uint32_t capacity)
+{
+	return (uint32_t)(key ^ (key >> 32)) & (capacity - 1U);
+}
+
+static void dt_index_free(struct dt_index *idx)
+{
+	if (idx->paths != NULL) {
+		tegrabl_free(idx->paths);
+	}
+	if (idx->phandle_table != NULL) {
+		tegrabl_free(idx->phandle_table);
+	}
+	if (idx->node_table != NULL) {
+		tegrabl_free(idx->node_table);
+	}
+	if (idx->node_spare != NULL) {
+		tegrabl_free(idx->node_spare);
+	}
+	memset(idx, 0, sizeof(*idx));
+}
+
+static bool dt_index_insert_path(struct dt_index *idx, uint64_t hash,
+								 int offset)
+{
+	uint32_t slot;
+
+	if ((idx->nodes + 1U) > (idx->capacity / 2U)) {
+		return false;
+	}
+
+	slot = dt_index_slot(hash, idx->capacity);
+	while (idx->paths[slot].offset != DT_INDEX_EMPTY) {
+		if (idx->paths[slot].hash == hash) {
+			idx->paths[slot].offset = offset;
+			return true;
+		}
+		slot = (slot + 1U) & (idx->capacity - 1U);
+	}
+
+	idx->paths[slot].hash = hash;
+	idx->paths[slot].offset = offset;
+	idx->nodes++;
+
+	return true;
+}
+
+static bool dt_index_insert_phandle(struct dt_index *idx, uint32_t phandle,
+									int offset)
+{
+	uint32_t slot;
+
+	if ((idx->phandles + 1U) > (idx->capacity / 2U)) {
+		return false;
+	}
+
+	slot = dt_index_slot(phandle, idx->capacity);
+	while (idx->phandle_table[slot].offset != DT_INDEX_EMPTY) {
+		if (idx->phandle_table[slot].phandle == phandle) {
+			idx->phandle_table[slot].offset = offset;
+			return true;
+		}
+		slot = (slot + 1U) & (idx->capacity - 1U);
+	}
+
+	idx->phandle_table[slot].phandle = phandle;
+	idx->phandle_table[slot].offset = offset;
+	idx->phandles++;
+
+	return true;
+}
+
+/* Store @entry in @table, returning true if its offset was not there yet */
+static bool dt_index_put_node(struct dt_index_node *table, uint32_t capacity,
+							  const struct dt_index_node *entry)
+{
+	bool added;
+	uint32_t slot;
+
+	slot = dt_index_slot((uint32_t)entry->offset, capacity);
+	while ((table[slot].offset != DT_INDEX_EMPTY) &&
+		   (table[slot].offset != entry->offset)) {
+		slot = (slot + 1U) & (capacity - 1U);
+	}
+	added = (table[slot].offset == DT_INDEX_EMPTY);
+	table[slot] = *entry;
+
+	return added;
+}
+
+static bool dt_index_insert_node(struct dt_index *idx, int offset, int parent,
+								 uint64_t hash)
+{
+	struct dt_index_node entry;
+
+	if ((idx->offsets + 1U) > (idx->capacity / 2U)) {
+		return false;
+	}
+
+	entry.offset = offset;
+	entry.parent = parent;
+	entry.hash = hash;
+	if (dt_index_put_node(idx->node_table, idx->capacity, &entry)) {
+		idx->offsets++;
+	}
+
+	return true;
+}
+
+static int dt_index_find_path(struct dt_index *idx, uint64_t hash)
+{
+	uint32_t slot;
+
+	slot = dt_index_slot(hash, idx->capacity);
+	while (idx->paths[slot].offset != DT_INDEX_EMPTY) {
+		if (idx->paths[slot].hash == hash) {
+			return idx->paths[slot].offset;
+		}
+		slot = (slot + 1U) & (idx->capacity - 1U);
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+static int dt_index_find_phandle(struct dt_index *idx, uint32_t phandle)
+{
+	uint32_t slot;
+
+	slot = dt_index_slot(phandle, idx->capacity);
+	while (idx->phandle_table[slot].offset != DT_INDEX_EMPTY) {
+		if (idx->phandle_table[slot].phandle == phandle) {
+			return idx->phandle_table[slot].offset;
+		}
+		slot = (slot + 1U) & (idx->capacity - 1U);
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+static struct dt_index_node *dt_index_find_node(struct dt_index *idx,
+												int offset)
+{
+	uint32_t slot;
+
+	slot = dt_index_slot((uint32_t)offset, idx->capacity);
+	while (idx->node_table[slot].offset != DT_INDEX_EMPTY) {
+		if (idx->node_table[slot].offset == offset) {
+			return &idx->node_table[slot];
+		}
+		slot = (slot + 1U) & (idx->capacity - 1U);
+	}
+
+	return NULL;
+}
+
+static tegrabl_error_t dt_index_build(struct dt_index *idx, const void *fdt)
+{
+	uint64_t hash_stack[DT_INDEX_MAX_DEPTH + 1];
+	int parent_stack[DT_INDEX_MAX_DEPTH + 1];
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint32_t count = 0;
+	uint32_t phandle;
+	const char *name;
+	int offset, depth, len;
+	uint32_t i;
+
+	if (fdt_check_header(fdt) != 0) {
+		return TEGRABL_ERR_INVALID;
+	}
+
+	depth = 0;
+	for (offset = 0; (offset >= 0) && (depth >= 0);
+		 offset = fdt_next_node(fdt, offset, &depth)) {
+		if (depth > DT_INDEX_MAX_DEPTH) {
+			pr_debug("DT index: nodes nested deeper than %d\n",
+					 DT_INDEX_MAX_DEPTH);
+			return TEGRABL_ERR_NOT_SUPPORTED;
+		}
+		count++;
+	}
+
+	idx->capacity = 1U;
+	while (idx->capacity < (2U * (count + DT_INDEX_HEADROOM))) {
+		idx->capacity <<= 1;
+	}
+
+	idx->paths = tegrabl_malloc(idx->capacity * sizeof(*idx->paths));
+	idx->phandle_table = tegrabl_malloc(idx->capacity *
+										sizeof(*idx->phandle_table));
+	idx->node_table = tegrabl_malloc(idx->capacity * sizeof(*idx->node_table));
+	idx->node_spare = tegrabl_malloc(idx->capacity * sizeof(*idx->node_spare));
+	if ((idx->paths == NULL) || (idx->phandle_table == NULL) ||
+		(idx->node_table == NULL) || (idx->node_spare == NULL)) {
+		err = TEGRABL_ERR_NO_MEMORY;
+		goto fail;
+	}
+
+	for (i = 0; i < idx->capacity; i++) {
+		idx->paths[i].offset = DT_INDEX_EMPTY;
+		idx->phandle_table[i].offset = DT_INDEX_EMPTY;
+		idx->node_table[i].offset = DT_INDEX_EMPTY;
+	}
+
+	hash_stack[0] = DT_INDEX_FNV_BASIS;
+	parent_stack[0] = DT_INDEX_EMPTY;
+	depth = 0;
+	for (offset = 0; (offset >= 0) && (depth >= 0);
+		 offset = fdt_next_node(fdt, offset, &depth)) {
+		if (depth > 0) {
+			name = fdt_get_name(fdt, offset, &len);
+			if (name == NULL) {
+				err = TEGRABL_ERR_INVALID;
+				goto fail;
+			}
+			hash_stack[depth] = dt_index_hash_component(hash_stack[depth - 1],
+														name, len);
+		}
+		(void)dt_index_insert_path(idx, hash_stack[depth], offset);
+		(void)dt_index_insert_node(idx, offset,
+								   (depth > 0) ? parent_stack[depth - 1] :
+								   DT_INDEX_EMPTY, hash_stack[depth]);
+		parent_stack[depth] = offset;
+
+		phandle = fdt_get_phandle(fdt, offset);
+		if ((phandle != 0U) && (phandle != (uint32_t)-1)) {
+			(void)dt_index_insert_phandle(idx, phandle, offset);
+		}
+	}
+
+	idx->fdt = fdt;
+	idx->struct_size = fdt_size_dt_struct(fdt);
+
+	pr_debug("DT index: %u nodes, %u phandles for fdt %p\n", idx->nodes,
+			 idx->phandles, fdt);
+
+	return TEGRABL_NO_ERROR;
+
+fail:
+	dt_index_free(idx);
+	return err;
+}
+
+/* Return the index of @fdt if one exists and is still in step with it */
+static struct dt_index *dt_index_current(const void *fdt)
+{
+	uint32_t i;
+
+	for (i = 0; i < DT_INDEX_SLOTS; i++) {
+		if (dt_indexes[i].fdt != fdt) {
+			continue;
+		}
+		if (dt_indexes[i].struct_size != fdt_size_dt_struct(fdt)) {
+			/* fdt was changed behind the index's back */
+			dt_index_free(&dt_indexes[i]);
+			return NULL;
+		}
+		dt_indexes[i].last_use = ++dt_index_clock;
+		return &dt_indexes[i];
+	}
+
+	return NULL;
+}
+
+/* Return the index of @fdt, building it in the least recently used slot */
+static struct dt_index *dt_index_get(const void *fdt)
+{
+	struct dt_index *idx;
+	uint32_t i;
+
+	idx = dt_index_current(fdt);
+	if (idx != NULL) {
+		return idx;
+	}
+
+	idx = &dt_indexes[0];
+	for (i = 1; i < DT_INDEX_SLOTS; i++) {
+		if ((dt_indexes[i].fdt == NULL) ||
+			(dt_indexes[i].last_use < idx->last_use)) {
+			idx = &dt_indexes[i];
+		}
+	}
+	dt_index_free(idx);
+
+	if (dt_index_build(idx, fdt) != TEGRABL_NO_ERROR) {
+		return NULL;
+	}
+	idx->last_use = ++dt_index_clock;
+
+	return idx;
+}
+
+/*
+ * Account for a mutation of the structure block inside @node. Everything
+ * stored after @node (its subnodes and all later nodes) moves by the change
+ * in structure block size; @node and the nodes before it stay in place.
+ */
+static void dt_index_moved(struct dt_index *idx, const void *fdt, int node)
+{
+	struct dt_index_node *table;
+	struct dt_index_node entry;
+	int32_t delta;
+	uint32_t i;
+
+	if (idx == NULL) {
+		return;
+	}
+
+	delta = (int32_t)fdt_size_dt_struct(fdt) - (int32_t)idx->struct_size;
+	if (delta != 0) {
+		for (i = 0; i < idx->capacity; i++) {
+			if (idx->paths[i].offset > node) {
+				idx->paths[i].offset += delta;
+			}
+			if (idx->phandle_table[i].offset > node) {
+				idx->phandle_table[i].offset += delta;
+			}
+		}
+
+		/* The reverse table is keyed by offset, so rehash it */
+		table = idx->node_spare;
+		for (i = 0; i < idx->capacity; i++) {
+			table[i].offset = DT_INDEX_EMPTY;
+		}
+		for (i = 0; i < idx->capacity; i++) {
+			entry = idx->node_table[i];
+			if (entry.offset == DT_INDEX_EMPTY) {
+				continue;
+			}
+			if (entry.offset > node) {
+				entry.offset += delta;
+			}
+			if (entry.parent > node) {
+				entry.parent += delta;
+			}
+			(void)dt_index_put_node(table, idx->capacity, &entry);
+		}
+		idx->node_spare = idx->node_table;
+		idx->node_table = table;
+	}
+	idx->struct_size = fdt_size_dt_struct(fdt);
+}
+
+static bool dt_index_is_phandle_prop(const char *name)
+{
+	return (strcmp(name, "phandle") == 0) ||
+		   (strcmp(name, "linux,phandle") == 0);
+}
+
+void tegrabl_dt_index_invalidate(const void *fdt)
+{
+	uint32_t i;
+
+	for (i = 0; i < DT_INDEX_SLOTS; i++) {
+		if ((fdt == NULL) || (dt_indexes[i].fdt == fdt)) {
+			dt_index_free(&dt_indexes[i]);
+		}
+	}
+}
+
+/*
+ * Check that the indexed node at @offset really is @path: walk up through
+ * the recorded parents and compare every component name with the fdt.
+ */
+static bool dt_index_path_matches(struct dt_index *idx, const void *fdt,
+								  int offset, const char * const *comp,
+								  const int *comp_len, int depth)
+{
+	struct dt_index_node *entry;
+	const char *name;
+	int len;
+
+	while (depth > 0) {
+		depth--;
+		entry = dt_index_find_node(idx, offset);
+		name = fdt_get_name(fdt, offset, &len);
+		if ((entry == NULL) || (name == NULL) || (len != comp_len[depth]) ||
+			(memcmp(name, comp[depth], len) != 0)) {
+			return false;
+		}
+		offset = entry->parent;
+	}
+
+	return offset == 0;
+}
+
+static int dt_index_path_offset(const void *fdt, const char *path)
+{
+	struct dt_index *idx;
+	uint64_t hash = DT_INDEX_FNV_BASIS;
+	const char *comp[DT_INDEX_MAX_DEPTH];
+	int comp_len[DT_INDEX_MAX_DEPTH];
+	int depth = 0;
+	int offset;
+	const char *p;
+
+	/* Aliases are resolved by libfdt */
+	if ((path == NULL) || (path[0] != '/')) {
+		return fdt_path_offset(fdt, path);
+	}
+
+	idx = dt_index_get(fdt);
+	if (idx == NULL) {
+		return fdt_path_offset(fdt, path);
+	}
+
+	p = path;
+	while (*p != '\0') {
+		while (*p == '/') {
+			p++;
+		}
+		if (*p == '\0') {
+			break;
+		}
+		if (depth == DT_INDEX_MAX_DEPTH) {
+			return fdt_path_offset(fdt, path);
+		}
+		comp[depth] = p;
+		while ((*p != '/') && (*p != '\0')) {
+			p++;
+		}
+		comp_len[depth] = (int)(p - comp[depth]);
+		hash = dt_index_hash_component(hash, comp[depth], comp_len[depth]);
+		depth++;
+	}
+
+	offset = dt_index_find_path(idx, hash);
+	if (offset < 0) {
+		/* May still match through libfdt's unit-address shorthand */
+		return fdt_path_offset(fdt, path);
+	}
+
+	if (!dt_index_path_matches(idx, fdt, offset, comp, comp_len, depth)) {
+		pr_debug("DT index: stale entry for %s, dropping index\n", path);
+		tegrabl_dt_index_invalidate(fdt);
+		return fdt_path_offset(fdt, path);
+	}
+
+	return offset;
+}
+
+static int dt_index_node_offset_by_phandle(const void *fdt, uint32_t phandle)
+{
+	struct dt_index *idx;
+	int offset;
+
+	if ((phandle == 0U) || (phandle == (uint32_t)-1)) {
+		return -FDT_ERR_BADPHANDLE;
+	}
+
+	idx = dt_index_get(fdt);
+	if (idx == NULL) {
+		return fdt_node_offset_by_phandle(fdt, phandle);
+	}
+
+	offset = dt_index_find_phandle(idx, phandle);
+	if ((offset >= 0) && (fdt_get_phandle(fdt, offset) == phandle)) {
+		return offset;
+	}
+
+	return fdt_node_offset_by_phandle(fdt, phandle);
+}
+
+static void dt_index_node_added(struct dt_index *idx, void *fdt, int parent,
+								const char *name, int node)
+{
+	struct dt_index_node *entry;
+	uint64_t hash;
+
+	if ((node < 0) || (idx == NULL)) {
+		return;
+	}
+
+	entry = dt_index_find_node(idx, parent);
+	if (entry == NULL) {
+		tegrabl_dt_index_invalidate(fdt);
+		return;
+	}
+
+	hash = dt_index_hash_component(entry->hash, name, strlen(name));
+	if (!dt_index_insert_path(idx, hash, node) ||
+		!dt_index_insert_node(idx, node, parent, hash)) {
+		tegrabl_dt_index_invalidate(fdt);
+	}
+}
+
+static void dt_index_prop_set(struct dt_index *idx, void *fdt, int node,
+							  const char *name, const void *val, int len)
+{
+	if ((idx == NULL) || !dt_index_is_phandle_prop(name)) {
+		return;
+	}
+
+	if ((len != (int)sizeof(uint32_t)) ||
+		!dt_index_insert_phandle(idx, fdt32_to_cpu(*(const uint32_t *)val),
+								 node)) {
+		tegrabl_dt_index_invalidate(fdt);
+	}
+}
+
+static void dt_index_prop_changed(struct dt_index *idx, void *fdt,
+								  const char *name)
+{
+	if ((idx != NULL) && dt_index_is_phandle_prop(name)) {
+		tegrabl_dt_index_invalidate(fdt);
+	}
+}
+
+#else
+
+struct dt_index;
+
+static inline struct dt_index *dt_index_current(const void *fdt)
+{
+	TEGRABL_UNUSED(fdt);
+	return NULL;
+}
+
+static inline void dt_index_moved(struct dt_index *idx, const void *fdt,
+								  int node)
+{
+	TEGRABL_UNUSED(idx);
+	TEGRABL_UNUSED(fdt);
+	TEGRABL_UNUSED(node);
+}
+
+static inline void dt_index_node_added(struct dt_index *idx, void *fdt,
+									   int parent, const char *name, int node)
+{
+	TEGRABL_UNUSED(idx);
+	TEGRABL_UNUSED(fdt);
+	TEGRABL_UNUSED(parent);
+	TEGRABL_UNUSED(name);
+	TEGRABL_UNUSED(node);
+}
+
+static inline void dt_index_prop_set(struct dt_index *idx, void *fdt,
+									 int node, const char *name,
+									 const void *val, int len)
+{
+	TEGRABL_UNUSED(idx);
+	TEGRABL_UNUSED(fdt);
+	TEGRABL_UNUSED(node);
+	TEGRABL_UNUSED(name);
+	TEGRABL_UNUSED(val);
+	TEGRABL_UNUSED(len);
+}
+
+static inline void dt_index_prop_changed(struct dt_index *idx, void *fdt,
+										 const char *name)
+{
+	TEGRABL_UNUSED(idx);
+	TEGRABL_UNUSED(fdt);
+	TEGRABL_UNUSED(name);
+}
+
+#define dt_index_path_offset(fdt, path) fdt_path_offset(fdt, path)
+#define dt_index_node_offset_by_phandle(fdt, phandle) \
+	fdt_node_offset_by_phandle(fdt, phandle)
+
+void tegrabl_dt_index_invalidate(const void *fdt)
+{
+	TEGRABL_UNUSED(fdt);
+}
+
+#endif /* CONFIG_ENABLE_DT_INDEX */
+
+int tegrabl_dt_path_offset(const void *fdt, const char *path)
+{
+	if (tegrabl_dt_stage_is_active(fdt)) {
+		return tegrabl_dt_stage_path_offset(fdt, path);
+	}
+
+	return dt_index_path_offset(fdt, path);
+}
+
+int tegrabl_dt_node_offset_by_phandle(const void *fdt, uint32_t phandle)
+{
+	return dt_index_node_offset_by_phandle(fdt, phandle);
+}
+
+int tegrabl_dt_subnode_offset(const void *fdt, int parent, const char *name)
+{
+	if (tegrabl_dt_stage_is_active(fdt)) {
+		return tegrabl_dt_stage_subnode_offset(fdt, parent, name,
+											   strlen(name));
+	}
+
+	return fdt_subnode_offset(fdt, parent, name);
+}
+
+int tegrabl_dt_add_subnode(void *fdt, int parent, const char *name)
+{
+	struct dt_index *idx;
+	int node;
+
+	if (tegrabl_dt_stage_is_active(fdt)) {
+		return tegrabl_dt_stage_add_subnode(fdt, parent, name);
+	}
+
+	idx = dt_index_current(fdt);
+
+	node = fdt_add_subnode(fdt, parent, name);
+	dt_index_moved(idx, fdt, parent);
+	dt_index_node_added(idx, fdt, parent, name, node);
+
+	return node;
+}
+
+int tegrabl_dt_setprop(void *fdt, int node, const char *name,
+					   const void *val, int len)
+{
+	struct dt_index *idx;
+	int ret;
+
+	if (tegrabl_dt_stage_is_active(fdt)) {
+		return tegrabl_dt_stage_setprop(fdt, node, name, val, len, false);
+	}
+
+	idx = dt_index_current(fdt);
+
+	ret = fdt_setprop(fdt, node, name, val, len);
+	dt_index_moved(idx, fdt, node);
+	if (ret == 0) {
+		dt_index_prop_set(idx, fdt, node, name, val, len);
+	}
+
+	return ret;
+}
+
+int tegrabl_dt_appendprop(void *fdt, int node, const char *name,
+						  const void *val, int len)
+{
+	struct dt_index *idx;
+	int ret;
+
+	if (tegrabl_dt_stage_is_active(fdt)) {
+		return tegrabl_dt_stage_setprop(fdt, node, name, val, len, true);
+	}
+
+	idx = dt_index_current(fdt);
+
+	ret = fdt_appendprop(fdt, node, name, val, len);
+	dt_index_moved(idx, fdt, node);
+	if (ret == 0) {
+		dt_index_prop_changed(idx, fdt, name);
+	}
+
+	return ret;
+}
+
+int tegrabl_dt_delprop(void *fdt, int node, const char *name)
+{
+	struct dt_index *idx;
+	int ret;
+
+	if (tegrabl_dt_stage_is_active(fdt)) {
+		return tegrabl_dt_stage_delprop(fdt, node, name);
+	}
+
+	idx = dt_index_current(fdt);
+
+	ret = fdt_delprop(fdt, node, name);
+	dt_index_moved(idx, fdt, node);
+	if (ret == 0) {
+		dt_index_prop_changed(idx, fdt, name);
+	}
+
+	return ret;
+}
+
+int tegrabl_dt_setprop_cell(void *fdt, int node, const char *name,
+							uint32_t val)
+{
+	uint32_t tmp = cpu_to_fdt32(val);
+
+	return tegrabl_dt_setprop(fdt, node, name, &tmp, sizeof(tmp));
+}
+
+int tegrabl_dt_setprop_string(void *fdt, int node, const char *name,
+							  const char *str)
+{
+	return tegrabl_dt_setprop(fdt, node, name, str, strlen(str) + 1);
+}
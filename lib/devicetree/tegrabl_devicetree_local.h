@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited
+ */
+
+#ifndef TEGRABL_DEVICETREE_LOCAL_H
+#define TEGRABL_DEVICETREE_LOCAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <libfdt.h>
+#include <tegrabl_compiler.h>
+
+#if defined(CONFIG_ENABLE_DT_STAGED_FIXUP)
+
+/*
+ * Hooks used by the tegrabl_dt_* lookup and edit wrappers while a staged
+ * fixup is open on a device tree (see tegrabl_dt_stage_begin()).
+ */
+bool tegrabl_dt_stage_is_active(const void *fdt);
+
+int tegrabl_dt_stage_path_offset(const void *fdt, const char *path);
+
+int tegrabl_dt_stage_subnode_offset(const void *fdt, int parent,
+									const char *name, int namelen);
+
+int tegrabl_dt_stage_add_subnode(void *fdt, int parent, const char *name);
+
+int tegrabl_dt_stage_setprop(void *fdt, int node, const char *name,
+							 const void *val, int len, bool append);
+
+int tegrabl_dt_stage_delprop(void *fdt, int node, const char *name);
+
+#else
+
+static inline bool tegrabl_dt_stage_is_active(const void *fdt)
+{
+	TEGRABL_UNUSED(fdt);
+	return false;
+}
+
+#define tegrabl_dt_stage_path_offset(fdt, path) (-FDT_ERR_INTERNAL)
+#define tegrabl_dt_stage_subnode_offset(fdt, parent, name, namelen) \
+	(-FDT_ERR_INTERNAL)
+#define tegrabl_dt_stage_add_subnode(fdt, parent, name) (-FDT_ERR_INTERNAL)
+#define tegrabl_dt_stage_setprop(fdt, node, name, val, len, append) \
+	(-FDT_ERR_INTERNAL)
+#define tegrabl_dt_stage_delprop(fdt, node, name) (-FDT_ERR_INTERNAL)
+
+#endif /* CONFIG_ENABLE_DT_STAGED_FIXUP */
+
+#endif /* TEGRABL_DEVICETREE_LOCAL_H */
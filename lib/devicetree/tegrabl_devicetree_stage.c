@@ -0,0 +1,846 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited
+ */
+
+#define MODULE TEGRABL_ERR_DEVICETREE
+
+#include <tegrabl_devicetree.h>
+#include <tegrabl_devicetree_local.h>
+#include <tegrabl_error.h>
+#include <tegrabl_debug.h>
+#include <tegrabl_malloc.h>
+#include <libfdt.h>
+#include <string.h>
+
+#if defined(CONFIG_ENABLE_DT_STAGED_FIXUP)
+
+/* Handles of staged nodes start above any structure block offset */
+#define DT_STAGE_NODE_BASE 0x40000000
+
+/* Deepest node nesting of the device tree being rebuilt */
+#define DT_STAGE_MAX_DEPTH 64
+
+/* Number of entries by which the staging arrays grow */
+#define DT_STAGE_GROW 16U
+
+#define DT_STAGE_TAGALIGN(x) (((x) + FDT_TAGSIZE - 1U) & ~(FDT_TAGSIZE - 1U))
+#define DT_STAGE_PROP_SIZE(len) \
+	((uint32_t)sizeof(struct fdt_property) + DT_STAGE_TAGALIGN(len))
+#define DT_STAGE_NODE_SIZE(namelen) \
+	((uint32_t)sizeof(struct fdt_node_header) + \
+	 DT_STAGE_TAGALIGN((namelen) + 1U) + FDT_TAGSIZE)
+
+struct dt_stage_node {
+	int parent;
+	char *name;
+	uint32_t namelen;
+};
+
+/*
+ * A property edit. Records with is_new set describe properties that the
+ * tree does not have yet; the others replace or delete the property stored
+ * at prop_offset in the tree.
+ */
+struct dt_stage_prop {
+	int node;
+	int prop_offset;
+	uint32_t nameoff;
+	void *data;
+	uint32_t len;
+	bool is_new;
+	bool deleted;
+};
+
+struct dt_stage {
+	void *fdt;
+	struct dt_stage_node *nodes;
+	uint32_t num_nodes;
+	uint32_t max_nodes;
+	struct dt_stage_prop *props;
+	uint32_t num_props;
+	uint32_t max_props;
+	/* strings to be appended to the strings block */
+	char *strings;
+	uint32_t strings_size;
+	uint32_t strings_max;
+	/* structure block size once the staged edits are applied */
+	uint32_t struct_size;
+};
+
+struct dt_stage_writer {
+	uint8_t *buf;
+	uint32_t pos;
+	uint32_t size;
+};
+
+static struct dt_stage dt_stage;
+
+static void dt_stage_reset(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < dt_stage.num_nodes; i++) {
+		tegrabl_free(dt_stage.nodes[i].name);
+	}
+	for (i = 0; i < dt_stage.num_props; i++) {
+		if (dt_stage.props[i].data != NULL) {
+			tegrabl_free(dt_stage.props[i].data);
+		}
+	}
+	if (dt_stage.nodes != NULL) {
+		tegrabl_free(dt_stage.nodes);
+	}
+	if (dt_stage.props != NULL) {
+		tegrabl_free(dt_stage.props);
+	}
+	if (dt_stage.strings != NULL) {
+		tegrabl_free(dt_stage.strings);
+	}
+	memset(&dt_stage, 0, sizeof(dt_stage));
+}
+
+static bool dt_stage_is_staged_node(int node)
+{
+	return node >= DT_STAGE_NODE_BASE;
+}
+
+static int dt_stage_check_node(int node)
+{
+	if (dt_stage_is_staged_node(node)) {
+		if ((uint32_t)(node - DT_STAGE_NODE_BASE) >= dt_stage.num_nodes) {
+			return -FDT_ERR_BADOFFSET;
+		}
+		return 0;
+	}
+
+	if ((node < 0) || (fdt_get_name(dt_stage.fdt, node, NULL) == NULL)) {
+		return -FDT_ERR_BADOFFSET;
+	}
+
+	return 0;
+}
+
+static const char *dt_stage_string(uint32_t nameoff)
+{
+	uint32_t tree_size = fdt_size_dt_strings(dt_stage.fdt);
+
+	if (nameoff < tree_size) {
+		return fdt_string(dt_stage.fdt, nameoff);
+	}
+
+	return dt_stage.strings + (nameoff - tree_size);
+}
+
+static const char *dt_stage_find_string(const char *strtab, uint32_t size,
+										const char *s, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; (i + len) <= size; i++) {
+		if (memcmp(strtab + i, s, len) == 0) {
+			return strtab + i;
+		}
+	}
+
+	return NULL;
+}
+
+/* Same lookup as libfdt, so that properties get the same name offsets */
+static int dt_stage_find_add_string(const char *name)
+{
+	const char *strtab;
+	uint32_t tree_size;
+	uint32_t len = strlen(name) + 1U;
+	const char *p;
+	char *strings;
+
+	strtab = (const char *)dt_stage.fdt + fdt_off_dt_strings(dt_stage.fdt);
+	tree_size = fdt_size_dt_strings(dt_stage.fdt);
+
+	p = dt_stage_find_string(strtab, tree_size, name, len);
+	if (p != NULL) {
+		return (int)(p - strtab);
+	}
+
+	p = dt_stage_find_string(dt_stage.strings, dt_stage.strings_size, name,
+							 len);
+	if (p != NULL) {
+		return (int)(tree_size + (p - dt_stage.strings));
+	}
+
+	if ((dt_stage.strings_size + len) > dt_stage.strings_max) {
+		strings = tegrabl_realloc(dt_stage.strings,
+								  dt_stage.strings_max + len + 256U);
+		if (strings == NULL) {
+			return -FDT_ERR_NOSPACE;
+		}
+		dt_stage.strings = strings;
+		dt_stage.strings_max += len + 256U;
+	}
+
+	memcpy(dt_stage.strings + dt_stage.strings_size, name, len);
+	dt_stage.strings_size += len;
+
+	return (int)(tree_size + dt_stage.strings_size - len);
+}
+
+static bool dt_stage_name_eq(const char *stored, uint32_t stored_len,
+							 const char *name, uint32_t namelen)
+{
+	if ((stored_len < namelen) || (memcmp(stored, name, namelen) != 0)) {
+		return false;
+	}
+
+	if (stored_len == namelen) {
+		return true;
+	}
+
+	/* unit-address may be left out, as with libfdt */
+	return (stored[namelen] == '@') && (memchr(name, '@', namelen) == NULL);
+}
+
+static struct dt_stage_prop *dt_stage_new_prop(int node)
+{
+	struct dt_stage_prop *props;
+
+	if (dt_stage.num_props == dt_stage.max_props) {
+		props = tegrabl_realloc(dt_stage.props,
+								(dt_stage.max_props + DT_STAGE_GROW) *
+								sizeof(*props));
+		if (props == NULL) {
+			return NULL;
+		}
+		dt_stage.props = props;
+		dt_stage.max_props += DT_STAGE_GROW;
+	}
+
+	props = &dt_stage.props[dt_stage.num_props++];
+	memset(props, 0, sizeof(*props));
+	props->node = node;
+	props->prop_offset = -1;
+
+	return props;
+}
+
+/* Return the staged value of property @name of @node, if any */
+static struct dt_stage_prop *dt_stage_find_prop(int node, const char *name)
+{
+	struct dt_stage_prop *prop;
+	uint32_t i;
+
+	for (i = 0; i < dt_stage.num_props; i++) {
+		prop = &dt_stage.props[i];
+		if ((prop->node == node) && !prop->deleted &&
+			(strcmp(dt_stage_string(prop->nameoff), name) == 0)) {
+			return prop;
+		}
+	}
+
+	return NULL;
+}
+
+/* Return the property @name of @node as stored in the tree, if not edited */
+static const struct fdt_property *dt_stage_tree_prop(int node,
+													 const char *name,
+													 int *len)
+{
+	const struct fdt_property *prop;
+	int prop_offset;
+	uint32_t i;
+
+	if (dt_stage_is_staged_node(node)) {
+		return NULL;
+	}
+
+	prop = fdt_get_property(dt_stage.fdt, node, name, len);
+	if (prop == NULL) {
+		return NULL;
+	}
+
+	prop_offset = (int)((const char *)prop - (const char *)dt_stage.fdt -
+						fdt_off_dt_struct(dt_stage.fdt));
+	for (i = 0; i < dt_stage.num_props; i++) {
+		if (dt_stage.props[i].prop_offset == prop_offset) {
+			return NULL;
+		}
+	}
+
+	return prop;
+}
+
+/*
+ * Set the value of @prop to @head_len bytes of @head followed by @val. A NULL
+ * @head keeps the first @head_len bytes of the current value.
+ */
+static int dt_stage_set_data(struct dt_stage_prop *prop, const void *head,
+							 uint32_t head_len, const void *val, uint32_t len)
+{
+	uint8_t *data;
+
+	data = tegrabl_realloc(prop->data, ((head_len + len) != 0U) ?
+						   (head_len + len) : 1U);
+	if (data == NULL) {
+		return -FDT_ERR_NOSPACE;
+	}
+
+	if ((head != NULL) && (head_len != 0U)) {
+		memcpy(data, head, head_len);
+	}
+	if (len != 0U) {
+		memcpy(data + head_len, val, len);
+	}
+	prop->data = data;
+	prop->len = head_len + len;
+
+	return 0;
+}
+
+bool tegrabl_dt_stage_is_active(const void *fdt)
+{
+	return (fdt != NULL) && (dt_stage.fdt == fdt);
+}
+
+int tegrabl_dt_stage_subnode_offset(const void *fdt, int parent,
+									const char *name, int namelen)
+{
+	struct dt_stage_node *node;
+	uint32_t i;
+	int err;
+
+	TEGRABL_UNUSED(fdt);
+
+	err = dt_stage_check_node(parent);
+	if (err < 0) {
+		return err;
+	}
+
+	/* nodes added later end up first among their siblings */
+	for (i = dt_stage.num_nodes; i > 0U; i--) {
+		node = &dt_stage.nodes[i - 1U];
+		if ((node->parent == parent) &&
+			dt_stage_name_eq(node->name, node->namelen, name, namelen)) {
+			return DT_STAGE_NODE_BASE + (int)(i - 1U);
+		}
+	}
+
+	if (dt_stage_is_staged_node(parent)) {
+		return -FDT_ERR_NOTFOUND;
+	}
+
+	return fdt_subnode_offset_namelen(dt_stage.fdt, parent, name, namelen);
+}
+
+int tegrabl_dt_stage_path_offset(const void *fdt, const char *path)
+{
+	const char *p = path;
+	const char *comp;
+	int node = 0;
+
+	/* aliases only refer to nodes present in the tree */
+	if ((path == NULL) || (path[0] != '/')) {
+		return fdt_path_offset(fdt, path);
+	}
+
+	while (*p != '\0') {
+		while (*p == '/') {
+			p++;
+		}
+		if (*p == '\0') {
+			break;
+		}
+		comp = p;
+		while ((*p != '/') && (*p != '\0')) {
+			p++;
+		}
+		node = tegrabl_dt_stage_subnode_offset(fdt, node, comp,
+											   (int)(p - comp));
+		if (node < 0) {
+			return node;
+		}
+	}
+
+	return node;
+}
+
+int tegrabl_dt_stage_add_subnode(void *fdt, int parent, const char *name)
+{
+	struct dt_stage_node *nodes;
+	uint32_t namelen = strlen(name);
+	int offset;
+
+	offset = tegrabl_dt_stage_subnode_offset(fdt, parent, name, namelen);
+	if (offset >= 0) {
+		return -FDT_ERR_EXISTS;
+	} else if (offset != -FDT_ERR_NOTFOUND) {
+		return offset;
+	}
+
+	if (dt_stage.num_nodes == dt_stage.max_nodes) {
+		nodes = tegrabl_realloc(dt_stage.nodes,
+								(dt_stage.max_nodes + DT_STAGE_GROW) *
+								sizeof(*nodes));
+		if (nodes == NULL) {
+			return -FDT_ERR_NOSPACE;
+		}
+		dt_stage.nodes = nodes;
+		dt_stage.max_nodes += DT_STAGE_GROW;
+	}
+
+	nodes = &dt_stage.nodes[dt_stage.num_nodes];
+	nodes->name = tegrabl_malloc(namelen + 1U);
+	if (nodes->name == NULL) {
+		return -FDT_ERR_NOSPACE;
+	}
+	memcpy(nodes->name, name, namelen + 1U);
+	nodes->namelen = namelen;
+	nodes->parent = parent;
+
+	dt_stage.struct_size += DT_STAGE_NODE_SIZE(namelen);
+
+	return DT_STAGE_NODE_BASE + (int)dt_stage.num_nodes++;
+}
+
+int tegrabl_dt_stage_setprop(void *fdt, int node, const char *name,
+							 const void *val, int len, bool append)
+{
+	const struct fdt_property *tree_prop;
+	struct dt_stage_prop *prop;
+	uint32_t old_len;
+	int tree_len;
+	int ret;
+
+	TEGRABL_UNUSED(fdt);
+
+	ret = dt_stage_check_node(node);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* property edited before, resized in place */
+	prop = dt_stage_find_prop(node, name);
+	if (prop != NULL) {
+		old_len = prop->len;
+		ret = dt_stage_set_data(prop, NULL, append ? old_len : 0U, val, len);
+		if (ret == 0) {
+			dt_stage.struct_size += DT_STAGE_TAGALIGN(prop->len);
+			dt_stage.struct_size -= DT_STAGE_TAGALIGN(old_len);
+		}
+		return ret;
+	}
+
+	/* property of the tree, resized in place */
+	tree_prop = dt_stage_tree_prop(node, name, &tree_len);
+	if (tree_prop != NULL) {
+		prop = dt_stage_new_prop(node);
+		if (prop == NULL) {
+			return -FDT_ERR_NOSPACE;
+		}
+		prop->prop_offset = (int)((const char *)tree_prop -
+								  (const char *)dt_stage.fdt -
+								  fdt_off_dt_struct(dt_stage.fdt));
+		prop->nameoff = fdt32_to_cpu(tree_prop->nameoff);
+		ret = dt_stage_set_data(prop, tree_prop->data,
+								append ? (uint32_t)tree_len : 0U, val, len);
+		if (ret < 0) {
+			dt_stage.num_props--;
+			return ret;
+		}
+		dt_stage.struct_size += DT_STAGE_TAGALIGN(prop->len);
+		dt_stage.struct_size -= DT_STAGE_TAGALIGN((uint32_t)tree_len);
+		return 0;
+	}
+
+	/* new property, placed first in the node */
+	ret = dt_stage_find_add_string(name);
+	if (ret < 0) {
+		return ret;
+	}
+
+	prop = dt_stage_new_prop(node);
+	if (prop == NULL) {
+		return -FDT_ERR_NOSPACE;
+	}
+	prop->nameoff = (uint32_t)ret;
+	prop->is_new = true;
+
+	ret = dt_stage_set_data(prop, NULL, 0U, val, len);
+	if (ret < 0) {
+		dt_stage.num_props--;
+		return ret;
+	}
+	dt_stage.struct_size += DT_STAGE_PROP_SIZE(prop->len);
+
+	return 0;
+}
+
+int tegrabl_dt_stage_delprop(void *fdt, int node, const char *name)
+{
+	const struct fdt_property *tree_prop;
+	struct dt_stage_prop *prop;
+	int tree_len;
+	int ret;
+
+	TEGRABL_UNUSED(fdt);
+
+	ret = dt_stage_check_node(node);
+	if (ret < 0) {
+		return ret;
+	}
+
+	prop = dt_stage_find_prop(node, name);
+	if (prop != NULL) {
+		dt_stage.struct_size -= DT_STAGE_PROP_SIZE(prop->len);
+		tegrabl_free(prop->data);
+		prop->data = NULL;
+		prop->len = 0;
+		prop->deleted = true;
+		return 0;
+	}
+
+	tree_prop = dt_stage_tree_prop(node, name, &tree_len);
+	if (tree_prop == NULL) {
+		return -FDT_ERR_NOTFOUND;
+	}
+
+	prop = dt_stage_new_prop(node);
+	if (prop == NULL) {
+		return -FDT_ERR_NOSPACE;
+	}
+	prop->prop_offset = (int)((const char *)tree_prop -
+							  (const char *)dt_stage.fdt -
+							  fdt_off_dt_struct(dt_stage.fdt));
+	prop->nameoff = fdt32_to_cpu(tree_prop->nameoff);
+	prop->deleted = true;
+	dt_stage.struct_size -= DT_STAGE_PROP_SIZE((uint32_t)tree_len);
+
+	return 0;
+}
+
+static bool dt_stage_put(struct dt_stage_writer *w, const void *data,
+						 uint32_t len, uint32_t padded_len)
+{
+	if ((w->pos + padded_len) > w->size) {
+		return false;
+	}
+
+	memcpy(w->buf + w->pos, data, len);
+	memset(w->buf + w->pos + len, 0, padded_len - len);
+	w->pos += padded_len;
+
+	return true;
+}
+
+static bool dt_stage_put_tag(struct dt_stage_writer *w, uint32_t tag)
+{
+	uint32_t val = cpu_to_fdt32(tag);
+
+	return dt_stage_put(w, &val, sizeof(val), sizeof(val));
+}
+
+static bool dt_stage_put_prop(struct dt_stage_writer *w,
+							  struct dt_stage_prop *prop)
+{
+	uint32_t hdr[3];
+
+	hdr[0] = cpu_to_fdt32(FDT_PROP);
+	hdr[1] = cpu_to_fdt32(prop->len);
+	hdr[2] = cpu_to_fdt32(prop->nameoff);
+
+	return dt_stage_put(w, hdr, sizeof(hdr), sizeof(hdr)) &&
+		   dt_stage_put(w, prop->data, prop->len,
+						DT_STAGE_TAGALIGN(prop->len));
+}
+
+/* New properties go first in a node, the most recent one leading */
+static bool dt_stage_put_new_props(struct dt_stage_writer *w, int node)
+{
+	struct dt_stage_prop *prop;
+	uint32_t i;
+
+	for (i = dt_stage.num_props; i > 0U; i--) {
+		prop = &dt_stage.props[i - 1U];
+		if ((prop->node == node) && prop->is_new && !prop->deleted) {
+			if (!dt_stage_put_prop(w, prop)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/* New subnodes go right after the properties, the most recent one leading */
+static bool dt_stage_put_new_subnodes(struct dt_stage_writer *w, int parent)
+{
+	struct dt_stage_node *node;
+	uint32_t i;
+	int handle;
+
+	for (i = dt_stage.num_nodes; i > 0U; i--) {
+		node = &dt_stage.nodes[i - 1U];
+		if (node->parent != parent) {
+			continue;
+		}
+		handle = DT_STAGE_NODE_BASE + (int)(i - 1U);
+		if (!dt_stage_put_tag(w, FDT_BEGIN_NODE) ||
+			!dt_stage_put(w, node->name, node->namelen + 1U,
+						  DT_STAGE_TAGALIGN(node->namelen + 1U)) ||
+			!dt_stage_put_new_props(w, handle) ||
+			!dt_stage_put_new_subnodes(w, handle) ||
+			!dt_stage_put_tag(w, FDT_END_NODE)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool dt_stage_node_is_dirty(int node)
+{
+	uint32_t i;
+
+	for (i = 0; i < dt_stage.num_props; i++) {
+		if (dt_stage.props[i].node == node) {
+			return true;
+		}
+	}
+	for (i = 0; i < dt_stage.num_nodes; i++) {
+		if (dt_stage.nodes[i].parent == node) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static struct dt_stage_prop *dt_stage_prop_at(int prop_offset)
+{
+	uint32_t i;
+
+	for (i = 0; i < dt_stage.num_props; i++) {
+		if (dt_stage.props[i].prop_offset == prop_offset) {
+			return &dt_stage.props[i];
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Write the structure block with all staged edits applied, in one walk over
+ * the tree. The layout is the one the same edits made through libfdt would
+ * have produced.
+ */
+static tegrabl_error_t dt_stage_build_struct(struct dt_stage_writer *w)
+{
+	struct {
+		int node;
+		bool dirty;
+		bool children_done;
+	} stack[DT_STAGE_MAX_DEPTH];
+	const uint8_t *tree;
+	struct dt_stage_prop *prop;
+	int depth = -1;
+	int offset = 0;
+	int next;
+	uint32_t tag;
+
+	tree = (const uint8_t *)dt_stage.fdt + fdt_off_dt_struct(dt_stage.fdt);
+
+	do {
+		tag = fdt_next_tag(dt_stage.fdt, offset, &next);
+		if (next < 0) {
+			return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+		}
+
+		if ((depth >= 0) && !stack[depth].children_done &&
+			((tag == FDT_BEGIN_NODE) || (tag == FDT_END_NODE))) {
+			stack[depth].children_done = true;
+			if (stack[depth].dirty &&
+				!dt_stage_put_new_subnodes(w, stack[depth].node)) {
+				return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 0);
+			}
+		}
+
+		prop = NULL;
+		if ((tag == FDT_PROP) && (depth >= 0) && stack[depth].dirty) {
+			prop = dt_stage_prop_at(offset);
+		}
+
+		if (prop != NULL) {
+			if (!prop->deleted && !dt_stage_put_prop(w, prop)) {
+				return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 1);
+			}
+		} else if (!dt_stage_put(w, tree + offset, next - offset,
+								 next - offset)) {
+			return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 2);
+		}
+
+		if (tag == FDT_BEGIN_NODE) {
+			if (++depth >= DT_STAGE_MAX_DEPTH) {
+				return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+			}
+			stack[depth].node = offset;
+			stack[depth].dirty = dt_stage_node_is_dirty(offset);
+			stack[depth].children_done = false;
+			if (stack[depth].dirty && !dt_stage_put_new_props(w, offset)) {
+				return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 3);
+			}
+		} else if (tag == FDT_END_NODE) {
+			depth--;
+		}
+
+		offset = next;
+	} while (tag != FDT_END);
+
+	/* anything trailing the END tag is kept as is */
+	if ((uint32_t)offset < fdt_size_dt_struct(dt_stage.fdt)) {
+		if (!dt_stage_put(w, tree + offset,
+						  fdt_size_dt_struct(dt_stage.fdt) - offset,
+						  fdt_size_dt_struct(dt_stage.fdt) - offset)) {
+			return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 4);
+		}
+	}
+
+	if (w->pos != w->size) {
+		pr_error("DT stage: built %u bytes of structure, expected %u\n",
+				 w->pos, w->size);
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID_STATE, 0);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t tegrabl_dt_stage_begin(void *fdt)
+{
+	if (fdt == NULL) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+	}
+
+	if (dt_stage.fdt != NULL) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BUSY, 0);
+	}
+
+	/* same layout requirements as libfdt's read-write functions */
+	if ((fdt_check_header(fdt) != 0) || (fdt_version(fdt) < 17) ||
+		(fdt_off_dt_strings(fdt) <
+		 (fdt_off_dt_struct(fdt) + fdt_size_dt_struct(fdt))) ||
+		(fdt_totalsize(fdt) <
+		 (fdt_off_dt_strings(fdt) + fdt_size_dt_strings(fdt)))) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
+	}
+
+	memset(&dt_stage, 0, sizeof(dt_stage));
+	dt_stage.fdt = fdt;
+	dt_stage.struct_size = fdt_size_dt_struct(fdt);
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t tegrabl_dt_stage_commit(void *fdt)
+{
+	struct dt_stage_writer w = { NULL, 0, 0 };
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint32_t off_struct, old_struct_size, gap;
+	uint32_t strings_off, strings_size;
+
+	if (!tegrabl_dt_stage_is_active(fdt)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID_STATE, 1);
+	}
+
+	if ((dt_stage.num_nodes == 0U) && (dt_stage.num_props == 0U)) {
+		goto done;
+	}
+
+	off_struct = fdt_off_dt_struct(fdt);
+	old_struct_size = fdt_size_dt_struct(fdt);
+	gap = fdt_off_dt_strings(fdt) - (off_struct + old_struct_size);
+	strings_size = fdt_size_dt_strings(fdt);
+	strings_off = off_struct + dt_stage.struct_size + gap;
+
+	if ((strings_off + strings_size + dt_stage.strings_size) >
+		fdt_totalsize(fdt)) {
+		pr_error("DT stage: %u bytes of fixups do not fit in DTB\n",
+				 strings_off + strings_size + dt_stage.strings_size -
+				 fdt_totalsize(fdt));
+		err = TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 5);
+		goto done;
+	}
+
+	w.size = dt_stage.struct_size;
+	w.buf = tegrabl_malloc(w.size);
+	if (w.buf == NULL) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+		goto done;
+	}
+
+	err = dt_stage_build_struct(&w);
+	if (err != TEGRABL_NO_ERROR) {
+		goto done;
+	}
+
+	/* move the strings block with whatever preceded it, then fill in */
+	memmove((uint8_t *)fdt + off_struct + dt_stage.struct_size,
+			(uint8_t *)fdt + off_struct + old_struct_size,
+			gap + strings_size);
+	if (dt_stage.strings_size != 0U) {
+		memcpy((uint8_t *)fdt + strings_off + strings_size, dt_stage.strings,
+			   dt_stage.strings_size);
+	}
+	memcpy((uint8_t *)fdt + off_struct, w.buf, w.size);
+
+	fdt_set_size_dt_struct(fdt, dt_stage.struct_size);
+	fdt_set_off_dt_strings(fdt, strings_off);
+	fdt_set_size_dt_strings(fdt, strings_size + dt_stage.strings_size);
+	if (fdt_version(fdt) > 17) {
+		fdt_set_version(fdt, 17);
+	}
+
+	pr_debug("DT stage: applied %u node and %u property edits\n",
+			 dt_stage.num_nodes, dt_stage.num_props);
+
+done:
+	if (w.buf != NULL) {
+		tegrabl_free(w.buf);
+	}
+	dt_stage_reset();
+	tegrabl_dt_index_invalidate(fdt);
+
+	return err;
+}
+
+void tegrabl_dt_stage_discard(void *fdt)
+{
+	if (tegrabl_dt_stage_is_active(fdt)) {
+		pr_debug("DT stage: dropped %u node and %u property edits\n",
+				 dt_stage.num_nodes, dt_stage.num_props);
+		dt_stage_reset();
+	}
+}
+
+#else
+
+tegrabl_error_t tegrabl_dt_stage_begin(void *fdt)
+{
+	TEGRABL_UNUSED(fdt);
+	return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+}
+
+tegrabl_error_t tegrabl_dt_stage_commit(void *fdt)
+{
+	TEGRABL_UNUSED(fdt);
+	return TEGRABL_NO_ERROR;
+}
+
+void tegrabl_dt_stage_discard(void *fdt)
+{
+	TEGRABL_UNUSED(fdt);
+}
+
+#endif /* CONFIG_ENABLE_DT_STAGED_FIXUP */
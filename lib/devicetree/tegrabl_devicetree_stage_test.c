@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited
+ */
+
+#define MODULE TEGRABL_ERR_DEVICETREE
+
+#include <tegrabl_devicetree.h>
+#include <tegrabl_error.h>
+#include <tegrabl_debug.h>
+#include <tegrabl_malloc.h>
+#include <tegrabl_utils.h>
+#include <libfdt.h>
+#include <string.h>
+
+#if defined(CONFIG_ENABLE_DT_STAGED_FIXUP)
+
+#define DT_STAGE_TEST_SIZE 4096U
+
+enum dt_stage_test_op {
+	DT_STAGE_TEST_ADD_NODE,
+	DT_STAGE_TEST_SETPROP,
+	DT_STAGE_TEST_APPENDPROP,
+	DT_STAGE_TEST_DELPROP,
+};
+
+struct dt_stage_test_edit {
+	enum dt_stage_test_op op;
+	const char *path;
+	const char *name;
+	const char *val;
+};
+
+/* Mix of edits to existing and added nodes, in the order dtb_update does */
+static const struct dt_stage_test_edit dt_stage_test_edits[] = {
+	{ DT_STAGE_TEST_SETPROP, "/", "serial-number", "0123456789" },
+	{ DT_STAGE_TEST_SETPROP, "/chosen", "bootargs", "console=ttyS0,115200n8" },
+	{ DT_STAGE_TEST_ADD_NODE, "/", "reserved-memory", NULL },
+	{ DT_STAGE_TEST_SETPROP, "/reserved-memory", "ranges", "" },
+	{ DT_STAGE_TEST_ADD_NODE, "/reserved-memory", "carveout", NULL },
+	{ DT_STAGE_TEST_SETPROP, "/reserved-memory/carveout", "status", "okay" },
+	{ DT_STAGE_TEST_APPENDPROP, "/chosen", "bootargs", " quiet" },
+	{ DT_STAGE_TEST_SETPROP, "/memory", "device_type", "memory" },
+	{ DT_STAGE_TEST_DELPROP, "/memory", "reg", NULL },
+	{ DT_STAGE_TEST_SETPROP, "/chosen", "bootargs", "root=/dev/mmcblk0p1" },
+	{ DT_STAGE_TEST_ADD_NODE, "/chosen", "plugin-manager", NULL },
+	{ DT_STAGE_TEST_SETPROP, "/reserved-memory/carveout", "status", "ok" },
+	{ DT_STAGE_TEST_DELPROP, "/chosen", "stdout-path", NULL },
+};
+
+static int dt_stage_test_build(void *fdt)
+{
+	static const uint32_t reg[4] = { 0, 0x80000000U, 0, 0x40000000U };
+	int err;
+
+	err = fdt_create(fdt, DT_STAGE_TEST_SIZE);
+	err = (err == 0) ? fdt_finish_reservemap(fdt) : err;
+	err = (err == 0) ? fdt_begin_node(fdt, "") : err;
+	err = (err == 0) ? fdt_property_string(fdt, "model", "stage test") : err;
+	err = (err == 0) ? fdt_begin_node(fdt, "chosen") : err;
+	err = (err == 0) ? fdt_property_string(fdt, "stdout-path", "serial0") :
+		  err;
+	err = (err == 0) ? fdt_end_node(fdt) : err;
+	err = (err == 0) ? fdt_begin_node(fdt, "memory") : err;
+	err = (err == 0) ? fdt_property(fdt, "reg", reg, sizeof(reg)) : err;
+	err = (err == 0) ? fdt_end_node(fdt) : err;
+	err = (err == 0) ? fdt_end_node(fdt) : err;
+	err = (err == 0) ? fdt_finish(fdt) : err;
+	err = (err == 0) ? fdt_open_into(fdt, fdt, DT_STAGE_TEST_SIZE) : err;
+
+	return err;
+}
+
+/* Apply the edit list through libfdt directly or through the wrappers */
+static int dt_stage_test_apply(void *fdt, bool wrappers)
+{
+	const struct dt_stage_test_edit *e;
+	int val_len;
+	uint32_t i;
+	int node;
+	int err = 0;
+
+	for (i = 0; i < ARRAY_SIZE(dt_stage_test_edits); i++) {
+		e = &dt_stage_test_edits[i];
+		val_len = (e->val != NULL) ? ((int)strlen(e->val) + 1) : 0;
+		node = wrappers ? tegrabl_dt_path_offset(fdt, e->path) :
+			   fdt_path_offset(fdt, e->path);
+		if (node < 0) {
+			return node;
+		}
+
+		switch (e->op) {
+		case DT_STAGE_TEST_ADD_NODE:
+			err = wrappers ? tegrabl_dt_add_subnode(fdt, node, e->name) :
+				  fdt_add_subnode(fdt, node, e->name);
+			break;
+		case DT_STAGE_TEST_SETPROP:
+			err = wrappers ?
+				  tegrabl_dt_setprop(fdt, node, e->name, e->val, val_len) :
+				  fdt_setprop(fdt, node, e->name, e->val, val_len);
+			break;
+		case DT_STAGE_TEST_APPENDPROP:
+			err = wrappers ?
+				  tegrabl_dt_appendprop(fdt, node, e->name, e->val, val_len) :
+				  fdt_appendprop(fdt, node, e->name, e->val, val_len);
+			break;
+		case DT_STAGE_TEST_DELPROP:
+			err = wrappers ? tegrabl_dt_delprop(fdt, node, e->name) :
+				  fdt_delprop(fdt, node, e->name);
+			break;
+		default:
+			err = -FDT_ERR_INTERNAL;
+			break;
+		}
+		if (err < 0) {
+			pr_error("DT stage test: edit %u failed (%s)\n", i,
+					 fdt_strerror(err));
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * libfdt leaves whatever was there in the padding that aligns node names and
+ * property values, while the staged rebuild writes zeroes. Clear it so the
+ * two can be compared byte for byte.
+ */
+static void dt_stage_test_clear_padding(void *fdt)
+{
+	uint8_t *tree = (uint8_t *)fdt + fdt_off_dt_struct(fdt);
+	const struct fdt_property *prop;
+	uint32_t tag;
+	int offset = 0;
+	int next = 0;
+	int end;
+
+	do {
+		tag = fdt_next_tag(fdt, offset, &next);
+		end = next;
+		if (tag == FDT_BEGIN_NODE) {
+			end = offset + FDT_TAGSIZE +
+				  (int)strlen((const char *)tree + offset + FDT_TAGSIZE) + 1;
+		} else if (tag == FDT_PROP) {
+			prop = fdt_offset_ptr(fdt, offset, sizeof(*prop));
+			end = offset + (int)sizeof(*prop) + (int)fdt32_to_cpu(prop->len);
+		}
+		if ((next > end) && (end > offset)) {
+			memset(tree + end, 0, next - end);
+		}
+		offset = next;
+	} while ((tag != FDT_END) && (next > 0));
+}
+
+/* Bytes of @fdt that carry the tree, leaving out the free space at the end */
+static uint32_t dt_stage_test_used(const void *fdt)
+{
+	return fdt_off_dt_strings(fdt) + fdt_size_dt_strings(fdt);
+}
+
+tegrabl_error_t tegrabl_dt_stage_test(void)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint8_t *orig = NULL;
+	uint8_t *direct = NULL;
+	uint8_t *staged = NULL;
+
+	orig = tegrabl_malloc(DT_STAGE_TEST_SIZE);
+	direct = tegrabl_malloc(DT_STAGE_TEST_SIZE);
+	staged = tegrabl_malloc(DT_STAGE_TEST_SIZE);
+	if ((orig == NULL) || (direct == NULL) || (staged == NULL)) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+		goto fail;
+	}
+
+	memset(orig, 0, DT_STAGE_TEST_SIZE);
+	if (dt_stage_test_build(orig) != 0) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+		goto fail;
+	}
+
+	/* reference: one libfdt edit at a time */
+	memcpy(direct, orig, DT_STAGE_TEST_SIZE);
+	if (dt_stage_test_apply(direct, false) != 0) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
+		goto fail;
+	}
+
+	/* staged edits must produce the same bytes */
+	memcpy(staged, orig, DT_STAGE_TEST_SIZE);
+	err = tegrabl_dt_stage_begin(staged);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	if (dt_stage_test_apply(staged, true) != 0) {
+		tegrabl_dt_stage_discard(staged);
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 2);
+		goto fail;
+	}
+	err = tegrabl_dt_stage_commit(staged);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	dt_stage_test_clear_padding(direct);
+	dt_stage_test_clear_padding(staged);
+	if ((dt_stage_test_used(staged) != dt_stage_test_used(direct)) ||
+		(memcmp(staged, direct, dt_stage_test_used(direct)) != 0)) {
+		pr_error("DT stage test: staged DTB differs from libfdt edits\n");
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 3);
+		goto fail;
+	}
+
+	/* discarded edits must leave the DTB untouched */
+	memcpy(staged, orig, DT_STAGE_TEST_SIZE);
+	err = tegrabl_dt_stage_begin(staged);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	if (dt_stage_test_apply(staged, true) != 0) {
+		tegrabl_dt_stage_discard(staged);
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 4);
+		goto fail;
+	}
+	tegrabl_dt_stage_discard(staged);
+	if (memcmp(staged, orig, DT_STAGE_TEST_SIZE) != 0) {
+		pr_error("DT stage test: discarded edits changed the DTB\n");
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 5);
+		goto fail;
+	}
+
+	pr_info("DT stage test: passed\n");
+
+fail:
+	if (orig != NULL) {
+		tegrabl_free(orig);
+	}
+	if (direct != NULL) {
+		tegrabl_free(direct);
+	}
+	if (staged != NULL) {
+		tegrabl_free(staged);
+	}
+
+	return err;
+}
+
+#endif /* CONFIG_ENABLE_DT_STAGED_FIXUP */
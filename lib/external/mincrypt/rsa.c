@@ -1,6 +1,6 @@
 /* rsa.c
 **
-** Copyright (c) 2015-2016, NVIDIA Corporation.  All Rights Reserved.
+** Copyright (c) 2015-2023, NVIDIA Corporation.  All Rights Reserved.
 **
 ** NVIDIA Corporation and its licensors retain all intellectual property and
 ** proprietary rights in and to this software and related documentation.  Any
@@ -37,23 +37,80 @@
 #include <lib/mincrypt/sha.h>
 #include <lib/mincrypt/sha256.h>
 
+#if defined(__SIZEOF_INT128__) && !defined(CONFIG_ENABLE_MINCRYPT_32BIT_LIMBS)
+/* 64-bit limbs: on AArch64 the double-width products below compile to
+ * MUL/UMULH pairs and the sums to ADDS/ADC chains, which halves the number of
+ * limb operations of the 32-bit version. Only multiplications and shifts are
+ * done on rsa_dlimb_t, so no libgcc helper is needed.
+ * CONFIG_ENABLE_MINCRYPT_32BIT_LIMBS selects the 32-bit limbs instead.*/
+typedef uint64_t rsa_limb_t;
+typedef unsigned __int128 rsa_dlimb_t;
+#else
+typedef uint32_t rsa_limb_t;
+typedef uint64_t rsa_dlimb_t;
+#endif
+
+#define RSA_LIMB_BITS (sizeof(rsa_limb_t) * 8)
+#define RSANUMLIMBS (RSANUMBYTES / sizeof(rsa_limb_t))
+#define RSA_WORDS_PER_LIMB (sizeof(rsa_limb_t) / sizeof(uint32_t))
+
+/* Public key converted to the limb size of this build.*/
+/* R = 2^(32 * RSANUMWORDS) does not depend on the limb size, so rr is reused.*/
+struct mont_key {
+	rsa_limb_t n0inv;	/* -1 / n[0] mod 2^RSA_LIMB_BITS */
+	rsa_limb_t n[RSANUMLIMBS];
+	rsa_limb_t rr[RSANUMLIMBS];
+};
+
+/* Gather little endian 32-bit words into a little endian limb array.*/
+static void words_to_limbs(rsa_limb_t *limbs, const uint32_t *words)
+{
+	int i, j;
+	for (i = 0; i < (int)RSANUMLIMBS; ++i) {
+		rsa_limb_t limb = 0;
+		for (j = RSA_WORDS_PER_LIMB; j;) {
+			--j;
+			limb = (rsa_limb_t)(((rsa_dlimb_t)limb << 32) |
+					    words[(i * RSA_WORDS_PER_LIMB) + j]);
+		}
+		limbs[i] = limb;
+	}
+}
+
+static void load_key(const struct rsa_public_key *key, struct mont_key *mkey)
+{
+	rsa_limb_t inv;
+	int i;
+
+	words_to_limbs(mkey->n, key->n);
+	words_to_limbs(mkey->rr, key->rr);
+
+	/* Newton iteration, n[0] is its own inverse modulo 8 as it is odd.*/
+	inv = mkey->n[0];
+	for (i = 0; i < 5; ++i)
+		inv *= 2 - (mkey->n[0] * inv);
+	mkey->n0inv = -inv;
+}
+
 /* a[] -= mod*/
-static void sub_m(const struct rsa_public_key *key, uint32_t *a)
+static void sub_m(const struct mont_key *key, rsa_limb_t *a)
 {
-	int64_t A = 0;
+	rsa_limb_t borrow = 0;
+	rsa_limb_t t, b;
 	int i;
-	for (i = 0; i < key->len; ++i) {
-		A += (uint64_t) a[i] - key->n[i];
-		a[i] = (uint32_t) A;
-		A >>= 32;
+	for (i = 0; i < (int)RSANUMLIMBS; ++i) {
+		t = a[i] - key->n[i];
+		b = (a[i] < key->n[i]) | (t < borrow);
+		a[i] = t - borrow;
+		borrow = b;
 	}
 }
 
 /* return a[] >= mod*/
-static int ge_m(const struct rsa_public_key *key, const uint32_t *a)
+static int ge_m(const struct mont_key *key, const rsa_limb_t *a)
 {
 	int i;
-	for (i = key->len; i;) {
+	for (i = RSANUMLIMBS; i;) {
 		--i;
 		if (a[i] < key->n[i])
 			return 0;
@@ -65,36 +122,37 @@ static int ge_m(const struct rsa_public_key *key, const uint32_t *a)
 }
 
 /* montgomery c[] += a * b[] / R % mod*/
-static void mont_mul_add(const struct rsa_public_key *key,
-		       uint32_t *c, const uint32_t a, const uint32_t *b)
+static void mont_mul_add(const struct mont_key *key,
+		       rsa_limb_t *c, const rsa_limb_t a, const rsa_limb_t *b)
 {
-	uint64_t A = (uint64_t)a * b[0] + c[0];
-	uint32_t d0 = (uint32_t)A * key->n0inv;
-	uint64_t B = (uint64_t)d0 * key->n[0] + (uint32_t)A;
+	rsa_dlimb_t A = (rsa_dlimb_t)a * b[0] + c[0];
+	rsa_limb_t d0 = (rsa_limb_t)A * key->n0inv;
+	rsa_dlimb_t B = (rsa_dlimb_t)d0 * key->n[0] + (rsa_limb_t)A;
 	int i;
 
-	for (i = 1; i < key->len; ++i) {
-		A = (A >> 32) + (uint64_t)a * b[i] + c[i];
-		B = (B >> 32) + (uint64_t)d0 * key->n[i] + (uint32_t)A;
-		c[i - 1] = (uint32_t) B;
+	for (i = 1; i < (int)RSANUMLIMBS; ++i) {
+		A = (A >> RSA_LIMB_BITS) + (rsa_dlimb_t)a * b[i] + c[i];
+		B = (B >> RSA_LIMB_BITS) + (rsa_dlimb_t)d0 * key->n[i] +
+		    (rsa_limb_t)A;
+		c[i - 1] = (rsa_limb_t) B;
 	}
 
-	A = (A >> 32) + (B >> 32);
+	A = (A >> RSA_LIMB_BITS) + (B >> RSA_LIMB_BITS);
 
-	c[i - 1] = (uint32_t) A;
+	c[i - 1] = (rsa_limb_t) A;
 
-	if (A >> 32)
+	if (A >> RSA_LIMB_BITS)
 		sub_m(key, c);
 }
 
 /* montgomery c[] = a[] * b[] / R % mod*/
-static void mont_mul(const struct rsa_public_key *key,
-		    uint32_t *c, const uint32_t *a, const uint32_t *b)
+static void mont_mul(const struct mont_key *key,
+		    rsa_limb_t *c, const rsa_limb_t *a, const rsa_limb_t *b)
 {
 	int i;
-	for (i = 0; i < key->len; ++i)
+	for (i = 0; i < (int)RSANUMLIMBS; ++i)
 		c[i] = 0;
-	for (i = 0; i < key->len; ++i)
+	for (i = 0; i < (int)RSANUMLIMBS; ++i)
 		mont_mul_add(key, c, a[i], b);
 }
 
@@ -102,50 +160,50 @@ static void mont_mul(const struct rsa_public_key *key,
 /* Input and output big-endian byte array in inout.*/
 static void modpow(const struct rsa_public_key *key, uint8_t *inout)
 {
-	uint32_t a[RSANUMWORDS];
-	uint32_t a_r[RSANUMWORDS];
-	uint32_t aa_r[RSANUMWORDS];
-	uint32_t *aaa = 0;
-	int i;
+	struct mont_key mkey;
+	rsa_limb_t a[RSANUMLIMBS];
+	rsa_limb_t a_r[RSANUMLIMBS];
+	rsa_limb_t aa_r[RSANUMLIMBS];
+	rsa_limb_t *aaa = 0;
+	int i, j;
 
 	if (key->exponent != 3 && key->exponent != 65537)
 		return;
 
-	/* Convert from big endian byte array to little endian word array.*/
-	for (i = 0; i < key->len; ++i) {
-		uint32_t tmp =
-		    (inout[((key->len - 1 - i) * 4) + 0] << 24) |
-		    (inout[((key->len - 1 - i) * 4) + 1] << 16) |
-		    (inout[((key->len - 1 - i) * 4) + 2] << 8) |
-		    (inout[((key->len - 1 - i) * 4) + 3] << 0);
+	load_key(key, &mkey);
+
+	/* Convert from big endian byte array to little endian limb array.*/
+	for (i = 0; i < (int)RSANUMLIMBS; ++i) {
+		const uint8_t *p = inout + ((RSANUMLIMBS - 1 - i) * sizeof(rsa_limb_t));
+		rsa_limb_t tmp = 0;
+		for (j = 0; j < (int)sizeof(rsa_limb_t); ++j)
+			tmp = (tmp << 8) | p[j];
 		a[i] = tmp;
 	}
 
 	if (key->exponent == 65537) {
 		aaa = aa_r;	/* Re-use location.*/
-		mont_mul(key, a_r, a, key->rr);	/* a_r = a * RR / R mod M*/
+		mont_mul(&mkey, a_r, a, mkey.rr);	/* a_r = a * RR / R mod M*/
 		for (i = 0; i < 16; i += 2) {
-			mont_mul(key, aa_r, a_r, a_r);	/* aa_r = a_r * a_r / R mod M*/
-			mont_mul(key, a_r, aa_r, aa_r);	/* a_r = aa_r * aa_r / R mod M*/
+			mont_mul(&mkey, aa_r, a_r, a_r);	/* aa_r = a_r * a_r / R mod M*/
+			mont_mul(&mkey, a_r, aa_r, aa_r);	/* a_r = aa_r * aa_r / R mod M*/
 		}
-		mont_mul(key, aaa, a_r, a);	/* aaa = a_r * a / R mod M*/
+		mont_mul(&mkey, aaa, a_r, a);	/* aaa = a_r * a / R mod M*/
 	} else if (key->exponent == 3) {
 		aaa = a_r;	/* Re-use location.*/
-		mont_mul(key, a_r, a, key->rr);	/* a_r = a * RR / R mod M   */
-		mont_mul(key, aa_r, a_r, a_r);	/* aa_r = a_r * a_r / R mod M */
-		mont_mul(key, aaa, aa_r, a);	/* aaa = aa_r * a / R mod M */
+		mont_mul(&mkey, a_r, a, mkey.rr);	/* a_r = a * RR / R mod M   */
+		mont_mul(&mkey, aa_r, a_r, a_r);	/* aa_r = a_r * a_r / R mod M */
+		mont_mul(&mkey, aaa, aa_r, a);	/* aaa = aa_r * a / R mod M */
 	}
 
 	/* Make sure aaa < mod; aaa is at most 1x mod too large.*/
-	if (ge_m(key, aaa))
-		sub_m(key, aaa);
+	if (ge_m(&mkey, aaa))
+		sub_m(&mkey, aaa);
 	/* Convert to bigendian byte array*/
-	for (i = key->len - 1; i >= 0; --i) {
-		uint32_t tmp = aaa[i];
-		*inout++ = tmp >> 24;
-		*inout++ = tmp >> 16;
-		*inout++ = tmp >> 8;
-		*inout++ = tmp >> 0;
+	for (i = RSANUMLIMBS - 1; i >= 0; --i) {
+		rsa_limb_t tmp = aaa[i];
+		for (j = sizeof(rsa_limb_t) - 1; j >= 0; --j)
+			*inout++ = (uint8_t)(tmp >> (8 * j));
 	}
 }
 
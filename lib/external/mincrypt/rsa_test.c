@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+#define MODULE TEGRABL_ERR_SW_CRYPTO
+
+#include <tegrabl_debug.h>
+#include <tegrabl_error.h>
+#include <tegrabl_timer.h>
+#include <lib/mincrypt/rsa.h>
+#include <lib/mincrypt/sha.h>
+#include <lib/mincrypt/sha256.h>
+#include <string.h>
+
+#define RSA_TEST_BENCH_LOOPS 16U
+
+/*
+ * Two 2048-bit keys with PKCS#1 v1.5 signatures of the message "abc": SHA-256
+ * with e = 65537 and SHA-1 with e = 3. n and rr = 2^4096 mod n are little
+ * endian 32-bit words, as in struct rsa_public_key.
+ */
+static const uint32_t rsa_test_n_e65537[RSANUMWORDS] = {
+	0xa503fced, 0x03463f44, 0xa3b61647, 0x9cc1fead,
+	0x800754fc, 0x9589fe86, 0x5938ab71, 0x0dc3476d,
+	0x4ae09031, 0xa8343053, 0x5c7d5d8a, 0xb5a2ad07,
+	0x0bfcf353, 0xaa483dad, 0x1300f6b3, 0xb9663a6f,
+	0xac8516a7, 0xc8a5caac, 0xed7769ee, 0xe11f892d,
+	0x68aff2f2, 0x7ca9f369, 0x66c04074, 0xa53c160c,
+	0x60f9a8fb, 0x2d4756dd, 0x010ab3f0, 0xdf0437e9,
+	0x4f222ca9, 0xfda720ff, 0xdaab0b40, 0x0019373d,
+	0xacd488c4, 0x106724ae, 0xbdcc54a5, 0x8be7d383,
+	0x459ed152, 0x3d3f5643, 0x044766d2, 0x33b001c9,
+	0xec16ec9e, 0x1f3ac1b3, 0xd8226983, 0x76615b63,
+	0x39fdc862, 0xc3447ee7, 0x949017d1, 0x5b18893a,
+	0xe857776f, 0x180f207c, 0x05b40ef3, 0xde1cb30d,
+	0xb4c8a866, 0xdec8d32b, 0x8ea22169, 0x1e8e14cf,
+	0x9de14d8c, 0xd3cccd0f, 0xd96b8350, 0x66780f63,
+	0x9c84cc24, 0xa52fe999, 0x630088a0, 0xb5991868,
+};
+
+static const uint32_t rsa_test_rr_e65537[RSANUMWORDS] = {
+	0x149fc660, 0xe0b9f0b3, 0x890d2e42, 0x14a02b3c,
+	0x340bfa9a, 0x312a8457, 0x67e47351, 0xb360b810,
+	0xa913832b, 0x434e963b, 0xfe91287b, 0x82413d7a,
+	0x8981ce42, 0x55829a81, 0xa8c78860, 0x8e142f22,
+	0xd989fb5e, 0xa5f59c76, 0x4b19e470, 0x125441c1,
+	0x1ab7d4c4, 0xbc773ca8, 0x0586e489, 0xa55d8b52,
+	0x4e573a59, 0x8b3a91ad, 0x8fed83c2, 0x61f076c7,
+	0x94937ced, 0xd800f08b, 0xf7ad9a87, 0x40449033,
+	0x8dc56ecd, 0x0b9dd867, 0xdb4faeb6, 0x9e7722f0,
+	0x4dbb3dd1, 0xf7864174, 0x711ee147, 0xae15d5a7,
+	0x499909b8, 0x24499165, 0x66616c7f, 0xab20d7de,
+	0x1c316441, 0x587eb50b, 0x6ebe84e9, 0xba00682a,
+	0xcf0df28b, 0x023525c9, 0x7d1609d1, 0xa56a6fda,
+	0x609b33c3, 0x715e9b7e, 0x4fe47ef1, 0xd49d516c,
+	0xebd5f3e6, 0xaf9fc74f, 0x0723c771, 0xb29ba5b8,
+	0x904daf19, 0xd4353c31, 0xaa9c968c, 0x24e1f37e,
+};
+
+static const uint8_t rsa_test_sig_e65537[RSANUMBYTES] = {
+	0x45, 0xcc, 0xd8, 0xec, 0xa6, 0x68, 0xfd, 0x19,
+	0x22, 0xf5, 0xfd, 0x43, 0x86, 0xc6, 0xa7, 0x2c,
+	0x6d, 0x58, 0xc6, 0x5f, 0x1f, 0x54, 0xa6, 0x46,
+	0x7d, 0x55, 0x11, 0xf9, 0x5f, 0x22, 0x99, 0x43,
+	0x40, 0xba, 0xc0, 0x8d, 0xf7, 0x86, 0xb1, 0x41,
+	0xf2, 0x74, 0x02, 0xbd, 0x42, 0x63, 0xf5, 0x84,
+	0x62, 0x62, 0xaf, 0x2a, 0xc0, 0x3e, 0xf5, 0xc3,
+	0xae, 0x47, 0x49, 0x48, 0x8b, 0xd7, 0x4f, 0xf4,
+	0x51, 0xa0, 0x96, 0x08, 0x67, 0x2b, 0xb2, 0xea,
+	0x8f, 0x26, 0x31, 0x30, 0x73, 0x26, 0x5a, 0x81,
+	0x02, 0xef, 0x44, 0xf4, 0xd8, 0xd4, 0xc4, 0xe0,
+	0x2d, 0x20, 0xe1, 0x8d, 0xd5, 0x9d, 0x8b, 0x4d,
+	0x2a, 0x1f, 0xa1, 0xfd, 0xf9, 0xe7, 0x01, 0x33,
+	0x2b, 0x2c, 0xfe, 0xff, 0xc5, 0x55, 0x7f, 0xa8,
+	0xcc, 0x68, 0x0c, 0x57, 0xb4, 0xc0, 0x23, 0xce,
+	0x3b, 0x2e, 0xa9, 0x35, 0x49, 0x01, 0x8b, 0x92,
+	0x14, 0x2e, 0x38, 0x29, 0x7c, 0x45, 0x84, 0xe0,
+	0xab, 0xf2, 0x7b, 0x69, 0xea, 0xe2, 0x28, 0x63,
+	0x8f, 0x53, 0xf8, 0x1e, 0xce, 0x89, 0x60, 0xd5,
+	0x89, 0xb2, 0xcc, 0x98, 0xe1, 0xf9, 0x2c, 0x8e,
+	0xe2, 0x6a, 0x01, 0xe4, 0x0c, 0x22, 0x28, 0xd1,
+	0x07, 0x96, 0x98, 0x10, 0xec, 0x02, 0xf6, 0xdb,
+	0x6f, 0xc1, 0xfb, 0x94, 0x43, 0x2f, 0x21, 0xf4,
+	0xd1, 0x70, 0x30, 0x67, 0x3e, 0x64, 0x5d, 0x40,
+	0xaf, 0xcf, 0x21, 0x8d, 0xd5, 0x12, 0x50, 0x27,
+	0xfd, 0x17, 0x83, 0x34, 0x09, 0x5a, 0x99, 0xc5,
+	0x3e, 0x1b, 0xee, 0xbc, 0xae, 0xe1, 0xae, 0xc4,
+	0xd5, 0x6b, 0xbd, 0x1e, 0x46, 0x25, 0x5b, 0xdd,
+	0xfc, 0x9c, 0x6d, 0xab, 0xf1, 0xef, 0xea, 0xdf,
+	0xc3, 0x10, 0x27, 0x5d, 0xf7, 0xa8, 0x66, 0xb4,
+	0xd2, 0x15, 0x50, 0x30, 0x3d, 0xfa, 0x01, 0x84,
+	0x1d, 0xe9, 0xa3, 0xdd, 0xeb, 0x6a, 0x3b, 0xbd,
+};
+
+static const uint32_t rsa_test_n_e3[RSANUMWORDS] = {
+	0xcfecb289, 0x1deb346e, 0x594472d9, 0x3168afe4,
+	0xdb3097c3, 0x89dd34d1, 0x4d6191bf, 0x8d2712c1,
+	0x576af372, 0x215fc644, 0x07b78418, 0xd71d5600,
+	0xd9fcc4d6, 0xaabe2103, 0xe1365d0a, 0xbd40313a,
+	0x8a275e23, 0xfa16af16, 0x6e68088b, 0x2ce88f07,
+	0x9b04988e, 0x6526d55b, 0x92a25c70, 0x8b5af345,
+	0xbf16d0e6, 0x3c34c4da, 0x7a8e8cd8, 0x00be50b5,
+	0x8d51a1fb, 0xe39c4b57, 0x7e534ee1, 0x8378b10f,
+	0x09cca2ca, 0x717f6d89, 0x28c57550, 0xb98ae549,
+	0xd496e46f, 0x7515e49e, 0x78eb6a45, 0xc1a83cb4,
+	0x3511f2b0, 0x40cd31d4, 0xe05ca917, 0x0ba5f6bd,
+	0x133dd765, 0xd59a0b75, 0x0c20abff, 0x99399b42,
+	0xe30c1d6e, 0x54144786, 0xeab4c718, 0xf31071ef,
+	0x3ca20881, 0x42118fa0, 0xb1bcbf48, 0xabf4beee,
+	0x971c64da, 0x472ef584, 0xd1a26ec9, 0xccfc7412,
+	0x369f9a73, 0x23f9972b, 0x9eb2b636, 0xc63ef32f,
+};
+
+static const uint32_t rsa_test_rr_e3[RSANUMWORDS] = {
+	0x74d1485f, 0x81ad27bf, 0x1b3a2dce, 0x6722565e,
+	0x8aecfd9d, 0x560c1494, 0x0797d269, 0xf3eac8d4,
+	0xf7100565, 0x4c34ec2c, 0x3f871758, 0x4eaf40bd,
+	0xe1c61191, 0xf8ddb853, 0x4afcaec6, 0x303622c1,
+	0xfd41f7a5, 0xd4f9ebe7, 0x94611263, 0xe8364d7f,
+	0x91388038, 0x0b94700b, 0x061fccfe, 0xfa55c42b,
+	0xe7ecb224, 0x71b4104c, 0x4ee5b4c6, 0x64daf425,
+	0xc62ee636, 0x2d0f44d5, 0x7ac719d5, 0xe5c7031c,
+	0x3cec1f4f, 0x2f11caea, 0x9214046f, 0x6f700241,
+	0xe98591a9, 0x9af3dfd1, 0x2707ec8f, 0x6138093f,
+	0xcd5dd8f3, 0x67532c97, 0x2a343e99, 0xb27e2cf8,
+	0x01ca25cd, 0x9270b538, 0x9aba0a1d, 0x3e103b0e,
+	0xc3fc3a7c, 0xb44f7aa8, 0x92500c46, 0x0f6c87bb,
+	0xe108f034, 0xeaa7eac2, 0x868fc580, 0xc287908a,
+	0x2adce3a6, 0xbfa9d000, 0x6ddce9ec, 0xe4eb17bd,
+	0x3d99d72f, 0x755beb76, 0xea038b20, 0x209a9aa1,
+};
+
+static const uint8_t rsa_test_sig_e3[RSANUMBYTES] = {
+	0xab, 0x58, 0xeb, 0xc6, 0x3c, 0x5a, 0x21, 0xa7,
+	0x14, 0x38, 0x2c, 0x4c, 0x56, 0xad, 0x3c, 0x83,
+	0x19, 0x1a, 0x91, 0xc9, 0x7f, 0x42, 0x47, 0x20,
+	0x9b, 0x64, 0x8c, 0xed, 0x8f, 0x04, 0xe1, 0x72,
+	0xbc, 0xc1, 0x51, 0x20, 0xbe, 0x79, 0x77, 0x18,
+	0x02, 0x93, 0x9e, 0x93, 0x24, 0x3b, 0x59, 0x9e,
+	0xc5, 0x78, 0x83, 0xa5, 0x2a, 0x0c, 0x16, 0xf0,
+	0xea, 0x12, 0x6b, 0xcd, 0x9d, 0xf7, 0xc2, 0x76,
+	0xe2, 0xcd, 0x88, 0x85, 0x2a, 0x1b, 0xc4, 0xdd,
+	0xef, 0xbf, 0x2e, 0x59, 0xb9, 0x8b, 0xb7, 0xf4,
+	0x20, 0x69, 0xd5, 0x33, 0xff, 0xd2, 0x94, 0xa7,
+	0xdb, 0x88, 0x29, 0xf0, 0x16, 0xa6, 0x17, 0x9a,
+	0x60, 0x0f, 0xbf, 0x15, 0xc2, 0x8a, 0x12, 0xdf,
+	0xca, 0x1b, 0x03, 0x2b, 0xfe, 0x69, 0xa2, 0x5b,
+	0x63, 0xeb, 0x16, 0xe9, 0xc0, 0x42, 0xd6, 0xbc,
+	0xb4, 0x7b, 0xad, 0xac, 0x64, 0x3f, 0xfa, 0xed,
+	0xca, 0x9b, 0x14, 0xab, 0xbe, 0xc6, 0xd4, 0x1d,
+	0xfa, 0xb2, 0xb0, 0xe5, 0xd1, 0xc4, 0x8a, 0xde,
+	0xab, 0x94, 0xf6, 0xa3, 0xfc, 0xca, 0xf1, 0xd3,
+	0xbb, 0x17, 0x7d, 0x3b, 0xa9, 0x3c, 0x24, 0xfa,
+	0x4c, 0x22, 0x2c, 0xbc, 0x20, 0xc5, 0xd9, 0xb7,
+	0xce, 0x0b, 0xce, 0x30, 0x49, 0xe9, 0x84, 0x52,
+	0x66, 0xd6, 0xd9, 0x90, 0xdd, 0xb0, 0x6a, 0xf1,
+	0x0f, 0x79, 0x01, 0x41, 0xa0, 0x90, 0x34, 0x92,
+	0x05, 0x81, 0x62, 0x30, 0x18, 0x12, 0x79, 0x23,
+	0x39, 0x1c, 0x1e, 0x9e, 0xf7, 0xee, 0x21, 0xd2,
+	0xc8, 0x9a, 0x69, 0xad, 0x55, 0xb5, 0xef, 0xc3,
+	0x3e, 0x06, 0xb8, 0xb7, 0x22, 0xab, 0x77, 0x0a,
+	0xed, 0x0b, 0x85, 0x0a, 0xcd, 0x6b, 0x43, 0xcb,
+	0xe9, 0xe1, 0x01, 0xdc, 0x57, 0x12, 0x9a, 0x5a,
+	0x16, 0x6a, 0xea, 0x49, 0x06, 0xeb, 0xbb, 0xbd,
+	0x93, 0x4c, 0x2e, 0x75, 0x9b, 0x04, 0x2a, 0xec,
+};
+
+/* FIPS 180-2 digests of "abc" */
+static const uint8_t rsa_test_sha256_abc[SHA256_DIGEST_SIZE] = {
+	0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+	0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+	0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+	0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+};
+
+static const uint8_t rsa_test_sha1_abc[SHA_DIGEST_SIZE] = {
+	0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a,
+	0xba, 0x3e, 0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c,
+	0x9c, 0xd0, 0xd8, 0x9d,
+};
+
+static void rsa_test_key(struct rsa_public_key *key, const uint32_t *n,
+	const uint32_t *rr, uint32_t n0inv, int exponent)
+{
+	key->len = RSANUMWORDS;
+	key->n0inv = n0inv;
+	memcpy(key->n, n, sizeof(key->n));
+	memcpy(key->rr, rr, sizeof(key->rr));
+	key->exponent = exponent;
+}
+
+/* The signature must verify, and must not once the signature or hash change */
+static tegrabl_error_t rsa_test_verify(const struct rsa_public_key *key,
+	const uint8_t *sig, const uint8_t *hash, int hash_len, uint8_t aux)
+{
+	uint8_t bad_sig[RSANUMBYTES];
+	uint8_t bad_hash[SHA256_DIGEST_SIZE];
+
+	if (rsa_verify(key, sig, RSANUMBYTES, hash, hash_len) != 1) {
+		pr_error("RSA test: e = %d signature rejected\n", key->exponent);
+		return TEGRABL_ERROR(TEGRABL_ERR_VERIFY_FAILED, aux);
+	}
+
+	memcpy(bad_sig, sig, RSANUMBYTES);
+	bad_sig[RSANUMBYTES / 2] ^= 0x01;
+	if (rsa_verify(key, bad_sig, RSANUMBYTES, hash, hash_len) != 0) {
+		pr_error("RSA test: e = %d bad signature accepted\n", key->exponent);
+		return TEGRABL_ERROR(TEGRABL_ERR_VERIFY_FAILED, aux + 1U);
+	}
+
+	memcpy(bad_hash, hash, hash_len);
+	bad_hash[hash_len - 1] ^= 0x80;
+	if (rsa_verify(key, sig, RSANUMBYTES, bad_hash, hash_len) != 0) {
+		pr_error("RSA test: e = %d bad hash accepted\n", key->exponent);
+		return TEGRABL_ERROR(TEGRABL_ERR_VERIFY_FAILED, aux + 2U);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t mincrypt_rsa_test(void)
+{
+	struct rsa_public_key key;
+	tegrabl_error_t err;
+	time_t start;
+	time_t elapsed;
+	uint32_t i;
+
+	rsa_test_key(&key, rsa_test_n_e65537, rsa_test_rr_e65537, 0x3dee3f1bU,
+				 65537);
+	err = rsa_test_verify(&key, rsa_test_sig_e65537, rsa_test_sha256_abc,
+						  SHA256_DIGEST_SIZE, 0);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
+	/* benchmark: time the e = 65537 verification that boot uses */
+	start = tegrabl_get_timestamp_us();
+	for (i = 0; i < RSA_TEST_BENCH_LOOPS; i++) {
+		(void)rsa_verify(&key, rsa_test_sig_e65537, RSANUMBYTES,
+						 rsa_test_sha256_abc, SHA256_DIGEST_SIZE);
+	}
+	elapsed = tegrabl_get_timestamp_us() - start;
+
+	rsa_test_key(&key, rsa_test_n_e3, rsa_test_rr_e3, 0x0c579c47U, 3);
+	err = rsa_test_verify(&key, rsa_test_sig_e3, rsa_test_sha1_abc,
+						  SHA_DIGEST_SIZE, 3);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
+	pr_info("RSA test: passed, 2048-bit e = 65537 verify takes %u us\n",
+			(uint32_t)(elapsed / RSA_TEST_BENCH_LOOPS));
+
+	return TEGRABL_NO_ERROR;
+}
@@ -1,5 +1,5 @@
 #
-# Copyright (c) 2015-2016, NVIDIA Corporation.  All Rights Reserved.
+# Copyright (c) 2015-2023, NVIDIA Corporation.  All Rights Reserved.
 #
 # NVIDIA Corporation and its licensors retain all intellectual property and
 # proprietary rights in and to this software and related documentation.  Any
@@ -16,6 +16,15 @@ GLOBAL_INCLUDES += $(LOCAL_DIR)
 MODULE_SRCS += \
 	$(LOCAL_DIR)/rsa.c	\
 	$(LOCAL_DIR)/sha.c	\
-	$(LOCAL_DIR)/sha256.c
+	$(LOCAL_DIR)/sha256.c	\
+	$(LOCAL_DIR)/sha_armv8.S
+
+ifeq ($(CONFIG_ENABLE_CRYPTO_SELF_TEST), yes)
+MODULE_SRCS += \
+	$(LOCAL_DIR)/rsa_test.c \
+	$(LOCAL_DIR)/sha_test.c
+endif
+
+MODULE_ASMFLAGS += -D_ASSEMBLY_=1
 
 include make/module.mk
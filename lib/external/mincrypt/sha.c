@@ -1,6 +1,6 @@
 /* sha.c
 **
-** Copyright (c) 2015, NVIDIA Corporation.  All Rights Reserved.
+** Copyright (c) 2015-2023, NVIDIA Corporation.  All Rights Reserved.
 **
 ** NVIDIA Corporation and its licensors retain all intellectual property and
 ** proprietary rights in and to this software and related documentation.  Any
@@ -41,17 +41,24 @@
 #include <string.h>
 #include <stdint.h>
 
+#if defined(__aarch64__)
+#include <tegrabl_cpu_arch.h>
+
+/* ARMv8 Cryptography Extension transform, see sha_armv8.S */
+void sha1_armv8_blocks(uint32_t *state, const uint8_t *data,
+		       uint32_t nblocks);
+#endif
+
 #define rol(bits, value) (((value) << (bits)) | ((value) >> (32 - (bits))))
 
-static void sha1_transform(struct HASH_CTX *ctx)
+static void sha1_transform(uint32_t *state, const uint8_t *p)
 {
 	uint32_t W[80];
 	uint32_t A, B, C, D, E;
-	uint8_t *p = ctx->buf;
 	int t;
 
 	for (t = 0; t < 16; ++t) {
-		uint32_t tmp = *p++ << 24;
+		uint32_t tmp = (uint32_t)*p++ << 24;
 		tmp |= *p++ << 16;
 		tmp |= *p++ << 8;
 		tmp |= *p++;
@@ -61,11 +68,11 @@ static void sha1_transform(struct HASH_CTX *ctx)
 	for (; t < 80; t++)
 		W[t] = rol(1, W[t - 3] ^ W[t - 8] ^ W[t - 14] ^ W[t - 16]);
 
-	A = ctx->state[0];
-	B = ctx->state[1];
-	C = ctx->state[2];
-	D = ctx->state[3];
-	E = ctx->state[4];
+	A = state[0];
+	B = state[1];
+	C = state[2];
+	D = state[3];
+	E = state[4];
 
 	for (t = 0; t < 80; t++) {
 		uint32_t tmp = rol(5, A) + E + W[t];
@@ -86,13 +93,69 @@ static void sha1_transform(struct HASH_CTX *ctx)
 		A = tmp;
 	}
 
-	ctx->state[0] += A;
-	ctx->state[1] += B;
-	ctx->state[2] += C;
-	ctx->state[3] += D;
-	ctx->state[4] += E;
+	state[0] += A;
+	state[1] += B;
+	state[2] += C;
+	state[3] += D;
+	state[4] += E;
+}
+
+static void sha1_blocks_c(uint32_t *state, const uint8_t *data,
+			  uint32_t nblocks)
+{
+	while (nblocks--) {
+		sha1_transform(state, data);
+		data += 64;
+	}
+}
+
+/* Block function, picked on first use from the CPU features */
+static void (*sha1_blocks)(uint32_t *state, const uint8_t *data,
+			   uint32_t nblocks);
+
+#if defined(__aarch64__)
+/* The CPU has the instructions and SIMD registers do not trap at EL1 */
+static int sha1_armv8_usable(void)
+{
+	if (((tegrabl_read_id_aa64isar0() >> ID_AA64ISAR0_SHA1_SHIFT) &
+	     ID_AA64ISAR0_FIELD_MASK) == 0)
+		return 0;
+
+	return ((tegrabl_read_cpacr_el1() >> CPACR_EL1_FPEN_SHIFT) &
+		CPACR_EL1_FPEN_MASK) == CPACR_EL1_FPEN_NO_TRAP;
+}
+#endif
+
+static void sha1_select_blocks(void)
+{
+	sha1_blocks = sha1_blocks_c;
+#if defined(__aarch64__)
+	if (sha1_armv8_usable())
+		sha1_blocks = sha1_armv8_blocks;
+#endif
 }
 
+#if defined(CONFIG_ENABLE_CRYPTO_SELF_TEST)
+int sha_test_select(int armv8)
+{
+	if (armv8 < 0) {
+		sha1_select_blocks();
+		return 1;
+	}
+	if (armv8 == 0) {
+		sha1_blocks = sha1_blocks_c;
+		return 1;
+	}
+#if defined(__aarch64__)
+	if (sha1_armv8_usable()) {
+		sha1_blocks = sha1_armv8_blocks;
+		return 1;
+	}
+#endif
+	return 0;
+}
+#endif
+
 static const struct HASH_VTAB SHA_VTAB = {
 	sha_init,
 	sha_update,
@@ -103,6 +166,9 @@ static const struct HASH_VTAB SHA_VTAB = {
 
 void sha_init(struct HASH_CTX *ctx)
 {
+	if (sha1_blocks == NULL)
+		sha1_select_blocks();
+
 	ctx->f = &SHA_VTAB;
 	ctx->state[0] = 0x67452301;
 	ctx->state[1] = 0xEFCDAB89;
@@ -117,15 +183,31 @@ void sha_update(struct HASH_CTX *ctx, const void *data, int len)
 	int i = (int)(ctx->count & 63);
 	const uint8_t *p = (const uint8_t *)data;
 
+	int n;
+
 	ctx->count += len;
 
-	while (len--) {
-		ctx->buf[i++] = *p++;
-		if (i == 64) {
-			sha1_transform(ctx);
-			i = 0;
+	/* complete a partially filled block first */
+	if (i != 0) {
+		n = 64 - i;
+		if (len < n) {
+			memcpy(ctx->buf + i, p, len);
+			return;
 		}
+		memcpy(ctx->buf + i, p, n);
+		sha1_blocks(ctx->state, ctx->buf, 1);
+		p += n;
+		len -= n;
 	}
+
+	/* whole blocks are hashed straight from the caller's buffer */
+	if (len >= 64) {
+		sha1_blocks(ctx->state, p, (uint32_t)len / 64);
+		p += len & ~63;
+		len &= 63;
+	}
+
+	memcpy(ctx->buf, p, len);
 }
 
 const uint8_t *sha_final(struct HASH_CTX *ctx)
@@ -2,7 +2,7 @@
 **
 ** Copyright 2013, The Android Open Source Project
 **
-** Copyright (c) 2015, NVIDIA Corporation. All Rights Reserved.
+** Copyright (c) 2015-2023, NVIDIA Corporation. All Rights Reserved.
 **
 ** Redistribution and use in source and binary forms, with or without
 ** modification, are permitted provided that the following conditions are met:
@@ -35,6 +35,14 @@
 #include <string.h>
 #include <stdint.h>
 
+#if defined(__aarch64__)
+#include <tegrabl_cpu_arch.h>
+
+/* ARMv8 Cryptography Extension transform, see sha_armv8.S */
+void sha256_armv8_blocks(uint32_t *state, const uint8_t *data,
+			 uint32_t nblocks);
+#endif
+
 #define ror(value, bits) (((value) >> (bits)) | ((value) << (32 - (bits))))
 #define shr(value, bits) ((value) >> (bits))
 
@@ -57,15 +65,14 @@ static const uint32_t K[64] = {
 	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
 };
 
-static void sha256_transform(struct HASH_CTX *ctx)
+static void sha256_transform(uint32_t *state, const uint8_t *p)
 {
 	uint32_t W[64];
 	uint32_t A, B, C, D, E, F, G, H;
-	uint8_t *p = ctx->buf;
 	int t;
 
 	for (t = 0; t < 16; ++t) {
-		uint32_t tmp = *p++ << 24;
+		uint32_t tmp = (uint32_t)*p++ << 24;
 		tmp |= *p++ << 16;
 		tmp |= *p++ << 8;
 		tmp |= *p++;
@@ -80,14 +87,14 @@ static void sha256_transform(struct HASH_CTX *ctx)
 		W[t] = W[t - 16] + s0 + W[t - 7] + s1;
 	}
 
-	A = ctx->state[0];
-	B = ctx->state[1];
-	C = ctx->state[2];
-	D = ctx->state[3];
-	E = ctx->state[4];
-	F = ctx->state[5];
-	G = ctx->state[6];
-	H = ctx->state[7];
+	A = state[0];
+	B = state[1];
+	C = state[2];
+	D = state[3];
+	E = state[4];
+	F = state[5];
+	G = state[6];
+	H = state[7];
 
 	for (t = 0; t < 64; t++) {
 		uint32_t s0 = ror(A, 2) ^ ror(A, 13) ^ ror(A, 22);
@@ -107,16 +114,72 @@ static void sha256_transform(struct HASH_CTX *ctx)
 		A = t1 + t2;
 	}
 
-	ctx->state[0] += A;
-	ctx->state[1] += B;
-	ctx->state[2] += C;
-	ctx->state[3] += D;
-	ctx->state[4] += E;
-	ctx->state[5] += F;
-	ctx->state[6] += G;
-	ctx->state[7] += H;
+	state[0] += A;
+	state[1] += B;
+	state[2] += C;
+	state[3] += D;
+	state[4] += E;
+	state[5] += F;
+	state[6] += G;
+	state[7] += H;
+}
+
+static void sha256_blocks_c(uint32_t *state, const uint8_t *data,
+			    uint32_t nblocks)
+{
+	while (nblocks--) {
+		sha256_transform(state, data);
+		data += 64;
+	}
+}
+
+/* Block function, picked on first use from the CPU features */
+static void (*sha256_blocks)(uint32_t *state, const uint8_t *data,
+			     uint32_t nblocks);
+
+#if defined(__aarch64__)
+/* The CPU has the instructions and SIMD registers do not trap at EL1 */
+static int sha256_armv8_usable(void)
+{
+	if (((tegrabl_read_id_aa64isar0() >> ID_AA64ISAR0_SHA2_SHIFT) &
+	     ID_AA64ISAR0_FIELD_MASK) == 0)
+		return 0;
+
+	return ((tegrabl_read_cpacr_el1() >> CPACR_EL1_FPEN_SHIFT) &
+		CPACR_EL1_FPEN_MASK) == CPACR_EL1_FPEN_NO_TRAP;
+}
+#endif
+
+static void sha256_select_blocks(void)
+{
+	sha256_blocks = sha256_blocks_c;
+#if defined(__aarch64__)
+	if (sha256_armv8_usable())
+		sha256_blocks = sha256_armv8_blocks;
+#endif
 }
 
+#if defined(CONFIG_ENABLE_CRYPTO_SELF_TEST)
+int sha256_test_select(int armv8)
+{
+	if (armv8 < 0) {
+		sha256_select_blocks();
+		return 1;
+	}
+	if (armv8 == 0) {
+		sha256_blocks = sha256_blocks_c;
+		return 1;
+	}
+#if defined(__aarch64__)
+	if (sha256_armv8_usable()) {
+		sha256_blocks = sha256_armv8_blocks;
+		return 1;
+	}
+#endif
+	return 0;
+}
+#endif
+
 static const struct HASH_VTAB SHA256_VTAB = {
 	sha256_init,
 	sha256_update,
@@ -127,6 +190,9 @@ static const struct HASH_VTAB SHA256_VTAB = {
 
 void sha256_init(struct HASH_CTX *ctx)
 {
+	if (sha256_blocks == NULL)
+		sha256_select_blocks();
+
 	ctx->f = &SHA256_VTAB;
 	ctx->state[0] = 0x6a09e667;
 	ctx->state[1] = 0xbb67ae85;
@@ -144,15 +210,31 @@ void sha256_update(struct HASH_CTX *ctx, const void *data, int len)
 	int i = (int)(ctx->count & 63);
 	const uint8_t *p = (const uint8_t *)data;
 
+	int n;
+
 	ctx->count += len;
 
-	while (len--) {
-		ctx->buf[i++] = *p++;
-		if (i == 64) {
-			sha256_transform(ctx);
-			i = 0;
+	/* complete a partially filled block first */
+	if (i != 0) {
+		n = 64 - i;
+		if (len < n) {
+			memcpy(ctx->buf + i, p, len);
+			return;
 		}
+		memcpy(ctx->buf + i, p, n);
+		sha256_blocks(ctx->state, ctx->buf, 1);
+		p += n;
+		len -= n;
 	}
+
+	/* whole blocks are hashed straight from the caller's buffer */
+	if (len >= 64) {
+		sha256_blocks(ctx->state, p, (uint32_t)len / 64);
+		p += len & ~63;
+		len &= 63;
+	}
+
+	memcpy(ctx->buf, p, len);
 }
 
 const uint8_t *sha256_final(struct HASH_CTX *ctx)
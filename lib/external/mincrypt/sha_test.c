@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+#define MODULE TEGRABL_ERR_SW_CRYPTO
+
+#include <tegrabl_debug.h>
+#include <tegrabl_error.h>
+#include <tegrabl_utils.h>
+#include <lib/mincrypt/sha.h>
+#include <lib/mincrypt/sha256.h>
+#include <string.h>
+
+struct sha_test_vector {
+	const char *msg;
+	uint32_t repeat;		/* the digest is of msg repeated this many times */
+	uint8_t digest[SHA256_DIGEST_SIZE];
+};
+
+/* FIPS 180-2 examples, the last one is one million "a" */
+static const struct sha_test_vector sha1_test_vectors[] = {
+	{ "", 1, {
+		0xda, 0x39, 0xa3, 0xee, 0x5e, 0x6b, 0x4b, 0x0d,
+		0x32, 0x55, 0xbf, 0xef, 0x95, 0x60, 0x18, 0x90,
+		0xaf, 0xd8, 0x07, 0x09,
+	} },
+	{ "abc", 1, {
+		0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a,
+		0xba, 0x3e, 0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c,
+		0x9c, 0xd0, 0xd8, 0x9d,
+	} },
+	{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1, {
+		0x84, 0x98, 0x3e, 0x44, 0x1c, 0x3b, 0xd2, 0x6e,
+		0xba, 0xae, 0x4a, 0xa1, 0xf9, 0x51, 0x29, 0xe5,
+		0xe5, 0x46, 0x70, 0xf1,
+	} },
+	{ "a", 1000000, {
+		0x34, 0xaa, 0x97, 0x3c, 0xd4, 0xc4, 0xda, 0xa4,
+		0xf6, 0x1e, 0xeb, 0x2b, 0xdb, 0xad, 0x27, 0x31,
+		0x65, 0x34, 0x01, 0x6f,
+	} },
+};
+
+static const struct sha_test_vector sha256_test_vectors[] = {
+	{ "", 1, {
+		0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14,
+		0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+		0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c,
+		0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55,
+	} },
+	{ "abc", 1, {
+		0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+		0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+		0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+	} },
+	{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1, {
+		0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8,
+		0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+		0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67,
+		0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1,
+	} },
+	{ "a", 1000000, {
+		0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92,
+		0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+		0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e,
+		0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0,
+	} },
+};
+
+struct sha_test_alg {
+	const char *name;
+	void (*init)(struct HASH_CTX *ctx);
+	void (*update)(struct HASH_CTX *ctx, const void *data, int len);
+	const uint8_t *(*final)(struct HASH_CTX *ctx);
+	int (*select)(int armv8);
+	int digest_size;
+	const struct sha_test_vector *vectors;
+	uint32_t num_vectors;
+};
+
+static const struct sha_test_alg sha_test_algs[] = {
+	{ "SHA-1", sha_init, sha_update, sha_final, sha_test_select,
+	  SHA_DIGEST_SIZE, sha1_test_vectors, ARRAY_SIZE(sha1_test_vectors) },
+	{ "SHA-256", sha256_init, sha256_update, sha256_final, sha256_test_select,
+	  SHA256_DIGEST_SIZE, sha256_test_vectors,
+	  ARRAY_SIZE(sha256_test_vectors) },
+};
+
+/* update lengths that cross the 64-byte block boundary in different ways */
+static const uint32_t sha_test_chunks[] = { 1, 55, 64, 129, 1000 };
+
+/*
+ * Hashes a vector twice: in one update where possible and in pieces, one byte
+ * at a time for short messages and in varying chunks for repeated ones.
+ */
+static tegrabl_error_t sha_test_vector(const struct sha_test_alg *alg,
+	const struct sha_test_vector *v, const uint8_t *fill)
+{
+	struct HASH_CTX ctx;
+	uint32_t len = (uint32_t)strlen(v->msg);
+	uint32_t total = len * v->repeat;
+	uint32_t done = 0;
+	uint32_t n;
+	uint32_t i = 0;
+
+	if (v->repeat == 1U) {
+		alg->init(&ctx);
+		alg->update(&ctx, v->msg, (int)len);
+		if (memcmp(alg->final(&ctx), v->digest, alg->digest_size) != 0) {
+			return TEGRABL_ERROR(TEGRABL_ERR_VERIFY_FAILED, 0);
+		}
+		alg->init(&ctx);
+		for (n = 0; n < len; n++) {
+			alg->update(&ctx, v->msg + n, 1);
+		}
+	} else {
+		/* repeated messages are single characters, see fill */
+		alg->init(&ctx);
+		while (done < total) {
+			n = MIN(sha_test_chunks[i++ % ARRAY_SIZE(sha_test_chunks)],
+					total - done);
+			alg->update(&ctx, fill, (int)n);
+			done += n;
+		}
+	}
+	if (memcmp(alg->final(&ctx), v->digest, alg->digest_size) != 0) {
+		return TEGRABL_ERROR(TEGRABL_ERR_VERIFY_FAILED, 1);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+static tegrabl_error_t sha_test_alg(const struct sha_test_alg *alg)
+{
+	static const char *const path[] = { "C", "ARMv8 CE" };
+	uint8_t fill[1000];
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint32_t armv8;
+	uint32_t i;
+
+	for (armv8 = 0; armv8 < ARRAY_SIZE(path); armv8++) {
+		if (alg->select((int)armv8) == 0) {
+			pr_info("%s test: %s transform not usable, skipped\n", alg->name,
+					path[armv8]);
+			continue;
+		}
+		for (i = 0; i < alg->num_vectors; i++) {
+			memset(fill, alg->vectors[i].msg[0], sizeof(fill));
+			err = sha_test_vector(alg, &alg->vectors[i], fill);
+			if (err != TEGRABL_NO_ERROR) {
+				pr_error("%s test: %s transform, vector %u failed\n",
+						 alg->name, path[armv8], i);
+				goto fail;
+			}
+		}
+	}
+
+fail:
+	(void)alg->select(-1);
+	return err;
+}
+
+tegrabl_error_t mincrypt_sha_test(void)
+{
+	tegrabl_error_t err;
+	uint32_t i;
+
+	for (i = 0; i < ARRAY_SIZE(sha_test_algs); i++) {
+		err = sha_test_alg(&sha_test_algs[i]);
+		if (err != TEGRABL_NO_ERROR) {
+			return err;
+		}
+	}
+
+	pr_info("SHA test: passed\n");
+
+	return TEGRABL_NO_ERROR;
+}
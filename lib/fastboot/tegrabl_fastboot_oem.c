@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2017, NVIDIA Corporation.  All Rights Reserved.
+ * Copyright (c) 2016-2023, NVIDIA Corporation.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -17,6 +17,10 @@
 #include <tegrabl_fastboot_protocol.h>
 #include <string.h>
 #include <tegrabl_exit.h>
+#if defined(CONFIG_ENABLE_USBF_LOOPBACK)
+#include <tegrabl_utils.h>
+#include <tegrabl_transport_usbf.h>
+#endif
 
 static struct tegrabl_fastboot_oem_ops oem_ops;
 
@@ -55,6 +59,31 @@ static const char *get_dts_basename(const char *path)
 	return fname ? (fname + 1) : path;
 }
 
+#if defined(CONFIG_ENABLE_USBF_LOOPBACK)
+/* "oem usb-loopback <bytes>": the host streams that many bytes once it gets
+ * the INFO response and reads each transfer back.
+ */
+static tegrabl_error_t usb_loopback(const char *arg)
+{
+	uint32_t length;
+	tegrabl_error_t ret;
+
+	length = (uint32_t)tegrabl_utils_strtoul(arg, NULL, 0);
+	if (length == 0U) {
+		fastboot_fail("usage: oem usb-loopback <bytes>");
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
+	}
+
+	fastboot_ack("INFO", "loopback ready");
+	ret = tegrabl_transport_usbf_loopback(length);
+	if (ret != TEGRABL_NO_ERROR) {
+		fastboot_fail("loopback failed");
+	}
+
+	return ret;
+}
+#endif
+
 tegrabl_error_t tegrabl_fastboot_oem_handler(const char *arg)
 {
 	uint8_t response[MAX_RESPONSE_SIZE];
@@ -105,6 +134,10 @@ tegrabl_error_t tegrabl_fastboot_oem_handler(const char *arg)
 		fastboot_okay("");
 		tegrabl_reboot_forced_recovery();
 	}
+#if defined(CONFIG_ENABLE_USBF_LOOPBACK)
+	else if (IS_VAR_TYPE("usb-loopback"))
+		ret = usb_loopback(arg + strlen("usb-loopback"));
+#endif
 
 	return ret;
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -8,12 +8,15 @@
  * license agreement from NVIDIA CORPORATION is strictly prohibited
  */
 
+#define MODULE TEGRABL_ERR_FASTBOOT
+
 #include <string.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <tegrabl_debug.h>
 #include <tegrabl_error.h>
 #include <tegrabl_utils.h>
+#include <tegrabl_blockdev.h>
 #include <tegrabl_partition_manager.h>
 #include <tegrabl_fastboot_partinfo.h>
 #include <tegrabl_a_b_partition_naming.h>
@@ -118,10 +121,124 @@ const struct tegrabl_fastboot_partition_info *
 tegrabl_error_t tegrabl_fastboot_partition_write(const void *buffer,
 												 uint64_t size, void *aux_info)
 {
+	struct tegrabl_partition *partition = (struct tegrabl_partition *)aux_info;
+	tegrabl_bdev_t *bdev = partition->block_device;
+	uint32_t block_size_log2 = TEGRABL_BLOCKDEV_BLOCK_SIZE_LOG2(bdev);
+	struct tegrabl_blockdev_req req;
+	uint32_t start_block = 0;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
 	pr_debug("Writing %"PRIu64" bytes to partition", size);
 
-	return tegrabl_partition_write((struct tegrabl_partition *)aux_info, buffer,
-								   size);
+	/* Partial blocks need the read-modify-write of the partition manager */
+	if ((size == 0U) ||
+		((partition->offset & ((1ULL << block_size_log2) - 1U)) != 0U) ||
+		((size & ((1ULL << block_size_log2) - 1U)) != 0U) ||
+		((partition->offset + size) > tegrabl_partition_size(partition))) {
+		return tegrabl_partition_write(partition, buffer, size);
+	}
+
+	error = tegrabl_partition_start_in_block(partition, &start_block);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	/*
+	 * The request queue splits the run at the driver's transfer limit and
+	 * uses its DMA xfer hooks when the buffer is aligned for them.
+	 */
+	req.xfer_type = TEGRABL_BLOCKDEV_WRITE;
+	req.buf = (void *)buffer;
+	req.start_block = start_block + (bnum_t)(partition->offset >> block_size_log2);
+	req.block_count = (bnum_t)(size >> block_size_log2);
+
+	error = tegrabl_blockdev_submit(bdev, &req, 1);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	return tegrabl_partition_seek(partition, (int64_t)size,
+								  TEGRABL_PARTITION_SEEK_CUR);
+}
+
+/* Block device whose erased blocks are known to read back as zeros */
+static tegrabl_bdev_t *erase_reads_zero_bdev;
+/* Block device whose erased blocks are known not to read back as zeros */
+static tegrabl_bdev_t *erase_reads_nonzero_bdev;
+
+/**
+ * @brief Checks if erased blocks of device read back as zeros. Erase is
+ * TRIM/UNMAP on eMMC and UFS, whose erased contents are reported by the device
+ * (ERASED_MEM_CONT on eMMC, TPRZ of the LUN on UFS). Devices not reporting it
+ * are taken not to read back zeros.
+ *
+ * @param bdev Handle of block device.
+ *
+ * @return true if erased blocks read back as zeros.
+ */
+static bool fastboot_erase_reads_zero(tegrabl_bdev_t *bdev)
+{
+	bool is_zero = false;
+
+	if (bdev == erase_reads_zero_bdev) {
+		return true;
+	}
+	if (bdev == erase_reads_nonzero_bdev) {
+		return false;
+	}
+
+	if ((tegrabl_blockdev_ioctl(bdev, TEGRABL_IOCTL_ERASE_READS_ZERO,
+								&is_zero) != TEGRABL_NO_ERROR) || !is_zero) {
+		erase_reads_nonzero_bdev = bdev;
+		return false;
+	}
+
+	erase_reads_zero_bdev = bdev;
+	return true;
+}
+
+tegrabl_error_t tegrabl_fastboot_partition_fill(uint32_t fill_value,
+												uint64_t size, void *aux_info)
+{
+	struct tegrabl_partition *partition = (struct tegrabl_partition *)aux_info;
+	tegrabl_bdev_t *bdev = partition->block_device;
+	uint32_t block_size_log2 = TEGRABL_BLOCKDEV_BLOCK_SIZE_LOG2(bdev);
+	uint32_t start_block = 0;
+	bnum_t block;
+	bnum_t count;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	/* Only zero fill of whole blocks maps to erase */
+	if ((fill_value != 0U) ||
+		((partition->offset & ((1ULL << block_size_log2) - 1U)) != 0U) ||
+		((size & ((1ULL << block_size_log2) - 1U)) != 0U) ||
+		((partition->offset + size) > tegrabl_partition_size(partition))) {
+		return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+	}
+
+	/* Zeros are written over the range instead */
+	if (!fastboot_erase_reads_zero(bdev)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 2);
+	}
+
+	error = tegrabl_partition_start_in_block(partition, &start_block);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	block = start_block + (bnum_t)(partition->offset >> block_size_log2);
+	count = (bnum_t)(size >> block_size_log2);
+
+	pr_debug("Discarding %"PRIu64" bytes of partition\n", size);
+
+	error = tegrabl_blockdev_erase(bdev, block, count, false);
+	if (error != TEGRABL_NO_ERROR) {
+		erase_reads_nonzero_bdev = bdev;
+		return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 1);
+	}
+
+	return tegrabl_partition_seek(partition, (int64_t)size,
+								  TEGRABL_PARTITION_SEEK_CUR);
 }
 
 tegrabl_error_t tegrabl_fastboot_partition_seek(uint64_t size, void *aux_info)
@@ -74,4 +74,19 @@ tegrabl_error_t tegrabl_fastboot_partition_write(const void *buffer,
  * @return TEGRABL_NO_ERROR if successful else appropriate error.
  */
 tegrabl_error_t tegrabl_fastboot_partition_seek(uint64_t size, void *aux_info);
+
+/**
+ * @brief Fills range of partition from current location with pattern. Zero
+ * fill is done by erasing the blocks on devices which read back zeros after
+ * erase.
+ *
+ * @param fill_value Pattern to be filled.
+ * @param size Bytes to fill from current location.
+ * @param aux_info Handle of partition.
+ *
+ * @return TEGRABL_NO_ERROR if successful, TEGRABL_ERR_NOT_SUPPORTED if pattern
+ * needs to be written else appropriate error.
+ */
+tegrabl_error_t tegrabl_fastboot_partition_fill(uint32_t fill_value,
+												uint64_t size, void *aux_info);
 #endif
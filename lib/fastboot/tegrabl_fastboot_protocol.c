@@ -563,6 +563,8 @@ static void cmd_flash(const char *arg, void *data, uint32_t sz)
 			pr_error("Failed to initialize unsparse state\n");
 			return;
 		}
+		tegrabl_sparse_set_unsparse_filler(&unsparse_state,
+			tegrabl_fastboot_partition_fill);
 	}
 
 	if (is_sparse) {
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2020, NVIDIA Corporation.  All Rights Reserved.
+ * Copyright (c) 2018-2021, NVIDIA Corporation.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -161,6 +161,22 @@ fail:
 	return err;
 }
 
+static tegrabl_error_t fm_get_path(struct tegrabl_fm_handle *handle, const char *file_path,
+								   char *path, size_t path_size)
+{
+	if ((strlen(handle->mount_path) + strlen(file_path)) >= path_size) {
+		pr_error("Destination buffer is insufficient to hold file path\n");
+		return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 0x2);
+	}
+	memset(path, '\0', path_size);
+	strcpy(path, handle->mount_path);
+	strcat(path, file_path);
+
+	pr_info("rootfs path: %s\n", path);
+
+	return TEGRABL_NO_ERROR;
+}
+
 tegrabl_error_t tegrabl_fm_read_partition(struct tegrabl_bdev *bdev,
 										  char *partition_name,
 										  void *load_address,
@@ -263,16 +279,10 @@ tegrabl_error_t tegrabl_fm_read(struct tegrabl_fm_handle *handle,
 	}
 
 	/* Load file from FS */
-	if ((strlen(handle->mount_path) + strlen(file_path)) >= sizeof(path)) {
-		pr_error("Destination buffer is insufficient to hold file path\n");
-		err = TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 0x2);
+	err = fm_get_path(handle, file_path, path, sizeof(path));
+	if (err != TEGRABL_NO_ERROR) {
 		goto load_from_partition;
 	}
-	memset(path, '\0', ARRAY_SIZE(path));
-	strcpy(path, handle->mount_path);
-	strcat(path, file_path);
-
-	pr_info("rootfs path: %s\n", path);
 
 	status = fs_open_file(path, &fh);
 	if (status != 0x0) {
@@ -331,6 +341,174 @@ fail:
 	return err;
 }
 
+static tegrabl_error_t fm_read_partition_sg(struct tegrabl_bdev *bdev,
+											 char *partition_name,
+											 uint64_t offset,
+											 const struct tegrabl_fm_sg_entry *sg,
+											 uint32_t sg_count,
+											 uint64_t *bytes_read)
+{
+	struct tegrabl_partition partition;
+	uint64_t partition_size;
+	uint64_t chunk;
+	uint32_t i;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	err = tegrabl_partition_lookup_bdev(partition_name, &partition, bdev);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("Cannot open partition %s\n", partition_name);
+		TEGRABL_SET_HIGHEST_MODULE(err);
+		goto fail;
+	}
+
+	partition_size = tegrabl_partition_size(&partition);
+	if (offset > partition_size) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0x5);
+		goto fail;
+	}
+
+	err = tegrabl_partition_seek(&partition, (int64_t)offset, TEGRABL_PARTITION_SEEK_SET);
+	if (err != TEGRABL_NO_ERROR) {
+		TEGRABL_SET_HIGHEST_MODULE(err);
+		goto fail;
+	}
+
+	for (i = 0; (i < sg_count) && (offset < partition_size); i++) {
+		chunk = MIN((uint64_t)sg[i].size, partition_size - offset);
+		if (chunk == 0U) {
+			continue;
+		}
+		err = tegrabl_partition_read(&partition, sg[i].load_address, chunk);
+		if (err != TEGRABL_NO_ERROR) {
+			pr_error("Error reading partition %s\n", partition_name);
+			TEGRABL_SET_HIGHEST_MODULE(err);
+			goto fail;
+		}
+		offset += chunk;
+		*bytes_read += chunk;
+	}
+
+fail:
+	return err;
+}
+
+tegrabl_error_t tegrabl_fm_read_sg(struct tegrabl_fm_handle *handle,
+								   char *file_path,
+								   char *partition_name,
+								   uint64_t offset,
+								   const struct tegrabl_fm_sg_entry *sg,
+								   uint32_t sg_count,
+								   uint64_t *bytes_read,
+								   bool *is_file_loaded_from_fs)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	char path[200];
+	filehandle *fh = NULL;
+	struct fs_iovec *iov = NULL;
+	ssize_t status = 0x0;
+	uint32_t i;
+
+	pr_trace("%s(): %u\n", __func__, __LINE__);
+
+	if (is_file_loaded_from_fs != NULL) {
+		*is_file_loaded_from_fs = false;
+	}
+
+	if ((handle == NULL) || (sg == NULL) || (sg_count == 0U) || (bytes_read == NULL)) {
+		pr_error("Invalid args passed\n");
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0x6);
+		goto fail;
+	}
+	*bytes_read = 0;
+
+	if ((file_path == NULL) || (handle->mount_path == NULL)) {
+		goto load_from_partition;
+	}
+
+	err = fm_get_path(handle, file_path, path, sizeof(path));
+	if (err != TEGRABL_NO_ERROR) {
+		goto load_from_partition;
+	}
+
+	status = fs_open_file(path, &fh);
+	if (status != 0x0) {
+		pr_error("file %s open failed!!\n", path);
+		err = TEGRABL_ERROR(TEGRABL_ERR_OPEN_FAILED, 0x2);
+		goto load_from_partition;
+	}
+
+	iov = tegrabl_malloc(sg_count * sizeof(*iov));
+	if (iov == NULL) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0x1);
+		goto fail;
+	}
+	for (i = 0; i < sg_count; i++) {
+		iov[i].base = sg[i].load_address;
+		iov[i].len = sg[i].size;
+	}
+
+	status = fs_read_file_iov(fh, iov, sg_count, offset);
+	if (status < 0) {
+		pr_error("file %s read failed!!\n", path);
+		err = TEGRABL_ERROR(TEGRABL_ERR_READ_FAILED, 0x2);
+		goto load_from_partition;
+	}
+
+	*bytes_read = (uint64_t)status;
+	if (is_file_loaded_from_fs) {
+		*is_file_loaded_from_fs = true;
+	}
+	err = TEGRABL_NO_ERROR;
+
+	goto fail;
+
+load_from_partition:
+	if (partition_name == NULL) {
+		goto fail;
+	}
+
+	pr_info("Fallback: Loading from %s partition of %s device ...\n",
+			partition_name,
+			tegrabl_blockdev_get_name(tegrabl_blockdev_get_storage_type(handle->bdev)));
+	*bytes_read = 0;
+	err = fm_read_partition_sg(handle->bdev, partition_name, offset, sg, sg_count, bytes_read);
+
+fail:
+	tegrabl_free(iov);
+	if (fh != NULL) {
+		fs_close_file(fh);
+	}
+	return err;
+}
+
+tegrabl_error_t tegrabl_fm_read_range(struct tegrabl_fm_handle *handle,
+									  char *file_path,
+									  char *partition_name,
+									  uint64_t offset,
+									  void *load_address,
+									  uint32_t *size,
+									  bool *is_file_loaded_from_fs)
+{
+	struct tegrabl_fm_sg_entry sg;
+	uint64_t bytes_read = 0;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if (size == NULL) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0x7);
+	}
+
+	sg.load_address = load_address;
+	sg.size = *size;
+
+	err = tegrabl_fm_read_sg(handle, file_path, partition_name, offset, &sg, 1,
+							 &bytes_read, is_file_loaded_from_fs);
+	if (err == TEGRABL_NO_ERROR) {
+		*size = (uint32_t)bytes_read;
+	}
+
+	return err;
+}
+
 /**
 * @brief Unmount the filesystem and freeup memory.
 *
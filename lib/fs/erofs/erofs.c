@@ -0,0 +1,607 @@
+/*
+ * Copyright (c) 2023, NVIDIA Corporation.  All Rights Reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property and
+ * proprietary rights in and to this software and related documentation.  Any
+ * use, reproduction, disclosure or distribution of this software and related
+ * documentation without an express license agreement from NVIDIA Corporation
+ * is strictly prohibited.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <err.h>
+#include <trace.h>
+#include <fs.h>
+#include <erofs_fs.h>
+#include <erofs_priv.h>
+#include <tegrabl_utils.h>
+#include <tegrabl_blockdev.h>
+
+#define LOCAL_TRACE    0
+
+/* limit on symlinks followed during one path walk */
+#define EROFS_MAX_SYMLINKS    8
+
+int erofs_dev_read(erofs_t *erofs, uint64_t pos, void *buf, size_t len)
+{
+    tegrabl_error_t error;
+
+    error = tegrabl_blockdev_read(erofs->dev, buf, erofs->fs_offset + pos, len);
+    if (error != TEGRABL_NO_ERROR) {
+        TRACEF("Failed to read %zu bytes at 0x%llx\n", len, (unsigned long long)pos);
+        return ERR_GENERIC;
+    }
+
+    return 0;
+}
+
+const uint8_t *erofs_meta_block(erofs_t *erofs, uint64_t blkaddr)
+{
+    if (erofs->meta_valid && (erofs->meta_blkaddr == blkaddr)) {
+        return erofs->meta_buf;
+    }
+
+    erofs->meta_valid = false;
+    if (erofs_dev_read(erofs, blkaddr << erofs->super_blk.blkszbits, erofs->meta_buf, erofs->blksz) < 0) {
+        return NULL;
+    }
+    erofs->meta_blkaddr = blkaddr;
+    erofs->meta_valid = true;
+
+    return erofs->meta_buf;
+}
+
+static int erofs_load_inode(erofs_t *erofs, uint64_t nid, erofs_inode_t *inode)
+{
+    union {
+        struct erofs_inode_compact c;
+        struct erofs_inode_extended e;
+    } di;
+    uint16_t format;
+    uint16_t xattr_icount;
+    uint32_t chunkformat;
+    int err;
+
+    memset(inode, 0, sizeof(*inode));
+    inode->erofs = erofs;
+    inode->nid = nid;
+
+    err = erofs_dev_read(erofs, erofs_iloc(inode), &di.c, sizeof(di.c));
+    if (err < 0) {
+        return err;
+    }
+
+    format = di.c.i_format;
+    if (format & ~EROFS_I_ALL) {
+        TRACEF("nid %llu: unsupported i_format 0x%x\n", (unsigned long long)nid, format);
+        return ERR_NOT_SUPPORTED;
+    }
+
+    inode->datalayout = (format >> EROFS_I_DATALAYOUT_SHIFT) & EROFS_I_DATALAYOUT_MASK;
+    if (inode->datalayout > EROFS_INODE_CHUNK_BASED) {
+        TRACEF("nid %llu: unsupported data layout %u\n", (unsigned long long)nid, inode->datalayout);
+        return ERR_NOT_SUPPORTED;
+    }
+
+    if ((format & EROFS_I_VERSION_MASK) == EROFS_INODE_LAYOUT_EXTENDED) {
+        err = erofs_dev_read(erofs, erofs_iloc(inode), &di.e, sizeof(di.e));
+        if (err < 0) {
+            return err;
+        }
+        inode->inode_isize = sizeof(struct erofs_inode_extended);
+        inode->mode = di.e.i_mode;
+        inode->size = di.e.i_size;
+        inode->i_u = di.e.i_u;
+        xattr_icount = di.e.i_xattr_icount;
+    } else {
+        inode->inode_isize = sizeof(struct erofs_inode_compact);
+        inode->mode = di.c.i_mode;
+        inode->size = di.c.i_size;
+        inode->i_u = di.c.i_u;
+        xattr_icount = di.c.i_xattr_icount;
+    }
+
+    inode->xattr_isize = 0;
+    if (xattr_icount != 0) {
+        inode->xattr_isize = EROFS_XATTR_IBODY_HDR_SIZE + (xattr_icount - 1U) * EROFS_XATTR_ENTRY_SIZE;
+    }
+
+    if (inode->datalayout == EROFS_INODE_CHUNK_BASED) {
+        chunkformat = inode->i_u & 0xFFFFU;
+        if (chunkformat & ~EROFS_CHUNK_FORMAT_ALL) {
+            TRACEF("nid %llu: unsupported chunk format 0x%x\n", (unsigned long long)nid, chunkformat);
+            return ERR_NOT_SUPPORTED;
+        }
+    }
+
+    LTRACEF("nid %llu mode 0%o layout %u size %llu\n", (unsigned long long)nid, inode->mode,
+            inode->datalayout, (unsigned long long)inode->size);
+
+    return 0;
+}
+
+/* map an offset of an uncompressed file to a contiguous on-disk range */
+static int erofs_map_flat(erofs_inode_t *inode, off_t offset, uint64_t *pa, uint64_t *plen, bool *mapped)
+{
+    erofs_t *erofs = inode->erofs;
+    uint8_t blkszbits = erofs->super_blk.blkszbits;
+    uint64_t data_end = erofs_iloc(inode) + inode->inode_isize + inode->xattr_isize;
+    uint64_t lastblk;
+    uint64_t tail_len;
+    uint32_t chunkformat;
+    uint32_t chunkbits;
+    uint32_t unit;
+    uint64_t chunknr;
+    uint64_t ipos;
+    uint64_t chunk_end;
+    uint32_t blkaddr;
+    const uint8_t *blk;
+    const struct erofs_inode_chunk_index *idx;
+
+    *mapped = true;
+
+    switch (inode->datalayout) {
+    case EROFS_INODE_FLAT_PLAIN:
+        *pa = ((uint64_t)inode->i_u << blkszbits) + offset;
+        *plen = inode->size - offset;
+        return 0;
+
+    case EROFS_INODE_FLAT_INLINE:
+        /* every block but the last lives at raw_blkaddr, the tail right after the inode */
+        lastblk = DIV_CEIL_LOG2(inode->size, blkszbits) - 1;
+        if (offset < (lastblk << blkszbits)) {
+            *pa = ((uint64_t)inode->i_u << blkszbits) + offset;
+            *plen = (lastblk << blkszbits) - offset;
+            return 0;
+        }
+        tail_len = inode->size - (lastblk << blkszbits);
+        if (MOD_LOG2(data_end, blkszbits) + tail_len > erofs->blksz) {
+            TRACEF("nid %llu: inline tail crosses a block\n", (unsigned long long)inode->nid);
+            return ERR_NOT_VALID;
+        }
+        *pa = data_end + (offset - (lastblk << blkszbits));
+        *plen = inode->size - offset;
+        return 0;
+
+    case EROFS_INODE_CHUNK_BASED:
+        chunkformat = inode->i_u & 0xFFFFU;
+        chunkbits = blkszbits + (chunkformat & EROFS_CHUNK_FORMAT_BLKBITS_MASK);
+        unit = (chunkformat & EROFS_CHUNK_FORMAT_INDEXES) ?
+               sizeof(struct erofs_inode_chunk_index) : EROFS_BLOCK_MAP_ENTRY_SIZE;
+        chunknr = offset >> chunkbits;
+        ipos = ROUND_UP_POW2(data_end, unit) + unit * chunknr;
+
+        /* entries are naturally aligned, so never straddle a block */
+        blk = erofs_meta_block(erofs, ipos >> blkszbits);
+        if (blk == NULL) {
+            return ERR_GENERIC;
+        }
+        blk += MOD_LOG2(ipos, blkszbits);
+
+        if (unit == EROFS_BLOCK_MAP_ENTRY_SIZE) {
+            memcpy(&blkaddr, blk, sizeof(blkaddr));
+        } else {
+            idx = (const struct erofs_inode_chunk_index *)blk;
+            blkaddr = idx->blkaddr;
+            if ((blkaddr != EROFS_NULL_ADDR) && (erofs->super_blk.extra_devices != 0) &&
+                (idx->device_id != 0)) {
+                TRACEF("nid %llu: chunk on extra device %u\n", (unsigned long long)inode->nid,
+                       idx->device_id);
+                return ERR_NOT_SUPPORTED;
+            }
+        }
+
+        chunk_end = MIN((chunknr + 1) << chunkbits, inode->size);
+        *plen = chunk_end - offset;
+        if (blkaddr == EROFS_NULL_ADDR) {
+            *mapped = false;
+            *pa = 0;
+        } else {
+            *pa = ((uint64_t)blkaddr << blkszbits) + (offset - (chunknr << chunkbits));
+        }
+        return 0;
+
+    default:
+        return ERR_NOT_SUPPORTED;
+    }
+}
+
+static int erofs_read_data(erofs_inode_t *inode, void *buf, off_t offset, size_t len)
+{
+    uint8_t *dst = buf;
+    uint64_t pa;
+    uint64_t plen;
+    bool mapped;
+    size_t n;
+    int err;
+
+    if ((inode->datalayout == EROFS_INODE_COMPRESSED_FULL) ||
+        (inode->datalayout == EROFS_INODE_COMPRESSED_COMPACT)) {
+        return erofs_z_read(inode, dst, offset, len);
+    }
+
+    while (len > 0) {
+        err = erofs_map_flat(inode, offset, &pa, &plen, &mapped);
+        if (err < 0) {
+            return err;
+        }
+
+        n = MIN(len, plen);
+        if (mapped) {
+            err = erofs_dev_read(inode->erofs, pa, dst, n);
+            if (err < 0) {
+                return err;
+            }
+        } else {
+            memset(dst, 0, n);
+        }
+
+        dst += n;
+        offset += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+static int erofs_namecmp(const char *name, size_t namelen, const uint8_t *dname, size_t dnamelen)
+{
+    int ret;
+
+    ret = memcmp(name, dname, MIN(namelen, dnamelen));
+    if (ret != 0) {
+        return ret;
+    }
+
+    return (namelen > dnamelen) - (namelen < dnamelen);
+}
+
+/* look up one path component; dirents are sorted by name within and across blocks */
+static int erofs_dir_lookup(erofs_inode_t *dir, const char *name, size_t namelen, uint64_t *nid)
+{
+    erofs_t *erofs = dir->erofs;
+    const struct erofs_dirent *de;
+    uint8_t *buf;
+    off_t pos;
+    size_t blklen;
+    uint32_t ndirents;
+    uint32_t nameoff;
+    uint32_t nameend;
+    int lo;
+    int hi;
+    int mid;
+    int cmp;
+    int err = ERR_NOT_FOUND;
+
+    LTRACEF("dir nid %llu, name '%.*s'\n", (unsigned long long)dir->nid, (int)namelen, name);
+
+    if (!EROFS_S_ISDIR(dir->mode)) {
+        return ERR_NOT_DIR;
+    }
+
+    buf = malloc(erofs->blksz);
+    if (buf == NULL) {
+        TRACEF("Failed to allocate memory for dir block\n");
+        return ERR_NO_MEMORY;
+    }
+    de = (const struct erofs_dirent *)buf;
+
+    for (pos = 0; pos < dir->size; pos += erofs->blksz) {
+        blklen = MIN(erofs->blksz, dir->size - pos);
+        err = erofs_read_data(dir, buf, pos, blklen);
+        if (err < 0) {
+            goto done;
+        }
+
+        nameoff = de[0].nameoff;
+        if ((blklen < sizeof(struct erofs_dirent)) || (nameoff < sizeof(struct erofs_dirent)) ||
+            (nameoff >= blklen)) {
+            TRACEF("dir nid %llu: bad dirent block at %llu\n", (unsigned long long)dir->nid,
+                   (unsigned long long)pos);
+            err = ERR_NOT_VALID;
+            goto done;
+        }
+        ndirents = nameoff / sizeof(struct erofs_dirent);
+
+        lo = 0;
+        hi = ndirents - 1;
+        while (lo <= hi) {
+            mid = lo + ((hi - lo) / 2);
+            nameoff = de[mid].nameoff;
+            if (mid + 1 < (int)ndirents) {
+                nameend = de[mid + 1].nameoff;
+            } else {
+                nameend = nameoff + strnlen((const char *)buf + nameoff, blklen - nameoff);
+            }
+            if ((nameoff > nameend) || (nameend > blklen)) {
+                TRACEF("dir nid %llu: bad dirent %d\n", (unsigned long long)dir->nid, mid);
+                err = ERR_NOT_VALID;
+                goto done;
+            }
+
+            cmp = erofs_namecmp(name, namelen, buf + nameoff, nameend - nameoff);
+            if (cmp == 0) {
+                *nid = de[mid].nid;
+                err = 0;
+                goto done;
+            } else if (cmp < 0) {
+                hi = mid - 1;
+            } else {
+                lo = mid + 1;
+            }
+        }
+
+        /* sorts before the first name of this block, so it is in no later block either */
+        if (lo == 0) {
+            break;
+        }
+    }
+    err = ERR_NOT_FOUND;
+
+done:
+    free(buf);
+    return err;
+}
+
+/* resolve a path to an inode, following symlinks */
+static int erofs_walk(erofs_t *erofs, const char *_path, erofs_inode_t *inode)
+{
+    char path[FS_MAX_PATH_LEN];
+    char link[FS_MAX_PATH_LEN];
+    erofs_inode_t cur;
+    const char *ptr;
+    const char *comp;
+    size_t linklen;
+    size_t restlen;
+    uint64_t nid;
+    uint32_t links = 0;
+    int err;
+
+    if (strlcpy(path, _path, sizeof(path)) >= sizeof(path)) {
+        return ERR_BAD_PATH;
+    }
+
+    err = erofs_load_inode(erofs, erofs->super_blk.root_nid, &cur);
+    if (err < 0) {
+        return err;
+    }
+
+    ptr = path;
+    while (true) {
+        while (*ptr == '/') {
+            ptr++;
+        }
+        if (*ptr == '\0') {
+            break;
+        }
+
+        comp = ptr;
+        while ((*ptr != '\0') && (*ptr != '/')) {
+            ptr++;
+        }
+
+        err = erofs_dir_lookup(&cur, comp, ptr - comp, &nid);
+        if (err < 0) {
+            return err;
+        }
+
+        err = erofs_load_inode(erofs, nid, inode);
+        if (err < 0) {
+            return err;
+        }
+
+        if (!EROFS_S_ISLNK(inode->mode)) {
+            memcpy(&cur, inode, sizeof(cur));
+            continue;
+        }
+
+        /* splice the link target in front of the rest of the path and start over */
+        if (++links > EROFS_MAX_SYMLINKS) {
+            return ERR_RECURSE_TOO_DEEP;
+        }
+        linklen = inode->size;
+        restlen = strlen(ptr);
+        if ((linklen == 0) || (linklen + restlen >= sizeof(link))) {
+            return ERR_BAD_PATH;
+        }
+        err = erofs_read_data(inode, link, 0, linklen);
+        if (err < 0) {
+            return err;
+        }
+        memcpy(link + linklen, ptr, restlen + 1);
+        memcpy(path, link, linklen + restlen + 1);
+        ptr = path;
+
+        LTRACEF("symlink, continuing with '%s'\n", path);
+
+        if (path[0] == '/') {
+            err = erofs_load_inode(erofs, erofs->super_blk.root_nid, &cur);
+            if (err < 0) {
+                return err;
+            }
+        }
+    }
+
+    memcpy(inode, &cur, sizeof(cur));
+
+    return 0;
+}
+
+status_t erofs_mount(struct tegrabl_bdev *dev, uint64_t start_sector, fscookie **cookie)
+{
+    erofs_t *erofs = NULL;
+    erofs_inode_t root;
+    int err = 0;
+
+    LTRACEF("dev %p\n", dev);
+
+    if (!dev) {
+        return ERR_NOT_FOUND;
+    }
+
+    erofs = malloc(sizeof(erofs_t));
+    if (erofs == NULL) {
+        TRACEF("Failed to allocate memory for erofs priv data object\n");
+        return ERR_NO_MEMORY;
+    }
+    memset(erofs, 0, sizeof(erofs_t));
+    erofs->dev = dev;
+    erofs->fs_offset = start_sector * TEGRABL_BLOCKDEV_BLOCK_SIZE(dev);
+
+    err = erofs_dev_read(erofs, EROFS_SUPER_OFFSET, &erofs->super_blk, sizeof(struct erofs_super_block));
+    if (err < 0) {
+        TRACEF("Failed to read superblock\n");
+        goto err;
+    }
+
+    if (erofs->super_blk.magic != EROFS_SUPER_MAGIC_V1) {
+        err = ERR_NOT_VALID;
+        goto err;
+    }
+
+    LTRACEF("block size bits %u\n", erofs->super_blk.blkszbits);
+    LTRACEF("incompat features 0x%x\n", erofs->super_blk.feature_incompat);
+    LTRACEF("meta blkaddr %u\n", erofs->super_blk.meta_blkaddr);
+    LTRACEF("root nid %u\n", erofs->super_blk.root_nid);
+
+    if ((erofs->super_blk.blkszbits < EROFS_MIN_BLKSZBITS) ||
+        (erofs->super_blk.blkszbits > EROFS_MAX_BLKSZBITS)) {
+        TRACEF("Unsupported block size bits %u\n", erofs->super_blk.blkszbits);
+        err = ERR_NOT_SUPPORTED;
+        goto err;
+    }
+
+    if (erofs->super_blk.feature_incompat & ~EROFS_ALL_FEATURE_INCOMPAT) {
+        TRACEF("Unsupported incompat features, 0x%08x\n", erofs->super_blk.feature_incompat);
+        err = ERR_NOT_SUPPORTED;
+        goto err;
+    }
+
+    if (erofs->super_blk.dirblkbits != 0) {
+        TRACEF("Unsupported directory block size\n");
+        err = ERR_NOT_SUPPORTED;
+        goto err;
+    }
+
+    erofs->blksz = 1U << erofs->super_blk.blkszbits;
+    erofs->meta_base = (uint64_t)erofs->super_blk.meta_blkaddr << erofs->super_blk.blkszbits;
+
+    erofs->meta_buf = malloc(erofs->blksz);
+    if (erofs->meta_buf == NULL) {
+        TRACEF("Failed to allocate memory for metadata block\n");
+        err = ERR_NO_MEMORY;
+        goto err;
+    }
+
+    err = erofs_load_inode(erofs, erofs->super_blk.root_nid, &root);
+    if (err < 0) {
+        goto err;
+    }
+    if (!EROFS_S_ISDIR(root.mode)) {
+        TRACEF("Root inode is not a directory\n");
+        err = ERR_NOT_VALID;
+        goto err;
+    }
+
+    *cookie = (fscookie *)erofs;
+
+    return 0;
+
+err:
+    LTRACEF("exiting with err code %d\n", err);
+    free(erofs->meta_buf);
+    free(erofs);
+
+    return err;
+}
+
+status_t erofs_unmount(fscookie *cookie)
+{
+    erofs_t *erofs = (erofs_t *)cookie;
+
+    free(erofs->dbuf);
+    free(erofs->cbuf);
+    free(erofs->meta_buf);
+    free(erofs);
+
+    return 0;
+}
+
+status_t erofs_open_file(fscookie *cookie, const char *path, filecookie **fcookie)
+{
+    erofs_t *erofs = (erofs_t *)cookie;
+    erofs_inode_t *inode;
+    int err;
+
+    inode = malloc(sizeof(erofs_inode_t));
+    if (inode == NULL) {
+        TRACEF("Failed to allocate memory for file object\n");
+        return ERR_NO_MEMORY;
+    }
+
+    err = erofs_walk(erofs, path, inode);
+    if (err < 0) {
+        TRACEF("'%s' lookup failed\n", path);
+        free(inode);
+        return err;
+    }
+
+    *fcookie = (filecookie *)inode;
+
+    return 0;
+}
+
+ssize_t erofs_read_file(filecookie *fcookie, void *buf, off_t offset, size_t len)
+{
+    erofs_inode_t *inode = (erofs_inode_t *)fcookie;
+    int err;
+
+    LTRACEF("nid %llu offset %llu len %zu\n", (unsigned long long)inode->nid,
+            (unsigned long long)offset, len);
+
+    if (!EROFS_S_ISREG(inode->mode)) {
+        TRACEF("not a file, mode: 0x%04x\n", inode->mode);
+        return ERR_NOT_FILE;
+    }
+
+    if (offset >= inode->size) {
+        return 0;
+    }
+    len = MIN(len, inode->size - offset);
+
+    err = erofs_read_data(inode, buf, offset, len);
+    if (err < 0) {
+        return err;
+    }
+
+    return len;
+}
+
+status_t erofs_stat_file(filecookie *fcookie, struct file_stat *stat)
+{
+    erofs_inode_t *inode = (erofs_inode_t *)fcookie;
+
+    stat->size = inode->size;
+    stat->is_dir = EROFS_S_ISDIR(inode->mode);
+
+    return 0;
+}
+
+status_t erofs_close_file(filecookie *fcookie)
+{
+    free(fcookie);
+
+    return 0;
+}
+
+static const struct fs_api erofs_api = {
+    .mount = erofs_mount,
+    .unmount = erofs_unmount,
+    .open = erofs_open_file,
+    .stat = erofs_stat_file,
+    .read = erofs_read_file,
+    .close = erofs_close_file,
+};
+
+STATIC_FS_IMPL(erofs, &erofs_api);
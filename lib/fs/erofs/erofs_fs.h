@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2023, NVIDIA Corporation.  All Rights Reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property and
+ * proprietary rights in and to this software and related documentation.  Any
+ * use, reproduction, disclosure or distribution of this software and related
+ * documentation without an express license agreement from NVIDIA Corporation
+ * is strictly prohibited.
+ */
+
+#ifndef __EROFS_FS_H
+#define __EROFS_FS_H
+
+#include <stdint.h>
+#include <tegrabl_compiler.h>
+
+/*
+ * EROFS on-disk format. All fields are little endian.
+ */
+
+#define EROFS_SUPER_MAGIC_V1            0xE0F5E1E2U
+#define EROFS_SUPER_OFFSET              1024
+
+#define EROFS_MIN_BLKSZBITS             9
+#define EROFS_MAX_BLKSZBITS             16
+
+/* Incompatible feature flags */
+#define EROFS_FEATURE_INCOMPAT_ZERO_PADDING     0x00000001
+#define EROFS_FEATURE_INCOMPAT_COMPR_CFGS       0x00000002
+#define EROFS_FEATURE_INCOMPAT_BIG_PCLUSTER     0x00000002
+#define EROFS_FEATURE_INCOMPAT_CHUNKED_FILE     0x00000004
+#define EROFS_FEATURE_INCOMPAT_DEVICE_TABLE     0x00000008
+#define EROFS_FEATURE_INCOMPAT_COMPR_HEAD2      0x00000008
+#define EROFS_FEATURE_INCOMPAT_ZTAILPACKING     0x00000010
+#define EROFS_FEATURE_INCOMPAT_FRAGMENTS        0x00000020
+#define EROFS_FEATURE_INCOMPAT_DEDUPE           0x00000020
+#define EROFS_FEATURE_INCOMPAT_XATTR_PREFIXES   0x00000040
+#define EROFS_ALL_FEATURE_INCOMPAT              0x0000007F
+
+/**
+ * @brief EROFS superblock, located at EROFS_SUPER_OFFSET
+ */
+TEGRABL_PACKED(
+struct erofs_super_block {
+    uint32_t magic;                 /* EROFS_SUPER_MAGIC_V1 */
+    uint32_t checksum;              /* crc32c of the superblock block */
+    uint32_t feature_compat;
+    uint8_t blkszbits;              /* log2 of the filesystem block size */
+    uint8_t sb_extslots;
+    uint16_t root_nid;              /* nid of the root directory */
+    uint64_t inos;                  /* total valid inode count */
+    uint64_t build_time;
+    uint32_t build_time_nsec;
+    uint32_t blocks;                /* total blocks */
+    uint32_t meta_blkaddr;          /* start block of the metadata (inode) area */
+    uint32_t xattr_blkaddr;         /* start block of the shared xattr area */
+    uint8_t uuid[16];
+    uint8_t volume_name[16];
+    uint32_t feature_incompat;
+    uint16_t available_compr_algs;  /* lz4_max_distance if !COMPR_CFGS */
+    uint16_t extra_devices;
+    uint16_t devt_slotoff;
+    uint8_t dirblkbits;
+    uint8_t xattr_prefix_count;
+    uint32_t xattr_prefix_start;
+    uint64_t packed_nid;
+    uint8_t reserved[24];
+});
+
+TEGRABL_COMPILE_ASSERT(sizeof(struct erofs_super_block) == 128, "Incorrect size");
+
+/* Inode data layouts, encoded in bits 1-3 of i_format */
+#define EROFS_INODE_FLAT_PLAIN              0
+#define EROFS_INODE_COMPRESSED_FULL         1
+#define EROFS_INODE_FLAT_INLINE             2
+#define EROFS_INODE_COMPRESSED_COMPACT      3
+#define EROFS_INODE_CHUNK_BASED             4
+
+#define EROFS_I_VERSION_MASK                0x01
+#define EROFS_I_DATALAYOUT_SHIFT            1
+#define EROFS_I_DATALAYOUT_MASK             0x07
+#define EROFS_I_ALL                         0x0F
+
+#define EROFS_INODE_LAYOUT_COMPACT          0
+#define EROFS_INODE_LAYOUT_EXTENDED         1
+
+#define EROFS_ISLOTBITS                     5   /* nids are in 32-byte slots */
+
+/* Chunk-based file format, stored in i_u of the inode */
+#define EROFS_CHUNK_FORMAT_BLKBITS_MASK     0x001F
+#define EROFS_CHUNK_FORMAT_INDEXES          0x0020
+#define EROFS_CHUNK_FORMAT_ALL              (EROFS_CHUNK_FORMAT_BLKBITS_MASK | EROFS_CHUNK_FORMAT_INDEXES)
+
+#define EROFS_NULL_ADDR                     0xFFFFFFFFU
+
+/**
+ * @brief Compact (v1) inode, 32 bytes
+ */
+TEGRABL_PACKED(
+struct erofs_inode_compact {
+    uint16_t i_format;      /* version and data layout */
+    uint16_t i_xattr_icount;
+    uint16_t i_mode;
+    uint16_t i_nlink;
+    uint32_t i_size;
+    uint32_t i_reserved;
+    uint32_t i_u;           /* raw_blkaddr, compressed_blocks or chunk format */
+    uint32_t i_ino;
+    uint16_t i_uid;
+    uint16_t i_gid;
+    uint32_t i_reserved2;
+});
+
+TEGRABL_COMPILE_ASSERT(sizeof(struct erofs_inode_compact) == 32, "Incorrect size");
+
+/**
+ * @brief Extended (v2) inode, 64 bytes
+ */
+TEGRABL_PACKED(
+struct erofs_inode_extended {
+    uint16_t i_format;      /* version and data layout */
+    uint16_t i_xattr_icount;
+    uint16_t i_mode;
+    uint16_t i_reserved;
+    uint64_t i_size;
+    uint32_t i_u;           /* raw_blkaddr, compressed_blocks or chunk format */
+    uint32_t i_ino;
+    uint32_t i_uid;
+    uint32_t i_gid;
+    uint64_t i_mtime;
+    uint32_t i_mtime_nsec;
+    uint32_t i_nlink;
+    uint8_t i_reserved2[16];
+});
+
+TEGRABL_COMPILE_ASSERT(sizeof(struct erofs_inode_extended) == 64, "Incorrect size");
+
+/* in-inode xattrs: a 12-byte header followed by (i_xattr_icount - 1) 4-byte slots */
+#define EROFS_XATTR_IBODY_HDR_SIZE          12
+#define EROFS_XATTR_ENTRY_SIZE              4
+
+/**
+ * @brief Chunk index entry of a chunk-based file with EROFS_CHUNK_FORMAT_INDEXES
+ */
+TEGRABL_PACKED(
+struct erofs_inode_chunk_index {
+    uint16_t advise;
+    uint16_t device_id;     /* 0 for the primary device */
+    uint32_t blkaddr;       /* EROFS_NULL_ADDR for a hole */
+});
+
+TEGRABL_COMPILE_ASSERT(sizeof(struct erofs_inode_chunk_index) == 8, "Incorrect size");
+
+/* chunk map entry of a chunk-based file without indexes */
+#define EROFS_BLOCK_MAP_ENTRY_SIZE          4
+
+/**
+ * @brief Directory entry. A directory block starts with an array of these,
+ *        followed by the (not NUL terminated) names, sorted by name.
+ */
+TEGRABL_PACKED(
+struct erofs_dirent {
+    uint64_t nid;
+    uint16_t nameoff;       /* offset of the name from the start of the block */
+    uint8_t file_type;
+    uint8_t reserved;
+});
+
+TEGRABL_COMPILE_ASSERT(sizeof(struct erofs_dirent) == 12, "Incorrect size");
+
+/* Compression algorithms */
+#define Z_EROFS_COMPRESSION_LZ4             0
+
+/* h_advise of the compression map header */
+#define Z_EROFS_ADVISE_COMPACTED_2B         0x0001
+#define Z_EROFS_ADVISE_BIG_PCLUSTER_1       0x0002
+#define Z_EROFS_ADVISE_BIG_PCLUSTER_2       0x0004
+#define Z_EROFS_ADVISE_INLINE_PCLUSTER      0x0008
+#define Z_EROFS_ADVISE_INTERLACED_PCLUSTER  0x0010
+#define Z_EROFS_ADVISE_FRAGMENT_PCLUSTER    0x0020
+
+#define Z_EROFS_FRAGMENT_INODE_BIT          7
+
+/**
+ * @brief Compression map header, 8-byte aligned after the inode and its xattrs
+ */
+TEGRABL_PACKED(
+struct z_erofs_map_header {
+    uint32_t h_fragmentoff;     /* h_idata_size in the upper half for ztailpacking */
+    uint16_t h_advise;
+    uint8_t h_algorithmtype;    /* bits 0-3: HEAD1 algorithm, bits 4-7: HEAD2 algorithm */
+    uint8_t h_clusterbits;      /* bits 0-2: lcluster bits - block size bits */
+});
+
+TEGRABL_COMPILE_ASSERT(sizeof(struct z_erofs_map_header) == 8, "Incorrect size");
+
+/* Logical cluster types */
+#define Z_EROFS_LCLUSTER_TYPE_PLAIN         0
+#define Z_EROFS_LCLUSTER_TYPE_HEAD1         1
+#define Z_EROFS_LCLUSTER_TYPE_NONHEAD       2
+#define Z_EROFS_LCLUSTER_TYPE_HEAD2         3
+#define Z_EROFS_LCLUSTER_TYPE_MASK          0x0003
+
+#define Z_EROFS_LI_PARTIAL_REF              (1U << 15)
+/* set in delta[0] of the first NONHEAD lcluster to carry the pcluster block count */
+#define Z_EROFS_LI_D0_CBLKCNT               (1U << 11)
+
+/**
+ * @brief Logical cluster index of the full (non compacted) layout
+ */
+TEGRABL_PACKED(
+struct z_erofs_lcluster_index {
+    uint16_t di_advise;         /* lcluster type in bits 0-1 */
+    uint16_t di_clusterofs;     /* where the head pcluster starts in this lcluster */
+    union {
+        uint32_t blkaddr;       /* HEAD/PLAIN: start block of the pcluster */
+        uint16_t delta[2];      /* NONHEAD: distance to the head, distance to the next head */
+    } di_u;
+});
+
+TEGRABL_COMPILE_ASSERT(sizeof(struct z_erofs_lcluster_index) == 8, "Incorrect size");
+
+#endif
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2023, NVIDIA Corporation.  All Rights Reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property and
+ * proprietary rights in and to this software and related documentation.  Any
+ * use, reproduction, disclosure or distribution of this software and related
+ * documentation without an express license agreement from NVIDIA Corporation
+ * is strictly prohibited.
+ */
+
+#ifndef __EROFS_PRIV_H
+#define __EROFS_PRIV_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <fs.h>
+#include <erofs_fs.h>
+#include <tegrabl_blockdev.h>
+
+#define EROFS_S_IFMT    0170000
+#define EROFS_S_IFDIR   0040000
+#define EROFS_S_IFREG   0100000
+#define EROFS_S_IFLNK   0120000
+
+#define EROFS_S_ISDIR(mode) (((mode) & EROFS_S_IFMT) == EROFS_S_IFDIR)
+#define EROFS_S_ISREG(mode) (((mode) & EROFS_S_IFMT) == EROFS_S_IFREG)
+#define EROFS_S_ISLNK(mode) (((mode) & EROFS_S_IFMT) == EROFS_S_IFLNK)
+
+/**
+ * @brief Mounted EROFS instance
+ */
+typedef struct {
+    struct tegrabl_bdev *dev;
+    off_t fs_offset;                /* byte offset of the filesystem on dev */
+    struct erofs_super_block super_blk;
+    uint32_t blksz;
+    uint64_t meta_base;             /* byte address of the inode area */
+
+    /* one cached metadata block, used for lcluster index lookups */
+    uint8_t *meta_buf;
+    uint64_t meta_blkaddr;
+    bool meta_valid;
+
+    /* staging buffer for compressed pclusters */
+    uint8_t *cbuf;
+    size_t cbuf_size;
+
+    /* last decompressed extent, reused while reads stay inside it */
+    uint8_t *dbuf;
+    size_t dbuf_size;
+    uint64_t dbuf_nid;
+    off_t dbuf_la;
+    size_t dbuf_len;                /* decoded bytes valid in dbuf */
+} erofs_t;
+
+/**
+ * @brief In-memory inode
+ */
+typedef struct {
+    erofs_t *erofs;
+    uint64_t nid;
+    uint16_t mode;
+    uint8_t datalayout;
+    uint8_t inode_isize;
+    uint32_t xattr_isize;
+    uint64_t size;
+    uint32_t i_u;                   /* raw_blkaddr, compressed_blocks or chunk format */
+
+    /* compression map header, loaded on first compressed read */
+    bool z_inited;
+    uint16_t z_advise;
+    uint8_t z_algorithmtype[2];
+    uint8_t z_lclusterbits;
+} erofs_inode_t;
+
+/**
+ * @brief Byte address of an inode
+ */
+static inline uint64_t erofs_iloc(const erofs_inode_t *inode)
+{
+    return inode->erofs->meta_base + (inode->nid << EROFS_ISLOTBITS);
+}
+
+/**
+ * @brief Read bytes from the device at a filesystem relative byte address
+ *
+ * @param erofs EROFS private structure
+ * @param pos Byte address
+ * @param buf Destination buffer
+ * @param len Number of bytes
+ *
+ * @return returns 0 for no error, otherwise appropriate error code
+ */
+int erofs_dev_read(erofs_t *erofs, uint64_t pos, void *buf, size_t len);
+
+/**
+ * @brief Return the cached copy of a metadata block, reading it if needed
+ *
+ * @param erofs EROFS private structure
+ * @param blkaddr Block number
+ *
+ * @return pointer to the block contents or NULL on read failure
+ */
+const uint8_t *erofs_meta_block(erofs_t *erofs, uint64_t blkaddr);
+
+/**
+ * @brief Read a byte range of a compressed file
+ *
+ * @param inode Inode of the file, with COMPRESSED_FULL or COMPRESSED_COMPACT layout
+ * @param buf Destination buffer
+ * @param offset Offset in the file, less than the file size
+ * @param len Number of bytes, not going past the end of the file
+ *
+ * @return returns 0 for no error, otherwise appropriate error code
+ */
+int erofs_z_read(erofs_inode_t *inode, uint8_t *buf, off_t offset, size_t len);
+
+status_t erofs_mount(struct tegrabl_bdev *dev, uint64_t start_sector, fscookie **cookie);
+status_t erofs_unmount(fscookie *cookie);
+status_t erofs_open_file(fscookie *cookie, const char *path, filecookie **fcookie);
+ssize_t erofs_read_file(filecookie *fcookie, void *buf, off_t offset, size_t len);
+status_t erofs_stat_file(filecookie *fcookie, struct file_stat *stat);
+status_t erofs_close_file(filecookie *fcookie);
+
+#endif
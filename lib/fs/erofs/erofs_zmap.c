@@ -0,0 +1,730 @@
+/*
+ * Copyright (c) 2023, NVIDIA Corporation.  All Rights Reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property and
+ * proprietary rights in and to this software and related documentation.  Any
+ * use, reproduction, disclosure or distribution of this software and related
+ * documentation without an express license agreement from NVIDIA Corporation
+ * is strictly prohibited.
+ */
+
+/*
+ * Compressed file support. A compressed file is split into fixed-size logical
+ * clusters (lclusters); each lcluster has an index entry telling whether a
+ * physical cluster (pcluster) starts in it (HEAD/PLAIN) and where, or how far
+ * back the head is (NONHEAD). Every pcluster is an independent LZ4 block (or
+ * stored uncompressed for PLAIN), so any byte range is served by reading and
+ * decoding only the pclusters that cover it.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <err.h>
+#include <trace.h>
+#include <erofs_fs.h>
+#include <erofs_priv.h>
+#include <tegrabl_utils.h>
+#include "lz4.h"
+
+#define LOCAL_TRACE    0
+
+struct z_erofs_maprecorder {
+    erofs_inode_t *inode;
+    uint64_t lcn;
+    uint8_t type;
+    uint8_t headtype;
+    bool partialref;
+    uint32_t clusterofs;
+    uint32_t delta[2];
+    uint32_t pblk;
+    uint32_t compressedblks;
+    off_t la;
+};
+
+/**
+ * @brief One pcluster and the file range it decodes to
+ */
+struct z_erofs_map {
+    off_t la;               /* first file byte of the extent */
+    uint64_t llen;          /* decompressed length */
+    uint64_t pa;            /* byte address of the pcluster */
+    uint64_t plen;          /* pcluster length */
+    uint8_t headtype;
+};
+
+static inline uint64_t z_erofs_index_base(erofs_inode_t *inode)
+{
+    return ROUND_UP_POW2(erofs_iloc(inode) + inode->inode_isize + inode->xattr_isize, 8ULL);
+}
+
+static inline uint64_t z_erofs_lcluster_count(erofs_inode_t *inode)
+{
+    return DIV_CEIL_LOG2(inode->size, inode->z_lclusterbits);
+}
+
+static int z_erofs_fill_inode(erofs_inode_t *inode)
+{
+    erofs_t *erofs = inode->erofs;
+    uint8_t blkszbits = erofs->super_blk.blkszbits;
+    struct z_erofs_map_header h;
+    const uint8_t *blk;
+    uint64_t pos;
+
+    if (inode->z_inited) {
+        return 0;
+    }
+
+    pos = z_erofs_index_base(inode);
+    blk = erofs_meta_block(erofs, pos >> blkszbits);
+    if (blk == NULL) {
+        return ERR_GENERIC;
+    }
+    memcpy(&h, blk + MOD_LOG2(pos, blkszbits), sizeof(h));
+
+    if ((h.h_clusterbits >> Z_EROFS_FRAGMENT_INODE_BIT) ||
+        (h.h_advise & (Z_EROFS_ADVISE_INLINE_PCLUSTER | Z_EROFS_ADVISE_FRAGMENT_PCLUSTER))) {
+        TRACEF("nid %llu: tail packing and fragments are not supported\n", (unsigned long long)inode->nid);
+        return ERR_NOT_SUPPORTED;
+    }
+
+    inode->z_advise = h.h_advise;
+    inode->z_algorithmtype[0] = h.h_algorithmtype & 0x0F;
+    inode->z_algorithmtype[1] = h.h_algorithmtype >> 4;
+    inode->z_lclusterbits = blkszbits + (h.h_clusterbits & 0x07);
+
+    if (!(erofs->super_blk.feature_incompat & EROFS_FEATURE_INCOMPAT_BIG_PCLUSTER) &&
+        (inode->z_advise & (Z_EROFS_ADVISE_BIG_PCLUSTER_1 | Z_EROFS_ADVISE_BIG_PCLUSTER_2))) {
+        TRACEF("nid %llu: big pcluster without the feature\n", (unsigned long long)inode->nid);
+        return ERR_NOT_VALID;
+    }
+
+    if ((inode->datalayout == EROFS_INODE_COMPRESSED_COMPACT) &&
+        (!(inode->z_advise & Z_EROFS_ADVISE_BIG_PCLUSTER_1) ^
+         !(inode->z_advise & Z_EROFS_ADVISE_BIG_PCLUSTER_2))) {
+        TRACEF("nid %llu: inconsistent big pcluster heads\n", (unsigned long long)inode->nid);
+        return ERR_NOT_VALID;
+    }
+
+    LTRACEF("nid %llu advise 0x%x algorithms %u/%u lclusterbits %u\n", (unsigned long long)inode->nid,
+            inode->z_advise, inode->z_algorithmtype[0], inode->z_algorithmtype[1], inode->z_lclusterbits);
+
+    inode->z_inited = true;
+
+    return 0;
+}
+
+static int z_erofs_load_full_lcluster(struct z_erofs_maprecorder *m, uint64_t lcn)
+{
+    erofs_inode_t *inode = m->inode;
+    uint8_t blkszbits = inode->erofs->super_blk.blkszbits;
+    struct z_erofs_lcluster_index di;
+    const uint8_t *blk;
+    uint64_t pos;
+
+    pos = z_erofs_index_base(inode) + sizeof(struct z_erofs_map_header) + 8 +
+          lcn * sizeof(struct z_erofs_lcluster_index);
+    blk = erofs_meta_block(inode->erofs, pos >> blkszbits);
+    if (blk == NULL) {
+        return ERR_GENERIC;
+    }
+    memcpy(&di, blk + MOD_LOG2(pos, blkszbits), sizeof(di));
+
+    m->lcn = lcn;
+    m->type = di.di_advise & Z_EROFS_LCLUSTER_TYPE_MASK;
+    if (m->type == Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+        m->clusterofs = 1U << inode->z_lclusterbits;
+        m->delta[0] = di.di_u.delta[0];
+        if (m->delta[0] & Z_EROFS_LI_D0_CBLKCNT) {
+            if (!(inode->z_advise & (Z_EROFS_ADVISE_BIG_PCLUSTER_1 | Z_EROFS_ADVISE_BIG_PCLUSTER_2))) {
+                return ERR_NOT_VALID;
+            }
+            m->compressedblks = m->delta[0] & ~Z_EROFS_LI_D0_CBLKCNT;
+            m->delta[0] = 1;
+        }
+        m->delta[1] = di.di_u.delta[1];
+    } else {
+        m->partialref = !!(di.di_advise & Z_EROFS_LI_PARTIAL_REF);
+        m->clusterofs = di.di_clusterofs;
+        if (m->clusterofs >= (1U << inode->z_lclusterbits)) {
+            return ERR_NOT_VALID;
+        }
+        m->pblk = di.di_u.blkaddr;
+    }
+
+    return 0;
+}
+
+static uint32_t z_erofs_decode_compactedbits(uint32_t lobits, const uint8_t *in, uint32_t pos, uint8_t *type)
+{
+    uint32_t v;
+
+    memcpy(&v, in + pos / 8, sizeof(v));
+    v >>= pos & 7;
+    *type = (v >> lobits) & 3;
+
+    return v & ((1U << lobits) - 1);
+}
+
+/* distance from lcluster i of a pack to the next head, used for lookahead */
+static uint32_t z_erofs_compacted_la_distance(uint32_t lobits, uint32_t encodebits, uint32_t vcnt,
+                                              const uint8_t *in, uint32_t i)
+{
+    uint32_t lo = 0;
+    uint32_t d1 = 0;
+    uint8_t type;
+
+    do {
+        lo = z_erofs_decode_compactedbits(lobits, in, encodebits * i, &type);
+        if (type != Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+            return d1;
+        }
+        ++d1;
+    } while (++i < vcnt);
+
+    /* the last NONHEAD of a pack stores delta[1] rather than delta[0] */
+    if (!(lo & Z_EROFS_LI_D0_CBLKCNT)) {
+        d1 += lo - 1;
+    }
+
+    return d1;
+}
+
+/*
+ * Compacted indexes are packed vcnt at a time: vcnt lo/type bitfields followed
+ * by the 32-bit block address of the first pcluster of the pack. Block
+ * addresses of later heads are recovered by counting pclusters in the pack.
+ */
+static int z_erofs_unpack_compacted_index(struct z_erofs_maprecorder *m, uint32_t amortizedshift,
+                                          uint64_t pos, bool lookahead)
+{
+    erofs_inode_t *inode = m->inode;
+    uint8_t blkszbits = inode->erofs->super_blk.blkszbits;
+    uint32_t lclusterbits = inode->z_lclusterbits;
+    bool big_pcluster = !!(inode->z_advise & Z_EROFS_ADVISE_BIG_PCLUSTER_1);
+    uint32_t vcnt;
+    uint32_t lobits;
+    uint32_t encodebits;
+    uint32_t eofs;
+    uint32_t base;
+    uint32_t lo;
+    uint32_t nblk;
+    uint32_t pblk;
+    uint8_t type;
+    const uint8_t *blk;
+    const uint8_t *in;
+    int i;
+
+    if (((1U << amortizedshift) == 4) && (lclusterbits <= 14)) {
+        vcnt = 2;
+    } else if (((1U << amortizedshift) == 2) && (lclusterbits <= 12)) {
+        vcnt = 16;
+    } else {
+        return ERR_NOT_SUPPORTED;
+    }
+
+    blk = erofs_meta_block(inode->erofs, pos >> blkszbits);
+    if (blk == NULL) {
+        return ERR_GENERIC;
+    }
+
+    lobits = MAX(lclusterbits, 12U);
+    encodebits = (((vcnt << amortizedshift) - sizeof(uint32_t)) * 8) / vcnt;
+    eofs = MOD_LOG2(pos, blkszbits);
+    base = ROUND_DOWN_POW2(eofs, vcnt << amortizedshift);
+    in = blk + base;
+    i = (eofs - base) >> amortizedshift;
+
+    lo = z_erofs_decode_compactedbits(lobits, in, encodebits * i, &type);
+    m->type = type;
+    if (type == Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+        m->clusterofs = 1U << lclusterbits;
+
+        if (lookahead) {
+            m->delta[1] = z_erofs_compacted_la_distance(lobits, encodebits, vcnt, in, i);
+        }
+
+        if (lo & Z_EROFS_LI_D0_CBLKCNT) {
+            if (!big_pcluster) {
+                return ERR_NOT_VALID;
+            }
+            m->compressedblks = lo & ~Z_EROFS_LI_D0_CBLKCNT;
+            m->delta[0] = 1;
+            return 0;
+        } else if ((uint32_t)(i + 1) != vcnt) {
+            m->delta[0] = lo;
+            return 0;
+        }
+
+        /* the last lcluster of a pack keeps delta[1]; derive delta[0] from its neighbour */
+        lo = z_erofs_decode_compactedbits(lobits, in, encodebits * (i - 1), &type);
+        if (type != Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+            lo = 0;
+        } else if (lo & Z_EROFS_LI_D0_CBLKCNT) {
+            lo = 1;
+        }
+        m->delta[0] = lo + 1;
+        return 0;
+    }
+
+    m->clusterofs = lo;
+    m->delta[0] = 0;
+
+    /* count the pclusters ahead of this head within the pack */
+    if (!big_pcluster) {
+        nblk = 1;
+        while (i > 0) {
+            --i;
+            lo = z_erofs_decode_compactedbits(lobits, in, encodebits * i, &type);
+            if (type == Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+                i -= lo;
+            }
+            if (i >= 0) {
+                ++nblk;
+            }
+        }
+    } else {
+        nblk = 0;
+        while (i > 0) {
+            --i;
+            lo = z_erofs_decode_compactedbits(lobits, in, encodebits * i, &type);
+            if (type == Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+                if (lo & Z_EROFS_LI_D0_CBLKCNT) {
+                    --i;
+                    nblk += lo & ~Z_EROFS_LI_D0_CBLKCNT;
+                    continue;
+                }
+                /* a big pcluster never has a plain delta[0] of 1 */
+                if (lo <= 1) {
+                    return ERR_NOT_VALID;
+                }
+                i -= lo - 2;
+                continue;
+            }
+            ++nblk;
+        }
+    }
+
+    memcpy(&pblk, in + (vcnt << amortizedshift) - sizeof(uint32_t), sizeof(pblk));
+    m->pblk = pblk + nblk;
+
+    return 0;
+}
+
+static int z_erofs_load_compact_lcluster(struct z_erofs_maprecorder *m, uint64_t lcn, bool lookahead)
+{
+    erofs_inode_t *inode = m->inode;
+    uint64_t ebase = z_erofs_index_base(inode) + sizeof(struct z_erofs_map_header);
+    uint64_t totalidx = z_erofs_lcluster_count(inode);
+    uint64_t compacted_4b_initial;
+    uint64_t compacted_2b;
+    uint32_t amortizedshift;
+    uint64_t pos;
+
+    m->lcn = lcn;
+
+    /* 4-byte packs come first until the 2-byte packs can start 32-byte aligned */
+    compacted_4b_initial = (32 - (ebase % 32)) / 4;
+    if (compacted_4b_initial == 32 / 4) {
+        compacted_4b_initial = 0;
+    }
+
+    if ((inode->z_advise & Z_EROFS_ADVISE_COMPACTED_2B) && (compacted_4b_initial < totalidx)) {
+        compacted_2b = ROUND_DOWN(totalidx - compacted_4b_initial, 16);
+    } else {
+        compacted_2b = 0;
+    }
+
+    pos = ebase;
+    if (lcn < compacted_4b_initial) {
+        amortizedshift = 2;
+        goto out;
+    }
+    pos += compacted_4b_initial * 4;
+    lcn -= compacted_4b_initial;
+
+    if (lcn < compacted_2b) {
+        amortizedshift = 1;
+        goto out;
+    }
+    pos += compacted_2b * 2;
+    lcn -= compacted_2b;
+    amortizedshift = 2;
+
+out:
+    pos += lcn << amortizedshift;
+
+    return z_erofs_unpack_compacted_index(m, amortizedshift, pos, lookahead);
+}
+
+static int z_erofs_load_lcluster(struct z_erofs_maprecorder *m, uint64_t lcn, bool lookahead)
+{
+    erofs_inode_t *inode = m->inode;
+
+    if (lcn >= z_erofs_lcluster_count(inode)) {
+        TRACEF("nid %llu: lcluster %llu out of range\n", (unsigned long long)inode->nid,
+               (unsigned long long)lcn);
+        return ERR_NOT_VALID;
+    }
+
+    if (inode->datalayout == EROFS_INODE_COMPRESSED_FULL) {
+        return z_erofs_load_full_lcluster(m, lcn);
+    }
+
+    return z_erofs_load_compact_lcluster(m, lcn, lookahead);
+}
+
+/* walk back from a NONHEAD lcluster to the head of its pcluster */
+static int z_erofs_extent_lookback(struct z_erofs_maprecorder *m, uint32_t lookback_distance)
+{
+    uint32_t lclusterbits = m->inode->z_lclusterbits;
+    uint64_t lcn;
+    int err;
+
+    while (m->lcn >= lookback_distance) {
+        lcn = m->lcn - lookback_distance;
+        err = z_erofs_load_lcluster(m, lcn, false);
+        if (err < 0) {
+            return err;
+        }
+
+        switch (m->type) {
+        case Z_EROFS_LCLUSTER_TYPE_NONHEAD:
+            lookback_distance = m->delta[0];
+            if (lookback_distance == 0) {
+                return ERR_NOT_VALID;
+            }
+            continue;
+        case Z_EROFS_LCLUSTER_TYPE_PLAIN:
+        case Z_EROFS_LCLUSTER_TYPE_HEAD1:
+        case Z_EROFS_LCLUSTER_TYPE_HEAD2:
+            m->headtype = m->type;
+            m->la = (lcn << lclusterbits) | m->clusterofs;
+            return 0;
+        default:
+            return ERR_NOT_VALID;
+        }
+    }
+
+    return ERR_NOT_VALID;
+}
+
+static int z_erofs_get_extent_compressedlen(struct z_erofs_maprecorder *m, struct z_erofs_map *map)
+{
+    erofs_inode_t *inode = m->inode;
+    uint8_t blkszbits = inode->erofs->super_blk.blkszbits;
+    uint32_t lclusterbits = inode->z_lclusterbits;
+    bool bigpcl1 = !!(inode->z_advise & Z_EROFS_ADVISE_BIG_PCLUSTER_1);
+    bool bigpcl2 = !!(inode->z_advise & Z_EROFS_ADVISE_BIG_PCLUSTER_2);
+    uint64_t lcn = m->lcn + 1;
+    int err;
+
+    if (((m->headtype == Z_EROFS_LCLUSTER_TYPE_HEAD1) && !bigpcl1) ||
+        (((m->headtype == Z_EROFS_LCLUSTER_TYPE_PLAIN) || (m->headtype == Z_EROFS_LCLUSTER_TYPE_HEAD2)) &&
+         !bigpcl2) ||
+        ((lcn << lclusterbits) >= inode->size)) {
+        map->plen = 1ULL << lclusterbits;
+        return 0;
+    }
+
+    if (m->compressedblks == 0) {
+        err = z_erofs_load_lcluster(m, lcn, false);
+        if (err < 0) {
+            return err;
+        }
+
+        switch (m->type) {
+        case Z_EROFS_LCLUSTER_TYPE_PLAIN:
+        case Z_EROFS_LCLUSTER_TYPE_HEAD1:
+        case Z_EROFS_LCLUSTER_TYPE_HEAD2:
+            /* next lcluster starts a new pcluster, so this one is a single lcluster */
+            m->compressedblks = 1U << (lclusterbits - blkszbits);
+            break;
+        case Z_EROFS_LCLUSTER_TYPE_NONHEAD:
+            if ((m->delta[0] == 1) && (m->compressedblks != 0)) {
+                break;
+            }
+            return ERR_NOT_VALID;
+        default:
+            return ERR_NOT_VALID;
+        }
+    }
+
+    map->plen = (uint64_t)m->compressedblks << blkszbits;
+
+    return 0;
+}
+
+static int z_erofs_get_extent_decompressedlen(struct z_erofs_maprecorder *m, struct z_erofs_map *map)
+{
+    erofs_inode_t *inode = m->inode;
+    uint32_t lclusterbits = inode->z_lclusterbits;
+    uint64_t lcn = m->lcn;
+    uint64_t headlcn = map->la >> lclusterbits;
+    int err;
+
+    do {
+        /* the last pcluster has no following head */
+        if ((lcn << lclusterbits) >= inode->size) {
+            map->llen = inode->size - map->la;
+            return 0;
+        }
+
+        err = z_erofs_load_lcluster(m, lcn, true);
+        if (err < 0) {
+            return err;
+        }
+
+        if (m->type == Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+            if ((m->delta[1] == 0) && (m->clusterofs != (1U << lclusterbits))) {
+                return ERR_NOT_VALID;
+            }
+        } else {
+            /* go on until the next head */
+            if (lcn != headlcn) {
+                break;
+            }
+            m->delta[1] = 1;
+        }
+        lcn += m->delta[1];
+    } while (m->delta[1] != 0);
+
+    map->llen = (lcn << lclusterbits) + m->clusterofs - map->la;
+
+    return 0;
+}
+
+/* find the pcluster covering file offset la */
+static int z_erofs_map_blocks(erofs_inode_t *inode, off_t la, struct z_erofs_map *map)
+{
+    struct z_erofs_maprecorder m;
+    uint32_t lclusterbits = inode->z_lclusterbits;
+    uint64_t initial_lcn = la >> lclusterbits;
+    uint32_t endoff = MOD_LOG2(la, lclusterbits);
+    uint8_t algorithm;
+    int err;
+
+    memset(&m, 0, sizeof(m));
+    m.inode = inode;
+
+    err = z_erofs_load_lcluster(&m, initial_lcn, false);
+    if (err < 0) {
+        return err;
+    }
+
+    switch (m.type) {
+    case Z_EROFS_LCLUSTER_TYPE_PLAIN:
+    case Z_EROFS_LCLUSTER_TYPE_HEAD1:
+    case Z_EROFS_LCLUSTER_TYPE_HEAD2:
+        if (endoff >= m.clusterofs) {
+            m.headtype = m.type;
+            m.la = (m.lcn << lclusterbits) | m.clusterofs;
+            break;
+        }
+        /* offset sits before the head in this lcluster, so it belongs to the previous pcluster */
+        if (m.lcn == 0) {
+            return ERR_NOT_VALID;
+        }
+        err = z_erofs_extent_lookback(&m, 1);
+        break;
+    case Z_EROFS_LCLUSTER_TYPE_NONHEAD:
+        err = z_erofs_extent_lookback(&m, m.delta[0]);
+        break;
+    default:
+        err = ERR_NOT_VALID;
+        break;
+    }
+    if (err < 0) {
+        return err;
+    }
+
+    if (m.partialref) {
+        TRACEF("nid %llu: deduplicated pclusters are not supported\n", (unsigned long long)inode->nid);
+        return ERR_NOT_SUPPORTED;
+    }
+
+    map->la = m.la;
+    map->pa = (uint64_t)m.pblk << inode->erofs->super_blk.blkszbits;
+    map->headtype = m.headtype;
+
+    err = z_erofs_get_extent_compressedlen(&m, map);
+    if (err < 0) {
+        return err;
+    }
+
+    err = z_erofs_get_extent_decompressedlen(&m, map);
+    if (err < 0) {
+        return err;
+    }
+
+    if (map->headtype != Z_EROFS_LCLUSTER_TYPE_PLAIN) {
+        algorithm = inode->z_algorithmtype[(map->headtype == Z_EROFS_LCLUSTER_TYPE_HEAD2) ? 1 : 0];
+        if (algorithm != Z_EROFS_COMPRESSION_LZ4) {
+            TRACEF("nid %llu: unsupported compression algorithm %u\n", (unsigned long long)inode->nid,
+                   algorithm);
+            return ERR_NOT_SUPPORTED;
+        }
+    }
+
+    LTRACEF("la %llu -> extent la %llu llen %llu pa 0x%llx plen %llu type %u\n", (unsigned long long)la,
+            (unsigned long long)map->la, (unsigned long long)map->llen, (unsigned long long)map->pa,
+            (unsigned long long)map->plen, map->headtype);
+
+    if ((map->la > la) || (map->la + map->llen <= (uint64_t)la)) {
+        return ERR_NOT_VALID;
+    }
+
+    return 0;
+}
+
+/* copy out of an uncompressed pcluster */
+static int z_erofs_read_plain(erofs_inode_t *inode, struct z_erofs_map *map, uint8_t *buf, size_t skip, size_t n)
+{
+    erofs_t *erofs = inode->erofs;
+    uint8_t blkszbits = erofs->super_blk.blkszbits;
+    uint32_t ofs;
+    size_t right;
+    int err;
+
+    if (!(inode->z_advise & Z_EROFS_ADVISE_INTERLACED_PCLUSTER)) {
+        if (skip + n > map->plen) {
+            return ERR_NOT_VALID;
+        }
+        return erofs_dev_read(erofs, map->pa + skip, buf, n);
+    }
+
+    /* interlaced: a single block, rotated so that it starts at the in-block offset of la */
+    if ((map->plen > erofs->blksz) || (map->llen > erofs->blksz)) {
+        return ERR_NOT_VALID;
+    }
+    ofs = MOD_LOG2(map->la + skip, blkszbits);
+    right = MIN(erofs->blksz - ofs, n);
+    err = erofs_dev_read(erofs, map->pa + ofs, buf, right);
+    if ((err < 0) || (right == n)) {
+        return err;
+    }
+
+    return erofs_dev_read(erofs, map->pa, buf + right, n - right);
+}
+
+static int z_erofs_grow_buf(uint8_t **buf, size_t *size, size_t need)
+{
+    if (*size >= need) {
+        return 0;
+    }
+
+    free(*buf);
+    *size = 0;
+    *buf = malloc(need);
+    if (*buf == NULL) {
+        TRACEF("Failed to allocate %zu bytes\n", need);
+        return ERR_NO_MEMORY;
+    }
+    *size = need;
+
+    return 0;
+}
+
+/* decode the part of an LZ4 pcluster needed for [skip, skip + n) of the extent */
+static int z_erofs_read_lz4(erofs_inode_t *inode, struct z_erofs_map *map, uint8_t *buf, size_t skip, size_t n)
+{
+    erofs_t *erofs = inode->erofs;
+    size_t need = skip + n;
+    size_t margin = 0;
+    uint8_t *dst;
+    bool direct;
+    int ret;
+    int err;
+
+    if ((erofs->dbuf_len >= need) && (erofs->dbuf_nid == inode->nid) && (erofs->dbuf_la == map->la)) {
+        memcpy(buf, erofs->dbuf + skip, n);
+        return 0;
+    }
+
+    /*
+     * The LZ4 decoder needs room for the whole extent even when it stops
+     * early, so decode straight into the caller's buffer only when the
+     * request covers the extent.
+     */
+    direct = (skip == 0) && (n == map->llen);
+    if (!direct) {
+        erofs->dbuf_len = 0;
+        err = z_erofs_grow_buf(&erofs->dbuf, &erofs->dbuf_size, map->llen);
+        if (err < 0) {
+            return err;
+        }
+    }
+
+    err = z_erofs_grow_buf(&erofs->cbuf, &erofs->cbuf_size, map->plen);
+    if (err < 0) {
+        return err;
+    }
+    err = erofs_dev_read(erofs, map->pa, erofs->cbuf, map->plen);
+    if (err < 0) {
+        return err;
+    }
+
+    /* with zero padding the compressed data is right-aligned in the pcluster */
+    if (erofs->super_blk.feature_incompat & EROFS_FEATURE_INCOMPAT_ZERO_PADDING) {
+        while ((margin < MIN(map->plen, erofs->blksz)) && (erofs->cbuf[margin] == 0)) {
+            margin++;
+        }
+        if (margin >= map->plen) {
+            return ERR_NOT_VALID;
+        }
+    }
+
+    dst = direct ? buf : erofs->dbuf;
+    ret = LZ4_decompress_safe_partial((const char *)erofs->cbuf + margin, (char *)dst,
+                                      map->plen - margin, need, map->llen);
+    if ((ret < 0) || ((size_t)ret < need)) {
+        TRACEF("nid %llu: LZ4 decode of extent at %llu failed (%d)\n", (unsigned long long)inode->nid,
+               (unsigned long long)map->la, ret);
+        return ERR_NOT_VALID;
+    }
+
+    if (!direct) {
+        erofs->dbuf_nid = inode->nid;
+        erofs->dbuf_la = map->la;
+        erofs->dbuf_len = ret;
+        memcpy(buf, erofs->dbuf + skip, n);
+    }
+
+    return 0;
+}
+
+int erofs_z_read(erofs_inode_t *inode, uint8_t *buf, off_t offset, size_t len)
+{
+    struct z_erofs_map map;
+    off_t end = offset + len;
+    size_t skip;
+    size_t n;
+    int err;
+
+    err = z_erofs_fill_inode(inode);
+    if (err < 0) {
+        return err;
+    }
+
+    while (offset < end) {
+        err = z_erofs_map_blocks(inode, offset, &map);
+        if (err < 0) {
+            return err;
+        }
+
+        skip = offset - map.la;
+        n = MIN(end, map.la + map.llen) - offset;
+        if (map.headtype == Z_EROFS_LCLUSTER_TYPE_PLAIN) {
+            err = z_erofs_read_plain(inode, &map, buf, skip, n);
+        } else {
+            err = z_erofs_read_lz4(inode, &map, buf, skip, n);
+        }
+        if (err < 0) {
+            return err;
+        }
+
+        buf += n;
+        offset += n;
+    }
+
+    return 0;
+}
@@ -0,0 +1,12 @@
+LOCAL_DIR := $(GET_LOCAL_DIR)
+
+MODULE := $(LOCAL_DIR)
+
+MODULE_DEPS += \
+	$(LOCAL_DIR)/../../decompress
+
+MODULE_SRCS += \
+	$(LOCAL_DIR)/erofs.c \
+	$(LOCAL_DIR)/erofs_zmap.c
+
+include make/module.mk
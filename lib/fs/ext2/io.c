@@ -23,6 +23,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <err.h>
 #include <trace.h>
 #include <ext2_priv.h>
 #include <ext2_dinode.h>
@@ -99,7 +100,7 @@ int ext2_get_indirect_block_pointer_cache_block(ext2_t *ext2, struct ext2fs_dino
 {
     uint32_t current_level = 0;
     uint current_block = 0, last_block;
-    blocknum_t *block = NULL;
+    uint32_t *block = NULL;
     int err;
 
     if ((level > 3) || (level == 0)) {
@@ -226,21 +227,35 @@ ssize_t ext2_read_inode(ext2_t *ext2, struct ext2fs_dinode *inode, void *_buf, o
         buf += tocopy;
     }
 
-    /* handle middle blocks */
+    /* handle middle blocks, reading physically contiguous runs straight into the buffer */
     while (len >= E2FS_BLOCK_SIZE(ext2->super_blk)) {
         /* calculate the block and read it */
         blocknum_t phys_block = file_block_to_fs_block(ext2, inode, file_block);
+        size_t run = 1;
+
         if (phys_block == 0) {
             memset(buf, 0, E2FS_BLOCK_SIZE(ext2->super_blk));
         } else {
-            ext2_read_block(ext2, buf, phys_block);
+            while ((len >= ((run + 1) * E2FS_BLOCK_SIZE(ext2->super_blk))) &&
+                   (file_block_to_fs_block(ext2, inode, file_block + run) == (phys_block + run))) {
+                run++;
+            }
+
+            if (run == 1) {
+                ext2_read_block(ext2, buf, phys_block);
+            } else if (tegrabl_blockdev_read(ext2->dev, buf,
+                                             ext2->fs_offset +
+                                                ((off_t)phys_block * E2FS_BLOCK_SIZE(ext2->super_blk)),
+                                             run * E2FS_BLOCK_SIZE(ext2->super_blk)) != TEGRABL_NO_ERROR) {
+                return ERR_GENERIC;
+            }
         }
 
         /* increment our stuff */
-        file_block++;
-        len -= E2FS_BLOCK_SIZE(ext2->super_blk);
-        bytes_read += E2FS_BLOCK_SIZE(ext2->super_blk);
-        buf += E2FS_BLOCK_SIZE(ext2->super_blk);
+        file_block += run;
+        len -= run * E2FS_BLOCK_SIZE(ext2->super_blk);
+        bytes_read += run * E2FS_BLOCK_SIZE(ext2->super_blk);
+        buf += run * E2FS_BLOCK_SIZE(ext2->super_blk);
     }
 
     /* handle partial last block */
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2019-2022, NVIDIA Corporation.  All Rights Reserved.
+ * Copyright (c) 2019-2023, NVIDIA Corporation.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -97,242 +97,225 @@ static inline bool validate_extents_magic(struct ext4_extent_header *extent_head
     return (extent_header->magic == E4FS_EXTENTS_MAGIC) ? true: false;
 }
 
-static int extents_blk_lookup(ext2_t *ext2, struct ext4_extent_header *extent_header, uint32_t num, void *buf)
-{
-    struct ext4_extent *extent = NULL;
-    off_t blk_num = 0;
-    off_t blk_addr;
-    uint16_t i;
-    uint32_t n;
-    int err = 0;
+/* Extents longer than this are uninitialized (preallocated, reads as zero) */
+#define EXT4_EXT_INIT_MAX_LEN    32768U
+/* Bound on the extent tree depth, ext4 itself never goes beyond 5 */
+#define EXT4_EXT_MAX_DEPTH       5U
 
-    LTRACEF("Extent: depth: %u, entries: %u\n", extent_header->depth, extent_header->entries);
-    extent = (struct ext4_extent *)((uintptr_t)extent_header + sizeof(struct ext4_extent_header));
+/**
+ * @brief State of one (offset, length) read through the extent tree
+ */
+struct ext4_read_ctx {
+    ext2_t *ext2;
+    uint8_t *buf;          /* Destination of file byte 'start' */
+    off_t start;           /* First file byte requested */
+    off_t pos;             /* Next file byte to be filled */
+    off_t end;             /* One past the last file byte requested */
+};
 
-    for (i = 0; i < extent_header->entries; i++) {
-        n = extent->block_no + extent->len;
-        if (n > num) {
-            blk_num = extent->start_hi;
-            blk_num = ((blk_num << 32U) | extent->start_lo) + (num - extent->block_no);
-            break;
-        }
-        extent++;
-    }
+static inline bool validate_extents_header(struct ext4_extent_header *extent_header)
+{
+    return validate_extents_magic(extent_header) &&
+           (extent_header->entries <= extent_header->max_entries) &&
+           (extent_header->depth <= EXT4_EXT_MAX_DEPTH);
+}
 
-    blk_addr = blk_num * E2FS_BLOCK_SIZE(ext2->super_blk);
-    blk_addr += ext2->fs_offset;
-    err = tegrabl_blockdev_read(ext2->dev, buf, blk_addr, E2FS_BLOCK_SIZE(ext2->super_blk));
-    if (err != TEGRABL_NO_ERROR) {
-        TRACEF("blockdev read failed, err 0x%08x\n", err);
-        err = ERR_GENERIC;
-        goto fail;
+/* Zero the destination up to file byte 'upto', for holes and uninitialized extents */
+static void ext4_read_fill_zero(struct ext4_read_ctx *ctx, off_t upto)
+{
+    if (upto > ctx->pos) {
+        memset(ctx->buf + (ctx->pos - ctx->start), 0, upto - ctx->pos);
+        ctx->pos = upto;
     }
-
-fail:
-    return err;
 }
 
-static int get_extents_blk(ext2_t *ext2, struct ext2fs_dinode *inode, uint32_t num, void *buf)
+static int ext4_read_leaf(struct ext4_read_ctx *ctx, struct ext4_extent_header *extent_header)
 {
-    struct ext4_extent_header *extent_header = NULL;
-    struct ext4_extent_idx *extent_idx = NULL;
-    off_t blk_addr;
-    int err = 0;
-    void *buf2 = NULL;
+    struct ext4_extent *extent;
+    uint32_t block_size = E2FS_BLOCK_SIZE(ctx->ext2->super_blk);
+    off_t ext_start;
+    off_t ext_end;
+    off_t from;
+    off_t to;
+    off_t data_blk;
+    uint32_t ext_len;
+    bool uninit;
+    uint16_t i;
+    tegrabl_error_t error;
 
-    LTRACE_ENTRY;
+    extent = (struct ext4_extent *)((uintptr_t)extent_header + sizeof(struct ext4_extent_header));
 
-    /* Extract extents info */
-    extent_header = (struct ext4_extent_header *)inode->e2di_blocks;
-    if (extent_header->depth > 0) {
-        /* Read index node */
-        extent_idx =
-            (struct ext4_extent_idx *)((uintptr_t)extent_header + sizeof(struct ext4_extent_header));
-        blk_addr = extent_idx->leaf_hi;
-        blk_addr = ((blk_addr << 32U) | extent_idx->leaf_lo) * E2FS_BLOCK_SIZE(ext2->super_blk);
-        blk_addr += ext2->fs_offset;
-
-        buf2 = tegrabl_memalign(SZ_64K, E2FS_BLOCK_SIZE(ext2->super_blk));
-        if (buf2 == NULL) {
-            err = ERR_NO_MEMORY;
-            TRACEF("Failed to allocate memory for super block\n");
-            goto fail;
+    for (i = 0; i < extent_header->entries; i++, extent++) {
+        ext_len = extent->len;
+        uninit = false;
+        if (ext_len > EXT4_EXT_INIT_MAX_LEN) {
+            ext_len -= EXT4_EXT_INIT_MAX_LEN;
+            uninit = true;
         }
-        err = tegrabl_blockdev_read(ext2->dev, buf2, blk_addr, E2FS_BLOCK_SIZE(ext2->super_blk));
-        if (err != TEGRABL_NO_ERROR) {
-            TRACEF("blockdev read failed\n");
-            err = ERR_GENERIC;
-            goto fail;
+
+        ext_start = (off_t)extent->block_no * block_size;
+        ext_end = ext_start + ((off_t)ext_len * block_size);
+        if (ext_end <= ctx->pos) {
+            continue;
+        }
+        if (ext_start >= ctx->end) {
+            break;
         }
 
-        extents_blk_lookup(ext2, (struct ext4_extent_header *)buf2, num, buf);
+        /* Anything between the previous extent and this one is a hole */
+        ext4_read_fill_zero(ctx, ext_start);
 
-    } else {
-        extents_blk_lookup(ext2, extent_header, num, buf);
-    }
+        from = MAX(ext_start, ctx->pos);
+        to = MIN(ext_end, ctx->end);
+        if (uninit) {
+            ext4_read_fill_zero(ctx, to);
+            continue;
+        }
 
-fail:
-    if (buf2) {
-        free(buf2);
+        data_blk = extent->start_hi;
+        data_blk = (data_blk << 32U) | extent->start_lo;
+        LTRACEF("entry:%u: blk %u, start data blk: %lu, len: %u, bytes %lu..%lu\n",
+                i, extent->block_no, data_blk, ext_len, from, to);
+
+        error = tegrabl_blockdev_read(ctx->ext2->dev, ctx->buf + (from - ctx->start),
+                                      ctx->ext2->fs_offset + (data_blk * block_size) + (from - ext_start),
+                                      to - from);
+        if (error != TEGRABL_NO_ERROR) {
+            TRACEF("blockdev read failed, err 0x%08x\n", error);
+            return ERR_GENERIC;
+        }
+        ctx->pos = to;
     }
 
-    return err;
+    return NO_ERROR;
 }
 
-static int ext4_read_extent(ext2_t *ext2, struct ext4_extent_header *extent_header, void *buf,
-                            off_t *total_bytes_read)
+static int ext4_read_node(struct ext4_read_ctx *ctx, struct ext4_extent_header *extent_header,
+                          uint32_t max_depth)
 {
-    struct ext4_extent *extent = NULL;
-    uint8_t *buf_ptr = NULL;
+    struct ext4_extent_idx *extent_idx;
+    uint32_t block_size = E2FS_BLOCK_SIZE(ctx->ext2->super_blk);
+    off_t idx_start;
+    off_t idx_end;
     off_t blk_addr;
-    off_t extent_len_bytes = 0;
-    off_t bytes_read = 0;
+    void *child = NULL;
     uint16_t i;
-    off_t data_blk;
-    int err = 0;
+    int err = NO_ERROR;
 
-    LTRACE_ENTRY;
+    if (!validate_extents_header(extent_header) || (extent_header->depth > max_depth)) {
+        TRACEF("Invalid extent node\n");
+        return ERR_NOT_VALID;
+    }
 
     LTRACEF("Extent: depth: %u, entries: %u\n", extent_header->depth, extent_header->entries);
-    buf_ptr = (uint8_t *)buf;
-    extent = (struct ext4_extent *)((uintptr_t)extent_header + sizeof(struct ext4_extent_header));
+
+    if (extent_header->depth == 0) {
+        return ext4_read_leaf(ctx, extent_header);
+    }
+
+    extent_idx = (struct ext4_extent_idx *)((uintptr_t)extent_header + sizeof(struct ext4_extent_header));
 
     for (i = 0; i < extent_header->entries; i++) {
-        /* Calculate destination address */
-        buf_ptr = (uint8_t *)(buf + (extent->block_no * E2FS_BLOCK_SIZE(ext2->super_blk)));
-        /* Get block number to which this extent points */
-        data_blk = extent->start_hi;
-        data_blk = (data_blk << 32U) | extent->start_lo;
-        /* Calculate block address */
-        blk_addr = data_blk * E2FS_BLOCK_SIZE(ext2->super_blk);
-        blk_addr += ext2->fs_offset;
-        /* Calculate num of bytes to read */
-        extent_len_bytes = extent->len * E2FS_BLOCK_SIZE(ext2->super_blk);
-        LTRACEF("entry:%u: start data blk: %lu, addr: 0x%lx, len: %u\n", i, data_blk, blk_addr, extent->len);
-        LTRACEF("num bytes to read: %lu, buf ptr: %p\n", extent_len_bytes, buf_ptr);
-        err = tegrabl_blockdev_read(ext2->dev, buf_ptr, blk_addr, extent_len_bytes);
-        if (err != TEGRABL_NO_ERROR) {
+        /* An index node covers file blocks up to where the next one starts */
+        idx_start = (off_t)extent_idx[i].block * block_size;
+        if ((i + 1U) < extent_header->entries) {
+            idx_end = (off_t)extent_idx[i + 1U].block * block_size;
+            if (idx_end <= ctx->pos) {
+                continue;
+            }
+        }
+        if (idx_start >= ctx->end) {
+            break;
+        }
+
+        if (child == NULL) {
+            child = tegrabl_memalign(SZ_64K, block_size);
+            if (child == NULL) {
+                TRACEF("Failed to allocate memory for extent node\n");
+                err = ERR_NO_MEMORY;
+                goto fail;
+            }
+        }
+
+        blk_addr = extent_idx[i].leaf_hi;
+        blk_addr = ((blk_addr << 32U) | extent_idx[i].leaf_lo) * block_size;
+        blk_addr += ctx->ext2->fs_offset;
+        if (tegrabl_blockdev_read(ctx->ext2->dev, child, blk_addr, block_size) != TEGRABL_NO_ERROR) {
             TRACEF("blockdev read failed\n");
             err = ERR_GENERIC;
             goto fail;
         }
-        bytes_read += extent_len_bytes;
-        extent++;
-    }
 
-    if (total_bytes_read) {
-        if (buf_ptr == buf) {
-            *total_bytes_read = bytes_read;
-        } else {
-            *total_bytes_read = ((uintptr_t)buf_ptr + extent_len_bytes) - (uintptr_t)buf;
+        err = ext4_read_node(ctx, (struct ext4_extent_header *)child, extent_header->depth - 1U);
+        if (err != NO_ERROR) {
+            goto fail;
         }
     }
-    LTRACEF("bytes_read %lu\n", *total_bytes_read);
 
 fail:
+    if (child != NULL) {
+        free(child);
+    }
     return err;
 }
 
-static ssize_t ext4_read_data_from_extent(ext2_t *ext2, struct ext2fs_dinode *inode, void *buf, size_t len)
+/**
+ * @brief Read 'len' bytes of an extent mapped inode starting at 'offset'.
+ *        The read is clipped to the file size and holes read back as zero.
+ *
+ * @return number of bytes read, or negative error
+ */
+static ssize_t ext4_read_range(ext2_t *ext2, struct ext2fs_dinode *inode, void *buf, off_t offset, size_t len)
 {
-    struct ext4_extent_header *extent_header = NULL;
-    struct ext4_extent_idx *extent_idx = NULL;
-    off_t blk_addr;
-    off_t bytes_read = 0;
-    uint16_t i;
-    void *buf2;
-    uint8_t *buf_ptr = NULL;
-    off_t total_bytes_read = 0;
-    int err = 0;
-    uint32_t file_len_in_blocks = 0;
-    uint32_t total_blocks_read;
-    uint32_t block_size;
+    struct ext4_read_ctx ctx;
+    off_t file_size;
+    int err;
 
-    LTRACE_ENTRY;
+    LTRACEF("offset %lu, len %zu\n", offset, len);
 
-    if (!validate_extents_magic((struct ext4_extent_header *)inode->e2di_blocks)) {
-        TRACEF("Invalid extents magic\n");
-        err = ERR_NOT_VALID;
-        goto fail;
+    file_size = ext2_file_len(ext2, inode);
+    if (offset >= file_size) {
+        return 0;
     }
-
-    buf_ptr = (uint8_t *)buf;
-    block_size = E2FS_BLOCK_SIZE(ext2->super_blk);
-
-    if (len != 0UL) {
-        file_len_in_blocks = len/block_size;
-        if ((len % block_size) != 0U) {
-            file_len_in_blocks++;
-        }
-        LTRACEF("file_len_in_blocks: %u\n", file_len_in_blocks);
+    if ((off_t)len > (file_size - offset)) {
+        len = file_size - offset;
     }
 
-    /* Extract extents info */
-    extent_header = (struct ext4_extent_header *)inode->e2di_blocks;
-    LTRACEF("Extent: depth: %u, entries: %u\n", extent_header->depth, extent_header->entries);
+    ctx.ext2 = ext2;
+    ctx.buf = (uint8_t *)buf;
+    ctx.start = offset;
+    ctx.pos = offset;
+    ctx.end = offset + len;
 
-    if (extent_header->depth > 0) {
-        for (i = 0; i < extent_header->entries; i++) {
-            /* Read index node */
-            extent_idx =
-                (struct ext4_extent_idx *)((uintptr_t)extent_header + sizeof(struct ext4_extent_header));
-            blk_addr = extent_idx->leaf_hi;
-            blk_addr = ((blk_addr << 32U) | extent_idx->leaf_lo) * E2FS_BLOCK_SIZE(ext2->super_blk);
-            blk_addr += ext2->fs_offset;
-
-            buf2 = tegrabl_memalign(SZ_64K, E2FS_BLOCK_SIZE(ext2->super_blk));
-            if (buf2 == NULL) {
-                err = ERR_NO_MEMORY;
-                TRACEF("Failed to allocate memory for super block\n");
-                goto fail;
-            }
-
-            err = tegrabl_blockdev_read(ext2->dev, buf2, blk_addr, E2FS_BLOCK_SIZE(ext2->super_blk));
-            if (err != TEGRABL_NO_ERROR) {
-                TRACEF("blockdev read failed\n");
-                err = ERR_GENERIC;
-                goto fail;
-            }
-            err = ext4_read_extent(ext2, (struct ext4_extent_header *)buf2, buf_ptr, &bytes_read);
-            total_bytes_read += bytes_read;
-            buf_ptr += bytes_read;
+    err = ext4_read_node(&ctx, (struct ext4_extent_header *)inode->e2di_blocks, EXT4_EXT_MAX_DEPTH);
+    if (err != NO_ERROR) {
+        return err;
+    }
 
-            total_blocks_read = total_bytes_read/block_size;
-            if ((total_bytes_read % block_size) != 0U) {
-                total_blocks_read++;
-            }
+    /* Sparse tail */
+    ext4_read_fill_zero(&ctx, ctx.end);
 
-            /* Check if extra block isn't read */
-            if ((len != 0) && (total_blocks_read > file_len_in_blocks)) {
-                TRACEF("More blocks are read (%u) than file block count (%u)\n",
-                        total_blocks_read, file_len_in_blocks);
-                err = ERR_NOT_VALID;
-                goto fail;
-            }
-        }
-    } else {
-        /* Read leaf node */
-        err = ext4_read_extent(ext2, extent_header, buf_ptr, &bytes_read);
-        total_bytes_read += bytes_read;
+    return (ssize_t)len;
+}
 
-        total_blocks_read = total_bytes_read/block_size;
-        if ((total_bytes_read % block_size) != 0U) {
-            total_blocks_read++;
-        }
+/* Read directory block 'num' into buf */
+static int get_extents_blk(ext2_t *ext2, struct ext2fs_dinode *inode, uint32_t num, void *buf)
+{
+    uint32_t block_size = E2FS_BLOCK_SIZE(ext2->super_blk);
+    ssize_t ret;
 
-        /* Check if extra block isn't read */
-        if ((len != 0) && (total_blocks_read > file_len_in_blocks)) {
-            TRACEF("More blocks are read (%u) than file block count (%u)\n",
-                    total_blocks_read, file_len_in_blocks);
-            err = ERR_NOT_VALID;
-            goto fail;
-        }
+    ret = ext4_read_range(ext2, inode, buf, (off_t)num * block_size, block_size);
+    if (ret < 0) {
+        return (int)ret;
+    }
+    if (ret == 0) {
+        return ERR_NOT_FOUND;
+    }
+    if ((size_t)ret < block_size) {
+        memset((uint8_t *)buf + ret, 0, block_size - ret);
     }
 
-    LTRACEF("err %d, bytes_read %lu\n", err, total_bytes_read);
-
-fail:
-    return err < 0 ? err : (ssize_t)total_bytes_read;
+    return NO_ERROR;
 }
 
 /* Read in the dir, look for the entry */
@@ -444,8 +427,8 @@ static int lookup_linear_dir(ext2_t *ext2, struct ext2fs_dinode *dir_inode, cons
 
     file_blocknum = 0;
     for (;;) {
-        err = ext4_read_data_from_extent(ext2, dir_inode, buf, 0);
-        if (err <= 0) {
+        err = get_extents_blk(ext2, dir_inode, file_blocknum, buf);
+        if (err != NO_ERROR) {
             return -1;
         }
 
@@ -740,12 +723,6 @@ ssize_t ext4_read_file(filecookie *fcookie, void *buf, off_t offset, size_t len)
         return -1;
     }
 
-    /* Offset is not used in this function so it must be 0 */
-    if (offset != 0) {
-        TRACEF("Offset must be 0\n");
-        return -1;
-    }
-
     file = (ext2_file_t *)fcookie;
 
     /* Test that it's a file */
@@ -754,7 +731,12 @@ ssize_t ext4_read_file(filecookie *fcookie, void *buf, off_t offset, size_t len)
         return -1;
     }
 
-    return ext4_read_data_from_extent(file->ext2, &file->inode, buf, len);
+    /* Files converted from ext2/3 keep their indirect block map */
+    if (!IS_EXTENTS(file->inode.e2di_flags)) {
+        return ext2_read_inode(file->ext2, &file->inode, buf, offset, len);
+    }
+
+    return ext4_read_range(file->ext2, &file->inode, buf, offset, len);
 }
 
 static const struct fs_api ext4_api = {
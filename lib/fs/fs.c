@@ -29,6 +29,9 @@
 #include <fs.h>
 #include <ext2_priv.h>
 #include <ext4_priv.h>
+#if defined(CONFIG_ENABLE_EROFS)
+#include <erofs_fs.h>
+#endif
 #include <lk/init.h>
 #include <tegrabl_blockdev.h>
 
@@ -152,6 +155,9 @@ char *fs_detect(struct tegrabl_bdev *dev, uint64_t start_sector)
     ext2_t ext2;
     off_t offset;
     char *fs_type = NULL;
+#if defined(CONFIG_ENABLE_EROFS)
+    uint32_t magic;
+#endif
     tegrabl_error_t err;
 
     offset = (start_sector * TEGRABL_BLOCKDEV_BLOCK_SIZE(dev)) + 1024;
@@ -161,8 +167,19 @@ char *fs_detect(struct tegrabl_bdev *dev, uint64_t start_sector)
         goto fail;
     }
 
+#if defined(CONFIG_ENABLE_EROFS)
+    /* EROFS keeps its superblock at the same offset, magic in the first word */
+    memcpy(&magic, &ext2.super_blk, sizeof(magic));
+    LE32SWAP(magic);
+#endif
     LE32SWAP(ext2.super_blk.e2fs_magic);
 
+#if defined(CONFIG_ENABLE_EROFS)
+    if (magic == EROFS_SUPER_MAGIC_V1) {
+        fs_type = "erofs";
+        LTRACEF("fs type: %s\n", fs_type);
+    } else
+#endif
     if (ext2.super_blk.e2fs_magic == E2FS_MAGIC) {
         fs_type = "ext2";
         if (ext2.super_blk.e2fs_features_incompat & EXT2F_INCOMPAT_EXTENTS) {
@@ -348,6 +365,31 @@ ssize_t fs_read_file(filehandle *handle, void *buf, off_t offset, size_t len)
     return handle->mount->api->read(handle->cookie, buf, offset, len);
 }
 
+ssize_t fs_read_file_iov(filehandle *handle, const struct fs_iovec *iov, uint32_t iovcnt, off_t offset)
+{
+    ssize_t total = 0;
+    ssize_t ret;
+    uint32_t i;
+
+    for (i = 0; i < iovcnt; i++) {
+        if (iov[i].len == 0)
+            continue;
+
+        ret = handle->mount->api->read(handle->cookie, iov[i].base, offset, iov[i].len);
+        if (ret < 0)
+            return ret;
+
+        total += ret;
+        offset += ret;
+
+        /* end of file */
+        if ((size_t)ret < iov[i].len)
+            break;
+    }
+
+    return total;
+}
+
 ssize_t fs_write_file(filehandle *handle, const void *buf, off_t offset, size_t len)
 {
     if (!handle->mount->api->write)
@@ -11,6 +11,14 @@ MODULE_DEPS += \
 	$(LOCAL_DIR)/ext2 \
 	$(LOCAL_DIR)/ext4
 
+ifeq ($(CONFIG_ENABLE_EROFS), yes)
+GLOBAL_INCLUDES += \
+	$(LOCAL_DIR)/erofs
+
+MODULE_DEPS += \
+	$(LOCAL_DIR)/erofs
+endif
+
 MODULE_SRCS += \
 	$(LOCAL_DIR)/fs.c
 
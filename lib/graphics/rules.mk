@@ -1,5 +1,5 @@
 #
-# Copyright (c) 2016, NVIDIA Corporation.  All Rights Reserved.
+# Copyright (c) 2016-2023, NVIDIA Corporation.  All Rights Reserved.
 #
 # NVIDIA Corporation and its licensors retain all intellectual property and
 # proprietary rights in and to this software and related documentation.  Any
@@ -19,6 +19,12 @@ GLOBAL_INCLUDES += \
 MODULE_SRCS += \
 	$(LOCAL_DIR)/tegrabl_surface.c \
 	$(LOCAL_DIR)/tegrabl_render_text.c \
-	$(LOCAL_DIR)/tegrabl_render_image.c
+	$(LOCAL_DIR)/tegrabl_render_image.c \
+	$(LOCAL_DIR)/tegrabl_blit.c \
+	$(LOCAL_DIR)/tegrabl_blit_test.c \
+	$(LOCAL_DIR)/tegrabl_image_stream.c
+
+MODULE_DEPS += \
+	$(LOCAL_DIR)/../decompress
 
 include make/module.mk
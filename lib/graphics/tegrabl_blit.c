@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+#define MODULE TEGRABL_ERR_GRAPHICS
+
+#include <tegrabl_debug.h>
+#include <tegrabl_error.h>
+#include <tegrabl_cache.h>
+#include <tegrabl_utils.h>
+#include <tegrabl_blit.h>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/* 16 x 32bpp pixels fill one 64-byte cache line */
+#define BLIT_TILE 16
+
+/**
+ * @brief Returns the address of pixel (x, y + row) of a surface, following the
+ *        same field layout as tegrabl_surface_write()
+ */
+static inline uint32_t *blit_dest_row(const struct tegrabl_surface *surf,
+	uint32_t x, uint32_t y, uint32_t row)
+{
+	uint8_t *dest = (uint8_t *)surf->base + surf->origin + (y * surf->pitch) +
+		(x * sizeof(uint32_t));
+
+	if (surf->scan_format == SCAN_FORMAT_INTERLACIVE) {
+		dest += (row >> 1) * surf->pitch;
+		if (((row + y) & 1U) != 0U) {
+			dest += surf->second_field_offset;
+		}
+	} else {
+		dest += row * surf->pitch;
+	}
+
+	return (uint32_t *)dest;
+}
+
+static inline const uint8_t *blit_src_row(const struct tegrabl_blit_src *src,
+	uint32_t row)
+{
+	return src->pixels + ((intptr_t)row * src->stride);
+}
+
+/**
+ * @brief Converts n source pixels to the 32bpp surface format. The channel
+ *        order is swapped and alpha is left at zero; 16bpp pixels keep their
+ *        5-bit channel values.
+ */
+static void blit_convert_row(uint32_t *dst, const uint8_t *src, uint32_t n,
+	tegrabl_blit_format_t format)
+{
+	uint32_t i = 0;
+	uint16_t c;
+
+#if defined(__ARM_NEON)
+	if (format == TEGRABL_BLIT_FORMAT_X1B5G5R5) {
+		uint16x8_t mask = vdupq_n_u16(0x1f);
+		uint8x8x4_t out;
+
+		out.val[3] = vdup_n_u8(0);
+		for (; (i + 8U) <= n; i += 8U) {
+			uint16x8_t in = vreinterpretq_u16_u8(vld1q_u8(src + (i * 2U)));
+			out.val[0] = vmovn_u16(vandq_u16(vshrq_n_u16(in, 10), mask));
+			out.val[1] = vmovn_u16(vandq_u16(vshrq_n_u16(in, 5), mask));
+			out.val[2] = vmovn_u16(vandq_u16(in, mask));
+			vst4_u8((uint8_t *)(dst + i), out);
+		}
+	} else if (format == TEGRABL_BLIT_FORMAT_R8G8B8) {
+		uint8x16x4_t out;
+
+		out.val[3] = vdupq_n_u8(0);
+		for (; (i + 16U) <= n; i += 16U) {
+			uint8x16x3_t in = vld3q_u8(src + (i * 3U));
+			out.val[0] = in.val[2];
+			out.val[1] = in.val[1];
+			out.val[2] = in.val[0];
+			vst4q_u8((uint8_t *)(dst + i), out);
+		}
+	} else {
+		uint8x16x4_t out;
+
+		out.val[3] = vdupq_n_u8(0);
+		for (; (i + 16U) <= n; i += 16U) {
+			uint8x16x4_t in = vld4q_u8(src + (i * 4U));
+			out.val[0] = in.val[2];
+			out.val[1] = in.val[1];
+			out.val[2] = in.val[0];
+			vst4q_u8((uint8_t *)(dst + i), out);
+		}
+	}
+#endif
+
+	switch (format) {
+	case TEGRABL_BLIT_FORMAT_X1B5G5R5:
+		for (; i < n; i++) {
+			c = (uint16_t)(src[i * 2U] | (src[(i * 2U) + 1U] << 8));
+			dst[i] = ((c >> 10) & 0x1fU) | (((c >> 5) & 0x1fU) << 8) |
+				((c & 0x1fU) << 16);
+		}
+		break;
+	case TEGRABL_BLIT_FORMAT_R8G8B8:
+		for (; i < n; i++) {
+			dst[i] = src[(i * 3U) + 2U] | (src[(i * 3U) + 1U] << 8) |
+				((uint32_t)src[i * 3U] << 16);
+		}
+		break;
+	default:
+		for (; i < n; i++) {
+			dst[i] = src[(i * 4U) + 2U] | (src[(i * 4U) + 1U] << 8) |
+				((uint32_t)src[i * 4U] << 16);
+		}
+		break;
+	}
+}
+
+static void blit_reverse_row(uint32_t *row, uint32_t n)
+{
+	uint32_t *end;
+	uint32_t tmp;
+
+	if (n == 0U) {
+		return;
+	}
+
+	end = row + n - 1U;
+	while (row < end) {
+		tmp = *row;
+		*row++ = *end;
+		*end-- = tmp;
+	}
+}
+
+/**
+ * @brief 90/270 degree rotation. The source is walked in BLIT_TILE x BLIT_TILE
+ *        tiles so that both the source rows and the destination rows of a tile
+ *        stay in the data cache while it is transposed.
+ */
+static void blit_rotate_tiled(struct tegrabl_surface *surf, uint32_t x,
+	uint32_t y, const struct tegrabl_blit_src *src, uint32_t angle)
+{
+	uint32_t tile[BLIT_TILE * BLIT_TILE];
+	uint32_t bpp = src->format;
+	uint32_t t0, x0, th, tw, i, j;
+	uint32_t *dest;
+
+	for (t0 = 0; t0 < src->height; t0 += BLIT_TILE) {
+		th = MIN(BLIT_TILE, src->height - t0);
+		for (x0 = 0; x0 < src->width; x0 += BLIT_TILE) {
+			tw = MIN(BLIT_TILE, src->width - x0);
+
+			for (j = 0; j < th; j++) {
+				blit_convert_row(&tile[j * BLIT_TILE],
+								 blit_src_row(src, t0 + j) + (x0 * bpp), tw,
+								 src->format);
+			}
+
+			/* source column x0 + i becomes a destination row */
+			for (i = 0; i < tw; i++) {
+				if (angle == 90U) {
+					dest = blit_dest_row(surf, x, y, x0 + i) +
+						(src->height - 1U - t0);
+					for (j = 0; j < th; j++) {
+						*(dest - j) = tile[(j * BLIT_TILE) + i];
+					}
+				} else {
+					dest = blit_dest_row(surf, x, y, src->width - 1U - x0 - i) +
+						t0;
+					for (j = 0; j < th; j++) {
+						dest[j] = tile[(j * BLIT_TILE) + i];
+					}
+				}
+			}
+		}
+	}
+}
+
+void tegrabl_blit_flush(struct tegrabl_surface *surf, uint32_t x, uint32_t y,
+	uint32_t width, uint32_t height)
+{
+	uintptr_t start = UINTPTR_MAX;
+	uintptr_t end = 0;
+	uintptr_t row;
+	uint32_t i;
+
+	if ((surf == NULL) || (width == 0U) || (height == 0U)) {
+		return;
+	}
+
+	for (i = 0; i < height; i++) {
+		row = (uintptr_t)blit_dest_row(surf, x, y, i);
+		start = MIN(start, row);
+		end = MAX(end, row + (width * sizeof(uint32_t)));
+	}
+
+	tegrabl_arch_clean_dcache_range(start, end - start);
+}
+
+tegrabl_error_t tegrabl_blit_strip(struct tegrabl_surface *surf, uint32_t x,
+	uint32_t y, const struct tegrabl_blit_src *src, uint32_t angle)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint32_t draw_width;
+	uint32_t draw_height;
+	uint32_t t;
+	uint32_t *dest;
+
+	if ((surf == NULL) || (src == NULL) || (src->pixels == NULL) ||
+		(surf->base == 0U)) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
+		goto fail;
+	}
+
+	/* Rows are addressed with surf->pitch, block linear is not handled */
+	if (surf->layout != SURFACE_LAYOUT_PITCH) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 3);
+		goto fail;
+	}
+
+	if ((src->format != TEGRABL_BLIT_FORMAT_X1B5G5R5) &&
+		(src->format != TEGRABL_BLIT_FORMAT_R8G8B8) &&
+		(src->format != TEGRABL_BLIT_FORMAT_R8G8B8X8)) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 1);
+		goto fail;
+	}
+
+	if ((angle == 90U) || (angle == 270U)) {
+		draw_width = src->height;
+		draw_height = src->width;
+	} else if ((angle == 0U) || (angle == 180U)) {
+		draw_width = src->width;
+		draw_height = src->height;
+	} else {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 2);
+		goto fail;
+	}
+
+	if ((x > surf->width) || (draw_width > (surf->width - x)) ||
+		(y > surf->height) || (draw_height > (surf->height - y))) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 2);
+		goto fail;
+	}
+
+	pr_debug("%s: %ux%u at (%u, %u), angle %u\n", __func__, draw_width,
+			 draw_height, x, y, angle);
+
+	switch (angle) {
+	case 0:
+		for (t = 0; t < src->height; t++) {
+			dest = blit_dest_row(surf, x, y, t);
+			blit_convert_row(dest, blit_src_row(src, t), src->width,
+							 src->format);
+		}
+		break;
+	case 180:
+		for (t = 0; t < src->height; t++) {
+			dest = blit_dest_row(surf, x, y, src->height - 1U - t);
+			blit_convert_row(dest, blit_src_row(src, t), src->width,
+							 src->format);
+			blit_reverse_row(dest, src->width);
+		}
+		break;
+	default:
+		blit_rotate_tiled(surf, x, y, src, angle);
+		break;
+	}
+
+fail:
+	return err;
+}
+
+tegrabl_error_t tegrabl_blit_image(struct tegrabl_surface *surf, uint32_t x,
+	uint32_t y, const struct tegrabl_blit_src *src, uint32_t angle)
+{
+	tegrabl_error_t err;
+
+	err = tegrabl_blit_strip(surf, x, y, src, angle);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	if ((angle == 90U) || (angle == 270U)) {
+		tegrabl_blit_flush(surf, x, y, src->height, src->width);
+	} else {
+		tegrabl_blit_flush(surf, x, y, src->width, src->height);
+	}
+
+fail:
+	return err;
+}
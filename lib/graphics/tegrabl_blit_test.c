@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+#define MODULE TEGRABL_ERR_GRAPHICS
+
+#include <tegrabl_debug.h>
+#include <tegrabl_error.h>
+#include <tegrabl_malloc.h>
+#include <tegrabl_utils.h>
+#include <tegrabl_surface.h>
+#include <tegrabl_blit.h>
+#include <string.h>
+
+#define BLIT_TEST_SURF_WIDTH 64U
+#define BLIT_TEST_SURF_HEIGHT 48U
+#define BLIT_TEST_PITCH (BLIT_TEST_SURF_WIDTH * sizeof(uint32_t))
+#define BLIT_TEST_SURF_SIZE (BLIT_TEST_PITCH * BLIT_TEST_SURF_HEIGHT)
+
+/* image sizes around the 16 pixel tile and NEON vector widths */
+static const uint32_t blit_test_sizes[][2] = {
+	{ 1, 1 }, { 7, 3 }, { 16, 16 }, { 17, 15 }, { 33, 19 }, { 40, 31 },
+};
+
+static const uint32_t blit_test_angles[] = { 0, 90, 180, 270 };
+
+static const tegrabl_blit_format_t blit_test_formats[] = {
+	TEGRABL_BLIT_FORMAT_X1B5G5R5,
+	TEGRABL_BLIT_FORMAT_R8G8B8,
+	TEGRABL_BLIT_FORMAT_R8G8B8X8,
+};
+
+static uint32_t blit_test_seed = 0x12345678U;
+
+static uint8_t blit_test_random(void)
+{
+	blit_test_seed = (blit_test_seed * 1103515245U) + 12345U;
+	return (uint8_t)(blit_test_seed >> 16);
+}
+
+/**
+ * @brief Reference rendering of a bottom-up BMP bitmap: converts and rotates
+ *        one pixel at a time into a draw_width x draw_height image, the way
+ *        tegrabl_render_bmp() did before it used the blitter.
+ */
+static void blit_test_reference(uint32_t *out, const uint8_t *bitmap,
+	uint32_t width, uint32_t height, uint32_t bpp, uint32_t angle)
+{
+	uint32_t draw_width = ((angle == 90U) || (angle == 270U)) ? height : width;
+	uint32_t draw_height = ((angle == 90U) || (angle == 270U)) ? width : height;
+	uint32_t row_bytes = ALIGN(width * bpp, sizeof(uint32_t));
+	uint32_t pixel_offset;
+	uint32_t x, y;
+	uint32_t r, g, b;
+	uint32_t color;
+
+	for (y = 0; y < height; y++) {
+		for (x = 0; x < width; x++) {
+			pixel_offset = (y * row_bytes) + (x * bpp);
+			if (bpp == 2U) {
+				color = bitmap[pixel_offset] |
+					(bitmap[pixel_offset + 1U] << 8);
+				r = color & 0x1fU;
+				g = (color >> 5) & 0x1fU;
+				b = (color >> 10) & 0x1fU;
+			} else {
+				r = bitmap[pixel_offset];
+				g = bitmap[pixel_offset + 1U];
+				b = bitmap[pixel_offset + 2U];
+			}
+			color = b | (g << 8) | (r << 16);
+			if (angle == 90U) {
+				out[(x * draw_width) + y] = color;
+			} else if (angle == 180U) {
+				out[(y * draw_width) + (draw_width - x - 1U)] = color;
+			} else if (angle == 270U) {
+				out[((draw_height - x - 1U) * draw_width) +
+					(draw_width - y - 1U)] = color;
+			} else {
+				out[((draw_height - y - 1U) * draw_width) + x] = color;
+			}
+		}
+	}
+}
+
+static tegrabl_error_t blit_test_one(struct tegrabl_surface *ref,
+	struct tegrabl_surface *blit, uint8_t *bitmap, uint32_t *image,
+	uint32_t width, uint32_t height, uint32_t bpp, uint32_t angle)
+{
+	struct tegrabl_blit_src src;
+	uint32_t row_bytes = ALIGN(width * bpp, sizeof(uint32_t));
+	uint32_t draw_width = ((angle == 90U) || (angle == 270U)) ? height : width;
+	uint32_t draw_height = ((angle == 90U) || (angle == 270U)) ? width : height;
+	uint32_t x = (BLIT_TEST_SURF_WIDTH - draw_width) / 2U;
+	uint32_t y = (BLIT_TEST_SURF_HEIGHT - draw_height) / 2U;
+	tegrabl_error_t err;
+	uint32_t i;
+
+	for (i = 0; i < (row_bytes * height); i++) {
+		bitmap[i] = blit_test_random();
+	}
+	memset((void *)ref->base, 0, BLIT_TEST_SURF_SIZE);
+	memset((void *)blit->base, 0, BLIT_TEST_SURF_SIZE);
+
+	blit_test_reference(image, bitmap, width, height, bpp, angle);
+	err = tegrabl_surface_write(ref, x, y, draw_width, draw_height, image);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
+	/* BMP rows are stored bottom-up */
+	src.pixels = bitmap + (row_bytes * (height - 1U));
+	src.stride = -(int32_t)row_bytes;
+	src.width = width;
+	src.height = height;
+	src.format = bpp;
+	err = tegrabl_blit_image(blit, x, y, &src, angle);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
+	if (memcmp((void *)ref->base, (void *)blit->base,
+			   BLIT_TEST_SURF_SIZE) != 0) {
+		pr_error("blit test: %ux%u %ubpp at %u degrees, %s differs\n", width,
+				 height, bpp * 8U, angle,
+				 (ref->scan_format == SCAN_FORMAT_INTERLACIVE) ?
+				 "interlaced" : "progressive");
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 10);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+static void blit_test_init_surface(struct tegrabl_surface *surf, void *buf,
+	tegrabl_scan_format_t scan_format)
+{
+	memset(surf, 0, sizeof(*surf));
+	surf->width = BLIT_TEST_SURF_WIDTH;
+	surf->height = BLIT_TEST_SURF_HEIGHT;
+	surf->pitch = BLIT_TEST_PITCH;
+	surf->base = (uintptr_t)buf;
+	surf->size = BLIT_TEST_SURF_SIZE;
+	surf->backing_size = BLIT_TEST_SURF_SIZE;
+	surf->pixel_format = PIXEL_FORMAT_A8B8G8R8;
+	surf->layout = SURFACE_LAYOUT_PITCH;
+	surf->scan_format = scan_format;
+	surf->second_field_offset = BLIT_TEST_SURF_SIZE / 2U;
+}
+
+tegrabl_error_t tegrabl_blit_test(void)
+{
+	struct tegrabl_surface ref;
+	struct tegrabl_surface blit;
+	uint8_t *ref_buf = NULL;
+	uint8_t *blit_buf = NULL;
+	uint8_t *bitmap = NULL;
+	uint32_t *image = NULL;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint32_t scan, s, f, a;
+
+	ref_buf = tegrabl_malloc(BLIT_TEST_SURF_SIZE);
+	blit_buf = tegrabl_malloc(BLIT_TEST_SURF_SIZE);
+	/* big enough for the largest test image at 32bpp */
+	bitmap = tegrabl_malloc(BLIT_TEST_SURF_SIZE);
+	image = tegrabl_malloc(BLIT_TEST_SURF_SIZE);
+	if ((ref_buf == NULL) || (blit_buf == NULL) || (bitmap == NULL) ||
+		(image == NULL)) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 10);
+		goto fail;
+	}
+
+	for (scan = SCAN_FORMAT_PROGRESSIVE; scan <= SCAN_FORMAT_INTERLACIVE;
+		 scan++) {
+		blit_test_init_surface(&ref, ref_buf, scan);
+		blit_test_init_surface(&blit, blit_buf, scan);
+		for (s = 0; s < ARRAY_SIZE(blit_test_sizes); s++) {
+			for (f = 0; f < ARRAY_SIZE(blit_test_formats); f++) {
+				for (a = 0; a < ARRAY_SIZE(blit_test_angles); a++) {
+					err = blit_test_one(&ref, &blit, bitmap, image,
+										blit_test_sizes[s][0],
+										blit_test_sizes[s][1],
+										blit_test_formats[f],
+										blit_test_angles[a]);
+					if (err != TEGRABL_NO_ERROR) {
+						goto fail;
+					}
+				}
+			}
+		}
+	}
+
+	pr_info("blit test: passed\n");
+
+fail:
+	if (ref_buf != NULL) {
+		tegrabl_free(ref_buf);
+	}
+	if (blit_buf != NULL) {
+		tegrabl_free(blit_buf);
+	}
+	if (bitmap != NULL) {
+		tegrabl_free(bitmap);
+	}
+	if (image != NULL) {
+		tegrabl_free(image);
+	}
+
+	return err;
+}
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ */
+
+#define MODULE TEGRABL_ERR_GRAPHICS
+
+#include <string.h>
+#include <tegrabl_debug.h>
+#include <tegrabl_error.h>
+#include <tegrabl_malloc.h>
+#include <tegrabl_utils.h>
+#include <tegrabl_image_stream.h>
+#include "lz4.h"
+
+#define LZ4_FRAME_MAGIC 0x184D2204U
+
+/* frame descriptor flags */
+#define LZ4_FLG_VERSION_SHIFT 6
+#define LZ4_FLG_VERSION 1U
+#define LZ4_FLG_BLOCK_INDEP (1U << 5)
+#define LZ4_FLG_BLOCK_CSUM (1U << 4)
+#define LZ4_FLG_CONTENT_SIZE (1U << 3)
+#define LZ4_FLG_DICT_ID (1U << 0)
+#define LZ4_BD_MAX_SIZE_SHIFT 4
+#define LZ4_BD_MAX_SIZE_MASK 0x7U
+
+#define LZ4_FRAME_HEADER_MIN 7U
+#define LZ4_CONTENT_SIZE_LEN 8U
+#define LZ4_BLOCK_SIZE_LEN 4U
+#define LZ4_BLOCK_CSUM_LEN 4U
+#define LZ4_BLOCK_UNCOMPRESSED (1U << 31)
+
+/* linked blocks may copy from up to 64KB before the block start */
+#define LZ4_HISTORY_SIZE (64U * 1024U)
+
+static inline uint32_t read_le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool tegrabl_image_stream_is_compressed(const uint8_t *data, uint32_t length)
+{
+	return (data != NULL) && (length >= LZ4_FRAME_HEADER_MIN) &&
+		(read_le32(data) == LZ4_FRAME_MAGIC);
+}
+
+tegrabl_error_t tegrabl_image_stream_open(struct tegrabl_image_stream *s,
+	const uint8_t *data, uint32_t length)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	const uint8_t *p;
+	uint32_t flg;
+	uint32_t bd;
+	uint64_t content_size;
+
+	if ((s == NULL) || (data == NULL)) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 6);
+		goto fail;
+	}
+
+	memset(s, 0, sizeof(*s));
+	s->in_end = data + length;
+
+	if (!tegrabl_image_stream_is_compressed(data, length)) {
+		s->in = s->in_end;
+		s->out = data;
+		s->out_avail = length;
+		s->length = length;
+		s->done = true;
+		goto fail;
+	}
+
+	p = data + sizeof(uint32_t);
+	flg = p[0];
+	bd = p[1];
+	p += 2;
+
+	if (((flg >> LZ4_FLG_VERSION_SHIFT) != LZ4_FLG_VERSION) ||
+		((flg & LZ4_FLG_DICT_ID) != 0U)) {
+		pr_error("%s: unsupported LZ4 frame flags 0x%02x\n", __func__, flg);
+		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 9);
+		goto fail;
+	}
+
+	bd = (bd >> LZ4_BD_MAX_SIZE_SHIFT) & LZ4_BD_MAX_SIZE_MASK;
+	if (bd < 4U) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 7);
+		goto fail;
+	}
+	/* 4: 64KB, 5: 256KB, 6: 1MB, 7: 4MB */
+	s->block_max = 1U << (8U + (2U * bd));
+
+	if ((flg & LZ4_FLG_CONTENT_SIZE) != 0U) {
+		if ((uint32_t)(s->in_end - p) < (LZ4_CONTENT_SIZE_LEN + 1U)) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 8);
+			goto fail;
+		}
+		content_size = read_le32(p) | ((uint64_t)read_le32(p + 4) << 32);
+		if (content_size > UINT32_MAX) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_TOO_LARGE, 1);
+			goto fail;
+		}
+		s->length = (uint32_t)content_size;
+		p += LZ4_CONTENT_SIZE_LEN;
+	}
+
+	/* skip the header checksum */
+	s->in = p + 1;
+	s->block_csum = (flg & LZ4_FLG_BLOCK_CSUM) != 0U;
+	s->linked = (flg & LZ4_FLG_BLOCK_INDEP) == 0U;
+
+	s->buf_size = s->block_max + (s->linked ? LZ4_HISTORY_SIZE : 0U);
+	s->buf = tegrabl_malloc(s->buf_size);
+	if (s->buf == NULL) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 4);
+		goto fail;
+	}
+
+	pr_debug("%s: LZ4 frame, %u byte blocks%s\n", __func__, s->block_max,
+			 s->linked ? " (linked)" : "");
+
+fail:
+	return err;
+}
+
+/**
+ * @brief Decodes the next block of the frame into the block buffer
+ */
+static tegrabl_error_t stream_refill(struct tegrabl_image_stream *s)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint32_t c_size;
+	uint32_t history;
+	uint8_t *dst;
+	int32_t n;
+
+	if ((uint32_t)(s->in_end - s->in) < LZ4_BLOCK_SIZE_LEN) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 9);
+		goto fail;
+	}
+
+	c_size = read_le32(s->in);
+	s->in += LZ4_BLOCK_SIZE_LEN;
+
+	/* end mark */
+	if (c_size == 0U) {
+		s->done = true;
+		goto fail;
+	}
+
+	if (((c_size & ~LZ4_BLOCK_UNCOMPRESSED) > s->block_max) ||
+		((c_size & ~LZ4_BLOCK_UNCOMPRESSED) > (uint32_t)(s->in_end - s->in))) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 10);
+		goto fail;
+	}
+
+	/* keep the window of the last blocks in front of the new one */
+	history = s->linked ? MIN(s->buf_pos, LZ4_HISTORY_SIZE) : 0U;
+	if ((s->buf_pos + s->block_max) > s->buf_size) {
+		memmove(s->buf, s->buf + s->buf_pos - history, history);
+		s->buf_pos = history;
+	}
+	dst = s->buf + s->buf_pos;
+
+	if ((c_size & LZ4_BLOCK_UNCOMPRESSED) != 0U) {
+		c_size &= ~LZ4_BLOCK_UNCOMPRESSED;
+		memcpy(dst, s->in, c_size);
+		n = (int32_t)c_size;
+	} else if (history != 0U) {
+		n = LZ4_decompress_safe_usingDict((const char *)s->in, (char *)dst,
+										  (int)c_size, (int)s->block_max,
+										  (const char *)dst - history,
+										  (int)history);
+	} else {
+		n = LZ4_decompress_safe((const char *)s->in, (char *)dst, (int)c_size,
+								(int)s->block_max);
+	}
+
+	if (n < 0) {
+		pr_error("%s: corrupted LZ4 block (%d)\n", __func__, n);
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 11);
+		goto fail;
+	}
+
+	s->in += c_size;
+	if (s->block_csum) {
+		if ((uint32_t)(s->in_end - s->in) < LZ4_BLOCK_CSUM_LEN) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 12);
+			goto fail;
+		}
+		s->in += LZ4_BLOCK_CSUM_LEN;
+	}
+
+	s->out = dst;
+	s->out_avail = (uint32_t)n;
+	s->buf_pos = s->linked ? (s->buf_pos + (uint32_t)n) : 0U;
+
+fail:
+	return err;
+}
+
+tegrabl_error_t tegrabl_image_stream_map(struct tegrabl_image_stream *s,
+	const uint8_t **ptr, uint32_t *avail)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	/* blocks may legitimately decode to nothing */
+	while ((s->out_avail == 0U) && !s->done) {
+		err = stream_refill(s);
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+	}
+
+	*ptr = s->out;
+	*avail = s->out_avail;
+
+fail:
+	return err;
+}
+
+void tegrabl_image_stream_consume(struct tegrabl_image_stream *s, uint32_t n)
+{
+	n = MIN(n, s->out_avail);
+	s->out += n;
+	s->out_avail -= n;
+}
+
+tegrabl_error_t tegrabl_image_stream_read(struct tegrabl_image_stream *s,
+	void *dst, uint32_t n)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint8_t *d = dst;
+	const uint8_t *ptr;
+	uint32_t avail;
+	uint32_t chunk;
+
+	while (n != 0U) {
+		err = tegrabl_image_stream_map(s, &ptr, &avail);
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+		if (avail == 0U) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_UNDERFLOW, 1);
+			goto fail;
+		}
+
+		chunk = MIN(n, avail);
+		if (d != NULL) {
+			memcpy(d, ptr, chunk);
+			d += chunk;
+		}
+		tegrabl_image_stream_consume(s, chunk);
+		n -= chunk;
+	}
+
+fail:
+	return err;
+}
+
+void tegrabl_image_stream_close(struct tegrabl_image_stream *s)
+{
+	if ((s != NULL) && (s->buf != NULL)) {
+		tegrabl_free(s->buf);
+		s->buf = NULL;
+	}
+}
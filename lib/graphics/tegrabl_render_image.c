@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2018, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -15,8 +15,27 @@
 #include <tegrabl_utils.h>
 #include <string.h>
 #include <tegrabl_render_image.h>
+#include <tegrabl_blit.h>
+#include <tegrabl_image_stream.h>
 
 #define BMP_HEADER_LENGTH 54
+#define BMP_FILE_HEADER_LENGTH 14
+#define BMP_INFO_HEADER_LENGTH 40
+
+/* rows decoded before they are drawn, one blit tile high */
+#define BMP_STRIP_ROWS 16
+#define BMP_PALETTE_SIZE 256
+#define BMP_RLE_RUN_MAX 256
+
+/* compression types */
+#define BMP_COMPRESSION_RGB 0
+#define BMP_COMPRESSION_RLE8 1
+#define BMP_COMPRESSION_RLE4 2
+
+/* RLE escape codes, following a zero count */
+#define BMP_RLE_END_OF_LINE 0
+#define BMP_RLE_END_OF_BITMAP 1
+#define BMP_RLE_DELTA 2
 
 /**
  * Defines BMP file Header
@@ -55,7 +74,21 @@ struct bitmap_info_header {
 struct bitmap_file {
 	struct bitmap_file_header bfh;
 	struct bitmap_info_header bih;
-	uint8_t *bitmap_data;
+	uint32_t palette[BMP_PALETTE_SIZE];	/* B, G, R, X bytes per entry */
+};
+
+/**
+ * Destination of the decoded rows of a BMP
+ */
+struct bmp_target {
+	struct tegrabl_surface *surf;
+	uint32_t x;			/* top-left of the rotated image on the surface */
+	uint32_t y;
+	uint32_t width;		/* image size before rotation */
+	uint32_t height;
+	uint32_t angle;
+	uint32_t *strip;	/* BMP_STRIP_ROWS rows of palette entries */
+	uint8_t *row;		/* one row, for rows split across LZ4 blocks */
 };
 
 static uint32_t rotation_angle;
@@ -98,7 +131,7 @@ static void fill_bmp_header(struct bitmap_file *bmf, uint8_t *buf)
 	bmf->bih.width = hdr[9] | hdr[10] << 16;
 	bmf->bih.height = hdr[11] | hdr[12] << 16;
 	bmf->bih.planes = hdr[13];
-	bmf->bih.depth = hdr[14] | hdr[15] << 16;
+	bmf->bih.depth = hdr[14];
 	bmf->bih.compression_type = hdr[15] | hdr[16] << 16;
 	bmf->bih.image_size = hdr[17] | hdr[18] << 16;
 	bmf->bih.horizontal_resolution = hdr[19] | hdr[20] << 16;
@@ -112,7 +145,7 @@ static tegrabl_error_t parse_bmp(uint8_t *buf, uint32_t len,
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 
-	if ((!buf) || (!bmf) || (len < BMP_HEADER_LENGTH)) {
+	if ((!buf) || (!bmf)) {
 		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
 		goto fail;
 	}
@@ -129,14 +162,20 @@ static tegrabl_error_t parse_bmp(uint8_t *buf, uint32_t len,
 	if (bmf->bih.image_size == 0)
 		bmf->bih.image_size = bmf->bfh.file_size - bmf->bfh.start_offset;
 
+	/* the file size is only known up front for images stored as is */
 	if ((bmf->bfh.file_size < 0) || (bmf->bih.image_size < 0) ||
 		((bmf->bfh.start_offset + bmf->bih.image_size) >
-		 (uint32_t)bmf->bfh.file_size) || ((uint32_t)bmf->bfh.file_size > len)) {
+		 (uint32_t)bmf->bfh.file_size) ||
+		((len != 0U) && ((uint32_t)bmf->bfh.file_size > len))) {
 		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 2);
 		goto fail;
 	}
 
-	bmf->bitmap_data = buf + bmf->bfh.start_offset;
+	if (bmf->bih.header_size < BMP_INFO_HEADER_LENGTH) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 9);
+		pr_error("(%s) BMP core header is not supported\n", __func__);
+		goto fail;
+	}
 
 fail:
 	if (err != TEGRABL_NO_ERROR) {
@@ -146,24 +185,321 @@ fail:
 	return err;
 }
 
+/**
+ * @brief Reads the color table of an indexed BMP and skips to the pixel data
+ */
+static tegrabl_error_t read_bmp_palette(struct tegrabl_image_stream *stream,
+									   struct bitmap_file *bmf)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint32_t colors = 0;
+	uint32_t offset;
+
+	/* skip the fields of the newer info headers */
+	err = tegrabl_image_stream_read(stream, NULL,
+									bmf->bih.header_size - BMP_INFO_HEADER_LENGTH);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	offset = BMP_FILE_HEADER_LENGTH + bmf->bih.header_size;
+
+	memset(bmf->palette, 0, sizeof(bmf->palette));
+	if (bmf->bih.depth <= 8U) {
+		colors = bmf->bih.num_colors;
+		if (colors == 0U) {
+			colors = 1U << bmf->bih.depth;
+		}
+		if (colors > (1U << bmf->bih.depth)) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 6);
+			goto fail;
+		}
+		err = tegrabl_image_stream_read(stream, bmf->palette,
+										colors * sizeof(uint32_t));
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+		offset += colors * sizeof(uint32_t);
+	}
+
+	if (bmf->bfh.start_offset < offset) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 7);
+		goto fail;
+	}
+	err = tegrabl_image_stream_read(stream, NULL,
+									bmf->bfh.start_offset - offset);
+
+fail:
+	return err;
+}
+
+/**
+ * @brief Draws n consecutive rows of the BMP, starting at the given row in
+ *        file (bottom-up) order. pixels points to the first of them and stride
+ *        is the distance from one row to the next one in file order.
+ */
+static tegrabl_error_t bmp_draw_rows(struct bmp_target *t,
+									 const uint8_t *pixels, uint32_t stride,
+									 uint32_t row, uint32_t n,
+									 tegrabl_blit_format_t format)
+{
+	struct tegrabl_blit_src src;
+	/* first row of the strip in top-down image order */
+	uint32_t top = t->height - row - n;
+	uint32_t x = t->x;
+	uint32_t y = t->y;
+
+	src.width = t->width;
+	src.height = n;
+	src.format = format;
+	src.stride = -(int32_t)stride;
+	src.pixels = pixels + ((n - 1U) * stride);
+
+	switch (t->angle) {
+	case 0:
+		y += top;
+		break;
+	case 90:
+		x += row;
+		break;
+	case 180:
+		y += row;
+		break;
+	default:
+		x += top;
+		break;
+	}
+
+	return tegrabl_blit_strip(t->surf, x, y, &src, t->angle);
+}
+
+static tegrabl_error_t bmp_draw_strip(struct bmp_target *t, uint32_t row,
+									  uint32_t n)
+{
+	return bmp_draw_rows(t, (const uint8_t *)t->strip,
+						 t->width * sizeof(uint32_t), row, n,
+						 TEGRABL_BLIT_FORMAT_R8G8B8X8);
+}
+
+/**
+ * @brief Decodes 16/24/32 bpp pixel data. Runs of rows that are contiguous in
+ *        the decoded data are drawn in place, only rows split across LZ4 blocks
+ *        are copied.
+ */
+static tegrabl_error_t decode_bmp_rgb(struct bmp_target *t,
+									  struct tegrabl_image_stream *stream,
+									  uint32_t bytes_per_pixel)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint32_t line_bytes = t->width * bytes_per_pixel;
+	uint32_t row_bytes = ALIGN(line_bytes, sizeof(uint32_t));
+	const uint8_t *ptr;
+	uint32_t avail;
+	uint32_t row = 0;
+	uint32_t n;
+
+	while (row < t->height) {
+		err = tegrabl_image_stream_map(stream, &ptr, &avail);
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+
+		n = MIN(t->height - row, avail / row_bytes);
+		if (n != 0U) {
+			err = bmp_draw_rows(t, ptr, row_bytes, row, n, bytes_per_pixel);
+			tegrabl_image_stream_consume(stream, n * row_bytes);
+		} else {
+			/* the last row may come without its padding */
+			n = 1;
+			err = tegrabl_image_stream_read(stream, t->row, line_bytes);
+			if ((err == TEGRABL_NO_ERROR) && ((row + 1U) < t->height)) {
+				err = tegrabl_image_stream_read(stream, NULL,
+												row_bytes - line_bytes);
+			}
+			if (err == TEGRABL_NO_ERROR) {
+				err = bmp_draw_rows(t, t->row, row_bytes, row, n,
+									bytes_per_pixel);
+			}
+		}
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+		row += n;
+	}
+
+fail:
+	return err;
+}
+
+/**
+ * @brief Decodes uncompressed 1/4/8 bpp pixel data through the color table
+ */
+static tegrabl_error_t decode_bmp_indexed(struct bmp_target *t,
+										  struct tegrabl_image_stream *stream,
+										  const struct bitmap_file *bmf)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint32_t depth = bmf->bih.depth;
+	uint32_t mask = (1U << depth) - 1U;
+	uint32_t line_bytes = ((t->width * depth) + 7U) / 8U;
+	uint32_t row_bytes = ALIGN(line_bytes, sizeof(uint32_t));
+	const uint8_t *ptr;
+	uint32_t avail;
+	uint32_t *dst;
+	uint32_t row;
+	uint32_t bit;
+	uint32_t i;
+
+	for (row = 0; row < t->height; row++) {
+		err = tegrabl_image_stream_map(stream, &ptr, &avail);
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+		if (avail >= line_bytes) {
+			tegrabl_image_stream_consume(stream, line_bytes);
+		} else {
+			err = tegrabl_image_stream_read(stream, t->row, line_bytes);
+			if (err != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+			ptr = t->row;
+		}
+
+		dst = t->strip + ((row % BMP_STRIP_ROWS) * t->width);
+		for (i = 0; i < t->width; i++) {
+			bit = i * depth;
+			dst[i] = bmf->palette[(ptr[bit >> 3] >> (8U - depth - (bit & 7U))) &
+								  mask];
+		}
+
+		if ((row + 1U) < t->height) {
+			err = tegrabl_image_stream_read(stream, NULL,
+											row_bytes - line_bytes);
+			if (err != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+		}
+
+		if ((((row + 1U) % BMP_STRIP_ROWS) == 0U) ||
+			((row + 1U) == t->height)) {
+			err = bmp_draw_strip(t, row - (row % BMP_STRIP_ROWS),
+								 (row % BMP_STRIP_ROWS) + 1U);
+			if (err != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+		}
+	}
+
+fail:
+	return err;
+}
+
+/**
+ * @brief Decodes RLE8/RLE4 pixel data. Pixels skipped by the delta and end of
+ *        line codes are drawn black.
+ */
+static tegrabl_error_t decode_bmp_rle(struct bmp_target *t,
+									  struct tegrabl_image_stream *stream,
+									  const struct bitmap_file *bmf)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	bool rle4 = (bmf->bih.compression_type == BMP_COMPRESSION_RLE4);
+	uint8_t run[BMP_RLE_RUN_MAX];
+	uint32_t strip_bytes = BMP_STRIP_ROWS * t->width * sizeof(uint32_t);
+	uint32_t strip_row = 0;
+	uint32_t row = 0;
+	uint32_t x = 0;
+	uint32_t count;
+	uint32_t index;
+	uint32_t i;
+	uint8_t cmd[2];
+	bool end = false;
+
+	memset(t->strip, 0, strip_bytes);
+
+	while (strip_row < t->height) {
+		if (!end && (row < t->height) &&
+			(row < (strip_row + BMP_STRIP_ROWS))) {
+			err = tegrabl_image_stream_read(stream, cmd, sizeof(cmd));
+			if (err != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+
+			count = cmd[0];
+			if (count != 0U) {
+				/* encoded run of one index, or two alternating ones for RLE4 */
+				for (i = 0; i < count; i++, x++) {
+					if (x < t->width) {
+						index = !rle4 ? cmd[1] :
+							((i & 1U) ? (cmd[1] & 0xfU) : (cmd[1] >> 4));
+						t->strip[((row - strip_row) * t->width) + x] =
+							bmf->palette[index];
+					}
+				}
+			} else if (cmd[1] == BMP_RLE_END_OF_LINE) {
+				row++;
+				x = 0;
+			} else if (cmd[1] == BMP_RLE_END_OF_BITMAP) {
+				end = true;
+			} else if (cmd[1] == BMP_RLE_DELTA) {
+				err = tegrabl_image_stream_read(stream, cmd, sizeof(cmd));
+				if (err != TEGRABL_NO_ERROR) {
+					goto fail;
+				}
+				x += cmd[0];
+				row += cmd[1];
+			} else {
+				/* absolute run, padded to a 16-bit boundary */
+				count = cmd[1];
+				err = tegrabl_image_stream_read(stream, run,
+					ALIGN(rle4 ? ((count + 1U) / 2U) : count, 2U));
+				if (err != TEGRABL_NO_ERROR) {
+					goto fail;
+				}
+				for (i = 0; i < count; i++, x++) {
+					if (x < t->width) {
+						index = !rle4 ? run[i] : ((i & 1U) ?
+							(run[i / 2U] & 0xfU) : (run[i / 2U] >> 4));
+						t->strip[((row - strip_row) * t->width) + x] =
+							bmf->palette[index];
+					}
+				}
+			}
+			continue;
+		}
+
+		/* all rows of the strip are decoded */
+		err = bmp_draw_strip(t, strip_row,
+							 MIN(BMP_STRIP_ROWS, t->height - strip_row));
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+		memset(t->strip, 0, strip_bytes);
+		strip_row += BMP_STRIP_ROWS;
+	}
+
+fail:
+	return err;
+}
+
 tegrabl_error_t tegrabl_render_bmp(struct tegrabl_surface *surf,
 								   uint8_t *buf, uint32_t length)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	struct bitmap_file *bmf = NULL;
+	struct tegrabl_image_stream stream;
+	struct bmp_target target;
+	uint16_t header[BMP_HEADER_LENGTH / sizeof(uint16_t)];
+	bool stream_open = false;
 
 	uint32_t draw_height = 0;
 	uint32_t draw_width = 0;
-	uint32_t *temp1 = NULL;
-	uint32_t surface_offset, image_offset;
-	int32_t x, y;
-	uint32_t r, g, b;
-	uint32_t color = 0xffffff;
 	uint32_t bytes_per_pixel = 0;
-	uint32_t pixel_offset = 0;
+	uint32_t row_bytes = 0;
 	uint32_t rotate_angle;
 	uint32_t x_off = 0, y_off = 0;
 
+	memset(&target, 0, sizeof(target));
+
 	if (!buf || !surf || !length) {
 		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 3);
 		goto fail;
@@ -176,18 +512,51 @@ tegrabl_error_t tegrabl_render_bmp(struct tegrabl_surface *surf,
 		goto fail;
 	}
 
-	/* Read bmp header and data */
-	err = parse_bmp(buf, length, bmf);
+	/* The image is either a plain BMP or an LZ4 frame holding one */
+	err = tegrabl_image_stream_open(&stream, buf, length);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	stream_open = true;
+
+	err = tegrabl_image_stream_read(&stream, header, BMP_HEADER_LENGTH);
 	if (err != TEGRABL_NO_ERROR) {
+		pr_error("(%s) BMP header is truncated\n", __func__);
 		goto fail;
 	}
 
-	length = bmf->bih.image_size;
-	pr_debug("%s, image size = %d\n", __func__, length);
+	/* Read bmp header */
+	err = parse_bmp((uint8_t *)header, stream.length, bmf);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
 
-	if (bmf->bih.compression_type) {
+	pr_debug("%s, image size = %d%s\n", __func__, bmf->bih.image_size,
+			 (stream.buf != NULL) ? " (lz4)" : "");
+
+	switch (bmf->bih.compression_type) {
+	case BMP_COMPRESSION_RGB:
+		if ((bmf->bih.depth != 1) && (bmf->bih.depth != 4) &&
+			(bmf->bih.depth != 8) && (bmf->bih.depth != 16) &&
+			(bmf->bih.depth != 24) && (bmf->bih.depth != 32)) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 8);
+			pr_error("(%s) Only 1,4,8,16,24 and 32 bits per pixel is "
+					 "supported\n", __func__);
+			goto fail;
+		}
+		break;
+	case BMP_COMPRESSION_RLE8:
+	case BMP_COMPRESSION_RLE4:
+		if (bmf->bih.depth !=
+			((bmf->bih.compression_type == BMP_COMPRESSION_RLE8) ? 8U : 4U)) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 8);
+			goto fail;
+		}
+		break;
+	default:
 		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 4);
-		pr_error("(%s) Only uncompressed BMP image is supported\n",	__func__);
+		pr_error("(%s) Only uncompressed and RLE BMP images are supported\n",
+				 __func__);
 		goto fail;
 	}
 
@@ -227,57 +596,72 @@ tegrabl_error_t tegrabl_render_bmp(struct tegrabl_surface *surf,
 	y_off = (surf->height - draw_height) / 2;
 	pr_debug("draw width = %d, draw height = %d\n",	draw_width, draw_height);
 
-	bytes_per_pixel = bmf->bih.depth / 8;
-	temp1 = tegrabl_malloc(draw_width * draw_height * sizeof(uint32_t));
-	memset(temp1, 0, draw_width * draw_height * sizeof(uint32_t));
-
-	for (y = 0; y < bmf->bih.height; y++) {
-		image_offset =  y * ALIGN(bmf->bih.width *
-			(bmf->bih.depth / (8 * sizeof(uint8_t))), sizeof(uint32_t));
-
-		for (x = 0; x < bmf->bih.width; x++) {
-			pixel_offset = image_offset + (x * bytes_per_pixel);
-			if (bytes_per_pixel == 2) {
-				color = bmf->bitmap_data[pixel_offset] |
-					(bmf->bitmap_data[pixel_offset + 1] << 8);
-				r = color & 0x1f;
-				g = (color >> 5) & 0x1f;
-				b = (color >> 10) & 0x1f;
-			} else if (bytes_per_pixel == 3 || bytes_per_pixel == 4) {
-				r = bmf->bitmap_data[pixel_offset];
-				g = bmf->bitmap_data[pixel_offset + 1];
-				b = bmf->bitmap_data[pixel_offset + 2];
-			} else {
-				err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 8);
-				pr_error("(%s) Only 16,24 and 32 bits per pixel is supported\n",
-						 __func__);
-				goto fail;
-			}
-			color = b | (g << 8) | (r << 16);
-			if (rotate_angle == 90) {
-				surface_offset = x * draw_width;
-				temp1[surface_offset + y] = color;
-			} else if (rotate_angle == 180) {
-				surface_offset = y * draw_width;
-				temp1[surface_offset + (draw_width - x - 1)] = color;
-			} else if (rotate_angle == 270) {
-				surface_offset = (draw_height - x - 1) * draw_width;
-				temp1[surface_offset + (draw_width - y - 1)] = color;
-			} else {
-				surface_offset = (draw_height - y - 1) * draw_width;
-				temp1[surface_offset + x] = color;
-			}
+	if (bmf->bih.compression_type == BMP_COMPRESSION_RGB) {
+		/* rows are padded to 4 bytes and stored bottom-up */
+		row_bytes = ALIGN(((bmf->bih.width * bmf->bih.depth) + 7) / 8,
+						  sizeof(uint32_t));
+		if ((bmf->bih.height != 0) &&
+			((((uint64_t)row_bytes * (bmf->bih.height - 1)) +
+			  (((bmf->bih.width * bmf->bih.depth) + 7) / 8)) >
+			 ((uint32_t)bmf->bfh.file_size - bmf->bfh.start_offset))) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 5);
+			pr_error("(%s) BMP pixel data is truncated\n", __func__);
+			goto fail;
+		}
+	}
+
+	err = read_bmp_palette(&stream, bmf);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	target.surf = surf;
+	target.x = x_off;
+	target.y = y_off;
+	target.width = bmf->bih.width;
+	target.height = bmf->bih.height;
+	target.angle = rotate_angle;
+
+	if (bmf->bih.depth <= 8) {
+		target.strip = tegrabl_malloc(BMP_STRIP_ROWS * target.width *
+									  sizeof(uint32_t));
+		if (target.strip == NULL) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 2);
+			goto fail;
 		}
 	}
-	err = tegrabl_surface_write(surf, x_off, y_off,	draw_width, draw_height,
-								temp1);
+	if (row_bytes != 0) {
+		target.row = tegrabl_malloc(row_bytes);
+		if (target.row == NULL) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 3);
+			goto fail;
+		}
+	}
+
+	if (bmf->bih.compression_type != BMP_COMPRESSION_RGB) {
+		err = decode_bmp_rle(&target, &stream, bmf);
+	} else if (bmf->bih.depth <= 8) {
+		err = decode_bmp_indexed(&target, &stream, bmf);
+	} else {
+		bytes_per_pixel = bmf->bih.depth / 8;
+		err = decode_bmp_rgb(&target, &stream, bytes_per_pixel);
+	}
+
+	/* whatever was drawn is written back, even if the data is corrupted */
+	tegrabl_blit_flush(surf, x_off, y_off, draw_width, draw_height);
 
 fail:
 	if (err != TEGRABL_NO_ERROR) {
 		pr_error("Unsuccesful attempt to draw BMP image\n");
 	}
-	if (temp1 != NULL) {
-		tegrabl_free(temp1);
+	if (stream_open) {
+		tegrabl_image_stream_close(&stream);
+	}
+	if (target.row != NULL) {
+		tegrabl_free(target.row);
+	}
+	if (target.strip != NULL) {
+		tegrabl_free(target.strip);
 	}
 	if (bmf != NULL) {
 		tegrabl_free(bmf);
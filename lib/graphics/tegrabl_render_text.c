@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2017, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -38,6 +38,33 @@ struct text_font current_font;
 
 static uint32_t rotation_angle;
 
+#define GLYPH_COUNT (sizeof(font_default) / DISP_FONT_HEIGHT)
+
+/* number of font/color/rotation combinations kept rasterized */
+#define GLYPH_CACHE_ENTRIES 4
+
+/**
+ * Pre-rasterized glyphs of the whole font, scaled, colored and rotated, ready
+ * to be copied into the surface
+ */
+struct glyph_cache_entry {
+	bool valid;
+	uint32_t font_type;
+	uint32_t font_size;
+	uint32_t color;
+	uint32_t angle;
+	uint32_t pixel_format;
+	uint32_t glyph_pixels;	/* pixels per glyph */
+	uint32_t *glyphs;		/* GLYPH_COUNT glyphs of glyph_pixels each */
+};
+
+static struct glyph_cache_entry glyph_cache[GLYPH_CACHE_ENTRIES];
+static uint32_t glyph_cache_victim;
+
+/* staging area for a run of glyphs written with one surface write */
+static uint32_t *run_pixels;
+static uint32_t run_pixels_count;
+
 tegrabl_error_t tegrabl_render_text_set_rotation_angle(uint32_t angle)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
@@ -91,17 +118,14 @@ void tegrabl_render_text_set_font(tegrabl_font_type_t type, uint32_t size)
 }
 
 static void get_pixels_for_char(void *dst_pixels, uint32_t index,
+								struct text_font *font, uint32_t rotateangle,
 								uint32_t pixel_format, uint32_t color)
 {
 	uint32_t j, k, l, m;
-	uint8_t *font_char;
-	uint32_t rotateangle = 0;
-	struct text_font *font;
+	const uint8_t *font_char;
 	uint32_t temp_pixel = 0;
 
-	font = tegrabl_render_text_get_font();
-	rotateangle = get_rotation_angle();
-	font_char = (uint8_t *)&font_default[index * font->height];
+	font_char = &font_default[index * font->height];
 
 	if (pixel_format == PIXEL_FORMAT_A8R8G8B8)
 		temp_pixel = color_format[color].argb_value;
@@ -109,10 +133,8 @@ static void get_pixels_for_char(void *dst_pixels, uint32_t index,
 		temp_pixel = color_format[color].abgr_value;
 
 	uint32_t *pixels = (uint32_t *)dst_pixels;
-	pr_debug("%s: color = %d\n", __func__, color);
 
 	for (j = 0; j < font->height; j++) {
-		pr_debug("%s: j = %d\n", __func__, j);
 		for (k = 0; k < font->width; k++) {
 			uint32_t pixel = 0;
 			uint32_t index_l = 0;
@@ -152,38 +174,86 @@ static void get_pixels_for_char(void *dst_pixels, uint32_t index,
 	}
 }
 
-static tegrabl_error_t text_surface_read(struct tegrabl_surface *surf,
-	uint32_t x, uint32_t y, uint32_t width,	uint32_t height, void *src_pixels)
+/**
+ * @brief Returns the rasterized glyphs for the current font, the given color,
+ *        rotation and pixel format, rasterizing the font on a miss
+ */
+static const uint32_t *glyph_cache_get(struct text_font *font, uint32_t color,
+									   uint32_t angle, uint32_t pixel_format)
 {
-	tegrabl_error_t err = TEGRABL_NO_ERROR;
-	uint32_t rotateangle = get_rotation_angle();
+	struct glyph_cache_entry *entry;
+	uint32_t glyph_pixels = font->width_scaled * font->height_scaled;
+	uint32_t i;
 
-	switch (rotateangle) {
-	case 0:
-		break;
-	case 90:
-		SWAP(x, y);
-		SWAP(width, height);
-		x = surf->width - x - 1 - width;
-		break;
-	case 180:
-		y = surf->height - y - 1 - height;
-		x = surf->width - x - 1 - width;
-		break;
-	case 270:
-		SWAP(x, y);
-		SWAP(width, height);
-		y = surf->height - y - 1 - height;
-		break;
-	default:
-		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 2);
-		break;
+	for (i = 0; i < GLYPH_CACHE_ENTRIES; i++) {
+		entry = &glyph_cache[i];
+		if (entry->valid && (entry->font_type == font->type) &&
+			(entry->font_size == font->size) && (entry->color == color) &&
+			(entry->angle == angle) && (entry->pixel_format == pixel_format)) {
+			return entry->glyphs;
+		}
 	}
 
-	if (err != TEGRABL_NO_ERROR)
-		return err;
-	else
-		return tegrabl_surface_read(surf, x, y, width, height, src_pixels);
+	entry = &glyph_cache[glyph_cache_victim];
+	glyph_cache_victim = (glyph_cache_victim + 1) % GLYPH_CACHE_ENTRIES;
+
+	if ((entry->glyphs != NULL) && (entry->glyph_pixels != glyph_pixels)) {
+		tegrabl_free(entry->glyphs);
+		entry->glyphs = NULL;
+	}
+	entry->valid = false;
+
+	if (entry->glyphs == NULL) {
+		entry->glyphs = tegrabl_malloc(GLYPH_COUNT * glyph_pixels *
+									   sizeof(uint32_t));
+		if (entry->glyphs == NULL) {
+			return NULL;
+		}
+	}
+
+	pr_debug("%s: rasterizing font %u size %u color %u angle %u\n", __func__,
+			 font->type, font->size, color, angle);
+
+	for (i = 0; i < GLYPH_COUNT; i++) {
+		get_pixels_for_char(&entry->glyphs[i * glyph_pixels], i, font, angle,
+							pixel_format, color);
+	}
+
+	entry->font_type = font->type;
+	entry->font_size = font->size;
+	entry->color = color;
+	entry->angle = angle;
+	entry->pixel_format = pixel_format;
+	entry->glyph_pixels = glyph_pixels;
+	entry->valid = true;
+
+	return entry->glyphs;
+}
+
+static inline uint32_t glyph_index(char c)
+{
+	/* characters outside the font are drawn as a space */
+	if ((c < ' ') || ((uint32_t)(c - ' ') >= GLYPH_COUNT))
+		return 0;
+
+	return (uint32_t)(c - ' ');
+}
+
+/**
+ * @brief Returns the size of the surface as seen by the rotated text
+ */
+static void text_get_extent(struct tegrabl_surface *surf, uint32_t *width,
+							uint32_t *height)
+{
+	uint32_t rotateangle = get_rotation_angle();
+
+	if ((rotateangle == 90) || (rotateangle == 270)) {
+		*width = surf->height;
+		*height = surf->width;
+	} else {
+		*width = surf->width;
+		*height = surf->height;
+	}
 }
 
 static tegrabl_error_t text_surface_write(struct tegrabl_surface *surf,
@@ -192,6 +262,15 @@ static tegrabl_error_t text_surface_write(struct tegrabl_surface *surf,
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	uint32_t rotateangle = get_rotation_angle();
+	uint32_t text_width;
+	uint32_t text_height;
+
+	text_get_extent(surf, &text_width, &text_height);
+
+	/* keep the mirrored coordinates below from wrapping around */
+	if ((x + width > text_width) || (y + height > text_height)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 4);
+	}
 
 	switch (rotateangle) {
 	case 0:
@@ -199,16 +278,16 @@ static tegrabl_error_t text_surface_write(struct tegrabl_surface *surf,
 	case 90:
 		SWAP(x, y);
 		SWAP(width, height);
-		x = surf->width - x - 1 - width;
+		x = surf->width - x - width;
 		break;
 	case 180:
-		y = surf->height - y - 1 - height;
-		x = surf->width - x - 1 - width;
+		y = surf->height - y - height;
+		x = surf->width - x - width;
 		break;
 	case 270:
 		SWAP(x, y);
 		SWAP(width, height);
-		y = surf->height - y - 1 - height;
+		y = surf->height - y - height;
 		break;
 	default:
 		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 3);
@@ -224,38 +303,64 @@ static tegrabl_error_t text_surface_write(struct tegrabl_surface *surf,
 static tegrabl_error_t line_feed(struct tegrabl_surface *surf,
 								 struct text_font *font)
 {
-	uint32_t i;
-	uint32_t size = surf->width * surf->pitch * font->height_scaled;
-	tegrabl_error_t err = TEGRABL_NO_ERROR;
-	void *line = tegrabl_malloc(size);
+	int32_t lines = (int32_t)font->height_scaled;
 
-	if (!line) {
-		err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 1);
-		pr_debug("Failed to allocate memory for line\n");
-		return err;
+	/* move the text up by one line, in surface coordinates */
+	switch (get_rotation_angle()) {
+	case 90:
+		return tegrabl_surface_scroll(surf, lines, 0);
+	case 180:
+		return tegrabl_surface_scroll(surf, 0, lines);
+	case 270:
+		return tegrabl_surface_scroll(surf, -lines, 0);
+	case 0:
+	default:
+		return tegrabl_surface_scroll(surf, 0, -lines);
 	}
+}
 
-	for (i = font->height_scaled; i < surf->height;	i += font->height_scaled) {
-		err = text_surface_read(surf, 0, i, surf->width, font->height_scaled,
-								line);
-		if (err != TEGRABL_NO_ERROR) {
-			goto fail;
-		}
+/**
+ * @brief Draws n consecutive characters of one line, starting at the given
+ *        text position, with a single surface write
+ */
+static tegrabl_error_t render_run(struct tegrabl_surface *surf,
+	struct text_font *font, const uint32_t *glyphs, const char *run,
+	uint32_t n, uint32_t x, uint32_t y)
+{
+	uint32_t rotateangle = get_rotation_angle();
+	uint32_t glyph_pixels = font->width_scaled * font->height_scaled;
+	uint32_t gw = font->width_scaled;
+	uint32_t gh = font->height_scaled;
+	const uint32_t *glyph;
+	uint32_t i, r, slot;
 
-		err = text_surface_write(surf, 0, i - font->height_scaled, surf->width,
-								 font->height_scaled, line);
-		if (err != TEGRABL_NO_ERROR) {
-			goto fail;
-		}
+	if (n == 0)
+		return TEGRABL_NO_ERROR;
+
+	if ((rotateangle == 90) || (rotateangle == 270)) {
+		SWAP(gw, gh);
 	}
 
-	memset(line, 0, size);
-	err = text_surface_write(surf, 0, surf->height - font->height_scaled,
-							 surf->width, font->height_scaled, line);
+	for (i = 0; i < n; i++) {
+		glyph = &glyphs[glyph_index(run[i]) * glyph_pixels];
 
-fail:
-	tegrabl_free(line);
-	return err;
+		/* text runs right to left (180) or bottom to top (270) on the surface */
+		slot = ((rotateangle == 180) || (rotateangle == 270)) ? (n - 1 - i) : i;
+
+		if ((rotateangle == 90) || (rotateangle == 270)) {
+			/* glyphs are stacked vertically, each one is contiguous */
+			memcpy(&run_pixels[slot * glyph_pixels], glyph,
+				   glyph_pixels * sizeof(uint32_t));
+		} else {
+			for (r = 0; r < gh; r++) {
+				memcpy(&run_pixels[(r * n * gw) + (slot * gw)], &glyph[r * gw],
+					   gw * sizeof(uint32_t));
+			}
+		}
+	}
+
+	return text_surface_write(surf, x, y, n * font->width_scaled,
+							  font->height_scaled, run_pixels);
 }
 
 tegrabl_error_t tegrabl_render_text(struct tegrabl_surface *surf,
@@ -265,8 +370,12 @@ tegrabl_error_t tegrabl_render_text(struct tegrabl_surface *surf,
 	uint32_t i;
 	struct text_position *position;
 	struct text_font *font;
-	uint32_t index;
-	uint32_t *pixels;
+	const uint32_t *glyphs;
+	uint32_t max_run;
+	uint32_t run_start = 0;
+	uint32_t run_len = 0;
+	uint32_t run_x = 0, run_y = 0;
+	uint32_t text_width, text_height;
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 
 	if (!surf || !msg) {
@@ -276,50 +385,90 @@ tegrabl_error_t tegrabl_render_text(struct tegrabl_surface *surf,
 
 	position = tegrabl_render_text_get_position();
 	font = tegrabl_render_text_get_font();
-	pixels = (uint32_t *)tegrabl_malloc(font->width_scaled *
-		font->height_scaled * sizeof(uint32_t));
-	if (pixels == NULL) {
+	text_get_extent(surf, &text_width, &text_height);
+	if (font->height_scaled > text_height) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 5);
+		return err;
+	}
+
+	glyphs = glyph_cache_get(font, color, get_rotation_angle(),
+							 surf->pixel_format);
+	if (glyphs == NULL) {
 		err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 2);
-		pr_debug("Failed to allocate memory for pixels\n");
+		pr_debug("Failed to allocate memory for glyphs\n");
 		return err;
 	}
 
+	/* a run never extends past the end of a line */
+	max_run = MAX(text_width / font->width_scaled, 1U);
+	if (run_pixels_count < (max_run * font->width_scaled *
+							font->height_scaled)) {
+		if (run_pixels != NULL) {
+			tegrabl_free(run_pixels);
+		}
+		run_pixels_count = max_run * font->width_scaled * font->height_scaled;
+		run_pixels = tegrabl_malloc(run_pixels_count * sizeof(uint32_t));
+		if (run_pixels == NULL) {
+			run_pixels_count = 0;
+			err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 3);
+			pr_debug("Failed to allocate memory for pixels\n");
+			return err;
+		}
+	}
+
 	len = strlen(msg);
 
 	for (i = 0; i < len; i++) {
 		pr_debug("%s: i=%d, x=%d, y=%d char=%c\n", __func__, i, position->x,
 				 position->y, msg[i]);
-		if (msg[i] == '\n' || position->y >= surf->height) {
+		if ((msg[i] == '\n') ||
+			(position->y + font->height_scaled > text_height)) {
+			err = render_run(surf, font, glyphs, &msg[run_start], run_len,
+							 run_x, run_y);
+			run_len = 0;
+			if (err != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+
 			position->x = 0;
 			position->y += font->height_scaled;
-			if (position->y >= surf->height) {
+			if (position->y + font->height_scaled > text_height) {
 				err = line_feed(surf, font);
 				if (err != TEGRABL_NO_ERROR) {
 					goto fail;
 				}
 
-				position->y = surf->height - font->height_scaled;
+				position->y = text_height - font->height_scaled;
 			}
 
 			if (msg[i] == '\n')
 				continue;
 		}
-		index = msg[i] - ' ';
-		get_pixels_for_char(pixels, index, surf->pixel_format, color);
-		err = text_surface_write(surf, position->x, position->y,
-			font->width_scaled, font->height_scaled, pixels);
-		if (err != TEGRABL_NO_ERROR) {
-			goto fail;
+
+		if (run_len == 0) {
+			run_start = i;
+			run_x = position->x;
+			run_y = position->y;
 		}
+		run_len++;
 
 		position->x += font->width_scaled;
-		if (position->x + font->width_scaled >= surf->width) {
+		if (position->x + font->width_scaled >= text_width) {
+			err = render_run(surf, font, glyphs, &msg[run_start], run_len,
+							 run_x, run_y);
+			run_len = 0;
+			if (err != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+
 			position->x = 0;
 			position->y += font->height_scaled;
 		}
 	}
 
+	err = render_run(surf, font, glyphs, &msg[run_start], run_len, run_x,
+					 run_y);
+
 fail:
-	tegrabl_free(pixels);
 	return err;
 }
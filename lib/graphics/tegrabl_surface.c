@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2017, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2016-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -13,6 +13,7 @@
 #include <tegrabl_debug.h>
 #include <tegrabl_error.h>
 #include <tegrabl_malloc.h>
+#include <tegrabl_cache.h>
 #include <string.h>
 #include <tegrabl_surface.h>
 
@@ -35,6 +36,36 @@ static bool is_npot(uint32_t val)
 	return !IS_POWER_OF_2(val);
 }
 
+/* Adds len bytes at dest to the range cleaned by the next flush */
+static void surface_mark_dirty(struct tegrabl_surface *surf,
+	const uint8_t *dest, uint32_t len)
+{
+	uint32_t start = (uint32_t)(dest - (uint8_t *)surf->base);
+
+	if (len == 0)
+		return;
+
+	if (surf->dirty_end <= surf->dirty_start) {
+		surf->dirty_start = start;
+		surf->dirty_end = start + len;
+	} else {
+		if (start < surf->dirty_start)
+			surf->dirty_start = start;
+		if (start + len > surf->dirty_end)
+			surf->dirty_end = start + len;
+	}
+}
+
+void tegrabl_surface_flush(struct tegrabl_surface *surf)
+{
+	if (surf->dirty_end > surf->dirty_start) {
+		tegrabl_arch_clean_dcache_range(surf->base + surf->dirty_start,
+										surf->dirty_end - surf->dirty_start);
+	}
+	surf->dirty_start = 0;
+	surf->dirty_end = 0;
+}
+
 void surface_free(struct tegrabl_surface *surf)
 {
 	/* Free surface from non-RM alloc'd memory */
@@ -97,7 +128,10 @@ tegrabl_error_t surface_compute_size(struct tegrabl_surface *surf)
 
 	num_bytes = align_value(num_bytes, SURFACE_LINEAR_SIZE_ALIGN);
 
+	/* size covers the visible frame only, the spare rows stay private */
 	surf->size = num_bytes;
+	surf->backing_size = align_value(num_bytes + (surf->pitch * surf->scroll_rows),
+									 SURFACE_LINEAR_SIZE_ALIGN);
 	return err;
 }
 
@@ -115,7 +149,9 @@ tegrabl_error_t surface_compute_alignment(struct tegrabl_surface *surf)
 
 void tegrabl_surface_clear(struct tegrabl_surface *surf)
 {
-	memset((void *)surf->base, 0, surf->size);
+	memset((void *)surf->base, 0, surf->backing_size);
+	surf->origin = 0;
+	surface_mark_dirty(surf, (uint8_t *)surf->base, surf->size);
 }
 
 tegrabl_error_t tegrabl_surface_setup(struct tegrabl_surface *surf)
@@ -149,7 +185,7 @@ tegrabl_error_t tegrabl_surface_setup(struct tegrabl_surface *surf)
 	}
 
 	/* This buffer is not freed */
-	base = (uintptr_t)tegrabl_malloc(surf->size + surf->alignment - 1);
+	base = (uintptr_t)tegrabl_malloc(surf->backing_size + surf->alignment - 1);
 	if ((void *)base == NULL) {
 		pr_debug("allocation for framebuffer failed\n");
 		err = TEGRABL_ERR_NO_MEMORY;
@@ -159,10 +195,14 @@ tegrabl_error_t tegrabl_surface_setup(struct tegrabl_surface *surf)
 	base &= ~(surf->alignment - 1);
 	pr_debug("base = %p, width = %d, height = %d\n", (void *)base, surf->width,
 			 surf->height);
-	pr_debug("pitch  = %d, alignment = %d, size = %d\n", surf->pitch,
-			 surf->alignment, surf->size);
+	pr_debug("pitch  = %d, alignment = %d, size = %d (%d)\n", surf->pitch,
+			 surf->alignment, surf->size, surf->backing_size);
 	surf->base = base;
-	memset((void *)surf->base, 0, surf->size);
+	surf->origin = 0;
+	memset((void *)surf->base, 0, surf->backing_size);
+	/* the owner maps the visible area for the display once after setup */
+	surf->dirty_start = 0;
+	surf->dirty_end = 0;
 
 fail:
 	return err;
@@ -209,7 +249,7 @@ tegrabl_error_t tegrabl_surface_write(struct tegrabl_surface *surf,	uint32_t x,
 	is_interlace = (surf->scan_format == SCAN_FORMAT_INTERLACIVE);
 	if (surf->layout == SURFACE_LAYOUT_PITCH) {
 		uint32_t second_field_offset = surf->second_field_offset;
-		dest = (uint8_t *)surf->base + y * surf->pitch + x;
+		dest = (uint8_t *)surf->base + surf->origin + y * surf->pitch + x;
 		if (is_interlace) {
 			cury = 0;
 			for (; cury < height; cury++) {
@@ -220,9 +260,11 @@ tegrabl_error_t tegrabl_surface_write(struct tegrabl_surface *surf,	uint32_t x,
 					dest_current = dest + (cury >> 1) * (surf->pitch);
 
 				 memcpy(dest_current, src, width);
+				 surface_mark_dirty(surf, dest_current, width);
 				 src += width;
 			}
-		} else {
+		} else if (height != 0) {
+			surface_mark_dirty(surf, dest, (height - 1) * surf->pitch + width);
 			while (height--) {
 				memcpy(dest, src, width);
 				src += width;
@@ -284,7 +326,7 @@ tegrabl_error_t tegrabl_surface_read(struct tegrabl_surface *surf, uint32_t x,
 	if (surf->layout == SURFACE_LAYOUT_PITCH) {
 		uint32_t second_field_offset = surf->second_field_offset;
 
-		src = (uint8_t *)surf->base + y * surf->pitch + x;
+		src = (uint8_t *)surf->base + surf->origin + y * surf->pitch + x;
 		if (is_interlace) {
 			cury = 0;
 			for (; cury < height; cury++) {
@@ -296,7 +338,8 @@ tegrabl_error_t tegrabl_surface_read(struct tegrabl_surface *surf, uint32_t x,
 
 				 memcpy(dest, src, width);
 				 dest += width;
-				 src = (uint8_t *)surf->base + y * surf->pitch + x;
+				 src = (uint8_t *)surf->base + surf->origin + y * surf->pitch +
+					x;
 			}
 		} else {
 			while (height--) {
@@ -312,3 +355,168 @@ tegrabl_error_t tegrabl_surface_read(struct tegrabl_surface *surf, uint32_t x,
 fail:
 	return err;
 }
+
+static uint8_t *surface_row(struct tegrabl_surface *surf, uint32_t row)
+{
+	uint8_t *dest = (uint8_t *)surf->base + surf->origin;
+
+	if (surf->scan_format == SCAN_FORMAT_INTERLACIVE) {
+		dest += (row >> 1) * surf->pitch;
+		if (row & 1)
+			dest += surf->second_field_offset;
+	} else {
+		dest += row * surf->pitch;
+	}
+
+	return dest;
+}
+
+static void surface_scroll_ring(struct tegrabl_surface *surf, int32_t dy)
+{
+	uint32_t pitch = surf->pitch;
+	uint32_t rows = surf->height;
+	uint32_t origin_row = surf->origin / pitch;
+	uint32_t n;
+	uint8_t *visible = (uint8_t *)surf->base + surf->origin;
+
+	if (dy < 0) {
+		n = (uint32_t)-dy;
+		if (origin_row + n <= surf->scroll_rows) {
+			surf->origin += n * pitch;
+		} else {
+			/* ran off the end of the spare rows, wrap back to the start */
+			memmove((void *)surf->base, visible + n * pitch, (rows - n) * pitch);
+			surf->origin = 0;
+			surface_mark_dirty(surf, (uint8_t *)surf->base, (rows - n) * pitch);
+		}
+		memset((uint8_t *)surf->base + surf->origin + (rows - n) * pitch, 0,
+			   n * pitch);
+		surface_mark_dirty(surf, (uint8_t *)surf->base + surf->origin +
+						   (rows - n) * pitch, n * pitch);
+	} else {
+		n = (uint32_t)dy;
+		if (origin_row >= n) {
+			surf->origin -= n * pitch;
+		} else {
+			/* ran off the start, wrap to the end of the spare rows */
+			memmove((uint8_t *)surf->base + (surf->scroll_rows + n) * pitch,
+					visible, (rows - n) * pitch);
+			surf->origin = surf->scroll_rows * pitch;
+			surface_mark_dirty(surf, (uint8_t *)surf->base +
+							   (surf->scroll_rows + n) * pitch, (rows - n) * pitch);
+		}
+		memset((uint8_t *)surf->base + surf->origin, 0, n * pitch);
+		surface_mark_dirty(surf, (uint8_t *)surf->base + surf->origin, n * pitch);
+	}
+}
+
+tegrabl_error_t tegrabl_surface_scroll(struct tegrabl_surface *surf,
+	int32_t dx, int32_t dy)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint32_t bytes_per_pixel = (BITS_PER_PIXEL + 7) >> 3;
+	uint32_t width_bytes;
+	uint32_t shift;
+	uint32_t n;
+	uint32_t row;
+
+	if (!surf || !(surf->base)) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 11);
+		goto fail;
+	}
+
+	if (surf->layout != SURFACE_LAYOUT_PITCH) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 6);
+		goto fail;
+	}
+
+	if ((dx != 0) && (dy != 0)) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 7);
+		goto fail;
+	}
+
+	width_bytes = surf->width * bytes_per_pixel;
+
+	if (dx != 0) {
+		n = (dx < 0) ? (uint32_t)-dx : (uint32_t)dx;
+		if (n >= surf->width) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 12);
+			goto fail;
+		}
+		shift = n * bytes_per_pixel;
+		for (row = 0; row < surf->height; row++) {
+			uint8_t *line = surface_row(surf, row);
+
+			if (dx < 0) {
+				memmove(line, line + shift, width_bytes - shift);
+				memset(line + width_bytes - shift, 0, shift);
+			} else {
+				memmove(line + shift, line, width_bytes - shift);
+				memset(line, 0, shift);
+			}
+			surface_mark_dirty(surf, line, width_bytes);
+		}
+		goto fail;
+	}
+
+	if (dy == 0) {
+		goto fail;
+	}
+
+	n = (dy < 0) ? (uint32_t)-dy : (uint32_t)dy;
+	if (n >= surf->height) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 13);
+		goto fail;
+	}
+
+	if (surf->scan_format == SCAN_FORMAT_INTERLACIVE) {
+		/* rows of the two fields are not contiguous, move them one by one */
+		if (dy < 0) {
+			for (row = 0; row < surf->height - n; row++)
+				memcpy(surface_row(surf, row), surface_row(surf, row + n),
+					   width_bytes);
+			for (; row < surf->height; row++)
+				memset(surface_row(surf, row), 0, width_bytes);
+		} else {
+			for (row = surf->height - 1; row >= n; row--)
+				memcpy(surface_row(surf, row), surface_row(surf, row - n),
+					   width_bytes);
+			for (row = 0; row < n; row++)
+				memset(surface_row(surf, row), 0, width_bytes);
+		}
+		for (row = 0; row < surf->height; row++)
+			surface_mark_dirty(surf, surface_row(surf, row), width_bytes);
+	} else if (surf->scroll_rows != 0) {
+		surface_scroll_ring(surf, dy);
+	} else {
+		uint8_t *visible = surface_row(surf, 0);
+
+		if (dy < 0) {
+			memmove(visible, visible + n * surf->pitch,
+					(surf->height - n) * surf->pitch);
+			memset(visible + (surf->height - n) * surf->pitch, 0,
+				   n * surf->pitch);
+		} else {
+			memmove(visible + n * surf->pitch, visible,
+					(surf->height - n) * surf->pitch);
+			memset(visible, 0, n * surf->pitch);
+		}
+		surface_mark_dirty(surf, visible, surf->height * surf->pitch);
+	}
+
+fail:
+	return err;
+}
+
+void tegrabl_surface_reset_origin(struct tegrabl_surface *surf)
+{
+	if (surf->origin == 0)
+		return;
+
+	memmove((void *)surf->base, (uint8_t *)surf->base + surf->origin,
+			surf->height * surf->pitch);
+	memset((uint8_t *)surf->base + surf->height * surf->pitch, 0,
+		   surf->origin);
+	surf->origin = 0;
+	surface_mark_dirty(surf, (uint8_t *)surf->base, surf->size);
+}
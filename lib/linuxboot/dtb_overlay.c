@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017, NVIDIA Corporation.  All Rights Reserved.
+ * Copyright (c) 2017-2023, NVIDIA Corporation.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -17,11 +17,233 @@
 #include <libufdt.h>
 #include <ufdt_overlay.h>
 
+/*
+ * The cache partition is not authenticated, so with secure boot a cached blob
+ * could stand in for the signed kernel DTB and overlay. Always merge then.
+ */
+#if defined(CONFIG_ENABLE_DTB_OVERLAY_CACHE) && \
+	!defined(CONFIG_ENABLE_SECURE_BOOT)
+#define DTB_CACHE_ENABLED
+#endif
+
+#if defined(DTB_CACHE_ENABLED)
+#include <stdbool.h>
+#include <string.h>
+#include <tegrabl_malloc.h>
+#include <tegrabl_partition_manager.h>
+#include <lib/mincrypt/sha256.h>
+#endif
+
+#if defined(DTB_CACHE_ENABLED)
+
+#if !defined(CONFIG_DTB_OVERLAY_CACHE_PARTITION)
+#define CONFIG_DTB_OVERLAY_CACHE_PARTITION "kernel-dtb-cache"
+#endif
+
+#define DTB_CACHE_MAGIC		0x43425444U	/* "DTBC" */
+#define DTB_CACHE_VERSION	1U
+/* Keep the merged blob block aligned within the partition */
+#define DTB_CACHE_HDR_SIZE	4096U
+
+/*
+ * Header stored at the start of the cache partition. The merged kernel DTB
+ * follows at DTB_CACHE_HDR_SIZE. Only the used part of the blob (up to the end
+ * of the strings block) is stored; totalsize in its fdt header tells how big a
+ * buffer ufdt_apply_overlay() would have returned.
+ */
+struct dtb_cache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t blob_size;
+	uint32_t reserved;
+	uint8_t key[SHA256_DIGEST_SIZE];
+	uint8_t blob_digest[SHA256_DIGEST_SIZE];
+};
+
+/**
+ * @brief Size of the fdt up to the end of its strings block, i.e. without the
+ * free space reserved at the tail.
+ */
+static uint32_t dtb_cache_used_size(const struct fdt_header *fdt)
+{
+	uint32_t used = fdt_off_dt_strings(fdt) + fdt_size_dt_strings(fdt);
+
+	if ((used < fdt_off_dt_strings(fdt)) || (used > fdt_totalsize(fdt))) {
+		used = fdt_totalsize(fdt);
+	}
+	return used;
+}
+
+/**
+ * @brief Compute the cache key of a merge.
+ *
+ * The main DTB reaching the overlay step already carries every bootloader
+ * fixup and the plugin-manager result, so its contents (base DTB, board ids,
+ * ODM data, ...) together with the DTBO fully determine the merged DTB.
+ */
+static void dtb_cache_key(const struct fdt_header *main_dt,
+						  const struct fdt_header *overlay_dt, uint8_t *key)
+{
+	struct HASH_CTX ctx;
+	uint32_t sizes[3];
+
+	sizes[0] = DTB_CACHE_VERSION;
+	sizes[1] = dtb_cache_used_size(main_dt);
+	sizes[2] = fdt_totalsize(overlay_dt);
+
+	sha256_init(&ctx);
+	sha256_update(&ctx, sizes, sizeof(sizes));
+	sha256_update(&ctx, main_dt, sizes[1]);
+	sha256_update(&ctx, overlay_dt, sizes[2]);
+	memcpy(key, sha256_final(&ctx), SHA256_DIGEST_SIZE);
+}
+
+/**
+ * @brief Load the merged DTB from the cache partition if it was produced from
+ * the same inputs and its contents still match the recorded digest.
+ *
+ * @param key cache key of the current merge
+ * @param merged_sz size ufdt_apply_overlay() would allocate for the merge
+ * @param merged_dt on success, newly allocated merged DTB
+ *
+ * @return TEGRABL_NO_ERROR on a verified hit else appropriate error.
+ */
+static tegrabl_error_t dtb_cache_load(const uint8_t *key, uint32_t merged_sz,
+									  struct fdt_header **merged_dt)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	struct tegrabl_partition part;
+	struct dtb_cache_header hdr;
+	uint8_t digest[SHA256_DIGEST_SIZE];
+	void *blob = NULL;
+	bool is_open = false;
+
+	err = tegrabl_partition_open(CONFIG_DTB_OVERLAY_CACHE_PARTITION, &part);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	is_open = true;
+
+	err = tegrabl_partition_read(&part, &hdr, sizeof(hdr));
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	if ((hdr.magic != DTB_CACHE_MAGIC) || (hdr.version != DTB_CACHE_VERSION) ||
+		(memcmp(hdr.key, key, SHA256_DIGEST_SIZE) != 0)) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
+		goto fail;
+	}
+
+	if ((hdr.blob_size < sizeof(struct fdt_header)) || (hdr.blob_size > merged_sz) ||
+		((DTB_CACHE_HDR_SIZE + (uint64_t)hdr.blob_size) > tegrabl_partition_size(&part))) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+		goto fail;
+	}
+
+	blob = tegrabl_malloc(merged_sz);
+	if (blob == NULL) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+		goto fail;
+	}
+
+	err = tegrabl_partition_seek(&part, DTB_CACHE_HDR_SIZE, TEGRABL_PARTITION_SEEK_SET);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	err = tegrabl_partition_read(&part, blob, hdr.blob_size);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	/* Catches torn writes and media corruption alike */
+	sha256_hash(blob, (int)hdr.blob_size, digest);
+	if ((memcmp(digest, hdr.blob_digest, SHA256_DIGEST_SIZE) != 0) ||
+		(fdt_check_header(blob) != 0) ||
+		(fdt_totalsize(blob) != merged_sz) ||
+		(dtb_cache_used_size(blob) != hdr.blob_size)) {
+		pr_warn("Cached merged kernel-dtb is corrupted\n");
+		err = TEGRABL_ERROR(TEGRABL_ERR_VERIFY_FAILED, 0);
+		goto fail;
+	}
+
+	*merged_dt = (struct fdt_header *)blob;
+	blob = NULL;
+
+fail:
+	tegrabl_free(blob);
+	if (is_open) {
+		tegrabl_partition_close(&part);
+	}
+	return err;
+}
+
+/**
+ * @brief Save a freshly merged DTB in the cache partition. The blob is
+ * written ahead of the header so that an interrupted update never pairs a
+ * valid key with stale contents without the digest check noticing.
+ */
+static tegrabl_error_t dtb_cache_store(const uint8_t *key,
+									   const struct fdt_header *merged_dt)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	struct tegrabl_partition part;
+	struct dtb_cache_header hdr;
+	bool is_open = false;
+
+	err = tegrabl_partition_open(CONFIG_DTB_OVERLAY_CACHE_PARTITION, &part);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	is_open = true;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = DTB_CACHE_MAGIC;
+	hdr.version = DTB_CACHE_VERSION;
+	hdr.blob_size = dtb_cache_used_size(merged_dt);
+	memcpy(hdr.key, key, SHA256_DIGEST_SIZE);
+	sha256_hash(merged_dt, (int)hdr.blob_size, hdr.blob_digest);
+
+	if ((DTB_CACHE_HDR_SIZE + (uint64_t)hdr.blob_size) > tegrabl_partition_size(&part)) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 0);
+		goto fail;
+	}
+
+	err = tegrabl_partition_seek(&part, DTB_CACHE_HDR_SIZE, TEGRABL_PARTITION_SEEK_SET);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	err = tegrabl_partition_write(&part, merged_dt, hdr.blob_size);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	err = tegrabl_partition_seek(&part, 0, TEGRABL_PARTITION_SEEK_SET);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	err = tegrabl_partition_write(&part, &hdr, sizeof(hdr));
+
+fail:
+	if (is_open) {
+		tegrabl_partition_close(&part);
+	}
+	return err;
+}
+#endif /* DTB_CACHE_ENABLED */
+
 tegrabl_error_t tegrabl_dtb_overlay(void **kernel_dtb, void *kernel_dtbo)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 	struct fdt_header *main_dt, *overlay_dt, *merged_dt;
 	uint32_t main_dt_sz, overlay_dt_sz;
+#if defined(DTB_CACHE_ENABLED)
+	uint8_t key[SHA256_DIGEST_SIZE];
+	tegrabl_error_t cache_err;
+#endif
 
 	if (!(*kernel_dtb) || !kernel_dtbo) {
 		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
@@ -33,6 +255,16 @@ tegrabl_error_t tegrabl_dtb_overlay(void **kernel_dtb, void *kernel_dtbo)
 	overlay_dt = (struct fdt_header *)kernel_dtbo;
 	overlay_dt_sz = fdt_totalsize(overlay_dt);
 
+#if defined(DTB_CACHE_ENABLED)
+	dtb_cache_key(main_dt, overlay_dt, key);
+	cache_err = dtb_cache_load(key, main_dt_sz + overlay_dt_sz, &merged_dt);
+	if (cache_err == TEGRABL_NO_ERROR) {
+		pr_info("Using cached merged kernel-dtb\n");
+		goto done;
+	}
+	pr_debug("Merged kernel-dtb cache miss (err = %x)\n", cache_err);
+#endif
+
 	pr_info("Merge kernel-dtbo into kernel-dtb\n");
 	merged_dt = ufdt_apply_overlay(main_dt, main_dt_sz, overlay_dt,
 								   overlay_dt_sz);
@@ -42,6 +274,14 @@ tegrabl_error_t tegrabl_dtb_overlay(void **kernel_dtb, void *kernel_dtbo)
 		goto fail;
 	}
 
+#if defined(DTB_CACHE_ENABLED)
+	cache_err = dtb_cache_store(key, merged_dt);
+	if (cache_err != TEGRABL_NO_ERROR) {
+		pr_warn("Failed to cache merged kernel-dtb (err = %x)\n", cache_err);
+	}
+
+done:
+#endif
 	/* merged kernel DTB address will be changed */
 	*kernel_dtb = (void *)merged_dt;
 	pr_info("Merged kernel-dtb @ %p\n", *kernel_dtb);
@@ -61,7 +61,8 @@ static tegrabl_error_t add_board_info(void *fdt, int nodeoffset)
 	TEGRABL_ASSERT(fdt);
 
 #define set_board_prop(prop, name) do {									\
-		err = fdt_setprop_cell(fdt, node, (name), boardinfo[(prop)]);	\
+		err = tegrabl_dt_setprop_cell(fdt, node, (name),				\
+									  boardinfo[(prop)]);			\
 		if (err < 0) {													\
 			pr_error(						\
 				"%s: Unable to set /chosen/%s (%s)\n", __func__,		\
@@ -197,8 +198,8 @@ static tegrabl_error_t add_memory_info(void *fdt, int nodeoffset)
 	 * to be 2 i.e. only for 64bit addr/size pairs */
 
 	name = "memory";
-	err = fdt_setprop(fdt, nodeoffset, "device_type",
-						 name, strlen(name)+1);
+	err = tegrabl_dt_setprop(fdt, nodeoffset, "device_type",
+							 name, strlen(name)+1);
 	if (err < 0) {
 		pr_error("Failed to update /memory/%s in DTB (%s)\n",
 				 "device_type", fdt_strerror(err));
@@ -207,8 +208,8 @@ static tegrabl_error_t add_memory_info(void *fdt, int nodeoffset)
 	}
 
 	if (num_memory_chunks) {
-		err = fdt_setprop(fdt, nodeoffset, "reg", buf,
-						  num_memory_chunks * 2 * sizeof(uint64_t));
+		err = tegrabl_dt_setprop(fdt, nodeoffset, "reg", buf,
+								 num_memory_chunks * 2 * sizeof(uint64_t));
 		if (err < 0) {
 			pr_error("Failed to update /memory/%s in DTB (%s)\n",
 					 "reg", fdt_strerror(err));
@@ -238,7 +239,8 @@ static tegrabl_error_t add_initrd_info(void *fdt, int nodeoffset)
 	}
 
 	buf = cpu_to_fdt64((uint64_t)memblock.base);
-	ret = fdt_setprop(fdt, nodeoffset, "linux,initrd-start", &buf, sizeof(buf));
+	ret = tegrabl_dt_setprop(fdt, nodeoffset, "linux,initrd-start", &buf,
+							 sizeof(buf));
 	if (ret < 0) {
 		pr_error("Unable to set \"%s\" in FDT\n", "linux,initrd-start");
 		status = TEGRABL_ERROR(TEGRABL_ERR_ADD_FAILED, 0);
@@ -246,7 +248,8 @@ static tegrabl_error_t add_initrd_info(void *fdt, int nodeoffset)
 	}
 
 	buf = cpu_to_fdt64((uint64_t)(memblock.base + memblock.size));
-	ret = fdt_setprop(fdt, nodeoffset, "linux,initrd-end", &buf, sizeof(buf));
+	ret = tegrabl_dt_setprop(fdt, nodeoffset, "linux,initrd-end", &buf,
+							 sizeof(buf));
 	if (ret < 0) {
 		pr_error("Unable to set \"%s\" in FDT\n", "linux,initrd-end");
 		status = TEGRABL_ERROR(TEGRABL_ERR_ADD_FAILED, 0);
@@ -287,14 +290,16 @@ static tegrabl_error_t add_bpmp_info(void *fdt, int nodeoffset)
 	}
 
 	buf = cpu_to_fdt32((uint32_t)memblock.base);
-	err = fdt_setprop(fdt, nodeoffset, "carveout-start", &buf, sizeof(buf));
+	err = tegrabl_dt_setprop(fdt, nodeoffset, "carveout-start", &buf,
+							 sizeof(buf));
 	if (err) {
 		status = TEGRABL_ERROR(TEGRABL_ERR_ADD_FAILED, 0);
 		goto fail;
 	}
 
 	buf = cpu_to_fdt32((uint32_t)memblock.size);
-	err = fdt_setprop(fdt, nodeoffset, "carveout-size", &buf, sizeof(buf));
+	err = tegrabl_dt_setprop(fdt, nodeoffset, "carveout-size", &buf,
+							 sizeof(buf));
 	if (err) {
 		status = TEGRABL_ERROR(TEGRABL_ERR_ADD_FAILED, 0);
 		goto fail;
@@ -413,8 +418,8 @@ static tegrabl_error_t add_bootarg_info(void *fdt, int nodeoffset)
 		remain -= len;
 	}
 
-	err = fdt_setprop(fdt, nodeoffset, "bootargs", cmdline,
-					  MAX_COMMAND_LINE_SIZE - remain + 1);
+	err = tegrabl_dt_setprop(fdt, nodeoffset, "bootargs", cmdline,
+							 MAX_COMMAND_LINE_SIZE - remain + 1);
 	if (err < 0) {
 		pr_error("Failed to set bootargs in DTB (%s)\n", fdt_strerror(err));
 		status = TEGRABL_ERROR(TEGRABL_ERR_ADD_FAILED, 0);
@@ -463,7 +468,7 @@ static tegrabl_error_t install_mac_addr(void *fdt, int nodeoffset,
 	char *interface = mac_addr_meta_data[type].type_of_interface;
 	int err;
 
-	err = fdt_setprop_string(fdt, nodeoffset, chosen_prop, mac_addr);
+	err = tegrabl_dt_setprop_string(fdt, nodeoffset, chosen_prop, mac_addr);
 	if (err < 0) {
 		pr_error("Failed to install %s MAC Addr in DT (%s)\n",
 				 interface, fdt_strerror(err));
@@ -517,7 +522,7 @@ static tegrabl_error_t tegrabl_update_tos_nodes(void *fdt)
 	/* get the secureos node */
 	switch (tos_type) {
 	case TEGRABL_TOS_TYPE_TLK:
-		node = fdt_path_offset(fdt, "/tlk");
+		node = tegrabl_dt_path_offset(fdt, "/tlk");
 		if (node < 0) {
 			err = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
 			goto fail;
@@ -525,7 +530,7 @@ static tegrabl_error_t tegrabl_update_tos_nodes(void *fdt)
 		break;
 
 	case TEGRABL_TOS_TYPE_TRUSTY:
-		node = fdt_path_offset(fdt, "/trusty");
+		node = tegrabl_dt_path_offset(fdt, "/trusty");
 		if (node < 0) {
 			err = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
 			goto fail;
@@ -538,7 +543,7 @@ static tegrabl_error_t tegrabl_update_tos_nodes(void *fdt)
 	}
 
 	/* enable the node */
-	fdt_err = fdt_setprop_string(fdt, node, "status", "okay");
+	fdt_err = tegrabl_dt_setprop_string(fdt, node, "status", "okay");
 	if (fdt_err < 0) {
 		err = TEGRABL_ERROR(TEGRABL_ERR_ADD_FAILED, 0);
 	}
@@ -561,15 +566,15 @@ static tegrabl_error_t tegrabl_add_serialno(void *fdt)
 	}
 
 	pr_info("Add serial number:%s as DT property\n", sno);
-	fdt_err = fdt_setprop_string(fdt, 0, "serial-number", sno);
+	fdt_err = tegrabl_dt_setprop_string(fdt, 0, "serial-number", sno);
 	if (fdt_err < 0) {
 		pr_error("Failed to add serialno in DT\n");
 		return TEGRABL_ERROR(TEGRABL_ERR_ADD_FAILED, 0);
 	}
 
-	node = fdt_path_offset(fdt, "/firmware/android");
+	node = tegrabl_dt_path_offset(fdt, "/firmware/android");
 	if (node > 0) {
-		fdt_err = fdt_setprop_string(fdt, node, "serialno", sno);
+		fdt_err = tegrabl_dt_setprop_string(fdt, node, "serialno", sno);
 		if (fdt_err < 0) {
 			pr_error("Failed to add serialno in /firmware/android\n");
 			return TEGRABL_ERROR(TEGRABL_ERR_ADD_FAILED, 1);
@@ -623,7 +628,7 @@ static tegrabl_error_t add_odmdata_info(void *fdt, int nodeoffset)
 		}
 
 		/* Add property */
-		err = fdt_setprop_cell(fdt, node, podmdata_list[idx].name, 1);
+		err = tegrabl_dt_setprop_cell(fdt, node, podmdata_list[idx].name, 1);
 		if (err < 0) {
 			pr_error("Unable to set /chosen/plugin-manager/%s (%s)\n",
 				podmdata_list[idx].name, fdt_strerror(err));
@@ -670,7 +675,7 @@ static tegrabl_error_t add_tnspec_info(void *fdt, int nodeoffset)
 	pr_info("Adding /chosen/plugin-manager/tnspec\n");
 
 	pr_debug("Adding tnspec/id: %s\n", id);
-	fdt_err = fdt_setprop_string(fdt, node, "id", id);
+	fdt_err = tegrabl_dt_setprop_string(fdt, node, "id", id);
 	if (fdt_err < 0) {
 		pr_error("Failed to add tnspec/id in DTB\n");
 		status = TEGRABL_ERROR(TEGRABL_ERR_ADD_FAILED, 0);
@@ -678,7 +683,7 @@ static tegrabl_error_t add_tnspec_info(void *fdt, int nodeoffset)
 	}
 
 	pr_debug("Adding tnspec/config: %s\n", config);
-	fdt_err = fdt_setprop_string(fdt, node, "config", config);
+	fdt_err = tegrabl_dt_setprop_string(fdt, node, "config", config);
 	if (fdt_err < 0) {
 		pr_error("Failed to add tnspec/config in DTB\n");
 		status = TEGRABL_ERROR(TEGRABL_ERR_ADD_FAILED, 0);
@@ -737,7 +742,7 @@ static tegrabl_error_t update_fb_carveout(void *fdt, int rm_offset,
 	}
 
 	/*add/update the reg property with fb.size & fb.addr, lut.size & lut.addr*/
-	err = fdt_setprop(fdt, offset, "reg", buf, sizeof(buf));
+	err = tegrabl_dt_setprop(fdt, offset, "reg", buf, sizeof(buf));
 	if (err != TEGRABL_NO_ERROR) {
 		pr_error("%s, error updating \"reg\" property in %s\n", __func__, fb_carveout_node[instance]);
 		goto fail;
@@ -865,10 +870,14 @@ tegrabl_error_t tegrabl_linuxboot_update_dtb(void *fdt)
 	char *prev_name = NULL;
 	tegrabl_error_t status;
 	struct tegrabl_linuxboot_dtnode_info *extra_nodes = NULL;
+	bool staged;
 
 	if (fdt == NULL)
 		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
 
+	/* collect the fixups below and apply them in one pass */
+	staged = (tegrabl_dt_stage_begin(fdt) == TEGRABL_NO_ERROR);
+
 	for (i = 0; common_nodes[i].node_name != NULL; i++) {
 		if (!prev_name || strcmp(prev_name, common_nodes[i].node_name)) {
 			node = tegrabl_add_subnode_if_absent(fdt, 0,
@@ -890,7 +899,7 @@ tegrabl_error_t tegrabl_linuxboot_update_dtb(void *fdt)
 		    if (status != TEGRABL_NO_ERROR) {
 				pr_error("%s: %p failed\n", __func__,
 						 common_nodes[i].fill_dtnode);
-				return status;
+				goto fail;
 			}
 		}
 	}
@@ -900,6 +909,15 @@ tegrabl_error_t tegrabl_linuxboot_update_dtb(void *fdt)
 			NULL, &extra_nodes) == TEGRABL_NO_ERROR) {
 		pr_debug("%s: extra_nodes: %p\n", __func__, extra_nodes);
 
+		/* platform callbacks may read back what they wrote through libfdt */
+		if (staged) {
+			staged = false;
+			status = tegrabl_dt_stage_commit(fdt);
+			if (status != TEGRABL_NO_ERROR) {
+				return status;
+			}
+		}
+
 		for (i = 0; extra_nodes[i].node_name != NULL; i++) {
 			if (!prev_name || strcmp(prev_name, extra_nodes[i].node_name)) {
 				node = tegrabl_add_subnode_if_absent(fdt, 0,
@@ -933,6 +951,15 @@ tegrabl_error_t tegrabl_linuxboot_update_dtb(void *fdt)
 	/* add serial number as kernel DT property */
 	tegrabl_add_serialno(fdt);
 
+	/* plugin-manager overlay reads the tree back, apply fixups before it */
+	if (staged) {
+		staged = false;
+		status = tegrabl_dt_stage_commit(fdt);
+		if (status != TEGRABL_NO_ERROR) {
+			return status;
+		}
+	}
+
 	/* plugin-manager overlay */
 #if defined(CONFIG_ENABLE_PLUGIN_MANAGER)
 	tegrabl_plugin_manager_overlay(fdt);
@@ -941,6 +968,13 @@ tegrabl_error_t tegrabl_linuxboot_update_dtb(void *fdt)
 	pr_debug("%s: done\n", __func__);
 
 	return TEGRABL_NO_ERROR;
+
+fail:
+	/* leave the DTB as it was rather than half fixed up */
+	if (staged) {
+		tegrabl_dt_stage_discard(fdt);
+	}
+	return status;
 }
 
 static void remove_substr(char *string, char *sub)
@@ -966,7 +1000,7 @@ int tegrabl_linuxboot_update_bootargs(void *fdt, char *boot_args)
 	pr_trace("%s(): %u\n", __func__, __LINE__);
 
 	/* Get bootargs */
-	node_offset = fdt_path_offset(fdt, "/chosen");
+	node_offset = tegrabl_dt_path_offset(fdt, "/chosen");
 	if (node_offset < 0) {
 		err = node_offset;
 		pr_error("Couldn't find offset for node /chosen (%s)\n", fdt_strerror(err));
@@ -1003,7 +1037,8 @@ int tegrabl_linuxboot_update_bootargs(void *fdt, char *boot_args)
 
 	/* Update bootargs */
 set_prop:
-	err = fdt_setprop(fdt, node_offset, "bootargs", ptr, MAX_COMMAND_LINE_SIZE);
+	err = tegrabl_dt_setprop(fdt, node_offset, "bootargs", ptr,
+							 MAX_COMMAND_LINE_SIZE);
 	if (err == -FDT_ERR_NOSPACE) {
 		err = tegrabl_dt_create_space(fdt, SZ_512, DTB_MAX_SIZE);
 		pr_trace("Increased FDT blob size by %u bytes\n", SZ_512);
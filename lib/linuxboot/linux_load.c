@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2016-2021, NVIDIA Corporation.  All Rights Reserved.
+ * Copyright (c) 2016-2023, NVIDIA Corporation.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -45,8 +45,12 @@
 #if defined(CONFIG_ENABLE_EXTLINUX_BOOT)
 #include <extlinux_boot.h>
 #endif
+#if defined(CONFIG_ENABLE_QSPI)
+#include <tegrabl_qspi_flash.h>
+#endif
 #if defined(CONFIG_ENABLE_NVME_BOOT)
 #include <tegrabl_pcie.h>
+#include <tegrabl_smmu_ext.h>
 #endif
 #if defined(CONFIG_ENABLE_SECURE_BOOT)
 #include <tegrabl_auth.h>
@@ -566,6 +570,10 @@ tegrabl_error_t tegrabl_load_kernel_and_dtb(struct tegrabl_kernel_bin *kernel,
 	pr_info("%s: Done\n", __func__);
 
 fail:
+#if defined(CONFIG_ENABLE_NVME_BOOT)
+	/* no buffer loaded over NVMe may stay mapped for the kernel */
+	tegrabl_smmu_flush_cached();
+#endif
 #if defined(CONFIG_ENABLE_SECURE_BOOT)
 	pr_debug("%s: completing auth ...\n", __func__);
 	err = tegrabl_auth_complete();
@@ -573,6 +581,10 @@ fail:
 
 	tegrabl_free(kernel_dtbo);
 	tegrabl_usbh_close();
+#if defined(CONFIG_ENABLE_QSPI)
+	/* Kernel expects the flash out of continuous read mode */
+	(void)tegrabl_qspi_flash_quiesce(0);
+#endif
 
 	return err;
 }
@@ -652,6 +664,10 @@ fail:
 	err = tegrabl_auth_complete();
 #endif
 	tegrabl_free(kernel_dtbo);
+#if defined(CONFIG_ENABLE_QSPI)
+	/* Kernel expects the flash out of continuous read mode */
+	(void)tegrabl_qspi_flash_quiesce(0);
+#endif
 
 	return err;
 }
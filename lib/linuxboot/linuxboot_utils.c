@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015-2021, NVIDIA Corporation.  All Rights Reserved.
+ * Copyright (c) 2015-2023, NVIDIA Corporation.  All Rights Reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -19,6 +19,9 @@
 #include <tegrabl_auth.h>
 #include <tegrabl_bootimg.h>
 #include <tegrabl_linuxboot_utils.h>
+#if defined(CONFIG_ENABLE_NVME_BOOT)
+#include <tegrabl_smmu_ext.h>
+#endif
 
 int32_t tegrabl_bom_compare(struct tegrabl_carveout_info *p_carveout, const uint32_t a, const uint32_t b)
 {
@@ -64,6 +67,11 @@ tegrabl_error_t tegrabl_validate_binary(uint32_t bin_type, char *bin_name, uint3
 
 	pr_info("Validate %s ...\n", bin_name);
 
+#if defined(CONFIG_ENABLE_NVME_BOOT)
+	/* the device must not be able to change the image once it is checked */
+	tegrabl_smmu_flush_cached();
+#endif
+
 	if (!tegrabl_do_ratchet_check(bin_type, load_addr)) {
 		err = TEGRABL_ERROR(TEGRABL_ERR_VERIFY_FAILED, 2);
 		goto fail;
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2018-2021, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2018-2023, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -31,6 +31,7 @@
 #include <tegrabl_linuxboot_helper.h>
 #include <tegrabl_linuxboot_utils.h>
 #include <net_boot.h>
+#include <net_boot_cache.h>
 
 #define TFTP_SERVER_IP						"10.24.238.35"
 #define TFTP_MAX_RRQ_RETRIES				(5)
@@ -44,7 +45,8 @@
 #define AUX_INFO_DTB_RECV_ERR				4
 #define AUX_INFO_BOOT_IMAGE_RECV_ERR		5
 #define AUX_INFO_TFTP_CLIENT_INIT_FAILED	6
-#define AUX_INFO_TFTP_CLIENT_INIT_FAILED	6
+#define AUX_INFO_FILE_RD_REQ_TIMEOUT		7
+#define AUX_INFO_FILE_RECV_ERR				8
 
 static struct netif netif;
 struct netif *saved_netif;
@@ -290,64 +292,91 @@ fail:
 	return err;
 }
 
-static tegrabl_error_t download_kernel_and_dtb_from_tftp(uint8_t *tftp_server_ip,
-														 void *boot_img_load_addr,
-														 void *dtb_load_addr,
-														 uint32_t *boot_img_size)
+static tegrabl_error_t tftp_fetch(void *priv, const char *file, void *buf, uint32_t max_size,
+								  uint32_t *size)
 {
 	err_t ret = 0;
 	uint32_t retry;
-	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint32_t aux_rd_req_timeout = AUX_INFO_FILE_RD_REQ_TIMEOUT;
+	uint32_t aux_recv_err = AUX_INFO_FILE_RECV_ERR;
 
-	ret = tftp_client_init(tftp_server_ip);
-	if (ret != ERR_OK) {
-		pr_error("Failed to initialize TFTP client\n");
-		err = TEGRABL_ERROR(TEGRABL_ERR_INIT_FAILED, AUX_INFO_TFTP_CLIENT_INIT_FAILED);
-		goto fail;
+	TEGRABL_UNUSED(priv);
+
+	if (strcmp(file, KERNEL_DTB) == 0) {
+		aux_rd_req_timeout = AUX_INFO_DTB_RD_REQ_TIMEOUT;
+		aux_recv_err = AUX_INFO_DTB_RECV_ERR;
+	} else if (strcmp(file, BOOT_IMAGE) == 0) {
+		aux_rd_req_timeout = AUX_INFO_BOOT_IMAGE_RD_REQ_TIMEOUT;
+		aux_recv_err = AUX_INFO_BOOT_IMAGE_RECV_ERR;
 	}
 
 	retry = 0;
 	while (retry++ < TFTP_MAX_RRQ_RETRIES) {
-		ret = tftp_client_recv(KERNEL_DTB, "octet", dtb_load_addr, DTB_MAX_SIZE, NULL);
+		ret = tftp_client_recv(file, "octet", buf, max_size, size);
 		if (ret == ERR_OK) {
 			break;
 		} else if (ret == ERR_CONN) {
 			etharp_tmr();
 			tegrabl_mdelay(10);
 			continue;
-		} else if (ret != ERR_OK) {
-			pr_error("Failed to get %s\n", KERNEL_DTB);
-			err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, AUX_INFO_DTB_RECV_ERR);
-			goto fail;
+		} else {
+			pr_error("Failed to get %s\n", file);
+			return TEGRABL_ERROR(TEGRABL_ERR_INVALID, aux_recv_err);
 		}
 	}
-	if (retry >= TFTP_MAX_RRQ_RETRIES) {
-		pr_error("Failed to send RRQ of %s within max retries\n", KERNEL_DTB);
-		err = TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, AUX_INFO_DTB_RD_REQ_TIMEOUT);
+	if (ret != ERR_OK) {
+		pr_error("Failed to send RRQ of %s within max retries\n", file);
+		return TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, aux_rd_req_timeout);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+static tegrabl_error_t download_kernel_and_dtb_from_tftp(uint8_t *tftp_server_ip,
+														 void *boot_img_load_addr,
+														 void *dtb_load_addr,
+														 uint32_t *boot_img_size)
+{
+	err_t ret = 0;
+	uint32_t dtb_size = 0;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	ret = tftp_client_init(tftp_server_ip);
+	if (ret != ERR_OK) {
+		pr_error("Failed to initialize TFTP client\n");
+		err = TEGRABL_ERROR(TEGRABL_ERR_INIT_FAILED, AUX_INFO_TFTP_CLIENT_INIT_FAILED);
 		goto fail;
 	}
 
-	retry = 0;
-	while (retry++ < TFTP_MAX_RRQ_RETRIES) {
-		ret = tftp_client_recv(BOOT_IMAGE, "octet", boot_img_load_addr, BOOT_IMAGE_MAX_SIZE, boot_img_size);
-		if (ret == ERR_OK) {
-			break;
-		} else if (ret == ERR_CONN) {
-			tegrabl_mdelay(10);
-			continue;
-		} else if (ret != ERR_OK) {
-			pr_error("Failed to get %s\n", BOOT_IMAGE);
-			err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, AUX_INFO_BOOT_IMAGE_RECV_ERR);
-			goto fail;
-		}
+#if defined(CONFIG_ENABLE_NET_BOOT_CACHE)
+	/* A failure only disables the cache, images are then downloaded */
+	(void)net_boot_cache_open(tftp_server_ip, tftp_fetch, NULL);
+
+	err = net_boot_cache_load(KERNEL_DTB, dtb_load_addr, DTB_MAX_SIZE, &dtb_size);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	err = net_boot_cache_load(BOOT_IMAGE, boot_img_load_addr, BOOT_IMAGE_MAX_SIZE, boot_img_size);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
 	}
-	if (retry >= TFTP_MAX_RRQ_RETRIES) {
-		pr_error("Failed to send RRQ of %s within max retries\n", BOOT_IMAGE);
-		err = TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, AUX_INFO_BOOT_IMAGE_RD_REQ_TIMEOUT);
+#else
+	err = tftp_fetch(NULL, KERNEL_DTB, dtb_load_addr, DTB_MAX_SIZE, &dtb_size);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	err = tftp_fetch(NULL, BOOT_IMAGE, boot_img_load_addr, BOOT_IMAGE_MAX_SIZE, boot_img_size);
+	if (err != TEGRABL_NO_ERROR) {
 		goto fail;
 	}
+#endif
 
 fail:
+#if defined(CONFIG_ENABLE_NET_BOOT_CACHE)
+	net_boot_cache_close();
+#endif
 	tegrabl_eqos_deinit();
 	netif_set_down(&netif);
 	netif_remove(&netif);
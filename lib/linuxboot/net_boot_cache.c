@@ -0,0 +1,562 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited
+ */
+
+#if defined(CONFIG_ENABLE_NET_BOOT_CACHE)
+
+#define MODULE TEGRABL_ERR_LINUXBOOT
+
+#include "build_config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <tegrabl_error.h>
+#include <tegrabl_debug.h>
+#include <tegrabl_malloc.h>
+#include <tegrabl_utils.h>
+#include <tegrabl_partition_manager.h>
+#include <lib/mincrypt/sha256.h>
+#include <net_boot_cache.h>
+
+#if !defined(CONFIG_NET_BOOT_CACHE_PARTITION)
+#define CONFIG_NET_BOOT_CACHE_PARTITION "netboot-cache"
+#endif
+
+#define NET_BOOT_CACHE_MAGIC		0x4342544eU	/* "NTBC" */
+#define NET_BOOT_CACHE_VERSION		1U
+/* The index takes the first block, images follow block aligned */
+#define NET_BOOT_CACHE_HDR_SIZE		4096U
+#define NET_BOOT_CACHE_ALIGN		4096U
+#define NET_BOOT_CACHE_MAX_ENTRIES	16U
+#define NET_BOOT_CACHE_PATH_LEN		64U
+
+#define NET_BOOT_MANIFEST_MAX_SIZE	4096U
+#define NET_BOOT_MANIFEST_MAX_FILES	16U
+
+/*
+ * An image downloaded from a server. The entry is the cache key (server, path)
+ * together with the size and SHA-256 digest of the contents, which decide
+ * whether the copy is fresh and catch corruption of the stored data.
+ */
+struct net_boot_cache_entry {
+	/* LRU stamp, 0 for a free entry */
+	uint32_t last_used;
+	uint32_t size;
+	uint64_t offset;
+	uint8_t server_ip[4];
+	uint32_t reserved;
+	char path[NET_BOOT_CACHE_PATH_LEN];
+	uint8_t digest[SHA256_DIGEST_SIZE];
+};
+
+struct net_boot_cache_index {
+	uint32_t magic;
+	uint32_t version;
+	/* Last LRU stamp handed out */
+	uint32_t stamp;
+	uint32_t reserved;
+	struct net_boot_cache_entry entry[NET_BOOT_CACHE_MAX_ENTRIES];
+	/* SHA-256 of the fields above */
+	uint8_t digest[SHA256_DIGEST_SIZE];
+};
+
+struct net_boot_manifest_file {
+	char path[NET_BOOT_CACHE_PATH_LEN];
+	uint8_t digest[SHA256_DIGEST_SIZE];
+};
+
+struct net_boot_cache {
+	bool is_open;
+	bool is_dirty;
+	struct tegrabl_partition part;
+	uint64_t part_size;
+	uint8_t server_ip[4];
+	net_boot_cache_fetch_t fetch;
+	void *priv;
+	struct net_boot_cache_index index;
+	uint32_t num_files;
+	struct net_boot_manifest_file files[NET_BOOT_MANIFEST_MAX_FILES];
+};
+
+static struct net_boot_cache s_cache;
+
+static int32_t hex_digit(char c)
+{
+	if ((c >= '0') && (c <= '9')) {
+		return c - '0';
+	}
+	if ((c >= 'a') && (c <= 'f')) {
+		return c - 'a' + 10;
+	}
+	if ((c >= 'A') && (c <= 'F')) {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+static bool parse_digest(const char *str, uint8_t *digest)
+{
+	int32_t hi;
+	int32_t lo;
+	uint32_t i;
+
+	for (i = 0; i < SHA256_DIGEST_SIZE; i++) {
+		hi = hex_digit(str[2U * i]);
+		lo = (hi < 0) ? -1 : hex_digit(str[(2U * i) + 1U]);
+		if (lo < 0) {
+			return false;
+		}
+		digest[i] = (uint8_t)((hi << 4) | lo);
+	}
+	return true;
+}
+
+/**
+ * @brief Parse a sha256sum style manifest. Lines which do not parse, or whose
+ * file name does not fit an entry, are skipped.
+ */
+static void net_boot_manifest_parse(const char *text, uint32_t len)
+{
+	struct net_boot_manifest_file *file;
+	const char *end = text + len;
+	const char *line = text;
+	const char *name;
+	const char *eol;
+	uint32_t name_len;
+
+	s_cache.num_files = 0;
+
+	while ((line < end) && (s_cache.num_files < NET_BOOT_MANIFEST_MAX_FILES)) {
+		eol = line;
+		while ((eol < end) && (*eol != '\n')) {
+			eol++;
+		}
+
+		file = &s_cache.files[s_cache.num_files];
+		if ((eol - line) <= (2 * SHA256_DIGEST_SIZE) ||
+			!parse_digest(line, file->digest)) {
+			goto next;
+		}
+
+		/* "<digest> <file>" or "<digest> *<file>" for binary mode */
+		name = line + (2U * SHA256_DIGEST_SIZE);
+		while ((name < eol) && ((*name == ' ') || (*name == '\t'))) {
+			name++;
+		}
+		if ((name < eol) && (*name == '*')) {
+			name++;
+		}
+		name_len = (uint32_t)(eol - name);
+		while ((name_len > 0U) && ((name[name_len - 1U] == '\r') ||
+			   (name[name_len - 1U] == ' '))) {
+			name_len--;
+		}
+		if ((name_len == 0U) || (name_len >= NET_BOOT_CACHE_PATH_LEN)) {
+			goto next;
+		}
+
+		memcpy(file->path, name, name_len);
+		file->path[name_len] = '\0';
+		s_cache.num_files++;
+next:
+		line = eol + 1;
+	}
+}
+
+static const uint8_t *net_boot_manifest_digest(const char *path)
+{
+	uint32_t i;
+
+	for (i = 0; i < s_cache.num_files; i++) {
+		if (strcmp(s_cache.files[i].path, path) == 0) {
+			return s_cache.files[i].digest;
+		}
+	}
+	return NULL;
+}
+
+static void net_boot_cache_index_digest(const struct net_boot_cache_index *index, uint8_t *digest)
+{
+	sha256_hash(index, (int)offsetof(struct net_boot_cache_index, digest), digest);
+}
+
+static bool net_boot_cache_index_valid(void)
+{
+	const struct net_boot_cache_index *index = &s_cache.index;
+	const struct net_boot_cache_entry *entry;
+	uint8_t digest[SHA256_DIGEST_SIZE];
+	uint32_t i;
+
+	if ((index->magic != NET_BOOT_CACHE_MAGIC) || (index->version != NET_BOOT_CACHE_VERSION)) {
+		return false;
+	}
+
+	net_boot_cache_index_digest(index, digest);
+	if (memcmp(digest, index->digest, SHA256_DIGEST_SIZE) != 0) {
+		return false;
+	}
+
+	for (i = 0; i < NET_BOOT_CACHE_MAX_ENTRIES; i++) {
+		entry = &index->entry[i];
+		if (entry->last_used == 0U) {
+			continue;
+		}
+		if ((entry->offset < NET_BOOT_CACHE_HDR_SIZE) ||
+			((entry->offset + entry->size) > s_cache.part_size) ||
+			(entry->path[NET_BOOT_CACHE_PATH_LEN - 1U] != '\0')) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static tegrabl_error_t net_boot_cache_index_write(void)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	net_boot_cache_index_digest(&s_cache.index, s_cache.index.digest);
+
+	err = tegrabl_partition_seek(&s_cache.part, 0, TEGRABL_PARTITION_SEEK_SET);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
+	err = tegrabl_partition_write(&s_cache.part, &s_cache.index, sizeof(s_cache.index));
+	if (err == TEGRABL_NO_ERROR) {
+		s_cache.is_dirty = false;
+	}
+	return err;
+}
+
+static struct net_boot_cache_entry *net_boot_cache_lookup(const char *path)
+{
+	struct net_boot_cache_entry *entry;
+	uint32_t i;
+
+	for (i = 0; i < NET_BOOT_CACHE_MAX_ENTRIES; i++) {
+		entry = &s_cache.index.entry[i];
+		if ((entry->last_used != 0U) &&
+			(memcmp(entry->server_ip, s_cache.server_ip, sizeof(s_cache.server_ip)) == 0) &&
+			(strcmp(entry->path, path) == 0)) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+static void net_boot_cache_touch(struct net_boot_cache_entry *entry)
+{
+	s_cache.index.stamp++;
+	entry->last_used = s_cache.index.stamp;
+	s_cache.is_dirty = true;
+}
+
+static void net_boot_cache_drop(struct net_boot_cache_entry *entry)
+{
+	memset(entry, 0, sizeof(*entry));
+	s_cache.is_dirty = true;
+}
+
+/**
+ * @brief Read a cached image and check it against the digest of the entry.
+ */
+static tegrabl_error_t net_boot_cache_read(const struct net_boot_cache_entry *entry, void *buf,
+										   uint32_t max_size)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint8_t digest[SHA256_DIGEST_SIZE];
+
+	if (entry->size > max_size) {
+		return TEGRABL_ERROR(TEGRABL_ERR_TOO_LARGE, 0);
+	}
+
+	err = tegrabl_partition_seek(&s_cache.part, (int64_t)entry->offset, TEGRABL_PARTITION_SEEK_SET);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
+	err = tegrabl_partition_read(&s_cache.part, buf, entry->size);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
+	sha256_hash(buf, (int)entry->size, digest);
+	if (memcmp(digest, entry->digest, SHA256_DIGEST_SIZE) != 0) {
+		return TEGRABL_ERROR(TEGRABL_ERR_VERIFY_FAILED, 0);
+	}
+	return TEGRABL_NO_ERROR;
+}
+
+static bool net_boot_cache_overlaps(uint64_t offset, uint64_t size)
+{
+	const struct net_boot_cache_entry *entry;
+	uint64_t entry_end;
+	uint32_t i;
+
+	for (i = 0; i < NET_BOOT_CACHE_MAX_ENTRIES; i++) {
+		entry = &s_cache.index.entry[i];
+		if (entry->last_used == 0U) {
+			continue;
+		}
+		entry_end = entry->offset + ALIGN((uint64_t)entry->size, NET_BOOT_CACHE_ALIGN);
+		if ((offset < entry_end) && (entry->offset < (offset + size))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Find a free entry and a free range of the partition for size bytes.
+ * Candidate ranges start right after the index or after a cached image.
+ */
+static struct net_boot_cache_entry *net_boot_cache_find_space(uint32_t size, uint64_t *offset)
+{
+	struct net_boot_cache_entry *free_entry = NULL;
+	const struct net_boot_cache_entry *entry;
+	uint64_t need = ALIGN((uint64_t)size, NET_BOOT_CACHE_ALIGN);
+	uint64_t candidate;
+	uint32_t i;
+
+	for (i = 0; i < NET_BOOT_CACHE_MAX_ENTRIES; i++) {
+		if (s_cache.index.entry[i].last_used == 0U) {
+			free_entry = &s_cache.index.entry[i];
+			break;
+		}
+	}
+	if (free_entry == NULL) {
+		return NULL;
+	}
+
+	for (i = 0; i <= NET_BOOT_CACHE_MAX_ENTRIES; i++) {
+		if (i == 0U) {
+			candidate = NET_BOOT_CACHE_HDR_SIZE;
+		} else {
+			entry = &s_cache.index.entry[i - 1U];
+			if (entry->last_used == 0U) {
+				continue;
+			}
+			candidate = entry->offset + ALIGN((uint64_t)entry->size, NET_BOOT_CACHE_ALIGN);
+		}
+		if (((candidate + need) <= s_cache.part_size) && !net_boot_cache_overlaps(candidate, need)) {
+			*offset = candidate;
+			return free_entry;
+		}
+	}
+	return NULL;
+}
+
+static struct net_boot_cache_entry *net_boot_cache_lru(void)
+{
+	struct net_boot_cache_entry *lru = NULL;
+	struct net_boot_cache_entry *entry;
+	uint32_t i;
+
+	for (i = 0; i < NET_BOOT_CACHE_MAX_ENTRIES; i++) {
+		entry = &s_cache.index.entry[i];
+		if ((entry->last_used != 0U) && ((lru == NULL) || (entry->last_used < lru->last_used))) {
+			lru = entry;
+		}
+	}
+	return lru;
+}
+
+/**
+ * @brief Add a downloaded image to the cache, evicting least recently used
+ * images until it fits. The index without the evicted entries is written
+ * before their space is reused and the new entry only after its data, so an
+ * interrupted update never leaves an entry pointing at foreign data.
+ */
+static void net_boot_cache_store(const char *path, const void *buf, uint32_t size, const uint8_t *digest)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	struct net_boot_cache_entry *entry;
+	struct net_boot_cache_entry *lru;
+	uint64_t offset = 0;
+
+	if ((strlen(path) >= NET_BOOT_CACHE_PATH_LEN) ||
+		((NET_BOOT_CACHE_HDR_SIZE + ALIGN((uint64_t)size, NET_BOOT_CACHE_ALIGN)) > s_cache.part_size)) {
+		pr_info("netboot cache: %s does not fit\n", path);
+		return;
+	}
+
+	entry = net_boot_cache_find_space(size, &offset);
+	while (entry == NULL) {
+		lru = net_boot_cache_lru();
+		if (lru == NULL) {
+			return;
+		}
+		pr_debug("netboot cache: evict %s\n", lru->path);
+		net_boot_cache_drop(lru);
+		entry = net_boot_cache_find_space(size, &offset);
+	}
+
+	if (s_cache.is_dirty) {
+		err = net_boot_cache_index_write();
+		if (err != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+	}
+
+	err = tegrabl_partition_seek(&s_cache.part, (int64_t)offset, TEGRABL_PARTITION_SEEK_SET);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	err = tegrabl_partition_write(&s_cache.part, buf, size);
+	if (err != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	memset(entry, 0, sizeof(*entry));
+	entry->size = size;
+	entry->offset = offset;
+	memcpy(entry->server_ip, s_cache.server_ip, sizeof(entry->server_ip));
+	strcpy(entry->path, path);
+	memcpy(entry->digest, digest, SHA256_DIGEST_SIZE);
+	net_boot_cache_touch(entry);
+
+	err = net_boot_cache_index_write();
+
+fail:
+	if (err != TEGRABL_NO_ERROR) {
+		pr_warn("netboot cache: failed to store %s (err = %x)\n", path, err);
+	}
+}
+
+tegrabl_error_t net_boot_cache_open(const uint8_t *server_ip, net_boot_cache_fetch_t fetch, void *priv)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	char *manifest = NULL;
+	uint32_t manifest_size = 0;
+
+	if ((server_ip == NULL) || (fetch == NULL)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 0);
+	}
+
+	memset(&s_cache, 0, sizeof(s_cache));
+	memcpy(s_cache.server_ip, server_ip, sizeof(s_cache.server_ip));
+	s_cache.fetch = fetch;
+	s_cache.priv = priv;
+
+	err = tegrabl_partition_open(CONFIG_NET_BOOT_CACHE_PARTITION, &s_cache.part);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_info("netboot cache: no %s partition\n", CONFIG_NET_BOOT_CACHE_PARTITION);
+		goto fail;
+	}
+	s_cache.is_open = true;
+	s_cache.part_size = tegrabl_partition_size(&s_cache.part);
+
+	err = tegrabl_partition_read(&s_cache.part, &s_cache.index, sizeof(s_cache.index));
+	if ((err != TEGRABL_NO_ERROR) || !net_boot_cache_index_valid()) {
+		pr_info("netboot cache: initializing index\n");
+		memset(&s_cache.index, 0, sizeof(s_cache.index));
+		s_cache.index.magic = NET_BOOT_CACHE_MAGIC;
+		s_cache.index.version = NET_BOOT_CACHE_VERSION;
+		s_cache.is_dirty = true;
+		err = TEGRABL_NO_ERROR;
+	}
+
+	/* Without the manifest nothing cached can be proven fresh; downloads
+	 * still populate the cache for later boots.
+	 */
+	manifest = tegrabl_malloc(NET_BOOT_MANIFEST_MAX_SIZE);
+	if (manifest == NULL) {
+		err = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+		goto fail;
+	}
+	if (fetch(priv, NET_BOOT_CACHE_MANIFEST, manifest, NET_BOOT_MANIFEST_MAX_SIZE,
+			  &manifest_size) == TEGRABL_NO_ERROR) {
+		net_boot_manifest_parse(manifest, MIN(manifest_size, NET_BOOT_MANIFEST_MAX_SIZE));
+	}
+	pr_info("netboot cache: %u digests advertised by server\n", s_cache.num_files);
+
+fail:
+	tegrabl_free(manifest);
+	if ((err != TEGRABL_NO_ERROR) && s_cache.is_open) {
+		tegrabl_partition_close(&s_cache.part);
+		s_cache.is_open = false;
+	}
+	return err;
+}
+
+tegrabl_error_t net_boot_cache_load(const char *file, void *buf, uint32_t max_size, uint32_t *size)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	struct net_boot_cache_entry *entry;
+	const uint8_t *expected;
+	uint8_t digest[SHA256_DIGEST_SIZE];
+
+	if ((file == NULL) || (buf == NULL) || (size == NULL) || (s_cache.fetch == NULL)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 0);
+	}
+
+	if (!s_cache.is_open) {
+		return s_cache.fetch(s_cache.priv, file, buf, max_size, size);
+	}
+
+	/* Without an advertised digest a cached copy can be neither trusted nor
+	 * refreshed, so the cache is left as it is */
+	expected = net_boot_manifest_digest(file);
+	if (expected == NULL) {
+		return s_cache.fetch(s_cache.priv, file, buf, max_size, size);
+	}
+
+	entry = net_boot_cache_lookup(file);
+
+	if ((entry != NULL) && (memcmp(entry->digest, expected, SHA256_DIGEST_SIZE) == 0)) {
+		err = net_boot_cache_read(entry, buf, max_size);
+		if (err == TEGRABL_NO_ERROR) {
+			pr_info("netboot cache: %s loaded from cache\n", file);
+			*size = entry->size;
+			net_boot_cache_touch(entry);
+			return TEGRABL_NO_ERROR;
+		}
+		pr_warn("netboot cache: cached %s is corrupted (err = %x)\n", file, err);
+	}
+
+	/* Stale, corrupted or unknown: the old copy is replaced */
+	if (entry != NULL) {
+		net_boot_cache_drop(entry);
+	}
+
+	err = s_cache.fetch(s_cache.priv, file, buf, max_size, size);
+	if (err != TEGRABL_NO_ERROR) {
+		return err;
+	}
+
+	sha256_hash(buf, (int)*size, digest);
+	if (memcmp(digest, expected, SHA256_DIGEST_SIZE) != 0) {
+		/* The server may be updating the file, do not cache it */
+		pr_warn("netboot cache: %s does not match advertised digest\n", file);
+		return TEGRABL_NO_ERROR;
+	}
+
+	net_boot_cache_store(file, buf, *size, digest);
+
+	return TEGRABL_NO_ERROR;
+}
+
+void net_boot_cache_close(void)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if (s_cache.is_open) {
+		if (s_cache.is_dirty) {
+			err = net_boot_cache_index_write();
+			if (err != TEGRABL_NO_ERROR) {
+				pr_warn("netboot cache: failed to write index (err = %x)\n", err);
+			}
+		}
+		tegrabl_partition_close(&s_cache.part);
+	}
+	memset(&s_cache, 0, sizeof(s_cache));
+}
+
+#endif  /* CONFIG_ENABLE_NET_BOOT_CACHE */
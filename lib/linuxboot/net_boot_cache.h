@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited
+ */
+
+#ifndef INCLUDED_NET_BOOT_CACHE_H
+#define INCLUDED_NET_BOOT_CACHE_H
+
+#include <stdint.h>
+#include <tegrabl_error.h>
+
+#if defined(CONFIG_ENABLE_NET_BOOT_CACHE)
+
+/**
+ * @brief Server-side file listing the SHA-256 digest of the images, in the
+ * format written by sha256sum ("<hex digest>  <file>" per line)
+ */
+#define NET_BOOT_CACHE_MANIFEST "netboot.sha256"
+
+/**
+ * @brief Callback downloading a file from the server
+ *
+ * @param priv Private data given to net_boot_cache_open()
+ * @param file Name of the file on the server
+ * @param buf Buffer to download the file to
+ * @param max_size Size of buf
+ * @param size Size of the file (output)
+ *
+ * @return TEGRABL_NO_ERROR on success, otherwise appropriate error
+ */
+typedef tegrabl_error_t (*net_boot_cache_fetch_t)(void *priv, const char *file, void *buf,
+												  uint32_t max_size, uint32_t *size);
+
+/**
+ * @brief Open the cache of images downloaded from a server and fetch the
+ * digest manifest of the server. Without the cache partition, every
+ * net_boot_cache_load() falls back to downloading.
+ *
+ * @param server_ip IPv4 address of the server, part of the cache key
+ * @param fetch Callback used to download files from the server
+ * @param priv Private data passed to fetch
+ *
+ * @return TEGRABL_NO_ERROR if the cache is usable, otherwise appropriate error
+ */
+tegrabl_error_t net_boot_cache_open(const uint8_t *server_ip, net_boot_cache_fetch_t fetch, void *priv);
+
+/**
+ * @brief Load a file of the server, from the cache partition when the cached
+ * copy matches the digest the server advertises, otherwise by downloading
+ * it. A downloaded file matching the advertised digest is added to the
+ * cache, evicting the least recently used entries to make room. A file
+ * missing from the manifest is downloaded and the cache is left untouched.
+ *
+ * @param file Name of the file on the server
+ * @param buf Buffer to load the file to
+ * @param max_size Size of buf
+ * @param size Size of the file (output)
+ *
+ * @return TEGRABL_NO_ERROR on success, otherwise appropriate error
+ */
+tegrabl_error_t net_boot_cache_load(const char *file, void *buf, uint32_t max_size, uint32_t *size);
+
+/**
+ * @brief Write back the cache index and release the cache
+ */
+void net_boot_cache_close(void);
+
+#endif  /* CONFIG_ENABLE_NET_BOOT_CACHE */
+
+#endif  /* INCLUDED_NET_BOOT_CACHE_H */
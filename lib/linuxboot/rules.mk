@@ -1,5 +1,5 @@
 #
-# Copyright (c) 2015-2019, NVIDIA Corporation.  All Rights Reserved.
+# Copyright (c) 2015-2023, NVIDIA Corporation.  All Rights Reserved.
 #
 # NVIDIA Corporation and its licensors retain all intellectual property and
 # proprietary rights in and to this software and related documentation.  Any
@@ -36,7 +36,8 @@ MODULE_DEPS += \
 ifneq ($(NVDISP_INIT_ONLY),true)
 MODULE_DEPS += \
 	$(LOCAL_DIR)/../plugin_manager \
-	$(LOCAL_DIR)/../external/libufdt
+	$(LOCAL_DIR)/../external/libufdt \
+	$(LOCAL_DIR)/../external/mincrypt
 endif
 
 ifneq ($(filter t18x, $(TARGET_FAMILY)),)
@@ -68,7 +69,8 @@ MODULE_SRCS += \
 ifneq ($(NVDISP_INIT_ONLY),true)
 MODULE_SRCS += \
 	$(LOCAL_DIR)/removable_boot.c \
-	$(LOCAL_DIR)/net_boot.c
+	$(LOCAL_DIR)/net_boot.c \
+	$(LOCAL_DIR)/net_boot_cache.c
 endif
 endif
 
@@ -420,7 +420,7 @@ static tegrabl_error_t pm_do_prop_overlay(void *fdt, int32_t target_nd,
 			pr_info("Removing prop %s from %s\n", (char *)prop_data,
 					(char *)fdt_get_name(fdt, target_nd, NULL));
 
-			fdt_err = fdt_delprop(fdt, target_nd, prop_data);
+			fdt_err = tegrabl_dt_delprop(fdt, target_nd, prop_data);
 			if (fdt_err < 0) {
 				if (!strlen(target_path)) {
 					fdt_get_path(fdt, target_nd, target_path, 128);
@@ -433,7 +433,7 @@ static tegrabl_error_t pm_do_prop_overlay(void *fdt, int32_t target_nd,
 		}
 
 		if (!strcmp(prop_name, "append-string-property")) {
-			fdt_err = fdt_appendprop(fdt, target_nd, prop_data, NULL, 0);
+			fdt_err = tegrabl_dt_appendprop(fdt, target_nd, prop_data, NULL, 0);
 			if (fdt_err < 0) {
 				if (!strlen(target_path)) {
 					fdt_get_path(fdt, target_nd, target_path, 128);
@@ -445,8 +445,8 @@ static tegrabl_error_t pm_do_prop_overlay(void *fdt, int32_t target_nd,
 			goto finish;
 		}
 
-		fdt_err = fdt_setprop(fdt, target_nd, prop_name, prop_data,
-							  prop_size);
+		fdt_err = tegrabl_dt_setprop(fdt, target_nd, prop_name, prop_data,
+									 prop_size);
 		if (fdt_err) {
 			if (!strlen(target_path)) {
 				fdt_get_path(fdt, target_nd, target_path, 128);
@@ -513,7 +513,7 @@ static tegrabl_error_t pm_override_fragment(void *fdt, void *fdt_buf,
 		return err;
 	}
 
-	target_nd = fdt_node_offset_by_phandle(fdt, target_phd);
+	target_nd = tegrabl_dt_node_offset_by_phandle(fdt, target_phd);
 	if (target_nd < 0) {
 		pr_error("Failed to find phandle for %s\n",
 				 fdt_get_name(fdt_buf, override_nd, NULL));
@@ -696,7 +696,7 @@ tegrabl_error_t tegrabl_plugin_manager_overlay(void *fdt)
 
 	/* TODO: add connection manager function here */
 
-	pm_node = fdt_path_offset(fdt, "/plugin-manager");
+	pm_node = tegrabl_dt_path_offset(fdt, "/plugin-manager");
 	if (pm_node <= 0) {
 		pr_warn("Failed to find /plugin-manager in DT\n");
 		return TEGRABL_NO_ERROR;
@@ -754,14 +754,14 @@ tegrabl_error_t tegrabl_plugin_manager_overlay(void *fdt)
 	}
 
 	/* Disable plugin-manager status for kernel */
-	pm_node = fdt_path_offset(fdt, "/plugin-manager");
+	pm_node = tegrabl_dt_path_offset(fdt, "/plugin-manager");
 	if (pm_node <= 0) {
 		pr_warn("Failed to find /plugin-manager in DT\n");
 		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
 		goto fail;
 	}
 
-	fdt_err = fdt_setprop_string(fdt, pm_node, "status", "disabled");
+	fdt_err = tegrabl_dt_setprop_string(fdt, pm_node, "status", "disabled");
 	if (fdt_err < 0) {
 		pr_error("Failed to disable plugin-manager status.\n");
 		err = TEGRABL_ERROR(TEGRABL_ERR_SET_FAILED, 0);
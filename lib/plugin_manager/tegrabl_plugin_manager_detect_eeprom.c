@@ -168,8 +168,8 @@ static tegrabl_error_t create_pm_ids_with_config(void *fdt, int pm_node,
 
 				pr_info("Adding plugin-manager/configs/%s %02x\n", prop_name,
 						(uint8_t)val);
-				err = fdt_setprop_cell(fdt, config_node, (char *)prop_name,
-									   val);
+				err = tegrabl_dt_setprop_cell(fdt, config_node, (char *)prop_name,
+											  val);
 				if (err < 0) {
 					pr_error("Can't set plugin-manager/config/%s (%s)\n",
 							 prop_name, fdt_strerror(err));
@@ -253,7 +253,7 @@ static tegrabl_error_t create_pm_ids_with_rev(void *fdt, int pm_node,
 			prop_name[BOARD_FULL_REV_SZ - 1] = '\0';
 
 			pr_info("Adding plugin-manager/ids/%s\n", prop_name);
-			err = fdt_setprop_cell(fdt, id_node, (char *)prop_name, 1);
+			err = tegrabl_dt_setprop_cell(fdt, id_node, (char *)prop_name, 1);
 			if (err < 0) {
 				pr_error("Can't set /chosen/plugin-manager/ids/%s (%s)\n",
 						 prop_name, fdt_strerror(err));
@@ -286,7 +286,7 @@ static tegrabl_error_t create_pm_ids_for_cvm(void *fdt, int pm_node,
 		prop_name[BOARD_ID_SZ + BOARD_SKU_SZ + BOARD_FAB_SZ + 2] = '\0';
 
 		pr_info("Adding plugin-manager/cvm\n");
-		err = fdt_setprop_string(fdt, pm_node, "cvm", prop_name);
+		err = tegrabl_dt_setprop_string(fdt, pm_node, "cvm", prop_name);
 		if (err < 0) {
 			pr_error("Can't set /chosen/plugin-manager/cvm (%s)\n", fdt_strerror(err));
 			status = TEGRABL_ERROR(TEGRABL_ERR_ADD_FAILED, 0);
@@ -342,7 +342,7 @@ static tegrabl_error_t create_pm_ids(void *fdt, int pm_node,
 
 		pr_info("Adding plugin-manager/ids/%s=%s\n", prop_name, loc_name);
 
-		err = fdt_setprop_string(fdt, id_node, prop_name, loc_name);
+		err = tegrabl_dt_setprop_string(fdt, id_node, prop_name, loc_name);
 		if (err < 0) {
 			pr_error("Can't set /chosen/plugin-manager/ids/%s (%s)\n",
 					 prop_name, fdt_strerror(err));
@@ -383,7 +383,7 @@ static tegrabl_error_t create_pm_ids(void *fdt, int pm_node,
 			prev_node = next_node;
 		}
 
-		err = fdt_setprop_string(fdt, next_node, prop_name, loc_name);
+		err = tegrabl_dt_setprop_string(fdt, next_node, prop_name, loc_name);
 		if (err < 0) {
 			pr_error("Can't set /chosen/plugin-manager/ids/%s (%s)\n",
 				 prop_name, fdt_strerror(err));
@@ -415,7 +415,7 @@ static tegrabl_error_t create_chip_id(void *fdt, int pm_node)
 
 	pr_info("Adding plugin-manager/chip-id/%s\n", prop_name);
 
-	err = fdt_setprop_cell(fdt, chip_node, prop_name, 1);
+	err = tegrabl_dt_setprop_cell(fdt, chip_node, prop_name, 1);
 	if (err < 0) {
 		pr_error("Can't set /chosen/plugin-manager/chip-id/%s (%s)\n",
 				prop_name, fdt_strerror(err));
@@ -530,7 +530,7 @@ tegrabl_error_t tegrabl_add_plugin_manager_ids_by_path(void *fdt, char *path)
 	TEGRABL_ASSERT(fdt);
 	TEGRABL_ASSERT(path);
 
-	node = fdt_path_offset(fdt, path);
+	node = tegrabl_dt_path_offset(fdt, path);
 	if (node > 0) {
 		return tegrabl_add_plugin_manager_ids(fdt, node);
 	}
@@ -550,7 +550,7 @@ tegrabl_error_t tegrabl_copy_plugin_manager_ids(void *fdt_dst, void *fdt_src, in
 	TEGRABL_ASSERT(fdt_dst);
 	TEGRABL_ASSERT(fdt_src);
 
-	src_pm_node = fdt_path_offset(fdt_src, "/chosen/plugin-manager");
+	src_pm_node = tegrabl_dt_path_offset(fdt_src, "/chosen/plugin-manager");
 	if (src_pm_node < 0) {
 		pr_error("Found no plugin manager ids in source DT\n");
 		err = TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 1);
@@ -568,7 +568,8 @@ tegrabl_error_t tegrabl_copy_plugin_manager_ids(void *fdt_dst, void *fdt_src, in
 		prop_data = (char *)fdt_getprop_by_offset(fdt_src, prop_node,
 												  (const char **)&prop_name, &prop_sz);
 
-		if (0 > fdt_setprop(fdt_dst, pm_node, prop_name, prop_data, prop_sz)) {
+		if (0 > tegrabl_dt_setprop(fdt_dst, pm_node, prop_name, prop_data,
+								   prop_sz)) {
 			pr_warn("Failed to add /chosen/plugin-manager/%s\n", prop_name);
 		} else {
 			pr_info("Adding /chosen/plugin-manager/%s\n", prop_name);
@@ -591,7 +592,8 @@ tegrabl_error_t tegrabl_copy_plugin_manager_ids(void *fdt_dst, void *fdt_src, in
 			prop_data = (char *)fdt_getprop_by_offset(fdt_src, prop_node,
 													  (const char **)&prop_name, &prop_sz);
 
-			if (0 > fdt_setprop(fdt_dst, dst_node, prop_name, prop_data, prop_sz)) {
+			if (0 > tegrabl_dt_setprop(fdt_dst, dst_node, prop_name,
+									   prop_data, prop_sz)) {
 				/* not critical failure, just warning */
 				pr_warn("Failed to add /chosen/plugin-manager/%s/%s\n", child_name, prop_name);
 			} else {
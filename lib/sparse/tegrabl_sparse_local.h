@@ -19,4 +19,10 @@
 
 #define SPARSE_MAX_LOCAL_BUFFER 1024
 
+/* Pattern buffer for fill chunks written through writer */
+#define SPARSE_FILL_BUFFER_SIZE (64U * 1024U)
+
+/* Adjacent raw chunks smaller than this are gathered into one write */
+#define SPARSE_COALESCE_BUFFER_SIZE (1024U * 1024U)
+
 #endif
@@ -15,6 +15,15 @@
 #include <tegrabl_sparse.h>
 #include <tegrabl_sparse_local.h>
 #include <tegrabl_debug.h>
+#include <tegrabl_malloc.h>
+
+/* Gathers data of adjacent raw chunks so that the writer gets one large
+ * write instead of one write per chunk.
+ */
+struct tegrabl_sparse_coalesce {
+	uint8_t *buffer;
+	uint64_t used;
+};
 
 tegrabl_error_t tegrabl_sparse_init_unsparse_state(
 		struct tegrabl_unsparse_state *unsparse_state,
@@ -37,6 +46,150 @@ tegrabl_error_t tegrabl_sparse_init_unsparse_state(
 	return TEGRABL_NO_ERROR;
 }
 
+tegrabl_error_t tegrabl_sparse_set_unsparse_filler(
+		struct tegrabl_unsparse_state *unsparse_state,
+		tegrabl_error_t (*filler)(uint32_t fill_value, uint64_t size,
+			void *aux_info))
+{
+	if (!unsparse_state) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BAD_PARAMETER, 2);
+	}
+
+	unsparse_state->filler = filler;
+
+	return TEGRABL_NO_ERROR;
+}
+
+/**
+ * @brief Writes raw data gathered so far.
+ *
+ * @param unsparse_state Handle of state maintained by unsparse machine.
+ * @param coalesce Raw data gathered.
+ * @param aux_info Auxiliary information passed to writer.
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sparse_flush_raw(
+		struct tegrabl_unsparse_state *unsparse_state,
+		struct tegrabl_sparse_coalesce *coalesce, void *aux_info)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if (coalesce->used == 0) {
+		goto done;
+	}
+
+	error = unsparse_state->writer(coalesce->buffer, coalesce->used, aux_info);
+	coalesce->used = 0;
+
+done:
+	return error;
+}
+
+/**
+ * @brief Writes data of raw chunk, small pieces are gathered with data of
+ * adjacent raw chunks and written together.
+ *
+ * @param unsparse_state Handle of state maintained by unsparse machine.
+ * @param coalesce Raw data gathered.
+ * @param data Data of raw chunk.
+ * @param size Size of the data.
+ * @param aux_info Auxiliary information passed to writer.
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sparse_write_raw(
+		struct tegrabl_unsparse_state *unsparse_state,
+		struct tegrabl_sparse_coalesce *coalesce, const uint8_t *data,
+		uint64_t size, void *aux_info)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if ((size < SPARSE_COALESCE_BUFFER_SIZE) && (coalesce->buffer == NULL)) {
+		coalesce->buffer = tegrabl_malloc(SPARSE_COALESCE_BUFFER_SIZE);
+	}
+
+	if ((coalesce->used + size) > SPARSE_COALESCE_BUFFER_SIZE) {
+		error = tegrabl_sparse_flush_raw(unsparse_state, coalesce, aux_info);
+		if (error != TEGRABL_NO_ERROR) {
+			goto done;
+		}
+	}
+
+	if ((size >= SPARSE_COALESCE_BUFFER_SIZE) || (coalesce->buffer == NULL)) {
+		error = unsparse_state->writer(data, size, aux_info);
+		goto done;
+	}
+
+	memcpy(coalesce->buffer + coalesce->used, data, size);
+	coalesce->used += size;
+
+done:
+	return error;
+}
+
+/**
+ * @brief Fills bytes with pattern of fill chunk. Uses filler if registered,
+ * else writes the pattern through writer.
+ *
+ * @param unsparse_state Handle of state maintained by unsparse machine.
+ * @param pattern Local buffer filled with the pattern.
+ * @param size Bytes to be filled.
+ * @param aux_info Auxiliary information passed to filler and writer.
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sparse_fill(
+		struct tegrabl_unsparse_state *unsparse_state, uint32_t *pattern,
+		uint64_t size, void *aux_info)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t *fill_buffer = NULL;
+	uint64_t fill_size = 0;
+	uint64_t chunk = 0;
+	uint32_t i = 0;
+
+	if (unsparse_state->filler) {
+		error = unsparse_state->filler(unsparse_state->fill_value, size,
+				aux_info);
+		if (TEGRABL_ERROR_REASON(error) != TEGRABL_ERR_NOT_SUPPORTED) {
+			goto done;
+		}
+	}
+
+	/* Write the pattern in large pieces if memory is available */
+	if (size > SPARSE_MAX_LOCAL_BUFFER) {
+		fill_size = MIN(size, SPARSE_FILL_BUFFER_SIZE);
+		fill_buffer = tegrabl_malloc(fill_size);
+	}
+	if (fill_buffer != NULL) {
+		for (i = 0; i < (fill_size / sizeof(uint32_t)); i++) {
+			fill_buffer[i] = unsparse_state->fill_value;
+		}
+	} else {
+		fill_buffer = pattern;
+		fill_size = SPARSE_MAX_LOCAL_BUFFER;
+	}
+
+	error = TEGRABL_NO_ERROR;
+	while (size) {
+		chunk = MIN(size, fill_size);
+		size -= chunk;
+
+		error = unsparse_state->writer(fill_buffer, chunk, aux_info);
+		if (error != TEGRABL_NO_ERROR) {
+			break;
+		}
+	}
+
+	if (fill_buffer != pattern) {
+		tegrabl_free(fill_buffer);
+	}
+
+done:
+	return error;
+}
+
 /**
  * @brief Validates header and checks if unsparsed size mentioned
  * in header is less or equal to maximum allowed size specified.
@@ -141,6 +294,7 @@ tegrabl_error_t tegrabl_sparse_unsparse(
 	uint32_t buffer[SPARSE_MAX_LOCAL_BUFFER / sizeof(uint32_t)];
 	const uint8_t *sparse_buffer = (const uint8_t *)buff;
 	uint8_t *tmp_buff = NULL;
+	struct tegrabl_sparse_coalesce coalesce = { NULL, 0 };
 	struct tegrabl_sparse_image_header *image_header = NULL;
 	struct tegrabl_sparse_chunk_header *curr_header = NULL;
 	tegrabl_unsparse_state_type_t state = 0;
@@ -249,7 +403,8 @@ tegrabl_error_t tegrabl_sparse_unsparse(
 
 		case TEGRABL_UNSPARSE_PARTIAL_CHUNK_RAW:
 			size = MIN(length, remaining);
-			error = unsparse_state->writer(sparse_buffer, size, aux_info);
+			error = tegrabl_sparse_write_raw(unsparse_state, &coalesce,
+					sparse_buffer, size, aux_info);
 			if (error != TEGRABL_NO_ERROR) {
 				pr_debug("Failed to write unsparse image\n");
 				TEGRABL_SET_HIGHEST_MODULE(error);
@@ -294,21 +449,24 @@ tegrabl_error_t tegrabl_sparse_unsparse(
 				buffer[i] = buffer[0];
 			}
 
-			while (remaining) {
-				size = MIN(remaining, SPARSE_MAX_LOCAL_BUFFER);
-				remaining -= size;
-
 #ifdef TEGRABL_CONFIG_ENABLE_SPARSE_CRC32
-				computed_crc = tegrabl_utils_crc32(computed_crc,
-						(void *)buffer, size);
+			for (size = 0; size < remaining; size += SPARSE_MAX_LOCAL_BUFFER) {
+				computed_crc = tegrabl_utils_crc32(computed_crc, (void *)buffer,
+						MIN(remaining - size, SPARSE_MAX_LOCAL_BUFFER));
+			}
 #endif
-				error = unsparse_state->writer(buffer, size, aux_info);
-				if (error != TEGRABL_NO_ERROR) {
-					pr_debug("Failed to write unsparse image\n");
-					TEGRABL_SET_HIGHEST_MODULE(error);
-					goto fail;
-				}
+			error = tegrabl_sparse_flush_raw(unsparse_state, &coalesce,
+					aux_info);
+			if (error == TEGRABL_NO_ERROR) {
+				error = tegrabl_sparse_fill(unsparse_state, buffer, remaining,
+						aux_info);
 			}
+			if (error != TEGRABL_NO_ERROR) {
+				pr_debug("Failed to write unsparse image\n");
+				TEGRABL_SET_HIGHEST_MODULE(error);
+				goto fail;
+			}
+			remaining = 0;
 
 			memset(curr_header, 0x0, sizeof(*curr_header));
 			state = TEGRABL_UNSPARSE_PARTIAL_CHUNK_HEADER;
@@ -317,7 +475,11 @@ tegrabl_error_t tegrabl_sparse_unsparse(
 			break;
 
 		case TEGRABL_UNSPARSE_PARTIAL_CHUNK_DONT_CARE:
-			error = unsparse_state->seeker(remaining, aux_info);
+			error = tegrabl_sparse_flush_raw(unsparse_state, &coalesce,
+					aux_info);
+			if (error == TEGRABL_NO_ERROR) {
+				error = unsparse_state->seeker(remaining, aux_info);
+			}
 			if (error != TEGRABL_NO_ERROR) {
 				pr_debug("Failed to seek to new location while unsparsing\n");
 				TEGRABL_SET_HIGHEST_MODULE(error);
@@ -364,6 +526,13 @@ tegrabl_error_t tegrabl_sparse_unsparse(
 		}
 	}
 
+	error = tegrabl_sparse_flush_raw(unsparse_state, &coalesce, aux_info);
+	if (error != TEGRABL_NO_ERROR) {
+		pr_debug("Failed to write unsparse image\n");
+		TEGRABL_SET_HIGHEST_MODULE(error);
+		goto fail;
+	}
+
 	unsparse_state->remaining = remaining;
 	unsparse_state->offset = offset;
 	unsparse_state->state = state;
@@ -375,6 +544,10 @@ tegrabl_error_t tegrabl_sparse_unsparse(
 #endif
 
 fail:
+	if (coalesce.buffer != NULL) {
+		tegrabl_free(coalesce.buffer);
+	}
+
 	return error;
 }
 
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2017-2019, NVIDIA Corporation.  All rights reserved.
+ * Copyright (c) 2017-2023, NVIDIA Corporation.  All rights reserved.
  *
  * NVIDIA Corporation and its licensors retain all intellectual property and
  * proprietary rights in and to this software and related documentation.  Any
@@ -20,6 +20,10 @@
 #include <tegrabl_sata.h>
 #include <tegrabl_ufs_bdev.h>
 #include <tegrabl_soc_misc.h>
+#include <string.h>
+#if defined(CONFIG_ENABLE_EMMC) && defined(CONFIG_ENABLE_SDMMC_TUNING_RECORD)
+#include <tegrabl_partition_manager.h>
+#endif
 
 #if defined(CONFIG_ENABLE_SDCARD)
 #include <tegrabl_gpio.h>
@@ -36,6 +40,233 @@ const tegrabl_storage_type_t map_to_storage_type_from_mb1_bct_type[] = {
 };
 
 
+#if defined(CONFIG_ENABLE_EMMC) && defined(CONFIG_ENABLE_SDMMC_TUNING_RECORD)
+
+#if !defined(CONFIG_SDMMC_TUNING_RECORD_PARTITION)
+#define CONFIG_SDMMC_TUNING_RECORD_PARTITION "sdmmc-tuning"
+#endif
+
+/**
+ * @brief Read the sdmmc tuning record stored by an earlier boot. The partition
+ * has to be on a device published before the eMMC is opened, usually the QSPI
+ * boot device; without it every boot runs the full mode selection.
+ *
+ * @param record Record read from the partition (output), zeroed if none
+ *
+ * @return true if the partition exists, false otherwise
+ */
+static bool storage_sdmmc_tuning_record_load(struct tegrabl_sdmmc_tuning_record *record)
+{
+	struct tegrabl_partition part;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	memset(record, 0, sizeof(*record));
+
+	err = tegrabl_partition_open(CONFIG_SDMMC_TUNING_RECORD_PARTITION, &part);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_debug("No %s partition\n", CONFIG_SDMMC_TUNING_RECORD_PARTITION);
+		return false;
+	}
+
+	/* magic, crc and cid are checked by sdmmc before the record is used */
+	err = tegrabl_partition_read(&part, record, sizeof(*record));
+	tegrabl_partition_close(&part);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_warn("Failed to read sdmmc tuning record (%x)\n", err);
+		memset(record, 0, sizeof(*record));
+	}
+
+	return true;
+}
+
+/**
+ * @brief Store the tuning record refreshed by sdmmc init, if it differs from
+ * the one read at the start of the init.
+ *
+ * @param record Record after the init
+ * @param saved Record as read by storage_sdmmc_tuning_record_load()
+ */
+static void storage_sdmmc_tuning_record_save(const struct tegrabl_sdmmc_tuning_record *record,
+											 const struct tegrabl_sdmmc_tuning_record *saved)
+{
+	struct tegrabl_partition part;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if ((record->magic != TEGRABL_SDMMC_TUNING_RECORD_MAGIC) ||
+		(memcmp(record, saved, sizeof(*record)) == 0)) {
+		return;
+	}
+
+	err = tegrabl_partition_open(CONFIG_SDMMC_TUNING_RECORD_PARTITION, &part);
+	if (err != TEGRABL_NO_ERROR) {
+		return;
+	}
+
+	err = tegrabl_partition_write(&part, record, sizeof(*record));
+	if (err != TEGRABL_NO_ERROR) {
+		pr_warn("Failed to store sdmmc tuning record (%x)\n", err);
+	}
+	tegrabl_partition_close(&part);
+}
+
+#endif /* CONFIG_ENABLE_EMMC && CONFIG_ENABLE_SDMMC_TUNING_RECORD */
+
+/**
+ * @brief Fill sdmmc platform params from the mb1 bct device params, falling
+ * back to the default DDR52 configuration when the bct leaves them empty.
+ */
+static void tegrabl_storage_fill_sdmmc_params(
+						const struct tegrabl_mb1bct_device_params *dev_params,
+						struct tegrabl_sdmmc_platform_params *sdmmc_params)
+{
+	memset(sdmmc_params, 0, sizeof(*sdmmc_params));
+
+	if (dev_params->emmc.clk_src == 0U) {
+		/* fill the params */
+		sdmmc_params->clk_src = TEGRABL_CLK_SRC_PLLP_OUT0;
+		sdmmc_params->best_mode = TEGRABL_SDMMC_MODE_DDR52;
+		sdmmc_params->tap_value = 9;
+		sdmmc_params->trim_value = 5;
+	} else {
+		/* Copy parameter from device param to sdmmc parameters */
+		sdmmc_params->clk_src = dev_params->emmc.clk_src;
+		sdmmc_params->best_mode = dev_params->emmc.best_mode;
+		sdmmc_params->tap_value = dev_params->emmc.tap_value;
+		sdmmc_params->trim_value = dev_params->emmc.trim_value;
+	}
+}
+
+#if defined(CONFIG_ENABLE_EMMC)
+/*
+ * Parameters of an eMMC open. They have to stay in place from
+ * sdmmc_bdev_open_start() until the matching sdmmc_bdev_open().
+ */
+struct storage_sdmmc_open {
+	uint32_t instance;
+	bool started;
+	struct tegrabl_sdmmc_platform_params params;
+#if defined(CONFIG_ENABLE_SDMMC_TUNING_RECORD)
+	struct tegrabl_sdmmc_tuning_record tuning_record;
+	struct tegrabl_sdmmc_tuning_record saved_record;
+	bool has_tuning_record;
+#endif
+};
+
+static void storage_sdmmc_open_prepare(struct storage_sdmmc_open *open,
+						uint32_t instance,
+						const struct tegrabl_mb1bct_device_params *dev_params,
+						bool sdmmc_skip_init)
+{
+	open->instance = instance;
+	open->started = false;
+	tegrabl_storage_fill_sdmmc_params(dev_params, &open->params);
+	open->params.is_skip_init = sdmmc_skip_init;
+#if defined(CONFIG_ENABLE_SDMMC_TUNING_RECORD)
+	open->has_tuning_record = false;
+	if (!sdmmc_skip_init) {
+		open->has_tuning_record =
+			storage_sdmmc_tuning_record_load(&open->saved_record);
+	}
+	if (open->has_tuning_record) {
+		open->tuning_record = open->saved_record;
+		open->params.tuning_record = &open->tuning_record;
+	}
+#endif
+}
+
+static tegrabl_error_t storage_sdmmc_open(struct storage_sdmmc_open *open)
+{
+	tegrabl_error_t err;
+
+	err = sdmmc_bdev_open(open->instance, &open->params);
+	open->started = false;
+	if (err != TEGRABL_NO_ERROR) {
+		pr_error("Error opening sdmmc-%d\n", open->instance);
+	}
+#if defined(CONFIG_ENABLE_SDMMC_TUNING_RECORD)
+	if ((err == TEGRABL_NO_ERROR) && open->has_tuning_record) {
+		storage_sdmmc_tuning_record_save(&open->tuning_record,
+										 &open->saved_record);
+	}
+#endif
+
+	return err;
+}
+#endif /* CONFIG_ENABLE_EMMC */
+
+#if defined(CONFIG_ENABLE_EMMC) && defined(CONFIG_ENABLE_STORAGE_INIT_OVERLAP)
+static bool storage_is_sdmmc(tegrabl_storage_type_t type)
+{
+	return (type == TEGRABL_STORAGE_SDMMC_BOOT) ||
+		   (type == TEGRABL_STORAGE_SDMMC_USER);
+}
+
+/**
+ * @brief Start the first eMMC among @storage_devs, unless it is the boot
+ * device. The card then runs its power-up init, which can take up to the OCR
+ * poll timeout, while the other storage devices are brought up.
+ *
+ * @return true if the eMMC has to be opened after the other devices
+ */
+static bool storage_sdmmc_overlap_start(
+						const struct tegrabl_device *const storage_devs,
+						const struct tegrabl_mb1bct_device_params *dev_params,
+						tegrabl_storage_type_t boot_dev,
+						bool sdmmc_skip_init,
+						struct storage_sdmmc_open *open)
+{
+	tegrabl_storage_type_t dev_type;
+	uint8_t i;
+
+	if (sdmmc_skip_init) {
+		return false;
+	}
+
+	for (i = 0; (i < TEGRABL_MAX_STORAGE_DEVICES) &&
+		 (storage_devs[i].type != (uint8_t)TEGRABL_MB1BCT_NONE); i++) {
+		dev_type = map_to_storage_type_from_mb1_bct_type[storage_devs[i].type];
+		if (storage_is_sdmmc(dev_type) && (dev_type != boot_dev)) {
+			break;
+		}
+	}
+	if ((i == TEGRABL_MAX_STORAGE_DEVICES) ||
+		(storage_devs[i].type == (uint8_t)TEGRABL_MB1BCT_NONE)) {
+		return false;
+	}
+
+	storage_sdmmc_open_prepare(open, storage_devs[i].instance, dev_params,
+							   false);
+	/* if starting fails the open below does the whole init */
+	open->started = (sdmmc_bdev_open_start(open->instance, &open->params) ==
+					 TEGRABL_NO_ERROR);
+
+	return true;
+}
+
+/**
+ * @brief Check on the eMMC started by storage_sdmmc_overlap_start() between
+ * two other devices. A card that fails or times out is dropped here and gets
+ * a full init when it is opened.
+ */
+static void storage_sdmmc_overlap_poll(struct storage_sdmmc_open *open)
+{
+	tegrabl_error_t err;
+	bool ready = false;
+
+	if (!open->started) {
+		return;
+	}
+
+	err = sdmmc_bdev_open_poll(open->instance, &ready);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_warn("sdmmc-%d power-up failed (%x), retrying\n", open->instance,
+				err);
+		sdmmc_bdev_open_cancel(open->instance);
+		open->started = false;
+	}
+}
+#endif /* CONFIG_ENABLE_EMMC && CONFIG_ENABLE_STORAGE_INIT_OVERLAP */
+
 tegrabl_storage_type_t tegrabl_storage_map_to_storage_dev_from_mb1bct_dev(
 									tegrabl_mb1_bct_boot_device_t mb1bct_dev)
 {
@@ -50,7 +281,7 @@ tegrabl_error_t tegrabl_storage_init_dev(
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 #if defined(CONFIG_ENABLE_EMMC)
-	struct tegrabl_sdmmc_platform_params sdmmc_params;
+	struct storage_sdmmc_open sdmmc_open;
 #endif
 #if defined(CONFIG_ENABLE_QSPI)
 	struct tegrabl_qspi_flash_platform_params qflash_params;
@@ -72,24 +303,9 @@ tegrabl_error_t tegrabl_storage_init_dev(
 	case TEGRABL_STORAGE_SDMMC_BOOT:
 	case TEGRABL_STORAGE_SDMMC_USER:
 
-		if (dev_params->emmc.clk_src == 0U) {
-			/* fill the params */
-			sdmmc_params.clk_src = TEGRABL_CLK_SRC_PLLP_OUT0;
-			sdmmc_params.best_mode = TEGRABL_SDMMC_MODE_DDR52;
-			sdmmc_params.tap_value = 9;
-			sdmmc_params.trim_value = 5;
-		} else {
-			/* Copy parameter from device param to qspi_flash parameters */
-			sdmmc_params.clk_src = dev_params->emmc.clk_src;
-			sdmmc_params.best_mode = dev_params->emmc.best_mode;
-			sdmmc_params.tap_value = dev_params->emmc.tap_value;
-			sdmmc_params.trim_value = dev_params->emmc.trim_value;
-		}
-		sdmmc_params.is_skip_init = sdmmc_skip_init;
-		err = sdmmc_bdev_open(instance, &sdmmc_params);
-		if (err != TEGRABL_NO_ERROR) {
-			pr_error("Error opening sdmmc-%d\n", instance);
-		}
+		storage_sdmmc_open_prepare(&sdmmc_open, instance, dev_params,
+								   sdmmc_skip_init);
+		err = storage_sdmmc_open(&sdmmc_open);
 		break;
 #endif  /* CONFIG_ENABLE_EMMC */
 
@@ -249,6 +465,10 @@ tegrabl_error_t tegrabl_storage_init_storage_devs(
 	uint32_t instance;
 	uint8_t i;
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
+#if defined(CONFIG_ENABLE_EMMC) && defined(CONFIG_ENABLE_STORAGE_INIT_OVERLAP)
+	struct storage_sdmmc_open emmc;
+	bool emmc_deferred = false;
+#endif
 
 	if ((storage_devs == NULL) || (dev_params == NULL)) {
 
@@ -257,6 +477,13 @@ tegrabl_error_t tegrabl_storage_init_storage_devs(
 		goto fail;
 	}
 
+#if defined(CONFIG_ENABLE_EMMC) && defined(CONFIG_ENABLE_STORAGE_INIT_OVERLAP)
+	/* eMMC power-up runs behind the other devices, so open it last */
+	emmc_deferred = storage_sdmmc_overlap_start(storage_devs, dev_params,
+												boot_dev, sdmmc_skip_init,
+												&emmc);
+#endif
+
 	for (i = 0;
 		 (storage_devs[i].type != (uint8_t)TEGRABL_MB1BCT_NONE) &&
 			(i < TEGRABL_MAX_STORAGE_DEVICES);
@@ -278,14 +505,39 @@ tegrabl_error_t tegrabl_storage_init_storage_devs(
 			continue;
 		}
 
+#if defined(CONFIG_ENABLE_EMMC) && defined(CONFIG_ENABLE_STORAGE_INIT_OVERLAP)
+		if (emmc_deferred && storage_is_sdmmc(dev_type) &&
+			(instance == emmc.instance)) {
+			continue;
+		}
+#endif
+
 		err = tegrabl_storage_init_dev(dev_type, instance, dev_params, NULL,
 									   sdmmc_skip_init, ufs_reinit);
 		if (err != TEGRABL_NO_ERROR) {
 			goto fail;
 		}
+
+#if defined(CONFIG_ENABLE_EMMC) && defined(CONFIG_ENABLE_STORAGE_INIT_OVERLAP)
+		if (emmc_deferred) {
+			storage_sdmmc_overlap_poll(&emmc);
+		}
+#endif
 	}
 
+#if defined(CONFIG_ENABLE_EMMC) && defined(CONFIG_ENABLE_STORAGE_INIT_OVERLAP)
+	if (emmc_deferred) {
+		emmc_deferred = false;
+		err = storage_sdmmc_open(&emmc);
+	}
+#endif
+
 fail:
+#if defined(CONFIG_ENABLE_EMMC) && defined(CONFIG_ENABLE_STORAGE_INIT_OVERLAP)
+	if (emmc_deferred && emmc.started) {
+		sdmmc_bdev_open_cancel(emmc.instance);
+	}
+#endif
 	return err;
 }
 
@@ -302,19 +554,7 @@ tegrabl_error_t tegrabl_storage_partial_sdmmc_init(
 		goto fail;
 	}
 
-	if (dev_params->emmc.clk_src == 0U) {
-		/* fill the params */
-		sdmmc_params.clk_src = TEGRABL_CLK_SRC_PLLP_OUT0;
-		sdmmc_params.best_mode = TEGRABL_SDMMC_MODE_DDR52;
-		sdmmc_params.tap_value = 9;
-		sdmmc_params.trim_value = 5;
-	} else {
-		/* Copy parameter from device param to qspi_flash parameters */
-		sdmmc_params.clk_src = dev_params->emmc.clk_src;
-		sdmmc_params.best_mode = dev_params->emmc.best_mode;
-		sdmmc_params.tap_value = dev_params->emmc.tap_value;
-		sdmmc_params.trim_value = dev_params->emmc.trim_value;
-	}
+	tegrabl_storage_fill_sdmmc_params(dev_params, &sdmmc_params);
 	err = sdmmc_send_cmd0_cmd1(3, &sdmmc_params);
 	if (err != TEGRABL_NO_ERROR) {
 		pr_error("Error sending cmd");